@@ -0,0 +1,208 @@
+#include "apk/apkdiff.h"
+#include "apk/resourcetable.h"
+#include "base/ziparchive.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QtEndian>
+#include <cstring>
+
+namespace
+{
+    const int MaxDetails = 500; // Per entry, to keep the memory usage bounded
+    const int DexHeaderSize = 0x70;
+
+    quint32 readUleb128(const uchar *&data, const uchar *end)
+    {
+        quint32 result = 0;
+        for (int shift = 0; shift < 35 && data < end; shift += 7) {
+            const uchar byte = *data++;
+            result |= quint32(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        return result;
+    }
+}
+
+QFuture<ApkDiff::Result> ApkDiff::compare(const QString &oldApk, const QString &newApk)
+{
+    return QtConcurrent::run(&ApkDiff::compareArchives, oldApk, newApk);
+}
+
+ApkDiff::Result ApkDiff::compareArchives(const QString &oldApk, const QString &newApk)
+{
+    Result result;
+    ZipArchive oldArchive(oldApk);
+    ZipArchive newArchive(newApk);
+    if (!oldArchive.open() || !newArchive.open()) {
+        return result;
+    }
+
+    // Central directory comparison:
+
+    for (const auto &oldEntry : oldArchive.getEntries()) {
+        if (oldEntry.isDirectory()) {
+            continue;
+        }
+        Entry entry;
+        entry.name = oldEntry.name;
+        entry.oldSize = oldEntry.uncompressedSize;
+        entry.oldCompressedSize = oldEntry.compressedSize;
+        const auto newEntry = newArchive.getEntry(oldEntry.name);
+        if (newEntry) {
+            entry.newSize = newEntry->uncompressedSize;
+            entry.newCompressedSize = newEntry->compressedSize;
+            const bool equal = newEntry->crc == oldEntry.crc && newEntry->uncompressedSize == oldEntry.uncompressedSize;
+            entry.status = equal ? Status::Unchanged : Status::Modified;
+        } else {
+            entry.status = Status::Removed;
+        }
+        result.entries.append(entry);
+    }
+    for (const auto &newEntry : newArchive.getEntries()) {
+        if (!newEntry.isDirectory() && !oldArchive.getEntry(newEntry.name)) {
+            Entry entry;
+            entry.name = newEntry.name;
+            entry.status = Status::Added;
+            entry.newSize = newEntry.uncompressedSize;
+            entry.newCompressedSize = newEntry.compressedSize;
+            result.entries.append(entry);
+        }
+    }
+
+    // Closer look at the changed entries whose format is known:
+
+    QVector<Entry *> changed;
+    for (Entry &entry : result.entries) {
+        if (entry.status == Status::Modified && (entry.name == "resources.arsc" || entry.name.endsWith(".dex"))) {
+            changed.append(&entry);
+        }
+    }
+    QtConcurrent::blockingMap(changed, [&](Entry *entry) {
+        if (entry->name == "resources.arsc") {
+            entry->details = compareResourceTables(oldApk, newApk);
+        } else {
+            // Decompressed one at a time per thread, released right after the comparison
+            entry->details = compareDexStrings(oldArchive.read(entry->name), newArchive.read(entry->name));
+        }
+    });
+
+    result.success = true;
+    return result;
+}
+
+QStringList ApkDiff::compareResourceTables(const QString &oldApk, const QString &newApk)
+{
+    auto readValues = [](const QString &apk, QHash<QString, QString> &values) -> bool {
+        ResourceTable table(apk);
+        if (!table.open()) {
+            return false;
+        }
+        for (const auto &entry : table.getEntries()) {
+            QString key = QString("%1/%2").arg(table.getTypeName(entry), table.getKeyName(entry));
+            const QString qualifiers = table.getQualifiers(entry);
+            if (!qualifiers.isEmpty()) {
+                key.append(QString(" [%1]").arg(qualifiers));
+            }
+            values.insert(key, table.formatValue(entry));
+        }
+        return true;
+    };
+
+    QHash<QString, QString> oldValues;
+    QHash<QString, QString> newValues;
+    if (!readValues(oldApk, oldValues) || !readValues(newApk, newValues)) {
+        return {tr("Could not read the resource table.")};
+    }
+
+    QStringList added;
+    QStringList removed;
+    QStringList modified;
+    for (auto it = oldValues.constBegin(); it != oldValues.constEnd(); ++it) {
+        const auto newValue = newValues.constFind(it.key());
+        if (newValue == newValues.constEnd()) {
+            removed.append(QString("- %1: %2").arg(it.key(), it.value()));
+        } else if (newValue.value() != it.value()) {
+            modified.append(QString("~ %1: %2 -> %3").arg(it.key(), it.value(), newValue.value()));
+        }
+    }
+    for (auto it = newValues.constBegin(); it != newValues.constEnd(); ++it) {
+        if (!oldValues.contains(it.key())) {
+            added.append(QString("+ %1: %2").arg(it.key(), it.value()));
+        }
+    }
+    added.sort();
+    removed.sort();
+    modified.sort();
+
+    //: "%1", "%2" and "%3" will be replaced with the number of added, removed and changed resources.
+    QStringList details = {tr("Resources added: %1, removed: %2, changed: %3.")
+                           .arg(added.count()).arg(removed.count()).arg(modified.count())};
+    for (const QStringList &lines : {added, removed, modified}) {
+        details.append(lines.mid(0, MaxDetails));
+        if (lines.count() > MaxDetails) {
+            details.append(tr("...and %n more", nullptr, lines.count() - MaxDetails));
+        }
+    }
+    return details;
+}
+
+QStringList ApkDiff::compareDexStrings(const QByteArray &oldDex, const QByteArray &newDex)
+{
+    return compareSets(readDexStrings(oldDex), readDexStrings(newDex));
+}
+
+QStringList ApkDiff::readDexStrings(const QByteArray &dex)
+{
+    QStringList strings;
+    if (dex.size() < DexHeaderSize || !dex.startsWith("dex\n")) {
+        return strings;
+    }
+    const uchar *data = reinterpret_cast<const uchar *>(dex.constData());
+    const uchar *end = data + dex.size();
+    const quint32 count = qFromLittleEndian<quint32>(data + 0x38);
+    const quint32 offset = qFromLittleEndian<quint32>(data + 0x3C);
+    if (quint64(offset) + quint64(count) * 4 > quint64(dex.size())) {
+        return strings;
+    }
+    strings.reserve(static_cast<int>(count));
+    for (quint32 i = 0; i < count; ++i) {
+        const quint32 dataOffset = qFromLittleEndian<quint32>(data + offset + i * 4);
+        if (dataOffset >= quint32(dex.size())) {
+            continue;
+        }
+        const uchar *string = data + dataOffset;
+        readUleb128(string, end); // UTF-16 length
+        const uchar *terminator = static_cast<const uchar *>(memchr(string, 0, static_cast<size_t>(end - string)));
+        if (!terminator) {
+            continue;
+        }
+        // Modified UTF-8 only differs from UTF-8 in encoding of U+0000 and supplementary characters
+        strings.append(QString::fromUtf8(reinterpret_cast<const char *>(string), static_cast<int>(terminator - string)));
+    }
+    return strings;
+}
+
+QStringList ApkDiff::compareSets(const QStringList &oldItems, const QStringList &newItems)
+{
+    const QSet<QString> oldSet = oldItems.toSet();
+    const QSet<QString> newSet = newItems.toSet();
+    QStringList added = QSet<QString>(newSet).subtract(oldSet).toList();
+    QStringList removed = QSet<QString>(oldSet).subtract(newSet).toList();
+    added.sort();
+    removed.sort();
+
+    //: "%1" and "%2" will be replaced with the number of added and removed strings in a DEX file.
+    QStringList details = {tr("Strings added: %1, removed: %2.").arg(added.count()).arg(removed.count())};
+    auto append = [&](const QStringList &lines, const QString &prefix) {
+        for (int i = 0; i < qMin(lines.count(), MaxDetails); ++i) {
+            details.append(prefix + lines.at(i));
+        }
+        if (lines.count() > MaxDetails) {
+            details.append(tr("...and %n more", nullptr, lines.count() - MaxDetails));
+        }
+    };
+    append(added, "+ ");
+    append(removed, "- ");
+    return details;
+}
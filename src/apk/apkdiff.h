@@ -0,0 +1,51 @@
+#ifndef APKDIFF_H
+#define APKDIFF_H
+
+#include <QCoreApplication>
+#include <QFuture>
+#include <QStringList>
+#include <QVector>
+
+// Comparison of two APKs. Entries are matched by name and compared by CRC-32 and size
+// from the central directories; only the changed entries are decompressed for a closer look.
+
+class ApkDiff
+{
+    Q_DECLARE_TR_FUNCTIONS(ApkDiff)
+
+public:
+    enum class Status {
+        Unchanged,
+        Added,
+        Removed,
+        Modified
+    };
+
+    struct Entry
+    {
+        QString name;
+        Status status = Status::Unchanged;
+        quint64 oldSize = 0;
+        quint64 newSize = 0;
+        quint64 oldCompressedSize = 0;
+        quint64 newCompressedSize = 0;
+        QStringList details;
+    };
+
+    struct Result
+    {
+        bool success = false;
+        QVector<Entry> entries;
+    };
+
+    static QFuture<Result> compare(const QString &oldApk, const QString &newApk);
+    static Result compareArchives(const QString &oldApk, const QString &newApk);
+
+private:
+    static QStringList compareResourceTables(const QString &oldApk, const QString &newApk);
+    static QStringList compareDexStrings(const QByteArray &oldDex, const QByteArray &newDex);
+    static QStringList readDexStrings(const QByteArray &dex);
+    static QStringList compareSets(const QStringList &oldItems, const QStringList &newItems);
+};
+
+#endif // APKDIFF_H
@@ -0,0 +1,512 @@
+#include "apk/archiveitemsmodel.h"
+#include "apk/binaryxml.h"
+#include "base/utils.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QLocale>
+#include <QUuid>
+#include <QDebug>
+#include <algorithm>
+
+namespace
+{
+    QDateTime fromDosDateTime(quint32 value)
+    {
+        const quint16 date = value >> 16;
+        const quint16 time = value & 0xFFFF;
+        return QDateTime(QDate(1980 + (date >> 9), (date >> 5) & 0x0F, date & 0x1F),
+                         QTime(time >> 11, (time >> 5) & 0x3F, (time & 0x1F) * 2));
+    }
+}
+
+ArchiveItemsModel::Node::Node(Node *parent, const QString &name)
+    : parent(parent)
+    , row(parent ? parent->children.count() : 0)
+    , name(name)
+{
+    if (parent) {
+        parent->children.append(this);
+    }
+}
+
+ArchiveItemsModel::Node::~Node()
+{
+    qDeleteAll(children);
+}
+
+ArchiveItemsModel::ArchiveItemsModel(QObject *parent)
+    : QAbstractItemModel(parent)
+    , root(new Node)
+    , cache(16 * 1024)
+{}
+
+ArchiveItemsModel::~ArchiveItemsModel()
+{
+    delete root;
+    if (!extractPath.isEmpty() && QDir(extractPath).exists()) {
+        Utils::rmdir(extractPath, true);
+    }
+}
+
+bool ArchiveItemsModel::open(const QString &apkPath)
+{
+    return open(new ZipArchive(apkPath));
+}
+
+bool ArchiveItemsModel::open(ZipArchive *apk)
+{
+    const QString apkPath = apk->getPath();
+
+    // Reopening the same archive (e.g., after it was patched in place) keeps the extracted files,
+    // as they may still be open in the editor. They are mapped onto the new entries by their names.
+    QSet<QString> extractedPaths;
+    QSet<QString> convertedPaths;
+    if (!archivePath.isEmpty() && QFileInfo(apkPath) == QFileInfo(archivePath)) {
+        for (auto it = extractedEntries.constBegin(); it != extractedEntries.constEnd(); ++it) {
+            extractedPaths.insert(it.value());
+            if (convertedEntries.contains(it.key())) {
+                convertedPaths.insert(it.value());
+            }
+        }
+    } else if (!extractPath.isEmpty()) {
+        Utils::rmdir(extractPath, true);
+        extractPath.clear();
+    }
+
+    beginResetModel();
+        delete root;
+        root = new Node;
+        cache.clear();
+        extractedEntries.clear();
+        convertedEntries.clear();
+        removedEntries.clear();
+        archivePath = apkPath;
+        archive.reset(apk);
+        const bool success = archive->open();
+        if (success) {
+            if (extractPath.isEmpty()) {
+                extractPath = Utils::getTemporaryPath(QString("contents/%1").arg(QUuid::createUuid().toString()));
+            }
+            QHash<QString, Node *> directories;
+            const auto &entries = archive->getEntries();
+            for (int i = 0; i < entries.count(); ++i) {
+                const auto &entry = entries.at(i);
+                if (entry.isDirectory()) {
+                    continue; // Directories are created from the file paths
+                }
+                const QStringList parts = entry.name.split('/', QString::SkipEmptyParts);
+                if (parts.isEmpty()) {
+                    continue;
+                }
+
+                Node *directory = root;
+                QString path;
+                for (int j = 0; j < parts.count() - 1; ++j) {
+                    path.append(parts.at(j) + '/');
+                    Node *node = directories.value(path);
+                    if (!node) {
+                        node = new Node(directory, parts.at(j));
+                        directories.insert(path, node);
+                    }
+                    directory = node;
+                }
+
+                auto file = new Node(directory, parts.last());
+                file->entry = i;
+                file->size = entry.uncompressedSize;
+                file->compressedSize = entry.compressedSize;
+                file->modified = (quint32(entry.modifiedDate) << 16) | entry.modifiedTime;
+                const QString extractedPath = QDir::cleanPath(QString("%1/%2").arg(extractPath, parts.join('/')));
+                if (extractedPaths.remove(extractedPath)) {
+                    extractedEntries.insert(i, extractedPath);
+                    if (convertedPaths.contains(extractedPath)) {
+                        convertedEntries.insert(i);
+                    }
+                }
+                for (Node *node = directory; node; node = node->parent) {
+                    node->size += file->size;
+                    node->compressedSize += file->compressedSize;
+                }
+            }
+            sortNode(root, NameColumn, Qt::AscendingOrder);
+            // Files of the entries which are no longer in the archive must not be picked up again:
+            for (const QString &path : extractedPaths) {
+                QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner);
+                QFile::remove(path);
+            }
+        } else {
+            archive.reset();
+        }
+    endResetModel();
+    return success;
+}
+
+void ArchiveItemsModel::close()
+{
+    archive.reset();
+    cache.clear();
+}
+
+bool ArchiveItemsModel::reopen()
+{
+    if (archive || archivePath.isEmpty()) {
+        return !archive.isNull();
+    }
+    archive.reset(new ZipArchive(archivePath));
+    if (!archive->open()) {
+        archive.reset();
+        return false;
+    }
+    return true;
+}
+
+void ArchiveItemsModel::setEditable(bool editable)
+{
+    this->editable = editable;
+}
+
+bool ArchiveItemsModel::isEditable() const
+{
+    return editable;
+}
+
+QString ArchiveItemsModel::getArchivePath() const
+{
+    return archivePath;
+}
+
+QModelIndex ArchiveItemsModel::findIndex(const QString &entryName) const
+{
+    Node *node = root;
+    const QStringList parts = entryName.split('/', QString::SkipEmptyParts);
+    for (const QString &part : parts) {
+        auto it = std::find_if(node->children.cbegin(), node->children.cend(), [&](const Node *child) {
+            return child->name == part;
+        });
+        if (it == node->children.cend()) {
+            return QModelIndex();
+        }
+        node = *it;
+    }
+    return node != root ? createIndex(node->row, 0, node) : QModelIndex();
+}
+
+QByteArray ArchiveItemsModel::getEntryData(const QModelIndex &index) const
+{
+    const Node *node = getNode(index);
+    if (!archive || !node || node->entry == -1) {
+        return QByteArray();
+    }
+    if (const QByteArray *cached = cache.object(node->entry)) {
+        return *cached;
+    }
+    const QByteArray data = archive->read(archive->getEntries().at(node->entry));
+    if (quint64(data.size()) == node->size) {
+        cache.insert(node->entry, new QByteArray(data), qMax(1, data.size() / 1024));
+    }
+    return data;
+}
+
+QMap<QString, QString> ArchiveItemsModel::getModifiedEntries() const
+{
+    QMap<QString, QString> modified;
+    if (!archive) {
+        return modified;
+    }
+    for (auto it = extractedEntries.constBegin(); it != extractedEntries.constEnd(); ++it) {
+        if (convertedEntries.contains(it.key()) || removedEntries.contains(it.key())) {
+            continue;
+        }
+        QFile file(it.value());
+        if (!file.open(QFile::ReadOnly)) {
+            continue;
+        }
+        const QByteArray data = file.readAll();
+        const auto &entry = archive->getEntries().at(it.key());
+        if (quint64(data.size()) != entry.uncompressedSize || ZipArchive::checksum(data) != entry.crc) {
+            modified.insert(entry.name, it.value());
+        }
+    }
+    return modified;
+}
+
+QStringList ArchiveItemsModel::getRemovedEntries() const
+{
+    QStringList removed;
+    if (archive) {
+        for (int entry : removedEntries) {
+            removed.append(archive->getEntries().at(entry).name);
+        }
+    }
+    return removed;
+}
+
+bool ArchiveItemsModel::replaceResource(const QModelIndex &index, const QString &path, QWidget *parent)
+{
+    // The contents can only be modified in the quick patching mode or after the APK is unpacked
+    const Node *node = getNode(index);
+    if (!editable || !node || node->entry == -1) {
+        return false;
+    }
+    const QString what = getResourcePath(index);
+    if (what.isEmpty() || convertedEntries.contains(node->entry)) {
+        return false;
+    }
+    if (Utils::replaceFile(what, path, parent)) {
+        emit dataChanged(index.sibling(index.row(), 0), index.sibling(index.row(), ColumnCount - 1));
+        return true;
+    }
+    return false;
+}
+
+bool ArchiveItemsModel::removeResource(const QModelIndex &index)
+{
+    return index.isValid() && removeRow(index.row(), index.parent());
+}
+
+QString ArchiveItemsModel::getResourcePath(const QModelIndex &index) const
+{
+    const Node *node = getNode(index);
+    if (!node || node->entry == -1 || extractPath.isEmpty()) {
+        return QString();
+    }
+
+    QStringList parts;
+    for (const Node *it = node; it != root; it = it->parent) {
+        parts.prepend(it->name);
+    }
+    const QString path = QDir::cleanPath(QString("%1/%2").arg(extractPath, parts.join('/')));
+    if (!path.startsWith(extractPath + '/')) {
+        qWarning() << "Skipping archive entry outside of the extraction directory:" << path;
+        return QString();
+    }
+    if (QFile::exists(path)) {
+        return path;
+    }
+    if (!archive) {
+        return QString();
+    }
+
+    QByteArray data = getEntryData(index);
+    if (quint64(data.size()) != node->size) {
+        qWarning() << "Could not extract archive entry" << parts.join('/');
+        return QString();
+    }
+    bool converted = false;
+    if (path.endsWith(".xml", Qt::CaseInsensitive) && BinaryXml::isBinaryXml(data)) {
+        BinaryXml xml;
+        if (xml.read(data)) {
+            data = xml.toXml();
+            converted = true;
+        }
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly) || file.write(data) != data.size()) {
+        qWarning() << "Could not write" << path;
+        return QString();
+    }
+    file.close();
+    extractedEntries.insert(node->entry, path);
+    if (converted) {
+        // Text can't be compiled back to binary XML without aapt
+        file.setPermissions(QFile::ReadOwner | QFile::ReadUser | QFile::ReadGroup | QFile::ReadOther);
+        convertedEntries.insert(node->entry);
+    }
+    return path;
+}
+
+QVariant ArchiveItemsModel::data(const QModelIndex &index, int role) const
+{
+    const Node *node = getNode(index);
+    if (!node) {
+        return QVariant();
+    }
+    const bool isFile = node->entry != -1;
+
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (index.column()) {
+        case NameColumn:
+            return node->name;
+        case SizeColumn:
+            return QLocale().formattedDataSize(node->size);
+        case CompressedSizeColumn:
+            return QLocale().formattedDataSize(node->compressedSize);
+        case ModifiedColumn:
+            return isFile ? QLocale().toString(fromDosDateTime(node->modified), QLocale::ShortFormat) : QString();
+        }
+        break;
+    case SortRole:
+        switch (index.column()) {
+        case NameColumn:
+            return node->name;
+        case SizeColumn:
+            return node->size;
+        case CompressedSizeColumn:
+            return node->compressedSize;
+        case ModifiedColumn:
+            return node->modified;
+        }
+        break;
+    case Qt::DecorationRole:
+        if (index.column() == NameColumn) {
+            return isFile ? iconProvider.icon(QFileInfo(node->name)) : iconProvider.icon(QFileIconProvider::Folder);
+        }
+        break;
+    case Qt::TextAlignmentRole:
+        if (index.column() == SizeColumn || index.column() == CompressedSizeColumn) {
+            return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+        }
+        break;
+    }
+    return QVariant();
+}
+
+QVariant ArchiveItemsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal) {
+        switch (section) {
+        case NameColumn:
+            return tr("Name");
+        case SizeColumn:
+            return tr("Size");
+        case CompressedSizeColumn:
+            //: This string refers to the size of a file compressed inside the APK.
+            return tr("Compressed");
+        case ModifiedColumn:
+            return tr("Date Modified");
+        }
+    }
+    return QVariant();
+}
+
+QModelIndex ArchiveItemsModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!hasIndex(row, column, parent)) {
+        return QModelIndex();
+    }
+    const Node *parentNode = parent.isValid() ? getNode(parent) : root;
+    return createIndex(row, column, parentNode->children.at(row));
+}
+
+QModelIndex ArchiveItemsModel::parent(const QModelIndex &index) const
+{
+    if (index.isValid()) {
+        Node *parentNode = getNode(index)->parent;
+        if (parentNode != root) {
+            return createIndex(parentNode->row, 0, parentNode);
+        }
+    }
+    return QModelIndex();
+}
+
+int ArchiveItemsModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) {
+        return 0;
+    }
+    const Node *parentNode = parent.isValid() ? getNode(parent) : root;
+    return parentNode->children.count();
+}
+
+int ArchiveItemsModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return ColumnCount;
+}
+
+void ArchiveItemsModel::sort(int column, Qt::SortOrder order)
+{
+    emit layoutAboutToBeChanged();
+    const QModelIndexList oldIndexes = persistentIndexList();
+    sortNode(root, column, order);
+    QModelIndexList newIndexes;
+    for (const QModelIndex &index : oldIndexes) {
+        Node *node = getNode(index);
+        newIndexes.append(createIndex(node->row, index.column(), node));
+    }
+    changePersistentIndexList(oldIndexes, newIndexes);
+    emit layoutChanged();
+}
+
+bool ArchiveItemsModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    Node *parentNode = parent.isValid() ? getNode(parent) : root;
+    if (!editable || row < 0 || count <= 0 || row + count > parentNode->children.count()) {
+        return false;
+    }
+    quint64 removedSize = 0;
+    quint64 removedCompressedSize = 0;
+    beginRemoveRows(parent, row, row + count - 1);
+        for (int i = row; i < row + count; ++i) {
+            const Node *node = parentNode->children.at(i);
+            removedSize += node->size;
+            removedCompressedSize += node->compressedSize;
+            markRemoved(node);
+            delete node;
+        }
+        parentNode->children.remove(row, count);
+        for (int i = row; i < parentNode->children.count(); ++i) {
+            parentNode->children.at(i)->row = i;
+        }
+    endRemoveRows();
+    // Directory sizes are the totals of their contents:
+    for (Node *node = parentNode; node; node = node->parent) {
+        node->size -= removedSize;
+        node->compressedSize -= removedCompressedSize;
+        if (node != root) {
+            emit dataChanged(createIndex(node->row, SizeColumn, node), createIndex(node->row, CompressedSizeColumn, node));
+        }
+    }
+    return true;
+}
+
+ArchiveItemsModel::Node *ArchiveItemsModel::getNode(const QModelIndex &index) const
+{
+    return index.isValid() ? static_cast<Node *>(index.internalPointer()) : nullptr;
+}
+
+void ArchiveItemsModel::sortNode(Node *node, int column, Qt::SortOrder order)
+{
+    auto lessThan = [=](const Node *a, const Node *b) {
+        switch (column) {
+        case SizeColumn:
+            return a->size < b->size;
+        case CompressedSizeColumn:
+            return a->compressedSize < b->compressedSize;
+        case ModifiedColumn:
+            return a->modified < b->modified;
+        default:
+            return a->name.compare(b->name, Qt::CaseInsensitive) < 0;
+        }
+    };
+    std::stable_sort(node->children.begin(), node->children.end(), [=](const Node *a, const Node *b) {
+        // Directories always go first
+        const bool isDirectoryA = a->entry == -1;
+        const bool isDirectoryB = b->entry == -1;
+        if (isDirectoryA != isDirectoryB) {
+            return isDirectoryA;
+        }
+        return order == Qt::AscendingOrder ? lessThan(a, b) : lessThan(b, a);
+    });
+    for (int row = 0; row < node->children.count(); ++row) {
+        Node *child = node->children.at(row);
+        child->row = row;
+        if (!child->children.isEmpty()) {
+            sortNode(child, column, order);
+        }
+    }
+}
+
+void ArchiveItemsModel::markRemoved(const Node *node)
+{
+    if (node->entry != -1) {
+        removedEntries.insert(node->entry);
+    }
+    for (const Node *child : node->children) {
+        markRemoved(child);
+    }
+}
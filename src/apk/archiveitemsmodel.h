@@ -0,0 +1,96 @@
+#ifndef ARCHIVEITEMSMODEL_H
+#define ARCHIVEITEMSMODEL_H
+
+#include "apk/iresourceitemsmodel.h"
+#include "base/ziparchive.h"
+#include <QAbstractItemModel>
+#include <QCache>
+#include <QFileIconProvider>
+#include <QMap>
+#include <QSet>
+
+// Tree of the APK contents listed straight from the ZIP central directory.
+// Entries are extracted to a temporary directory only when their path is requested (e.g., to open them in a sheet).
+// The model is read-only unless editing is enabled for quick patching; edited entries are then detected by their CRC-32.
+
+class ArchiveItemsModel : public QAbstractItemModel, public IResourceItemsModel
+{
+    Q_OBJECT
+    Q_INTERFACES(IResourceItemsModel)
+
+public:
+    enum Column {
+        NameColumn,
+        SizeColumn,
+        CompressedSizeColumn,
+        ModifiedColumn,
+        ColumnCount
+    };
+
+    enum Role {
+        SortRole = Qt::UserRole + 1
+    };
+
+    explicit ArchiveItemsModel(QObject *parent = nullptr);
+    ~ArchiveItemsModel() override;
+
+    bool open(const QString &apkPath);
+    bool open(ZipArchive *apk); // Takes the ownership, e.g., of an archive opened on a worker thread
+    void close(); // Releases the archive but keeps the listing and already extracted entries
+    bool reopen(); // Maps the archive again after close()
+
+    void setEditable(bool editable);
+    bool isEditable() const;
+
+    QString getArchivePath() const;
+    QModelIndex findIndex(const QString &entryName) const;
+    QByteArray getEntryData(const QModelIndex &index) const;
+    QMap<QString, QString> getModifiedEntries() const; // Entry name -> extracted file path
+    QStringList getRemovedEntries() const;
+
+    bool replaceResource(const QModelIndex &index, const QString &path = QString(), QWidget *parent = nullptr) override;
+    bool removeResource(const QModelIndex &index) override;
+    QString getResourcePath(const QModelIndex &index) const override;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &index) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+
+private:
+    struct Node
+    {
+        Node(Node *parent = nullptr, const QString &name = QString());
+        ~Node();
+
+        Node *parent;
+        int row;
+        QString name;
+        int entry = -1; // Index in the central directory, -1 for directories
+        quint64 size = 0;
+        quint64 compressedSize = 0;
+        quint32 modified = 0; // MS-DOS date and time
+        QVector<Node *> children;
+    };
+
+    Node *getNode(const QModelIndex &index) const;
+    void sortNode(Node *node, int column, Qt::SortOrder order);
+    void markRemoved(const Node *node);
+
+    QScopedPointer<ZipArchive> archive;
+    Node *root;
+    QString archivePath;
+    QString extractPath;
+    bool editable = false;
+    mutable QHash<int, QString> extractedEntries;
+    mutable QSet<int> convertedEntries; // Binary XML converted to text, can't be written back
+    QSet<int> removedEntries;
+    mutable QCache<int, QByteArray> cache; // Recently decompressed entries, cost in KiB
+    QFileIconProvider iconProvider;
+};
+
+#endif // ARCHIVEITEMSMODEL_H
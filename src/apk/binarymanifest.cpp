@@ -0,0 +1,172 @@
+#include "apk/binarymanifest.h"
+#include "base/ziparchive.h"
+
+bool BinaryManifest::read(const QByteArray &data)
+{
+    *this = BinaryManifest();
+    if (!xml.read(data)) {
+        return false;
+    }
+
+    const auto &nodes = xml.getNodes();
+    for (int i = 0; i < nodes.count(); ++i) {
+        const auto &node = nodes.at(i);
+        if (node.type != BinaryXml::Node::StartElement) {
+            continue;
+        }
+        const QString element = xml.getString(node.name);
+        auto value = [&](quint32 id, const QString &name) -> const BinaryXml::Attribute * {
+            return xml.findAttribute(node, id, name);
+        };
+        auto number = [&](const BinaryXml::Attribute *attribute) -> int {
+            if (attribute->type == BinaryXml::TypeIntDec || attribute->type == BinaryXml::TypeIntHex) {
+                return static_cast<int>(attribute->data);
+            }
+            return xml.getAttributeValue(*attribute).toInt();
+        };
+        if (element == "manifest") {
+            manifestNode = i;
+            if (auto attribute = value(0, "package")) {
+                packageName = xml.getAttributeValue(*attribute);
+            }
+            if (auto attribute = value(VersionCodeAttribute, "versionCode")) {
+                versionCode = number(attribute);
+            }
+            if (auto attribute = value(VersionNameAttribute, "versionName")) {
+                versionName = xml.getAttributeValue(*attribute);
+            }
+        } else if (element == "uses-sdk") {
+            usesSdkNode = i;
+            if (auto attribute = value(MinSdkVersionAttribute, "minSdkVersion")) {
+                minSdk = number(attribute);
+            }
+            if (auto attribute = value(TargetSdkVersionAttribute, "targetSdkVersion")) {
+                targetSdk = number(attribute);
+            }
+        } else if (element == "uses-permission" || element == "uses-permission-sdk-23") {
+            if (auto attribute = value(NameAttribute, "name")) {
+                permissions.append(xml.getAttributeValue(*attribute));
+            }
+        } else if (element == "application") {
+            applicationNode = i;
+            if (auto attribute = value(LabelAttribute, "label")) {
+                applicationLabel = xml.getAttributeValue(*attribute);
+            }
+            if (auto attribute = value(IconAttribute, "icon")) {
+                applicationIcon = attribute->type == BinaryXml::TypeReference ? attribute->data : 0;
+            }
+            if (auto attribute = value(DebuggableAttribute, "debuggable")) {
+                debuggable = attribute->data;
+            }
+        }
+    }
+
+    valid = !packageName.isEmpty();
+    return valid;
+}
+
+bool BinaryManifest::readFromApk(const QString &apkPath)
+{
+    ZipArchive apk(apkPath);
+    if (!apk.open()) {
+        return false;
+    }
+    return read(apk.read("AndroidManifest.xml"));
+}
+
+bool BinaryManifest::isValid() const
+{
+    return valid;
+}
+
+QString BinaryManifest::getPackageName() const
+{
+    return packageName;
+}
+
+int BinaryManifest::getVersionCode() const
+{
+    return versionCode;
+}
+
+QString BinaryManifest::getVersionName() const
+{
+    return versionName;
+}
+
+int BinaryManifest::getMinSdk() const
+{
+    return minSdk;
+}
+
+int BinaryManifest::getTargetSdk() const
+{
+    return targetSdk;
+}
+
+bool BinaryManifest::isDebuggable() const
+{
+    return debuggable;
+}
+
+QStringList BinaryManifest::getPermissions() const
+{
+    return permissions;
+}
+
+QString BinaryManifest::getApplicationLabel() const
+{
+    return applicationLabel;
+}
+
+quint32 BinaryManifest::getApplicationIcon() const
+{
+    return applicationIcon;
+}
+
+bool BinaryManifest::setVersionCode(int versionCode)
+{
+    if (!xml.setAttribute(manifestNode, VersionCodeAttribute, "versionCode", BinaryXml::TypeIntDec, static_cast<quint32>(versionCode))) {
+        return false;
+    }
+    this->versionCode = versionCode;
+    return true;
+}
+
+bool BinaryManifest::setVersionName(const QString &versionName)
+{
+    if (!xml.setAttribute(manifestNode, VersionNameAttribute, "versionName", BinaryXml::TypeString, 0, versionName)) {
+        return false;
+    }
+    this->versionName = versionName;
+    return true;
+}
+
+bool BinaryManifest::setMinSdk(int minSdk)
+{
+    // The <uses-sdk> element is always generated by aapt, so it isn't created here
+    if (!xml.setAttribute(usesSdkNode, MinSdkVersionAttribute, "minSdkVersion", BinaryXml::TypeIntDec, static_cast<quint32>(minSdk))) {
+        return false;
+    }
+    this->minSdk = minSdk;
+    return true;
+}
+
+bool BinaryManifest::setDebuggable(bool debuggable)
+{
+    if (!xml.setAttribute(applicationNode, DebuggableAttribute, "debuggable", BinaryXml::TypeIntBoolean, debuggable ? 0xFFFFFFFF : 0)) {
+        return false;
+    }
+    this->debuggable = debuggable;
+    return true;
+}
+
+const BinaryXml &BinaryManifest::getXml() const
+{
+    return xml;
+}
+
+QByteArray BinaryManifest::toBinary() const
+{
+    return xml.toBinary();
+}
@@ -0,0 +1,64 @@
+#ifndef BINARYMANIFEST_H
+#define BINARYMANIFEST_H
+
+#include "apk/binaryxml.h"
+
+// Basic package information read directly from the compiled "AndroidManifest.xml" (no decoding required).
+// The version, minimum SDK and debuggable flag can be patched and written back with toBinary().
+
+class BinaryManifest
+{
+public:
+    enum AttributeId : quint32 {
+        LabelAttribute = 0x01010001,
+        IconAttribute = 0x01010002,
+        NameAttribute = 0x01010003,
+        DebuggableAttribute = 0x0101000f,
+        MinSdkVersionAttribute = 0x0101020c,
+        VersionCodeAttribute = 0x0101021b,
+        VersionNameAttribute = 0x0101021c,
+        TargetSdkVersionAttribute = 0x01010270,
+        RoundIconAttribute = 0x0101052c
+    };
+
+    bool read(const QByteArray &data);
+    bool readFromApk(const QString &apkPath);
+    bool isValid() const;
+
+    QString getPackageName() const;
+    int getVersionCode() const;
+    QString getVersionName() const;
+    int getMinSdk() const;
+    int getTargetSdk() const;
+    bool isDebuggable() const;
+    QStringList getPermissions() const;
+    QString getApplicationLabel() const;
+    quint32 getApplicationIcon() const;
+
+    bool setVersionCode(int versionCode);
+    bool setVersionName(const QString &versionName);
+    bool setMinSdk(int minSdk);
+    bool setDebuggable(bool debuggable);
+
+    const BinaryXml &getXml() const;
+    QByteArray toBinary() const;
+
+private:
+    BinaryXml xml;
+    bool valid = false;
+    int manifestNode = -1;
+    int usesSdkNode = -1;
+    int applicationNode = -1;
+
+    QString packageName;
+    int versionCode = 0;
+    QString versionName;
+    int minSdk = 0;
+    int targetSdk = 0;
+    bool debuggable = false;
+    QStringList permissions;
+    QString applicationLabel;
+    quint32 applicationIcon = 0;
+};
+
+#endif // BINARYMANIFEST_H
@@ -0,0 +1,544 @@
+#include "apk/binaryxml.h"
+#include <QXmlStreamWriter>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+
+namespace
+{
+    enum ChunkType : quint16 {
+        StringPoolChunk = 0x0001,
+        XmlChunk = 0x0003,
+        ResourceMapChunk = 0x0180
+    };
+
+    const quint32 Utf8Flag = 1 << 8;
+    const quint32 NoEntry = 0xFFFFFFFF;
+    const quint16 ChunkHeaderSize = 8;
+    const quint16 StringPoolHeaderSize = 28;
+    const quint16 NodeHeaderSize = 16;
+    const quint16 AttributeSize = 20;
+    const quint16 ValueSize = 8;
+    const QString AndroidNamespace("http://schemas.android.com/apk/res/android");
+
+    template<typename T> T readValue(const uchar *data)
+    {
+        return qFromLittleEndian<T>(data);
+    }
+
+    qint32 readIndex(const uchar *data)
+    {
+        const quint32 index = readValue<quint32>(data);
+        return index == NoEntry ? -1 : static_cast<qint32>(index);
+    }
+
+    template<typename T> void appendValue(QByteArray &buffer, T value)
+    {
+        const T littleEndian = qToLittleEndian(value);
+        buffer.append(reinterpret_cast<const char *>(&littleEndian), sizeof(T));
+    }
+
+    void appendChunkHeader(QByteArray &buffer, quint16 type, quint16 headerSize, int size)
+    {
+        appendValue<quint16>(buffer, type);
+        appendValue<quint16>(buffer, headerSize);
+        appendValue<quint32>(buffer, static_cast<quint32>(size));
+    }
+}
+
+bool BinaryXml::read(const QByteArray &data)
+{
+    nodes.clear();
+    strings.clear();
+    styles.clear();
+    resourceIds.clear();
+
+    const auto begin = reinterpret_cast<const uchar *>(data.constData());
+    const auto end = begin + data.size();
+    if (data.size() < 8 || readValue<quint16>(begin) != XmlChunk) {
+        qWarning() << "Binary XML: invalid header";
+        return false;
+    }
+
+    const uchar *chunk = begin + readValue<quint16>(begin + 2);
+    while (chunk + 8 <= end) {
+        const quint16 type = readValue<quint16>(chunk);
+        const quint16 headerSize = readValue<quint16>(chunk + 2);
+        const quint32 size = readValue<quint32>(chunk + 4);
+        if (size < 8 || headerSize > size || size > quint64(end - chunk)) {
+            qWarning() << "Binary XML: invalid chunk";
+            return false;
+        }
+
+        switch (type) {
+        case StringPoolChunk: {
+            if (headerSize < 28) {
+                return false;
+            }
+            const quint32 stringCount = readValue<quint32>(chunk + 8);
+            const quint32 styleCount = readValue<quint32>(chunk + 12);
+            const quint32 flags = readValue<quint32>(chunk + 16);
+            const quint32 stringsStart = readValue<quint32>(chunk + 20);
+            const quint32 stylesStart = readValue<quint32>(chunk + 24);
+            // Offsets are validated as 64-bit integers, so that crafted values can't wrap around:
+            const uchar *offsets = chunk + headerSize;
+            if (headerSize + 4 * (quint64(stringCount) + styleCount) > size) {
+                return false;
+            }
+            utf8 = flags & Utf8Flag;
+            strings.reserve(static_cast<int>(stringCount));
+            for (quint32 i = 0; i < stringCount; ++i) {
+                const quint64 stringOffset = quint64(stringsStart) + readValue<quint32>(offsets + 4 * i);
+                if (stringOffset + 4 > size) {
+                    return false;
+                }
+                const uchar *string = chunk + stringOffset;
+                if (utf8) {
+                    // UTF-16 length (skipped), then UTF-8 byte length:
+                    string += (string[0] & 0x80) ? 2 : 1;
+                    int length = string[0];
+                    if (length & 0x80) {
+                        length = ((length & 0x7F) << 8) | string[1];
+                        string += 2;
+                    } else {
+                        string += 1;
+                    }
+                    if (quint64(string - chunk) + length > size) {
+                        return false;
+                    }
+                    strings.append(QString::fromUtf8(reinterpret_cast<const char *>(string), length));
+                } else {
+                    int length = readValue<quint16>(string);
+                    if (length & 0x8000) {
+                        length = ((length & 0x7FFF) << 16) | readValue<quint16>(string + 2);
+                        string += 4;
+                    } else {
+                        string += 2;
+                    }
+                    if (quint64(string - chunk) + 2 * quint64(length) > size) {
+                        return false;
+                    }
+                    QString value(length, Qt::Uninitialized);
+                    for (int c = 0; c < length; ++c) {
+                        value[c] = QChar(readValue<quint16>(string + 2 * c));
+                    }
+                    strings.append(value);
+                }
+            }
+            for (quint32 i = 0; i < styleCount; ++i) {
+                // Span entries (12 bytes each) up to the terminating NoEntry:
+                const quint64 styleOffset = quint64(stylesStart) + readValue<quint32>(offsets + 4 * (quint64(stringCount) + i));
+                quint64 spanOffset = styleOffset;
+                while (spanOffset + 4 <= size && readValue<quint32>(chunk + spanOffset) != NoEntry) {
+                    spanOffset += 12;
+                }
+                if (spanOffset + 4 > size) {
+                    qWarning() << "Binary XML: invalid style";
+                    return false;
+                }
+                styles.append(QByteArray(reinterpret_cast<const char *>(chunk + styleOffset), static_cast<int>(spanOffset - styleOffset + 4)));
+            }
+            break;
+        }
+        case ResourceMapChunk: {
+            const quint32 count = (size - headerSize) / 4;
+            resourceIds.reserve(static_cast<int>(count));
+            for (quint32 i = 0; i < count; ++i) {
+                resourceIds.append(readValue<quint32>(chunk + headerSize + 4 * i));
+            }
+            break;
+        }
+        case Node::StartNamespace:
+        case Node::EndNamespace:
+        case Node::StartElement:
+        case Node::EndElement:
+        case Node::CData: {
+            if (headerSize < 16 || size < headerSize + 8u) {
+                return false;
+            }
+            Node node;
+            node.type = static_cast<Node::Type>(type);
+            node.lineNumber = readValue<quint32>(chunk + 8);
+            node.comment = readIndex(chunk + 12);
+            const uchar *extension = chunk + headerSize;
+            node.ns = readIndex(extension);
+            node.name = readIndex(extension + 4);
+            node.idIndex = 0;
+            node.classIndex = 0;
+            node.styleIndex = 0;
+            node.dataType = TypeNull;
+            node.data = 0;
+            if (node.type == Node::StartElement) {
+                if (size < headerSize + 20u) {
+                    return false;
+                }
+                const quint16 attributeStart = readValue<quint16>(extension + 8);
+                const quint16 attributeSize = readValue<quint16>(extension + 10);
+                const quint16 attributeCount = readValue<quint16>(extension + 12);
+                node.idIndex = readValue<quint16>(extension + 14);
+                node.classIndex = readValue<quint16>(extension + 16);
+                node.styleIndex = readValue<quint16>(extension + 18);
+                if (attributeSize < 20 || headerSize + attributeStart + quint64(attributeSize) * attributeCount > size) {
+                    return false;
+                }
+                node.attributes.reserve(attributeCount);
+                for (int i = 0; i < attributeCount; ++i) {
+                    const uchar *attribute = extension + attributeStart + attributeSize * i;
+                    Attribute value;
+                    value.ns = readIndex(attribute);
+                    value.name = readIndex(attribute + 4);
+                    value.rawValue = readIndex(attribute + 8);
+                    value.type = attribute[15];
+                    value.data = readValue<quint32>(attribute + 16);
+                    node.attributes.append(value);
+                }
+            } else if (node.type == Node::CData) {
+                if (size < headerSize + 12u) {
+                    return false;
+                }
+                node.name = readIndex(extension);
+                node.dataType = extension[7];
+                node.data = readValue<quint32>(extension + 8);
+            }
+            nodes.append(node);
+            break;
+        }
+        default:
+            // Unknown chunks are skipped
+            break;
+        }
+
+        chunk += size;
+    }
+
+    return true;
+}
+
+const QVector<BinaryXml::Node> &BinaryXml::getNodes() const
+{
+    return nodes;
+}
+
+QString BinaryXml::getString(qint32 index) const
+{
+    return (index >= 0 && index < strings.count()) ? strings.at(index) : QString();
+}
+
+quint32 BinaryXml::getResourceId(qint32 stringIndex) const
+{
+    return (stringIndex >= 0 && stringIndex < resourceIds.count()) ? resourceIds.at(stringIndex) : 0;
+}
+
+QString BinaryXml::getAttributeName(const Attribute &attribute) const
+{
+    return getString(attribute.name);
+}
+
+QString BinaryXml::getAttributeValue(const Attribute &attribute) const
+{
+    if (attribute.type == TypeString) {
+        return getString(static_cast<qint32>(attribute.data));
+    }
+    if (attribute.type == TypeNull && attribute.rawValue != -1) {
+        return getString(attribute.rawValue);
+    }
+    return formatValue(attribute.type, attribute.data);
+}
+
+const BinaryXml::Attribute *BinaryXml::findAttribute(const Node &node, quint32 resourceId, const QString &name) const
+{
+    // Attribute names may be stripped by obfuscators, so resource IDs take precedence
+    for (const Attribute &attribute : node.attributes) {
+        const quint32 id = getResourceId(attribute.name);
+        if ((resourceId && id == resourceId) || (!name.isEmpty() && !id && getString(attribute.name) == name)) {
+            return &attribute;
+        }
+    }
+    return nullptr;
+}
+
+bool BinaryXml::setAttribute(int nodeIndex, quint32 resourceId, const QString &name, quint8 type, quint32 data, const QString &string)
+{
+    if (nodeIndex < 0 || nodeIndex >= nodes.count() || nodes.at(nodeIndex).type != Node::StartElement) {
+        return false;
+    }
+
+    int attributeIndex = -1;
+    if (const Attribute *existing = findAttribute(nodes.at(nodeIndex), resourceId, name)) {
+        attributeIndex = static_cast<int>(existing - nodes.at(nodeIndex).attributes.constData());
+    } else {
+        // Only framework attributes can be added, as they are resolved by their resource ID
+        if (!resourceId || !strings.contains(AndroidNamespace)) {
+            return false;
+        }
+        Attribute attribute;
+        attribute.name = addAttributeName(resourceId, name);
+        // Looked up after the name is added, as inserting into the resource-mapped strings shifts the indexes
+        attribute.ns = strings.indexOf(AndroidNamespace);
+
+        // The framework expects the attributes to be sorted by their resource ID
+        Node &node = nodes[nodeIndex];
+        attributeIndex = 0;
+        while (attributeIndex < node.attributes.count()) {
+            const quint32 id = getResourceId(node.attributes.at(attributeIndex).name);
+            if (!id || id > resourceId) {
+                break;
+            }
+            ++attributeIndex;
+        }
+        node.attributes.insert(attributeIndex, attribute);
+        for (quint16 *index : {&node.idIndex, &node.classIndex, &node.styleIndex}) {
+            if (*index > attributeIndex) {
+                ++*index; // One-based
+            }
+        }
+    }
+
+    // Value strings are appended after the attribute names, so no indexes are shifted here
+    const qint32 valueIndex = type == TypeString ? addString(string) : -1;
+    Attribute &attribute = nodes[nodeIndex].attributes[attributeIndex];
+    attribute.rawValue = valueIndex;
+    attribute.type = type;
+    attribute.data = type == TypeString ? static_cast<quint32>(valueIndex) : data;
+    return true;
+}
+
+qint32 BinaryXml::addString(const QString &string)
+{
+    const qint32 index = strings.indexOf(string);
+    if (index != -1) {
+        return index;
+    }
+    strings.append(string);
+    return strings.count() - 1;
+}
+
+qint32 BinaryXml::addAttributeName(quint32 resourceId, const QString &name)
+{
+    const qint32 index = resourceIds.indexOf(resourceId);
+    if (index != -1) {
+        return index;
+    }
+    // The resource map only covers the beginning of the string pool
+    const qint32 newIndex = resourceIds.count();
+    insertString(newIndex, name);
+    resourceIds.append(resourceId);
+    return newIndex;
+}
+
+void BinaryXml::insertString(qint32 index, const QString &string)
+{
+    strings.insert(index, string);
+    if (index < styles.count()) {
+        // Styles are matched with the strings by index
+        QByteArray noSpans;
+        appendValue<quint32>(noSpans, NoEntry);
+        styles.insert(index, noSpans);
+    }
+
+    auto shift = [index](qint32 &value) {
+        if (value >= index) {
+            ++value;
+        }
+    };
+    for (Node &node : nodes) {
+        shift(node.comment);
+        shift(node.ns);
+        shift(node.name);
+        for (Attribute &attribute : node.attributes) {
+            shift(attribute.ns);
+            shift(attribute.name);
+            shift(attribute.rawValue);
+            if (attribute.type == TypeString) {
+                qint32 value = static_cast<qint32>(attribute.data);
+                shift(value);
+                attribute.data = static_cast<quint32>(value);
+            }
+        }
+    }
+}
+
+QByteArray BinaryXml::toXml() const
+{
+    QByteArray output;
+    QXmlStreamWriter writer(&output);
+    writer.setAutoFormatting(true);
+    writer.setAutoFormattingIndent(4);
+    writer.writeStartDocument();
+    for (const Node &node : nodes) {
+        switch (node.type) {
+        case Node::StartNamespace:
+            // Applies to the next element written
+            writer.writeNamespace(getString(node.name), getString(node.ns));
+            break;
+        case Node::StartElement:
+            writer.writeStartElement(getString(node.ns), getString(node.name));
+            for (const Attribute &attribute : node.attributes) {
+                QString name = getAttributeName(attribute);
+                if (name.isEmpty()) {
+                    // Stripped by an obfuscator
+                    name = QString("_0x%1").arg(getResourceId(attribute.name), 8, 16, QChar('0'));
+                }
+                writer.writeAttribute(getString(attribute.ns), name, getAttributeValue(attribute));
+            }
+            break;
+        case Node::EndElement:
+            writer.writeEndElement();
+            break;
+        case Node::CData:
+            writer.writeCharacters(getString(node.name));
+            break;
+        case Node::EndNamespace:
+            break;
+        }
+    }
+    writer.writeEndDocument();
+    return output;
+}
+
+QByteArray BinaryXml::toBinary() const
+{
+    // String pool:
+
+    QByteArray offsets;
+    QByteArray stringData;
+    for (const QString &string : strings) {
+        appendValue<quint32>(offsets, static_cast<quint32>(stringData.size()));
+        if (utf8) {
+            const QByteArray bytes = string.toUtf8();
+            for (const int length : {string.size(), bytes.size()}) {
+                if (length > 0x7F) {
+                    stringData.append(static_cast<char>(((length >> 8) & 0x7F) | 0x80));
+                }
+                stringData.append(static_cast<char>(length & 0xFF));
+            }
+            stringData.append(bytes);
+            stringData.append('\0');
+        } else {
+            const int length = string.size();
+            if (length > 0x7FFF) {
+                appendValue<quint16>(stringData, static_cast<quint16>(((length >> 16) & 0x7FFF) | 0x8000));
+            }
+            appendValue<quint16>(stringData, static_cast<quint16>(length & 0xFFFF));
+            for (const QChar c : string) {
+                appendValue<quint16>(stringData, c.unicode());
+            }
+            appendValue<quint16>(stringData, 0);
+        }
+    }
+    stringData.append((4 - stringData.size() % 4) % 4, '\0');
+
+    QByteArray styleData;
+    for (const QByteArray &style : styles) {
+        appendValue<quint32>(offsets, static_cast<quint32>(styleData.size()));
+        styleData.append(style);
+    }
+    if (!styles.isEmpty()) {
+        // Terminates the style list, as aapt does
+        appendValue<quint32>(styleData, NoEntry);
+        appendValue<quint32>(styleData, NoEntry);
+    }
+
+    const int stringsStart = StringPoolHeaderSize + offsets.size();
+    QByteArray body;
+    appendChunkHeader(body, StringPoolChunk, StringPoolHeaderSize, stringsStart + stringData.size() + styleData.size());
+    appendValue<quint32>(body, static_cast<quint32>(strings.count()));
+    appendValue<quint32>(body, static_cast<quint32>(styles.count()));
+    appendValue<quint32>(body, utf8 ? Utf8Flag : 0);
+    appendValue<quint32>(body, static_cast<quint32>(stringsStart));
+    appendValue<quint32>(body, styles.isEmpty() ? 0 : static_cast<quint32>(stringsStart + stringData.size()));
+    body.append(offsets);
+    body.append(stringData);
+    body.append(styleData);
+
+    // Resource map:
+
+    if (!resourceIds.isEmpty()) {
+        appendChunkHeader(body, ResourceMapChunk, ChunkHeaderSize, ChunkHeaderSize + 4 * resourceIds.count());
+        for (const quint32 id : resourceIds) {
+            appendValue<quint32>(body, id);
+        }
+    }
+
+    // Nodes:
+
+    for (const Node &node : nodes) {
+        QByteArray extension;
+        switch (node.type) {
+        case Node::StartNamespace:
+        case Node::EndNamespace:
+        case Node::EndElement:
+            appendValue<qint32>(extension, node.ns);
+            appendValue<qint32>(extension, node.name);
+            break;
+        case Node::StartElement:
+            appendValue<qint32>(extension, node.ns);
+            appendValue<qint32>(extension, node.name);
+            appendValue<quint16>(extension, AttributeSize); // Attribute start, right after this extension
+            appendValue<quint16>(extension, AttributeSize);
+            appendValue<quint16>(extension, static_cast<quint16>(node.attributes.count()));
+            appendValue<quint16>(extension, node.idIndex);
+            appendValue<quint16>(extension, node.classIndex);
+            appendValue<quint16>(extension, node.styleIndex);
+            for (const Attribute &attribute : node.attributes) {
+                appendValue<qint32>(extension, attribute.ns);
+                appendValue<qint32>(extension, attribute.name);
+                appendValue<qint32>(extension, attribute.rawValue);
+                appendValue<quint16>(extension, ValueSize);
+                appendValue<quint8>(extension, 0);
+                appendValue<quint8>(extension, attribute.type);
+                appendValue<quint32>(extension, attribute.data);
+            }
+            break;
+        case Node::CData:
+            appendValue<qint32>(extension, node.name);
+            appendValue<quint16>(extension, ValueSize);
+            appendValue<quint8>(extension, 0);
+            appendValue<quint8>(extension, node.dataType);
+            appendValue<quint32>(extension, node.data);
+            break;
+        }
+        appendChunkHeader(body, node.type, NodeHeaderSize, NodeHeaderSize + extension.size());
+        appendValue<quint32>(body, node.lineNumber);
+        appendValue<qint32>(body, node.comment);
+        body.append(extension);
+    }
+
+    QByteArray output;
+    appendChunkHeader(output, XmlChunk, ChunkHeaderSize, ChunkHeaderSize + body.size());
+    output.append(body);
+    return output;
+}
+
+bool BinaryXml::isBinaryXml(const QByteArray &data)
+{
+    return data.size() >= 8 && readValue<quint16>(reinterpret_cast<const uchar *>(data.constData())) == XmlChunk;
+}
+
+QString BinaryXml::formatValue(quint8 type, quint32 data)
+{
+    switch (type) {
+    case TypeNull:
+        return QString();
+    case TypeReference:
+        return QString("@0x%1").arg(data, 8, 16, QChar('0'));
+    case TypeAttribute:
+        return QString("?0x%1").arg(data, 8, 16, QChar('0'));
+    case TypeFloat: {
+        float value;
+        std::memcpy(&value, &data, sizeof(value));
+        return QString::number(value);
+    }
+    case TypeIntDec:
+        return QString::number(static_cast<qint32>(data));
+    case TypeIntBoolean:
+        return data ? "true" : "false";
+    case TypeIntColorArgb8:
+    case TypeIntColorRgb8:
+    case TypeIntColorArgb4:
+    case TypeIntColorRgb4:
+        return QString("#%1").arg(data, 8, 16, QChar('0'));
+    default:
+        return QString("0x%1").arg(data, 8, 16, QChar('0'));
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef BINARYXML_H
+#define BINARYXML_H
+
+#include <QStringList>
+#include <QVector>
+
+// Android binary XML (AXML) document, as stored in the compiled APK (e.g., "AndroidManifest.xml").
+// Attribute values can be modified in place and written back without recompiling the document.
+
+class BinaryXml
+{
+public:
+    enum ValueType : quint8 {
+        TypeNull = 0x00,
+        TypeReference = 0x01,
+        TypeAttribute = 0x02,
+        TypeString = 0x03,
+        TypeFloat = 0x04,
+        TypeDimension = 0x05,
+        TypeFraction = 0x06,
+        TypeIntDec = 0x10,
+        TypeIntHex = 0x11,
+        TypeIntBoolean = 0x12,
+        TypeIntColorArgb8 = 0x1c,
+        TypeIntColorRgb8 = 0x1d,
+        TypeIntColorArgb4 = 0x1e,
+        TypeIntColorRgb4 = 0x1f
+    };
+
+    struct Attribute
+    {
+        qint32 ns;
+        qint32 name;
+        qint32 rawValue;
+        quint8 type;
+        quint32 data;
+    };
+
+    struct Node
+    {
+        enum Type : quint16 {
+            StartNamespace = 0x0100,
+            EndNamespace = 0x0101,
+            StartElement = 0x0102,
+            EndElement = 0x0103,
+            CData = 0x0104
+        };
+
+        Type type;
+        quint32 lineNumber;
+        qint32 comment;
+        qint32 ns; // Namespace prefix for namespace nodes, namespace URI for elements
+        qint32 name; // Namespace URI for namespace nodes, text for CDATA nodes
+        quint16 idIndex;
+        quint16 classIndex;
+        quint16 styleIndex;
+        QVector<Attribute> attributes;
+        quint8 dataType; // Typed value for CDATA nodes
+        quint32 data;
+    };
+
+    bool read(const QByteArray &data);
+
+    const QVector<Node> &getNodes() const;
+    QString getString(qint32 index) const;
+    quint32 getResourceId(qint32 stringIndex) const;
+
+    QString getAttributeName(const Attribute &attribute) const;
+    QString getAttributeValue(const Attribute &attribute) const;
+    const Attribute *findAttribute(const Node &node, quint32 resourceId, const QString &name = QString()) const;
+    bool setAttribute(int nodeIndex, quint32 resourceId, const QString &name, quint8 type, quint32 data, const QString &string = QString());
+    QByteArray toXml() const;
+    QByteArray toBinary() const;
+
+    static bool isBinaryXml(const QByteArray &data);
+
+    static QString formatValue(quint8 type, quint32 data);
+
+protected:
+    qint32 addString(const QString &string);
+    qint32 addAttributeName(quint32 resourceId, const QString &name);
+    void insertString(qint32 index, const QString &string);
+
+    QVector<Node> nodes;
+    QStringList strings;
+    QVector<QByteArray> styles; // Raw span data, kept as is
+    QVector<quint32> resourceIds; // Attribute resource IDs, indexed by string pool index
+    bool utf8 = false;
+};
+
+#endif // BINARYXML_H
@@ -5,6 +5,7 @@
 #include "base/utils.h"
 #include <QDebug>
 #include <QDir>
+#include <QSet>
 
 IconItemsModel::IconItemsModel(QObject *parent) : QAbstractProxyModel(parent)
 {
@@ -43,8 +44,12 @@ void IconItemsModel::setSourceModel(QAbstractItemModel *newSourceModel)
 
 void IconItemsModel::setManifestScopes(const QList<ManifestScope *> &scopes)
 {
-    this->scopes = scopes;
-    sourceModelReset();
+    // Icons only have to be rediscovered if the drawables referenced by the manifest have changed:
+    IconReferenceIndex references = buildIconReferences(scopes);
+    if (references != iconReferences) {
+        iconReferences = references;
+        sourceModelReset();
+    }
 }
 
 ResourceItemsModel *IconItemsModel::sourceModel() const
@@ -244,40 +249,21 @@ void IconItemsModel::sort(int column, Qt::SortOrder order)
     const QList<QPersistentModelIndex> rootIndexes{applicationIndex, activitiesIndex};
     emit layoutAboutToBeChanged(rootIndexes, QAbstractItemModel::VerticalSortHint);
 
-    auto comparator = [this](TreeNode *node1, TreeNode *node2) -> bool {
-        auto icon1 = static_cast<IconNode *>(node1);
-        auto icon2 = static_cast<IconNode *>(node2);
-        auto index1 = proxyToSourceMap.value(icon1);
-        auto index2 = proxyToSourceMap.value(icon2);
-        const bool swap = ![&]() -> bool {
-            if (icon1->iconType < icon2->iconType) { return true; }
-            if (icon2->iconType < icon1->iconType) { return false; }
-            auto dpi1 = index1.sibling(index1.row(), ResourceItemsModel::DpiColumn).data(ResourceItemsModel::SortRole);
-            auto dpi2 = index2.sibling(index2.row(), ResourceItemsModel::DpiColumn).data(ResourceItemsModel::SortRole);
-            if (dpi1 < dpi2) { return true; }
-            if (dpi2 < dpi1) { return false; }
-            return false;
-        }();
-        if (swap) {
-            changePersistentIndex(mapFromSource(index1), mapFromSource(index2));
-        }
-        return !swap;
-    };
-
-    auto &applicationIcons = applicationNode->getChildren();
-    std::sort(applicationIcons.begin(), applicationIcons.end(), comparator);
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QVector<TreeNode *> nodes;
+    nodes.reserve(oldIndexes.size());
+    for (const QModelIndex &index : oldIndexes) {
+        nodes.append(static_cast<TreeNode *>(index.internalPointer()));
+    }
 
-    auto &activityScopes = activitiesNode->getChildren();
-    std::sort(activityScopes.begin(), activityScopes.end(), [](const TreeNode *node1, const TreeNode *node2) -> bool {
-        auto activity1 = static_cast<const ActivityNode *>(node1);
-        auto activity2 = static_cast<const ActivityNode *>(node2);
-        return activity1->scope->type() < activity2->scope->type();
-    });
+    sortIcons();
 
-    for (auto activityNode : activityScopes) {
-        auto &activityIcons = activityNode->getChildren();
-        std::sort(activityIcons.begin(), activityIcons.end(), comparator);
+    QModelIndexList newIndexes;
+    newIndexes.reserve(oldIndexes.size());
+    for (int i = 0; i < oldIndexes.size(); ++i) {
+        newIndexes.append(createIndex(nodes.at(i)->row(), oldIndexes.at(i).column(), nodes.at(i)));
     }
+    changePersistentIndexList(oldIndexes, newIndexes);
 
     emit layoutChanged(rootIndexes, QAbstractItemModel::VerticalSortHint);
 }
@@ -314,86 +300,148 @@ bool IconItemsModel::removeRows(int row, int count, const QModelIndex &parent)
     return sourceModel()->removeRows(index.row(), count, index.parent());
 }
 
-bool IconItemsModel::appendIcon(const QPersistentModelIndex &iconIndex, ManifestScope *scope, IconType iconType)
-{
-    if (!sourceToProxyMap.contains(iconIndex)) {
-        switch (scope->type()) {
-        case ManifestScope::Type::Application: {
-            const int row = applicationNode->childCount();
-            beginInsertRows(index(ApplicationRow, 0), row, row);
-                auto iconNode = new IconNode(iconType);
-                applicationNode->addChild(iconNode);
-                sourceToProxyMap.insert(iconIndex, iconNode);
-                proxyToSourceMap.insert(iconNode, iconIndex);
-            endInsertRows();
-            sort();
-            return true;
-        }
-        case ManifestScope::Type::Activity: {
-            ActivityNode *activityNode = nullptr;
-            // Try to find existing activity node:
-            const auto iconNodes = activitiesNode->getChildren();
-            for (auto node : iconNodes) {
-                auto interimActivityNode = static_cast<ActivityNode *>(node);
-                if (scope == interimActivityNode->scope) {
-                    activityNode = interimActivityNode;
-                    break;
-                }
+IconItemsModel::IconReferenceIndex IconItemsModel::buildIconReferences(const QList<ManifestScope *> &scopes)
+{
+    IconReferenceIndex references;
+    for (ManifestScope *scope : scopes) {
+        // A drawable referenced by several attributes of the same scope is only listed with the first icon type:
+        QSet<QPair<QString, QString>> scopeKeys;
+        auto addReference = [&](const ManifestAttribute &attribute, IconType type) {
+            const QPair<QString, QString> key(attribute.getResourceType(), attribute.getResourceName());
+            if (!key.first.isEmpty() && !key.second.isEmpty() && !scopeKeys.contains(key)) {
+                scopeKeys.insert(key);
+                references[key].append({scope, type});
             }
-            if (!activityNode) {
-                // Create new activity node:
-                const int row = activitiesNode->childCount();
+        };
+        addReference(scope->icon(), TypeIcon);
+        addReference(scope->roundIcon(), TypeRoundIcon);
+        addReference(scope->banner(), TypeBanner);
+    }
+    return references;
+}
+
+QVector<IconItemsModel::IconReference> IconItemsModel::findIconReferences(const QModelIndex &sourceIndex) const
+{
+    if (iconReferences.isEmpty()) {
+        return {};
+    }
+    const auto resource = sourceModel()->getResourceFile(sourceIndex);
+    if (!resource) {
+        return {};
+    }
+    const auto references = iconReferences.value(qMakePair(resource->getType(), resource->getName()));
+    if (references.isEmpty() || !Utils::isDrawableResource(resource->getFilePath())) {
+        return {};
+    }
+    return references;
+}
+
+bool IconItemsModel::appendIcon(const QPersistentModelIndex &iconIndex, const IconReference &reference, bool notify)
+{
+    // Notifications are omitted while the model is being reset
+    if (sourceToProxyMap.contains(iconIndex)) {
+        return false;
+    }
+    TreeNode *parentNode = nullptr;
+    switch (reference.scope->type()) {
+    case ManifestScope::Type::Application:
+        parentNode = applicationNode;
+        break;
+    case ManifestScope::Type::Activity: {
+        ActivityNode *activityNode = activityNodes.value(reference.scope);
+        if (!activityNode) {
+            const int row = activitiesNode->childCount();
+            if (notify) {
                 beginInsertRows(index(ActivitiesRow, 0), row, row);
-                    activityNode = new ActivityNode(scope);
-                    activitiesNode->addChild(activityNode);
+            }
+            activityNode = new ActivityNode(reference.scope);
+            activitiesNode->addChild(activityNode);
+            activityNodes.insert(reference.scope, activityNode);
+            if (notify) {
                 endInsertRows();
             }
-            const QModelIndex activityIndex = index(activityNode->row(), 0, index(ActivitiesRow, 0));
-            const int row = activityNode->childCount();
-            beginInsertRows(activityIndex, row, row);
-                auto iconNode = new IconNode(iconType);
-                activityNode->addChild(iconNode);
-                sourceToProxyMap.insert(iconIndex, iconNode);
-                proxyToSourceMap.insert(iconNode, iconIndex);
-            endInsertRows();
-            sort();
-            return true;
-        }
         }
+        parentNode = activityNode;
+        break;
+    }
+    }
+    if (!parentNode) {
+        return false;
     }
-    return false;
+    const int row = parentNode->childCount();
+    if (notify) {
+        const QModelIndex parentIndex = parentNode == applicationNode
+            ? index(ApplicationRow, 0)
+            : index(parentNode->row(), 0, index(ActivitiesRow, 0));
+        beginInsertRows(parentIndex, row, row);
+    }
+    auto iconNode = new IconNode(reference.type);
+    parentNode->addChild(iconNode);
+    sourceToProxyMap.insert(iconIndex, iconNode);
+    proxyToSourceMap.insert(iconNode, iconIndex);
+    if (notify) {
+        endInsertRows();
+    }
+    return true;
 }
 
 void IconItemsModel::populateFromSource(const QModelIndex &parent)
 {
     const int rows = sourceModel()->rowCount(parent);
-    sourceRowsInserted(parent, 0, rows);
     for (int row = 0; row < rows; ++row) {
-        populateFromSource(sourceModel()->index(row, 0, parent));
+        const QModelIndex index = sourceModel()->index(row, 0, parent);
+        const auto references = findIconReferences(index);
+        for (const IconReference &reference : references) {
+            appendIcon(index, reference, false);
+        }
+        populateFromSource(index);
+    }
+}
+
+void IconItemsModel::sortIcons()
+{
+    auto comparator = [this](TreeNode *node1, TreeNode *node2) -> bool {
+        auto icon1 = static_cast<IconNode *>(node1);
+        auto icon2 = static_cast<IconNode *>(node2);
+        if (icon1->iconType != icon2->iconType) {
+            return icon1->iconType < icon2->iconType;
+        }
+        const QModelIndex index1 = proxyToSourceMap.value(icon1);
+        const QModelIndex index2 = proxyToSourceMap.value(icon2);
+        const auto dpi1 = index1.sibling(index1.row(), ResourceItemsModel::DpiColumn).data(ResourceItemsModel::SortRole);
+        const auto dpi2 = index2.sibling(index2.row(), ResourceItemsModel::DpiColumn).data(ResourceItemsModel::SortRole);
+        return dpi1 < dpi2;
+    };
+
+    auto &applicationIcons = applicationNode->getChildren();
+    std::sort(applicationIcons.begin(), applicationIcons.end(), comparator);
+
+    auto &activityScopes = activitiesNode->getChildren();
+    std::sort(activityScopes.begin(), activityScopes.end(), [](const TreeNode *node1, const TreeNode *node2) -> bool {
+        auto activity1 = static_cast<const ActivityNode *>(node1);
+        auto activity2 = static_cast<const ActivityNode *>(node2);
+        return activity1->scope->type() < activity2->scope->type();
+    });
+
+    for (auto activityNode : activityScopes) {
+        auto &activityIcons = activityNode->getChildren();
+        std::sort(activityIcons.begin(), activityIcons.end(), comparator);
     }
 }
 
 void IconItemsModel::sourceRowsInserted(const QModelIndex &parent, int first, int last)
 {
+    bool appended = false;
     for (int row = first; row <= last; ++row) {
         const auto index = sourceModel()->index(row, 0, parent);
-        const auto resource = sourceModel()->getResourceFile(index);
-        if (resource && Utils::isDrawableResource(resource->getFilePath())) {
-            auto resourceName = resource->getName();
-            auto resourceType = resource->getType();
-            if (!resourceName.isEmpty() && !resourceType.isEmpty()) {
-                for (ManifestScope *scope : qAsConst(scopes)) {
-                    if (resourceName == scope->icon().getResourceName() && resourceType == scope->icon().getResourceType()) {
-                        appendIcon(index, scope, TypeIcon);
-                    } else if (resourceName == scope->roundIcon().getResourceName() && resourceType == scope->roundIcon().getResourceType()) {
-                        appendIcon(index, scope, TypeRoundIcon);
-                    } else if (resourceName == scope->banner().getResourceName() && resourceType == scope->banner().getResourceType()) {
-                        appendIcon(index, scope, TypeBanner);
-                    }
-                }
-            }
+        const auto references = findIconReferences(index);
+        for (const IconReference &reference : references) {
+            appended |= appendIcon(index, reference);
         }
     }
+    if (appended) {
+        sort();
+    }
 }
 
 void IconItemsModel::sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
@@ -425,8 +473,15 @@ void IconItemsModel::sourceModelReset()
     proxyToSourceMap.clear();
     applicationNode->removeChildren();
     activitiesNode->removeChildren();
+    activityNodes.clear();
     populateFromSource();
+    sortIcons();
     endResetModel();
+
+    // Drawables are read on demand, their icons are added as the rows are inserted
+    for (auto it = iconReferences.constBegin(); it != iconReferences.constEnd(); ++it) {
+        sourceModel()->fetchResource(it.key().first, it.key().second);
+    }
 }
 
 void IconItemsModel::ActivityNode::addChild(IconItemsModel::IconNode *node)
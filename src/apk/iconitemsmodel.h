@@ -76,14 +76,28 @@ private:
         const ManifestScope *scope;
     };
 
-    bool appendIcon(const QPersistentModelIndex &index, ManifestScope *scope, IconType type = TypeIcon);
+    struct IconReference
+    {
+        ManifestScope *scope;
+        IconType type;
+        bool operator==(const IconReference &other) const { return scope == other.scope && type == other.type; }
+    };
+
+    // Manifest icon references by drawable (type, name), e.g., ("mipmap", "ic_launcher")
+    typedef QHash<QPair<QString, QString>, QVector<IconReference>> IconReferenceIndex;
+
+    static IconReferenceIndex buildIconReferences(const QList<ManifestScope *> &scopes);
+    QVector<IconReference> findIconReferences(const QModelIndex &sourceIndex) const;
+    bool appendIcon(const QPersistentModelIndex &index, const IconReference &reference, bool notify = true);
     void populateFromSource(const QModelIndex &parent = {});
+    void sortIcons();
     void sourceRowsInserted(const QModelIndex &parent, int first, int last);
     void sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
     void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
     void sourceModelReset();
 
-    QList<ManifestScope *> scopes;
+    IconReferenceIndex iconReferences;
+    QHash<const ManifestScope *, ActivityNode *> activityNodes;
     QHash<QPersistentModelIndex, IconNode *> sourceToProxyMap;
     QHash<IconNode *, QPersistentModelIndex> proxyToSourceMap;
     TreeNode *root;
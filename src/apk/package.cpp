@@ -1,13 +1,21 @@
 #include "apk/package.h"
+#include "apk/resourcetable.h"
+#include "apk/smalichecker.h"
 #include "base/application.h"
+#include "base/multireplacer.h"
 #include "base/settings.h"
+#include "base/zippatcher.h"
 #include "base/utils.h"
 #include "tools/adb.h"
 #include "tools/apktool.h"
 #include "tools/apksigner.h"
 #include "tools/keystore.h"
 #include "tools/zipalign.h"
+#include <QDirIterator>
+#include <QPersistentModelIndex>
+#include <QSharedPointer>
 #include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrent>
 #include <QUuid>
 #include <QDebug>
 
@@ -50,7 +58,12 @@ QString Package::getContentsPath() const
 
 QString Package::getPackageName() const
 {
-    return manifest->getPackageName();
+    return manifest ? manifest->getPackageName() : binaryManifest.getPackageName();
+}
+
+const BinaryManifest &Package::getBinaryManifest() const
+{
+    return binaryManifest;
 }
 
 QIcon Package::getThumbnail() const
@@ -64,14 +77,57 @@ const PackageState &Package::getState() const
     return state;
 }
 
+void Package::setModified(bool modified)
+{
+    state.setModified(modified);
+}
+
 bool Package::hasSourcesUnpacked() const
 {
     return withSources;
 }
 
+bool Package::openForPatching()
+{
+    if (state.isUnpacked() || !binaryManifest.isValid() || archiveModel.getArchivePath().isEmpty()) {
+        return false;
+    }
+    archiveModel.setEditable(true);
+    connect(&archiveModel, &ArchiveItemsModel::dataChanged, this, [=]() {
+        state.setModified(true);
+    });
+    connect(&archiveModel, &ArchiveItemsModel::rowsRemoved, this, [=]() {
+        state.setModified(true);
+    });
+    state.setPatchable(true);
+    return true;
+}
+
 void Package::setApplicationIcon(const QString &path, QWidget *parent)
 {
-    iconsProxy.replaceApplicationIcons(path, parent);
+    if (state.isUnpacked()) {
+        iconsProxy.replaceApplicationIcons(path, parent);
+        return;
+    }
+    if (!state.isPatchable()) {
+        return;
+    }
+
+    // Without the decoded resources, the icon files are resolved through the compiled resource table
+    ResourceTable table(archiveModel.getArchivePath());
+    if (!table.open()) {
+        return;
+    }
+    const auto entries = table.findEntries(binaryManifest.getApplicationIcon());
+    for (const auto entry : entries) {
+        if (entry->complex || entry->value.type != BinaryXml::TypeString) {
+            continue;
+        }
+        const QString iconPath = table.formatValue(entry->value);
+        if (Utils::isImageReadable(iconPath)) {
+            archiveModel.replaceResource(archiveModel.findIndex(iconPath), path, parent);
+        }
+    }
 }
 
 bool Package::setPackageName(const QString &packageName)
@@ -83,7 +139,6 @@ bool Package::setPackageName(const QString &packageName)
     auto packagePath = packageName;
     packagePath.replace('.', '/');
 
-    const auto originalPackageName = getPackageName();
     auto originalPackagePath = getPackageName();
     originalPackagePath.replace('.', '/');
 
@@ -97,51 +152,11 @@ bool Package::setPackageName(const QString &packageName)
 
     manifest->setPackageName(packageName);
 
-    // Update references in resources:
-
-    const auto resourcesPath = contentsPath + "/res/";
-    QDirIterator files(resourcesPath, QDir::Files, QDirIterator::Subdirectories);
-    while (files.hasNext()) {
-        const QString path(files.next());
-        QFile file(path);
-        if (file.open(QFile::ReadWrite)) {
-            const QString data(file.readAll());
-            QString newData(data);
-            newData.replace(originalPackageName, packageName);
-            if (newData != data) {
-                file.resize(0);
-                file.write(newData.toUtf8());
-            }
-            file.close();
-        }
-    }
+    // Update directory structure:
 
     const auto smaliDirs = QDir(contentsPath).entryList({"smali*"}, QDir::Dirs);
     for (const auto &smaliDir : smaliDirs) {
-
         const auto smaliPath = QString("%1/%2/").arg(contentsPath, smaliDir);
-
-        // Update references in smali:
-
-        QDirIterator files(smaliPath, QDir::Files, QDirIterator::Subdirectories);
-        while (files.hasNext()) {
-            const QString path(files.next());
-            QFile file(path);
-            if (file.open(QFile::ReadWrite)) {
-                const QString data(file.readAll());
-                QString newData(data);
-                newData.replace('L' + originalPackagePath, 'L' + packagePath);
-                newData.replace(originalPackageName, packageName);
-                if (newData != data) {
-                    file.resize(0);
-                    file.write(newData.toUtf8());
-                }
-                file.close();
-            }
-        }
-
-        // Update directory structure:
-
         const auto fullPackagePath = smaliPath + packagePath;
         const auto fullOriginalPackagePath = smaliPath + originalPackagePath;
         if (!QDir().exists(fullOriginalPackagePath)) {
@@ -157,6 +172,62 @@ bool Package::setPackageName(const QString &packageName)
     return true;
 }
 
+bool Package::patchBinaryManifest(int versionCode, const QString &versionName, int minSdk, bool debuggable)
+{
+    if (!state.isPatchable()) {
+        return false;
+    }
+
+    // Only the changed attributes are touched, so that no new attributes are added needlessly
+    BinaryManifest patched = binaryManifest;
+    if ((versionCode != patched.getVersionCode() && !patched.setVersionCode(versionCode))
+            || (versionName != patched.getVersionName() && !patched.setVersionName(versionName))
+            || (minSdk != patched.getMinSdk() && !patched.setMinSdk(minSdk))
+            || (debuggable != patched.isDebuggable() && !patched.setDebuggable(debuggable))) {
+        return false;
+    }
+
+    binaryManifest = patched;
+    binaryManifestPatched = true;
+    state.setModified(true);
+    return true;
+}
+
+QFuture<QString> Package::replacePackageNameReferences(const QString &packageName, bool dryRun)
+{
+    const auto originalPackageName = getPackageName();
+    if (!withSources || packageName.isEmpty() || originalPackageName.isEmpty()) {
+        return {};
+    }
+
+    auto packagePath = packageName;
+    packagePath.replace('.', '/');
+    auto originalPackagePath = originalPackageName;
+    originalPackagePath.replace('.', '/');
+
+    // Type descriptors (e.g., "Lcom/example/Class;") are only replaced in smali
+    const MultiReplacer resourcesReplacer({
+        {originalPackageName.toUtf8(), packageName.toUtf8()},
+    });
+    const MultiReplacer smaliReplacer({
+        {('L' + originalPackagePath).toUtf8(), ('L' + packagePath).toUtf8()},
+        {originalPackageName.toUtf8(), packageName.toUtf8()},
+    });
+
+    const auto contentsPath = getContentsPath();
+    QStringList smaliPaths;
+    const auto smaliDirs = QDir(contentsPath).entryList({"smali*"}, QDir::Dirs);
+    for (const auto &smaliDir : smaliDirs) {
+        smaliPaths.append(QString("%1/%2/").arg(contentsPath, smaliDir));
+    }
+
+    // Only the files containing the original package name are rewritten
+    return MultiReplacer::replaceInFiles({
+        {resourcesReplacer, {contentsPath + "/res/"}},
+        {smaliReplacer, smaliPaths},
+    }, dryRun);
+}
+
 Commands *Package::createCommandChain()
 {
     auto command = new Commands(this);
@@ -173,6 +244,16 @@ Commands *Package::createCommandChain()
     return command;
 }
 
+Command *Package::createReadCommand()
+{
+    auto read = new ReadCommand(this);
+    connect(read, &Command::started, this, [=]() {
+        logModel.add(tr("Reading APK..."));
+        state.setCurrentStatus(PackageState::Status::Unpacking);
+    });
+    return read;
+}
+
 Command *Package::createUnpackCommand()
 {
     QString target;
@@ -198,6 +279,8 @@ Command *Package::createUnpackCommand()
     connect(apktoolDecode, &Command::finished, this, [=](bool success) {
         if (success) {
             filesystemModel.setRootPath(getContentsPath());
+            archiveModel.close();
+            smaliCheckTime = QDateTime::currentDateTime();
         } else {
             logModel.add(tr("Error unpacking APK."), apktoolDecode->output(), LogEntry::Error);
         }
@@ -234,6 +317,16 @@ Command *Package::createUnpackCommand()
     return command;
 }
 
+Command *Package::createSmaliCheckCommand()
+{
+    auto smaliCheck = new SmaliCheckCommand(this);
+    connect(smaliCheck, &Command::started, this, [=]() {
+        logModel.add(tr("Checking smali files..."));
+        state.setCurrentStatus(PackageState::Status::Packing);
+    });
+    return smaliCheck;
+}
+
 Command *Package::createPackCommand(const QString &target)
 {
     const QString source = getContentsPath();
@@ -261,6 +354,37 @@ Command *Package::createPackCommand(const QString &target)
     return apktoolBuild;
 }
 
+Command *Package::createPatchCommand(const QString &target)
+{
+    auto patch = new PatchCommand(this, target);
+
+    connect(patch, &Command::started, this, [=]() {
+        qDebug() << qPrintable(QString("Patching\n  from: %1\n    to: %2\n").arg(getOriginalPath(), target));
+        logModel.add(tr("Patching APK..."));
+        state.setCurrentStatus(PackageState::Status::Packing);
+    });
+
+    connect(patch, &Command::finished, this, [=](bool success) {
+        const bool inPlace = QFileInfo(target) == QFileInfo(archiveModel.getArchivePath());
+        if (success) {
+            originalPath = QFileInfo(target).absoluteFilePath();
+            state.setModified(false);
+            if (inPlace) {
+                // The archive has been replaced, so the patched contents become the new baseline
+                archiveModel.open(originalPath);
+                binaryManifestPatched = false;
+            }
+        } else {
+            logModel.add(tr("Error patching APK."), LogEntry::Error);
+            if (inPlace) {
+                archiveModel.reopen();
+            }
+        }
+    });
+
+    return patch;
+}
+
 Command *Package::createZipalignCommand(const QString &apk)
 {
     auto zipalign = new Zipalign::Align(apk.isEmpty() ? getOriginalPath() : apk);
@@ -297,22 +421,70 @@ Command *Package::createSignCommand(const Keystore *keystore, const QString &apk
     return apksigner;
 }
 
-Command *Package::createInstallCommand(const QString &serial, const QString &apk)
+Command *Package::createInstallCommand(const QList<Device> &devices, const QString &apk)
 {
-    auto install = new Adb::Install(apk.isEmpty() ? getOriginalPath() : apk, serial);
+    // All selected devices are installed to at the same time
+    auto command = new ParallelCommands;
 
-    connect(install, &Command::started, this, [=]() {
+    connect(command, &Command::started, this, [=]() {
         logModel.add(tr("Installing APK..."));
         state.setCurrentStatus(PackageState::Status::Installing);
     });
 
-    connect(install, &Command::finished, this, [=](bool success) {
+    const QString path = apk.isEmpty() ? getOriginalPath() : apk;
+    for (const Device &device : devices) {
+        const QString name = device.getAlias().isEmpty() ? device.getSerial() : device.getAlias();
+        auto install = new Adb::Install(path, device.getSerial());
+        auto entryIndex = QSharedPointer<QPersistentModelIndex>::create();
+
+        connect(install, &Command::started, this, [=]() {
+            //: "%1" will be replaced with a device name.
+            *entryIndex = logModel.add(tr("Installing APK on %1...").arg(name));
+        });
+
+        connect(install, &Command::finished, this, [=](bool success) {
+            if (!entryIndex->isValid()) {
+                return;
+            }
+            if (success) {
+                //: "%1" will be replaced with a device name.
+                logModel.update(*entryIndex, tr("Installed APK on %1.").arg(name), {}, LogEntry::Success);
+            } else {
+                //: "%1" will be replaced with a device name.
+                logModel.update(*entryIndex, tr("Error installing APK on %1.").arg(name), install->output(), LogEntry::Error);
+            }
+        });
+
+        command->add(install);
+    }
+
+    return command;
+}
+
+void Package::ReadCommand::run()
+{
+    emit started();
+
+    // The basic package information and the contents listing are read before the APK is unpacked.
+    // The archive is mapped and parsed on a worker thread, then handed over to the model.
+    auto archive = new ZipArchive(package->originalPath);
+    auto watcher = new QFutureWatcher<BinaryManifest>(this);
+    connect(watcher, &QFutureWatcher<BinaryManifest>::finished, this, [=]() {
+        package->binaryManifest = watcher->result();
+        const bool success = package->archiveModel.open(archive);
         if (!success) {
-            logModel.add(tr("Error installing APK."), install->output(), LogEntry::Error);
+            package->logModel.add(Package::tr("Could not read the APK."), LogEntry::Error);
         }
+        emit package->stateUpdated();
+        emit finished(success);
     });
-
-    return install;
+    watcher->setFuture(QtConcurrent::run([archive]() {
+        BinaryManifest manifest;
+        if (archive->open()) {
+            manifest.read(archive->read("AndroidManifest.xml"));
+        }
+        return manifest;
+    }));
 }
 
 void Package::LoadUnpackedCommand::run()
@@ -335,3 +507,84 @@ void Package::LoadUnpackedCommand::run()
     });
     initResourcesFutureWatcher->setFuture(initResourcesFuture);
 }
+
+void Package::SmaliCheckCommand::run()
+{
+    emit started();
+
+    // Only the files modified since the last successful check are checked
+    const QString contentsPath = package->getContentsPath();
+    const QDateTime since = package->smaliCheckTime;
+    const QDateTime now = QDateTime::currentDateTime();
+
+    auto watcher = new QFutureWatcher<QStringList>(this);
+    connect(watcher, &QFutureWatcher<QStringList>::finished, this, [=]() {
+        const QStringList errors = watcher->result();
+        if (errors.isEmpty()) {
+            package->smaliCheckTime = now;
+            emit finished(true);
+        } else {
+            //: "Smali" is the name of the tool/format, don't translate it.
+            package->logModel.add(Package::tr("Smali code contains errors. To pack the APK anyway, turn off the smali check in the options."),
+                                  errors.join('\n'), LogEntry::Error);
+            emit finished(false);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run([=]() {
+        QStringList errors;
+        const QDir contentsDir(contentsPath);
+        const auto smaliDirs = contentsDir.entryList({"smali*"}, QDir::Dirs);
+        for (const auto &smaliDir : smaliDirs) {
+            QDirIterator smali(contentsDir.filePath(smaliDir), {"*.smali"}, QDir::Files, QDirIterator::Subdirectories);
+            while (smali.hasNext()) {
+                const QString path = smali.next();
+                if (smali.fileInfo().lastModified() < since) {
+                    continue;
+                }
+                const QString relativePath = contentsDir.relativeFilePath(path);
+                for (const auto &error : SmaliChecker::checkFile(path)) {
+                    errors.append(QString("%1:%2: %3").arg(relativePath).arg(error.line + 1).arg(error.message));
+                }
+            }
+        }
+        return errors;
+    }));
+}
+
+void Package::PatchCommand::run()
+{
+    emit started();
+
+    // The model state is collected here, while the modified files are read in the worker
+    const QString sourcePath = package->archiveModel.getArchivePath();
+    const auto modified = package->archiveModel.getModifiedEntries();
+    const auto removed = package->archiveModel.getRemovedEntries();
+    const QByteArray manifest = package->binaryManifestPatched ? package->binaryManifest.toBinary() : QByteArray();
+    if (QFileInfo(target) == QFileInfo(sourcePath)) {
+        package->archiveModel.close();
+    }
+
+    // Unchanged entries are copied as is, so the patched APK is written in a single pass
+    auto watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [=]() {
+        emit finished(watcher->result());
+    });
+    const QString targetPath = target;
+    watcher->setFuture(QtConcurrent::run([=]() {
+        ZipPatcher patcher(sourcePath);
+        for (auto it = modified.constBegin(); it != modified.constEnd(); ++it) {
+            QFile file(it.value());
+            if (!file.open(QFile::ReadOnly)) {
+                return false;
+            }
+            patcher.replace(it.key(), file.readAll());
+        }
+        for (const QString &entry : removed) {
+            patcher.remove(entry);
+        }
+        if (!manifest.isEmpty()) {
+            patcher.replace("AndroidManifest.xml", manifest);
+        }
+        return patcher.write(targetPath);
+    }));
+}
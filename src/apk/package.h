@@ -1,6 +1,8 @@
 #ifndef PACKAGE_H
 #define PACKAGE_H
 
+#include "apk/archiveitemsmodel.h"
+#include "apk/binarymanifest.h"
 #include "apk/filesystemmodel.h"
 #include "apk/iconitemsmodel.h"
 #include "apk/logmodel.h"
@@ -8,6 +10,8 @@
 #include "apk/packagestate.h"
 #include "apk/resourceitemsmodel.h"
 #include "base/command.h"
+#include "base/device.h"
+#include <QDateTime>
 #include <QIcon>
 
 class Keystore;
@@ -24,32 +28,51 @@ public:
     QString getOriginalPath() const;
     QString getContentsPath() const;
     QString getPackageName() const;
+    const BinaryManifest &getBinaryManifest() const;
     QIcon getThumbnail() const;
     const PackageState &getState() const;
     bool hasSourcesUnpacked() const;
 
+    bool openForPatching();
+    void setModified(bool modified);
+
     void setApplicationIcon(const QString &path, QWidget *parent = nullptr);
     bool setPackageName(const QString &packageName);
+    bool patchBinaryManifest(int versionCode, const QString &versionName, int minSdk, bool debuggable);
+    QFuture<QString> replacePackageNameReferences(const QString &packageName, bool dryRun = false);
 
     Manifest *manifest;
 
     ResourceItemsModel resourcesModel;
     FileSystemModel filesystemModel;
+    ArchiveItemsModel archiveModel; // Contents listing available before the APK is unpacked
     IconItemsModel iconsProxy;
     ManifestModel manifestModel;
     LogModel logModel;
 
     Commands *createCommandChain();
+    Command *createReadCommand();
     Command *createUnpackCommand();
+    Command *createSmaliCheckCommand();
     Command *createPackCommand(const QString &target);
+    Command *createPatchCommand(const QString &target); // Strips the signature, re-sign with createSignCommand
     Command *createZipalignCommand(const QString &apk = QString());
     Command *createSignCommand(const Keystore *keystore, const QString &apk = QString());
-    Command *createInstallCommand(const QString &serial, const QString &apk = QString());
+    Command *createInstallCommand(const QList<Device> &devices, const QString &apk = QString());
 
 signals:
     void stateUpdated();
 
 private:    
+    class ReadCommand : public Command
+    {
+    public:
+        ReadCommand(Package *package) : package(package) {}
+        void run() override;
+    private:
+        Package *package;
+    };
+
     class LoadUnpackedCommand : public Command
     {
     public:
@@ -59,11 +82,33 @@ private:
         Package *package;
     };
 
+    class SmaliCheckCommand : public Command
+    {
+    public:
+        SmaliCheckCommand(Package *package) : package(package) {}
+        void run() override;
+    private:
+        Package *package;
+    };
+
+    class PatchCommand : public Command
+    {
+    public:
+        PatchCommand(Package *package, const QString &target) : package(package), target(target) {}
+        void run() override;
+    private:
+        Package *package;
+        QString target;
+    };
+
     PackageState state;
 
     QString originalPath;
     QString contentsPath;
     QIcon thumbnail;
+    BinaryManifest binaryManifest;
+    bool binaryManifestPatched = false;
+    QDateTime smaliCheckTime; // Smali files modified after this time are checked before packing
 
     bool withSources = false;
     bool withResources = false;
@@ -3,6 +3,7 @@
 PackageState::PackageState()
 {
     unpacked = false;
+    patchable = false;
     modified = false;
     status = Status::Normal;
 }
@@ -19,6 +20,12 @@ void PackageState::setUnpacked(bool unpacked)
     emit changed();
 }
 
+void PackageState::setPatchable(bool patchable)
+{
+    this->patchable = patchable;
+    emit changed();
+}
+
 void PackageState::setModified(bool modified)
 {
     this->modified = modified;
@@ -35,6 +42,11 @@ bool PackageState::isUnpacked() const
     return unpacked;
 }
 
+bool PackageState::isPatchable() const
+{
+    return patchable;
+}
+
 bool PackageState::isModified() const
 {
     return modified;
@@ -52,12 +64,12 @@ bool PackageState::canEdit() const
 
 bool PackageState::canSave() const
 {
-    return isUnpacked() && isIdle();
+    return (isUnpacked() || isPatchable()) && isIdle();
 }
 
 bool PackageState::canInstall() const
 {
-    return isUnpacked() && isIdle();
+    return (isUnpacked() || isPatchable()) && isIdle();
 }
 
 bool PackageState::canExplore() const
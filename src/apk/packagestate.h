@@ -22,10 +22,12 @@ public:
 
     void setCurrentStatus(const Status &status);
     void setUnpacked(bool unpacked);
+    void setPatchable(bool patchable);
     void setModified(bool modified);
 
     const Status &getCurrentStatus() const;
     bool isUnpacked() const;
+    bool isPatchable() const;
     bool isModified() const;
     bool isIdle() const;
 
@@ -40,6 +42,7 @@ signals:
 
 private:
     bool unpacked;
+    bool patchable;
     bool modified;
     Status status;
 };
@@ -11,11 +11,16 @@
 #include "windows/dialogs.h"
 #include "windows/rememberdialog.h"
 #include "windows/permissioneditor.h"
+#include "windows/resourcecleaner.h"
+#include "windows/resourcetableviewer.h"
 #include "windows/signatureviewer.h"
+#include "windows/sizeanalyzer.h"
 #include "tools/keystore.h"
 #include <QImageReader>
+#include <QFutureWatcher>
 #include <QInputDialog>
 #include <QMimeDatabase>
+#include <QProgressDialog>
 
 Project::Project(Package *package, QWidget *parent)
     : QObject(parent)
@@ -132,6 +137,28 @@ void Project::openPackageRenamer()
         return;
     }
 
+    // Dry run to find out which files are affected:
+
+    bool canceled = false;
+    const auto affectedFiles = waitForFiles(package->replacePackageNameReferences(newPackageName, true),
+                                            tr("Searching for package name references..."), &canceled);
+    if (canceled) {
+        return;
+    }
+
+    QMessageBox confirmation(QMessageBox::Question, {}, tr(
+        "%n file(s) reference the original package name and will be updated. Proceed?",
+        nullptr, affectedFiles.count()), QMessageBox::Yes | QMessageBox::No, parentWidget());
+    if (!affectedFiles.isEmpty()) {
+        confirmation.setDetailedText(affectedFiles.join('\n'));
+    }
+    if (confirmation.exec() != QMessageBox::Yes) {
+        return;
+    }
+
+    // Not cancelable: stopping halfway would leave the references partially updated
+    waitForFiles(package->replacePackageNameReferences(newPackageName),
+                 tr("Updating package name references..."));
     if (!package->setPackageName(newPackageName)) {
         QMessageBox::warning(parentWidget(), {}, tr("Could not clone the APK."));
         return;
@@ -146,6 +173,42 @@ void Project::openSignatureViewer()
     signatureViewer.exec();
 }
 
+void Project::openResourceTableViewer()
+{
+    ResourceTableViewer resourceTableViewer(package->getOriginalPath(), parentWidget());
+    resourceTableViewer.exec();
+}
+
+void Project::openSizeAnalyzer()
+{
+    SizeAnalyzer sizeAnalyzer(package->getOriginalPath(), parentWidget());
+    sizeAnalyzer.exec();
+}
+
+void Project::openResourceCleaner()
+{
+    if (!package->hasSourcesUnpacked()) {
+        // Resource IDs referenced from the code can't be tracked without smali
+        const QString question = tr(
+            "Searching for unused resources requires the source code decompilation to be turned on. "
+            "Proceed?");
+        if (!app->settings->getDecompileSources()
+                && QMessageBox::question(parentWidget(), {}, question) == QMessageBox::Yes) {
+            app->settings->setDecompileSources(true);
+            QMessageBox::information(parentWidget(), {}, tr("Settings have been applied. Please, reopen this APK."));
+        } else if (app->settings->getDecompileSources()) {
+            QMessageBox::warning(parentWidget(), {}, tr(
+                "Please, reopen this APK in order to unpack the source code and search for unused resources."));
+        }
+        return;
+    }
+
+    ResourceCleaner resourceCleaner(package, parentWidget());
+    if (resourceCleaner.exec() == QDialog::Accepted) {
+        package->setModified(true);
+    }
+}
+
 bool Project::saveTabs()
 {
     bool result = true;
@@ -181,9 +244,18 @@ bool Project::saveProject()
         return false;
     }
     auto command = package->createCommandChain();
-    command->add(package->createPackCommand(target), true);
-    if (app->settings->getOptimizeApk()) {
-        command->add(package->createZipalignCommand(target), false);
+    if (package->getState().isPatchable()) {
+        // Patched entries are aligned as they are written
+        command->add(package->createPatchCommand(target), true);
+    } else {
+        if (package->hasSourcesUnpacked() && app->settings->getCheckSmali()) {
+            // Catch the smali errors before running apktool
+            command->add(package->createSmaliCheckCommand(), true);
+        }
+        command->add(package->createPackCommand(target), true);
+        if (app->settings->getOptimizeApk()) {
+            command->add(package->createZipalignCommand(target), false);
+        }
     }
     if (app->settings->getSignApk()) {
         auto keystore = Keystore::get(parentWidget());
@@ -197,8 +269,8 @@ bool Project::saveProject()
 
 bool Project::installProject()
 {
-    const auto device = Dialogs::getInstallDevice(parentWidget());
-    if (device.isNull()) {
+    const auto devices = Dialogs::getInstallDevices(parentWidget());
+    if (devices.isEmpty()) {
         return false;
     }
 
@@ -217,9 +289,16 @@ bool Project::installProject()
                 delete command;
                 return false;
             }
-            command->add(package->createPackCommand(target), true);
-            if (app->settings->getOptimizeApk()) {
-                command->add(package->createZipalignCommand(target), false);
+            if (package->getState().isPatchable()) {
+                command->add(package->createPatchCommand(target), true);
+            } else {
+                if (package->hasSourcesUnpacked() && app->settings->getCheckSmali()) {
+                    command->add(package->createSmaliCheckCommand(), true);
+                }
+                command->add(package->createPackCommand(target), true);
+                if (app->settings->getOptimizeApk()) {
+                    command->add(package->createZipalignCommand(target), false);
+                }
             }
             if (app->settings->getSignApk()) {
                 auto keystore = Keystore::get(parentWidget());
@@ -237,7 +316,7 @@ bool Project::installProject()
         }
     }
 
-    command->add(package->createInstallCommand(device.getSerial(), target));
+    command->add(package->createInstallCommand(devices, target));
     command->run();
     return true;
 }
@@ -276,7 +355,7 @@ int Project::addTab(BaseSheet *tab)
     if (editor) {
         connect(editor, &BaseEditableSheet::saved, this, [this]() {
             // Project save indicator:
-            const_cast<PackageState &>(package->getState()).setModified(true);
+            package->setModified(true);
         });
         connect(editor, &BaseEditableSheet::modifiedStateChanged, this, [=](bool modified) {
             // Tab save indicator:
@@ -338,6 +417,35 @@ BaseSheet *Project::getTabByIdentifier(const QString &identifier) const
     return nullptr;
 }
 
+QStringList Project::waitForFiles(QFuture<QString> future, const QString &label, bool *canceled) const
+{
+    // The operation can only be canceled if the caller is interested in it
+    QProgressDialog progressDialog(label, canceled ? tr("Cancel") : QString(), 0, 0, parentWidget());
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(0);
+    if (!canceled) {
+        progressDialog.setWindowFlags(progressDialog.windowFlags() & ~Qt::WindowCloseButtonHint);
+    }
+
+    QFutureWatcher<QString> watcher;
+    connect(&watcher, &QFutureWatcher<QString>::progressRangeChanged, &progressDialog, &QProgressDialog::setRange);
+    connect(&watcher, &QFutureWatcher<QString>::progressValueChanged, &progressDialog, &QProgressDialog::setValue);
+    connect(&watcher, &QFutureWatcher<QString>::finished, &progressDialog, &QProgressDialog::reset);
+    if (canceled) {
+        connect(&progressDialog, &QProgressDialog::canceled, &watcher, &QFutureWatcher<QString>::cancel);
+    }
+    watcher.setFuture(future);
+    if (!future.isFinished()) {
+        progressDialog.exec();
+    }
+    watcher.waitForFinished();
+
+    if (canceled) {
+        *canceled = future.isCanceled();
+    }
+    return future.results();
+}
+
 QWidget *Project::parentWidget() const
 {
     return static_cast<QWidget *>(parent());
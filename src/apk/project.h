@@ -1,6 +1,7 @@
 #ifndef PROJECT_H
 #define PROJECT_H
 
+#include <QFuture>
 #include <QObject>
 
 class BaseSheet;
@@ -21,6 +22,9 @@ public:
     void openPermissionEditor();
     void openPackageRenamer();
     void openSignatureViewer();
+    void openResourceTableViewer();
+    void openSizeAnalyzer();
+    void openResourceCleaner();
 
     bool saveTabs();
     bool saveProject();
@@ -42,6 +46,7 @@ private:
 
     bool hasUnsavedTabs() const;
     BaseSheet *getTabByIdentifier(const QString &identifier) const;
+    QStringList waitForFiles(QFuture<QString> future, const QString &label, bool *canceled = nullptr) const;
     QWidget *parentWidget() const;
 
     Package *package;
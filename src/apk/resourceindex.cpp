@@ -0,0 +1,202 @@
+#include "apk/resourceindex.h"
+#include "apk/resourceitemsmodel.h"
+#include "apk/resourcefile.h"
+#include <QRegularExpression>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace
+{
+    const int TrigramSize = 3;
+
+    quint64 getTrigram(const QString &string, int position)
+    {
+        return (quint64(string.at(position).unicode()) << 32)
+             | (quint64(string.at(position + 1).unicode()) << 16)
+             | quint64(string.at(position + 2).unicode());
+    }
+}
+
+bool ResourceIndex::Query::isEmpty() const
+{
+    if (!text.isEmpty()) {
+        return false;
+    }
+    for (const QString &facet : facets) {
+        if (!facet.isEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QVector<ResourceIndex::Entry> ResourceIndex::snapshot(const ResourceItemsModel *model)
+{
+    QVector<Entry> entries;
+    if (model) {
+        snapshot(model, {}, -1, entries);
+    }
+    return entries;
+}
+
+void ResourceIndex::snapshot(const ResourceItemsModel *model, const QModelIndex &parent, int parentEntry, QVector<Entry> &entries)
+{
+    const int rows = model->rowCount(parent);
+    for (int row = 0; row < rows; ++row) {
+        const QModelIndex index = model->index(row, ResourceItemsModel::CaptionColumn, parent);
+        Entry entry;
+        entry.node = index.internalPointer();
+        entry.parent = parentEntry;
+        entry.caption = index.data().toString();
+        const ResourceFile *file = model->getResourceFile(index);
+        if (file) {
+            entry.path = file->getFilePath();
+        }
+        entries.append(entry);
+        snapshot(model, index, entries.size() - 1, entries);
+    }
+}
+
+ResourceIndex::ResourceIndex(const QVector<Entry> &entries) : entries(entries)
+{
+    const int count = entries.size();
+    captions.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const Entry &entry = entries.at(i);
+        const QString caption = entry.caption.toLower();
+        captions.append(caption);
+
+        // Posting lists are sorted, as the entries are visited in order:
+        for (int position = 0; position + TrigramSize <= caption.size(); ++position) {
+            auto &postings = trigrams[getTrigram(caption, position)];
+            if (postings.isEmpty() || postings.last() != i) {
+                postings.append(i);
+            }
+        }
+
+        if (entry.path.isEmpty()) {
+            continue;
+        }
+        const ResourceFile file(entry.path);
+        const QString values[FacetCount] = {file.getType(), file.getLocaleCode(), file.getDpi().toLower(), file.getApiVersion()};
+        for (int facet = 0; facet < FacetCount; ++facet) {
+            const QString &value = values[facet];
+            if (!value.isEmpty()) {
+                auto &bits = facets[facet][value];
+                if (bits.isEmpty()) {
+                    bits.resize(count);
+                }
+                bits.setBit(i);
+            }
+        }
+    }
+}
+
+QStringList ResourceIndex::getFacetValues(Facet facet) const
+{
+    QStringList values = facets[facet].keys();
+    if (facet == ApiFacet) {
+        std::sort(values.begin(), values.end(), [](const QString &a, const QString &b) {
+            return a.mid(1).toInt() < b.mid(1).toInt(); // E.g., "v21"
+        });
+    } else {
+        std::sort(values.begin(), values.end());
+    }
+    return values;
+}
+
+QSet<const void *> ResourceIndex::search(const Query &query, const std::function<bool()> &isCancelled) const
+{
+    // Split the wildcard pattern into the literals, which must all be contained in the matching captions:
+    const QString text = query.text.toLower();
+    QStringList literals;
+    QString pattern;
+    QString literal;
+    for (const QChar c : text) {
+        if (c == '*' || c == '?') {
+            literals.append(literal);
+            pattern.append(QRegularExpression::escape(literal));
+            pattern.append(c == '*' ? ".*" : ".");
+            literal.clear();
+        } else {
+            literal.append(c);
+        }
+    }
+    literals.append(literal);
+    pattern.append(QRegularExpression::escape(literal));
+    const bool isWildcard = literals.size() > 1;
+    const QRegularExpression regex(isWildcard ? pattern : QString());
+
+    QBitArray facetMask;
+    for (int facet = 0; facet < FacetCount; ++facet) {
+        const QString &value = query.facets[facet];
+        if (!value.isEmpty()) {
+            const QBitArray bits = facets[facet].value(value);
+            if (bits.isEmpty()) {
+                return {};
+            }
+            facetMask = facetMask.isEmpty() ? bits : (facetMask & bits);
+        }
+    }
+
+    QSet<const void *> result;
+    const QVector<int> candidates = findCandidates(literals);
+    for (int i = 0; i < candidates.size(); ++i) {
+        if (isCancelled && i % 1024 == 0 && isCancelled()) {
+            return {};
+        }
+        const int candidate = candidates.at(i);
+        if (!facetMask.isEmpty() && !facetMask.testBit(candidate)) {
+            continue;
+        }
+        const QString &caption = captions.at(candidate);
+        if (isWildcard ? !regex.match(caption).hasMatch() : !caption.contains(text)) {
+            continue;
+        }
+        // Ancestors have to be accepted for the node to be displayed:
+        for (int entry = candidate; entry != -1; entry = entries.at(entry).parent) {
+            const void *node = entries.at(entry).node;
+            if (result.contains(node)) {
+                break;
+            }
+            result.insert(node);
+        }
+    }
+    return result;
+}
+
+QVector<int> ResourceIndex::findCandidates(const QStringList &literals) const
+{
+    QVector<const QVector<int> *> postingLists;
+    for (const QString &literal : literals) {
+        for (int position = 0; position + TrigramSize <= literal.size(); ++position) {
+            auto it = trigrams.constFind(getTrigram(literal, position));
+            if (it == trigrams.constEnd()) {
+                return {};
+            }
+            postingLists.append(&it.value());
+        }
+    }
+
+    if (postingLists.isEmpty()) {
+        // Literals are too short to narrow down the search
+        QVector<int> candidates(entries.size());
+        std::iota(candidates.begin(), candidates.end(), 0);
+        return candidates;
+    }
+
+    // Intersect the posting lists, starting from the shortest:
+    std::sort(postingLists.begin(), postingLists.end(), [](const QVector<int> *a, const QVector<int> *b) {
+        return a->size() < b->size();
+    });
+    QVector<int> candidates = *postingLists.first();
+    for (int i = 1; i < postingLists.size() && !candidates.isEmpty(); ++i) {
+        QVector<int> intersection;
+        std::set_intersection(candidates.constBegin(), candidates.constEnd(),
+                              postingLists.at(i)->constBegin(), postingLists.at(i)->constEnd(),
+                              std::back_inserter(intersection));
+        candidates = intersection;
+    }
+    return candidates;
+}
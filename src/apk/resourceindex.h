@@ -0,0 +1,62 @@
+#ifndef RESOURCEINDEX_H
+#define RESOURCEINDEX_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <functional>
+
+class ResourceItemsModel;
+class QModelIndex;
+
+// Searchable snapshot of the resource tree: a trigram index of the node captions and,
+// for each qualifier value, a bitset of the resource files having it.
+// The snapshot only copies the captions and paths on the GUI thread; the qualifiers are parsed
+// and the index is built and queried on a worker thread.
+
+class ResourceIndex
+{
+public:
+    enum Facet {
+        TypeFacet,
+        LocaleFacet,
+        DpiFacet,
+        ApiFacet,
+        FacetCount
+    };
+
+    struct Query
+    {
+        QString text; // Case-insensitive wildcard pattern
+        QString facets[FacetCount]; // Empty values match any file
+        bool isEmpty() const;
+    };
+
+    struct Entry
+    {
+        const void *node = nullptr; // Only used to identify the node, never dereferenced
+        int parent = -1;
+        QString caption;
+        QString path; // Empty for the type and group nodes
+    };
+
+    static QVector<Entry> snapshot(const ResourceItemsModel *model);
+    explicit ResourceIndex(const QVector<Entry> &entries);
+
+    QStringList getFacetValues(Facet facet) const;
+
+    // Returns the matching nodes along with their ancestors, or an empty set if the search was cancelled
+    QSet<const void *> search(const Query &query, const std::function<bool()> &isCancelled = nullptr) const;
+
+private:
+    static void snapshot(const ResourceItemsModel *model, const QModelIndex &parent, int parentEntry, QVector<Entry> &entries);
+    QVector<int> findCandidates(const QStringList &literals) const;
+
+    QVector<Entry> entries;
+    QVector<QString> captions; // Lowercase
+    QHash<quint64, QVector<int>> trigrams;
+    QHash<QString, QBitArray> facets[FacetCount];
+};
+
+#endif // RESOURCEINDEX_H
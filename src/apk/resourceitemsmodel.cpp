@@ -5,6 +5,8 @@
 #include <QtConcurrent/QtConcurrent>
 #include <QDirIterator>
 #include <QIcon>
+#include <algorithm>
+#include <functional>
 
 #ifdef QT_DEBUG
     #include <QDebug>
@@ -26,10 +28,9 @@ QFuture<void> ResourceItemsModel::initialize(const QString &path)
 
     return QtConcurrent::run([=] {
 
-        // Parse resource directories:
+        // Parse resource directories, their files are read on demand:
 
         QMap<QString, ResourceNode *> mapResourceTypes;
-        QMap<QString, ResourceNode *> mapResourceGroups;
 
         QDirIterator resourceDirectories(path, QDir::Dirs | QDir::NoDotAndDotDot);
         while (resourceDirectories.hasNext()) {
@@ -42,24 +43,22 @@ QFuture<void> ResourceItemsModel::initialize(const QString &path)
                 root->addChild(resourceTypeNode);
                 mapResourceTypes[resourceTypeTitle] = resourceTypeNode;
             }
+            resourceTypeNode->addPendingPath(resourceDirectory.filePath());
+        }
 
-            // Parse resource files:
-
-            QDirIterator resourceFiles(resourceDirectory.filePath(), QDir::Files);
-            while (resourceFiles.hasNext()) {
-
-                const QFileInfo resourceFile(resourceFiles.next());
-                const QString resourceFilename = resourceFile.fileName();
-
-                ResourceNode *resourceGroupNode  = mapResourceGroups.value(resourceFilename, nullptr);
-                if (!resourceGroupNode) {
-                    resourceGroupNode = new ResourceNode(resourceFilename, nullptr);
+        // Read the most frequently used resource types in advance, the rest (e.g., drawables) are read on demand:
+
+        for (const QString &resourceType : {"mipmap", "values"}) {
+            ResourceNode *resourceTypeNode = mapResourceTypes.value(resourceType, nullptr);
+            if (resourceTypeNode) {
+                const auto resourceGroupNodes = readGroups(resourceTypeNode->takePendingPaths());
+                for (ResourceNode *resourceGroupNode : resourceGroupNodes) {
+                    const auto fileNodes = readFiles(resourceGroupNode->getCaption(), resourceGroupNode->takePendingPaths());
+                    for (ResourceNode *fileNode : fileNodes) {
+                        resourceGroupNode->addChild(fileNode);
+                    }
                     resourceTypeNode->addChild(resourceGroupNode);
-                    mapResourceGroups[resourceFilename] = resourceGroupNode;
                 }
-
-                ResourceNode *fileNode = new ResourceNode(resourceFilename, new ResourceFile(resourceFile.filePath()));
-                resourceGroupNode->addChild(fileNode);
             }
         }
 
@@ -223,6 +222,116 @@ int ResourceItemsModel::columnCount(const QModelIndex &parent) const
     return ColumnCount;
 }
 
+bool ResourceItemsModel::hasChildren(const QModelIndex &parent) const
+{
+    const ResourceNode *node = getNode(parent);
+    return node->hasChildren() || !node->getPendingPaths().isEmpty();
+}
+
+bool ResourceItemsModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !getNode(parent)->getPendingPaths().isEmpty();
+}
+
+void ResourceItemsModel::fetchMore(const QModelIndex &parent)
+{
+    ResourceNode *node = getNode(parent);
+    if (node->getPendingPaths().isEmpty()) {
+        return;
+    }
+    const QStringList paths = node->takePendingPaths();
+    const auto children = node->getParent() == root
+        ? readGroups(paths)
+        : readFiles(node->getCaption(), paths);
+    if (!children.isEmpty()) {
+        const int row = node->childCount();
+        beginInsertRows(parent, row, row + children.size() - 1);
+        for (ResourceNode *child : children) {
+            node->addChild(child);
+        }
+        endInsertRows();
+    }
+}
+
+void ResourceItemsModel::fetchAll()
+{
+    if (fetchingAll) {
+        return;
+    }
+
+    // Pending paths are left in place, so the branches can still be expanded while they are being read
+    QVector<QPersistentModelIndex> parents;
+    QVector<FetchJob> jobs;
+    for (int typeRow = 0; typeRow < rowCount(); ++typeRow) {
+        const QModelIndex typeIndex = index(typeRow, 0);
+        const ResourceNode *typeNode = getNode(typeIndex);
+        if (!typeNode->getPendingPaths().isEmpty()) {
+            parents.append(typeIndex);
+            jobs.append({true, QString(), typeNode->getPendingPaths()});
+            continue;
+        }
+        for (int groupRow = 0; groupRow < rowCount(typeIndex); ++groupRow) {
+            const QModelIndex groupIndex = index(groupRow, 0, typeIndex);
+            const ResourceNode *groupNode = getNode(groupIndex);
+            if (!groupNode->getPendingPaths().isEmpty()) {
+                parents.append(groupIndex);
+                jobs.append({false, groupNode->getCaption(), groupNode->getPendingPaths()});
+            }
+        }
+    }
+    if (jobs.isEmpty()) {
+        emit fetchedAll();
+        return;
+    }
+
+    fetchingAll = true;
+    auto watcher = new QFutureWatcher<QVector<QVector<ResourceNode *>>>(this);
+    connect(watcher, &QFutureWatcher<QVector<QVector<ResourceNode *>>>::finished, this, [=]() {
+        const auto results = watcher->result();
+        for (int i = 0; i < results.size(); ++i) {
+            // Branches which have been removed or fetched in the meantime are skipped
+            const QModelIndex parent = parents.at(i);
+            ResourceNode *node = parent.isValid() ? getNode(parent) : nullptr;
+            if (!node || node->getPendingPaths() != jobs.at(i).paths) {
+                qDeleteAll(results.at(i));
+                continue;
+            }
+            node->takePendingPaths();
+            const auto &children = results.at(i);
+            if (!children.isEmpty()) {
+                const int row = node->childCount();
+                beginInsertRows(parent, row, row + children.size() - 1);
+                for (ResourceNode *child : children) {
+                    node->addChild(child);
+                }
+                endInsertRows();
+            }
+        }
+        fetchingAll = false;
+        watcher->deleteLater();
+        emit fetchedAll();
+    });
+    watcher->setFuture(QtConcurrent::run([jobs]() {
+        QVector<QVector<ResourceNode *>> results;
+        results.reserve(jobs.size());
+        for (const FetchJob &job : jobs) {
+            if (!job.isType) {
+                results.append(readFiles(job.caption, job.paths));
+                continue;
+            }
+            const auto groups = readGroups(job.paths);
+            for (ResourceNode *group : groups) {
+                const auto files = readFiles(group->getCaption(), group->takePendingPaths());
+                for (ResourceNode *file : files) {
+                    group->addChild(file);
+                }
+            }
+            results.append(groups);
+        }
+        return results;
+    }));
+}
+
 bool ResourceItemsModel::removeRows(int row, int count, const QModelIndex &parent)
 {
     auto parentNode = parent.isValid() ? static_cast<ResourceNode *>(parent.internalPointer()) : root;
@@ -230,7 +339,7 @@ bool ResourceItemsModel::removeRows(int row, int count, const QModelIndex &paren
     // Check if the underlying files can actually be deleted
     int lastDeleteRow = -1;
     for (int i = row; i < row + count; ++i) {
-        if (!parentNode->removeFile(row)) {
+        if (!parentNode->removeFile(i)) {
             break;
         }
         lastDeleteRow = i;
@@ -260,8 +369,75 @@ bool ResourceItemsModel::removeRows(int row, int count, const QModelIndex &paren
     return lastDeleteRow == (row + count - 1);
 }
 
-QModelIndex ResourceItemsModel::findIndex(const QString &path) const
+int ResourceItemsModel::removeResources(const QStringList &paths)
+{
+    // Read the branches which are yet to be read, then resolve all the paths in a single pass over the tree
+    for (const QString &path : paths) {
+        fetchGroup(path);
+    }
+    QHash<QString, QPersistentModelIndex> indexes;
+    collectIndexes({}, indexes);
+
+    QList<QPersistentModelIndex> targets;
+    for (const QString &path : paths) {
+        const auto resource = indexes.value(path);
+        if (resource.isValid()) {
+            targets.append(resource);
+        }
+    }
+
+    // Rows are grouped by their parent one batch at a time, as emptied parents are removed along with their last rows
+    QList<QPersistentModelIndex> pending = targets;
+    while (!pending.isEmpty()) {
+        const QPersistentModelIndex parent = pending.first().parent();
+        QList<int> rows;
+        QList<QPersistentModelIndex> rest;
+        for (const auto &target : qAsConst(pending)) {
+            if (target.parent() == parent) {
+                rows.append(target.row());
+            } else {
+                rest.append(target);
+            }
+        }
+        pending = rest;
+
+        // Remove contiguous row ranges, starting from the bottom to keep the remaining row numbers valid
+        std::sort(rows.begin(), rows.end(), std::greater<int>());
+        int i = 0;
+        while (i < rows.count()) {
+            const int last = rows.at(i);
+            int first = last;
+            while (i + 1 < rows.count() && rows.at(i + 1) == first - 1) {
+                first = rows.at(++i);
+            }
+            removeRows(first, last - first + 1, parent);
+            ++i;
+        }
+        pending.erase(std::remove_if(pending.begin(), pending.end(), [](const QPersistentModelIndex &target) {
+            return !target.isValid();
+        }), pending.end());
+    }
+
+    int removed = 0;
+    for (const auto &target : targets) {
+        if (!target.isValid()) {
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+QModelIndex ResourceItemsModel::findIndex(const QString &path)
 {
+    const QModelIndex group = fetchGroup(path);
+    if (group.isValid()) {
+        for (int row = 0; row < rowCount(group); ++row) {
+            const auto resource = index(row, PathColumn, group);
+            if (resource.data().toString() == path) {
+                return resource;
+            }
+        }
+    }
     return findIndex(path, {});
 }
 
@@ -280,6 +456,95 @@ QModelIndex ResourceItemsModel::findIndex(const QString &path, const QModelIndex
     return {};
 }
 
+void ResourceItemsModel::collectIndexes(const QModelIndex &parent, QHash<QString, QPersistentModelIndex> &indexes) const
+{
+    for (int row = 0; row < rowCount(parent); ++row) {
+        const auto child = index(row, 0, parent);
+        const ResourceFile *file = getResourceFile(child);
+        if (file) {
+            indexes.insert(file->getFilePath(), child);
+        }
+        collectIndexes(child, indexes);
+    }
+}
+
+QVector<ResourceNode *> ResourceItemsModel::readGroups(const QStringList &directories)
+{
+    // Files with the same name are grouped across the qualified directories of the resource type
+    QVector<ResourceNode *> groups;
+    QHash<QString, ResourceNode *> groupsByName;
+    for (const QString &directory : directories) {
+        QDirIterator resourceFiles(directory, QDir::Files);
+        while (resourceFiles.hasNext()) {
+            const QString path = resourceFiles.next();
+            const QString filename = resourceFiles.fileName();
+            ResourceNode *group = groupsByName.value(filename, nullptr);
+            if (!group) {
+                group = new ResourceNode(filename, nullptr);
+                groups.append(group);
+                groupsByName.insert(filename, group);
+            }
+            group->addPendingPath(path);
+        }
+    }
+    return groups;
+}
+
+QVector<ResourceNode *> ResourceItemsModel::readFiles(const QString &caption, const QStringList &paths)
+{
+    QVector<ResourceNode *> files;
+    files.reserve(paths.size());
+    for (const QString &path : paths) {
+        files.append(new ResourceNode(caption, new ResourceFile(path)));
+    }
+    return files;
+}
+
+ResourceNode *ResourceItemsModel::getNode(const QModelIndex &index) const
+{
+    return index.isValid() ? static_cast<ResourceNode *>(index.internalPointer()) : root;
+}
+
+QModelIndex ResourceItemsModel::fetchGroup(const QString &path)
+{
+    // Reads the resource type and group which the file belongs to
+    const QFileInfo file(path);
+    const QString type = file.dir().dirName().split('-').first();
+    for (int typeRow = 0; typeRow < rowCount(); ++typeRow) {
+        const QModelIndex typeIndex = index(typeRow, 0);
+        if (typeIndex.data().toString() == type) {
+            fetchMore(typeIndex);
+            for (int groupRow = 0; groupRow < rowCount(typeIndex); ++groupRow) {
+                const QModelIndex groupIndex = index(groupRow, 0, typeIndex);
+                if (groupIndex.data().toString() == file.fileName()) {
+                    fetchMore(groupIndex);
+                    return groupIndex;
+                }
+            }
+            break;
+        }
+    }
+    return {};
+}
+
+void ResourceItemsModel::fetchResource(const QString &type, const QString &name)
+{
+    // Only the groups of the given resource are read, e.g., "drawable" and "icon" for "@drawable/icon"
+    for (int typeRow = 0; typeRow < rowCount(); ++typeRow) {
+        const QModelIndex typeIndex = index(typeRow, 0);
+        if (typeIndex.data().toString() == type) {
+            fetchMore(typeIndex);
+            for (int groupRow = 0; groupRow < rowCount(typeIndex); ++groupRow) {
+                const QModelIndex groupIndex = index(groupRow, 0, typeIndex);
+                if (QFileInfo(groupIndex.data().toString()).baseName() == name) {
+                    fetchMore(groupIndex);
+                }
+            }
+            break;
+        }
+    }
+}
+
 const ResourceFile *ResourceItemsModel::getResourceFile(const QModelIndex &index) const
 {
     if (!index.isValid()) {
@@ -45,15 +45,38 @@ public:
     QModelIndex parent(const QModelIndex &index) const override;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    void fetchResource(const QString &type, const QString &name);
+    void fetchAll(); // Reads the pending resources on a worker thread, fetchedAll() is emitted once they are added
     bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+    int removeResources(const QStringList &paths);
 
-    QModelIndex findIndex(const QString &path) const;
+    QModelIndex findIndex(const QString &path);
     QModelIndex findIndex(const QString &path, const QModelIndex &parent) const;
     const ResourceFile *getResourceFile(const QModelIndex &index) const;
 
+signals:
+    void fetchedAll();
+
 private:
+    struct FetchJob
+    {
+        bool isType; // Groups of a resource type, otherwise files of a resource group
+        QString caption;
+        QStringList paths;
+    };
+
+    static QVector<ResourceNode *> readGroups(const QStringList &directories);
+    static QVector<ResourceNode *> readFiles(const QString &caption, const QStringList &paths);
+    ResourceNode *getNode(const QModelIndex &index) const;
+    QModelIndex fetchGroup(const QString &path);
+    void collectIndexes(const QModelIndex &parent, QHash<QString, QPersistentModelIndex> &indexes) const;
+
     ResourceNode *root;
     QFileIconProvider iconProvider;
+    bool fetchingAll = false;
 };
 
 #endif // RESOURCEITEMSMODEL_H
@@ -37,6 +37,23 @@ void ResourceNode::setFile(ResourceFile *file)
     this->file = file;
 }
 
+const QStringList &ResourceNode::getPendingPaths() const
+{
+    return pendingPaths;
+}
+
+void ResourceNode::addPendingPath(const QString &path)
+{
+    pendingPaths.append(path);
+}
+
+QStringList ResourceNode::takePendingPaths()
+{
+    QStringList paths;
+    paths.swap(pendingPaths);
+    return paths;
+}
+
 bool ResourceNode::removeFile(int row)
 {
     auto child = getChild(row);
@@ -3,6 +3,7 @@
 
 #include "base/treenode.h"
 #include "apk/resourcefile.h"
+#include <QStringList>
 
 class ResourceNode : public TreeNode
 {
@@ -16,6 +17,11 @@ public:
     void setCaption(const QString &caption);
     void setFile(ResourceFile *file);
 
+    // Directories (for resource types) or files (for resource groups) which are yet to be read
+    const QStringList &getPendingPaths() const;
+    void addPendingPath(const QString &path);
+    QStringList takePendingPaths();
+
     bool removeFile(int row);
     ResourceNode *getChild(int row) const;
     ResourceNode *getParent() const;
@@ -23,6 +29,7 @@ public:
 private:
     QString caption;
     ResourceFile *file;
+    QStringList pendingPaths;
 };
 
 #endif // RESOURCENODE_H
@@ -0,0 +1,526 @@
+#include "apk/resourcetable.h"
+#include "apk/binaryxml.h"
+#include <QtEndian>
+#include <QDebug>
+
+namespace
+{
+    enum ChunkType : quint16 {
+        StringPoolChunk = 0x0001,
+        TableChunk = 0x0002,
+        PackageChunk = 0x0200,
+        TypeChunk = 0x0201,
+        TypeSpecChunk = 0x0202
+    };
+
+    const quint32 NoEntry = 0xFFFFFFFF;
+    const quint16 NoEntry16 = 0xFFFF;
+    const quint8 SparseTypeFlag = 0x01;
+    const quint8 Offset16TypeFlag = 0x02;
+    const quint16 ComplexEntryFlag = 0x0001;
+    const quint16 CompactEntryFlag = 0x0008;
+
+    template<typename T> T readValue(const uchar *data)
+    {
+        return qFromLittleEndian<T>(data);
+    }
+
+    QString unpackLocaleCode(const uchar *code, char base)
+    {
+        if (!code[0]) {
+            return QString();
+        }
+        if (code[0] & 0x80) {
+            // Packed three-letter code
+            const char first = code[1] & 0x1f;
+            const char second = ((code[1] & 0xe0) >> 5) + ((code[0] & 0x03) << 3);
+            const char third = (code[0] & 0x7c) >> 2;
+            const QChar letters[] = {QChar(base + first), QChar(base + second), QChar(base + third)};
+            return QString(letters, 3);
+        }
+        return QString::fromLatin1(reinterpret_cast<const char *>(code), 2);
+    }
+
+    QString trimmedLatin1(const uchar *data, int size)
+    {
+        int length = 0;
+        while (length < size && data[length]) {
+            ++length;
+        }
+        return QString::fromLatin1(reinterpret_cast<const char *>(data), length);
+    }
+}
+
+// String pool
+
+bool ResourceTable::StringPool::read(const uchar *chunk, quint32 size)
+{
+    if (size < 28) {
+        return false;
+    }
+    const quint16 headerSize = readValue<quint16>(chunk + 2);
+    const quint32 stringsStart = readValue<quint32>(chunk + 20);
+    stringCount = readValue<quint32>(chunk + 8);
+    if (headerSize < 28 || headerSize > size || stringsStart > size
+            || headerSize + 4 * quint64(stringCount) > size) {
+        return false;
+    }
+    utf8 = readValue<quint32>(chunk + 16) & (1 << 8);
+    offsets = chunk + headerSize;
+    strings = chunk + stringsStart;
+    end = chunk + size;
+    return true;
+}
+
+int ResourceTable::StringPool::count() const
+{
+    return static_cast<int>(stringCount);
+}
+
+QString ResourceTable::StringPool::at(int index) const
+{
+    if (index < 0 || quint32(index) >= stringCount) {
+        return QString();
+    }
+    const quint32 offset = readValue<quint32>(offsets + 4 * index);
+    if (quint64(offset) + 4 > quint64(end - strings)) {
+        return QString();
+    }
+    const uchar *string = strings + offset;
+    if (utf8) {
+        string += (string[0] & 0x80) ? 2 : 1;
+        int length = string[0];
+        if (length & 0x80) {
+            length = ((length & 0x7F) << 8) | string[1];
+            string += 2;
+        } else {
+            string += 1;
+        }
+        if (length > end - string) {
+            return QString();
+        }
+        return QString::fromUtf8(reinterpret_cast<const char *>(string), length);
+    } else {
+        int length = readValue<quint16>(string);
+        if (length & 0x8000) {
+            length = ((length & 0x7FFF) << 16) | readValue<quint16>(string + 2);
+            string += 4;
+        } else {
+            string += 2;
+        }
+        if (2 * qint64(length) > end - string) {
+            return QString();
+        }
+        QString value(length, Qt::Uninitialized);
+        for (int i = 0; i < length; ++i) {
+            value[i] = QChar(readValue<quint16>(string + 2 * i));
+        }
+        return value;
+    }
+}
+
+// Resource table
+
+ResourceTable::ResourceTable(const QString &apkPath) : apk(apkPath) {}
+
+bool ResourceTable::open()
+{
+    if (!apk.open()) {
+        return false;
+    }
+    const auto entry = apk.getEntry("resources.arsc");
+    if (!entry) {
+        return false;
+    }
+    if (!entry->isCompressed()) {
+        // Stored tables (required since Android 11) are read straight from the mapped APK
+        const uchar *data = apk.getRawData(*entry);
+        return data && readTable(data, entry->uncompressedSize);
+    }
+    buffer = apk.read(*entry);
+    return readTable(reinterpret_cast<const uchar *>(buffer.constData()), buffer.size());
+}
+
+const QVector<ResourceTable::Entry> &ResourceTable::getEntries() const
+{
+    return entries;
+}
+
+QVector<const ResourceTable::Entry *> ResourceTable::findEntries(quint32 id) const
+{
+    QVector<const Entry *> result;
+    for (auto it = entryIndexes.constFind(id); it != entryIndexes.constEnd() && it.key() == id; ++it) {
+        result.append(&entries.at(it.value()));
+    }
+    return result;
+}
+
+QString ResourceTable::getPackageName(const Entry &entry) const
+{
+    return packages.at(entry.package).name;
+}
+
+QString ResourceTable::getTypeName(const Entry &entry) const
+{
+    return packages.at(entry.package).types.at(((entry.id >> 16) & 0xFF) - 1);
+}
+
+QString ResourceTable::getKeyName(const Entry &entry) const
+{
+    return packages.at(entry.package).keys.at(entry.key);
+}
+
+QString ResourceTable::getQualifiers(const Entry &entry) const
+{
+    return configs.at(entry.config);
+}
+
+QString ResourceTable::getResourceName(quint32 id) const
+{
+    const auto it = entryIndexes.constFind(id);
+    if (it == entryIndexes.constEnd()) {
+        return QString();
+    }
+    const Entry &entry = entries.at(it.value());
+    return QString("@%1/%2").arg(getTypeName(entry), getKeyName(entry));
+}
+
+QString ResourceTable::formatValue(const Value &value) const
+{
+    switch (value.type) {
+    case BinaryXml::TypeString:
+        return values.at(static_cast<int>(value.data));
+    case BinaryXml::TypeReference: {
+        const QString name = getResourceName(value.data);
+        return !name.isEmpty() ? name : BinaryXml::formatValue(value.type, value.data);
+    }
+    default:
+        return BinaryXml::formatValue(value.type, value.data);
+    }
+}
+
+QString ResourceTable::formatValue(const Entry &entry) const
+{
+    if (!entry.complex) {
+        return formatValue(entry.value);
+    }
+    QStringList items;
+    for (const MapItem &item : entry.items) {
+        items.append(formatValue(item.value));
+    }
+    return QString("[%1]").arg(items.join(", "));
+}
+
+QString ResourceTable::getQualifiers(const uchar *config, quint32 size)
+{
+    // Read more: https://developer.android.com/guide/topics/resources/providing-resources#AlternativeResources
+
+    auto u8 = [&](quint32 offset) -> quint8 { return offset < size ? config[offset] : 0; };
+    auto u16 = [&](quint32 offset) -> quint16 { return offset + 2 <= size ? readValue<quint16>(config + offset) : 0; };
+
+    QStringList qualifiers;
+
+    if (const quint16 mcc = u16(4)) {
+        qualifiers.append(QString("mcc%1").arg(mcc, 3, 10, QChar('0')));
+    }
+    if (const quint16 mnc = u16(6)) {
+        qualifiers.append(QString("mnc%1").arg(mnc == 0xFFFF ? 0 : mnc, 2, 10, QChar('0')));
+    }
+
+    const QString language = size >= 12 ? unpackLocaleCode(config + 8, 'a') : QString();
+    const QString region = size >= 12 ? unpackLocaleCode(config + 10, '0') : QString();
+    const QString script = size >= 40 ? trimmedLatin1(config + 36, 4) : QString();
+    const QString variant = size >= 48 ? trimmedLatin1(config + 40, 8) : QString();
+    if (!script.isEmpty() || !variant.isEmpty()) {
+        QStringList parts = {"b", language.isEmpty() ? "und" : language};
+        if (!script.isEmpty()) {
+            parts.append(script);
+        }
+        if (!region.isEmpty()) {
+            parts.append(region);
+        }
+        if (!variant.isEmpty()) {
+            parts.append(variant);
+        }
+        qualifiers.append(parts.join('+'));
+    } else if (!language.isEmpty()) {
+        qualifiers.append(region.isEmpty() ? language : QString("%1-r%2").arg(language, region));
+    }
+
+    const quint8 screenLayout = u8(28);
+    switch (screenLayout & 0xC0) {
+    case 0x40: qualifiers.append("ldltr"); break;
+    case 0x80: qualifiers.append("ldrtl"); break;
+    }
+    if (const quint16 smallestWidth = u16(30)) {
+        qualifiers.append(QString("sw%1dp").arg(smallestWidth));
+    }
+    if (const quint16 width = u16(32)) {
+        qualifiers.append(QString("w%1dp").arg(width));
+    }
+    if (const quint16 height = u16(34)) {
+        qualifiers.append(QString("h%1dp").arg(height));
+    }
+    switch (screenLayout & 0x0F) {
+    case 1: qualifiers.append("small"); break;
+    case 2: qualifiers.append("normal"); break;
+    case 3: qualifiers.append("large"); break;
+    case 4: qualifiers.append("xlarge"); break;
+    }
+    switch (screenLayout & 0x30) {
+    case 0x10: qualifiers.append("notlong"); break;
+    case 0x20: qualifiers.append("long"); break;
+    }
+    switch (u8(48) & 0x03) {
+    case 1: qualifiers.append("notround"); break;
+    case 2: qualifiers.append("round"); break;
+    }
+    const quint8 colorMode = u8(49);
+    switch (colorMode & 0x03) {
+    case 1: qualifiers.append("nowidecg"); break;
+    case 2: qualifiers.append("widecg"); break;
+    }
+    switch (colorMode & 0x0C) {
+    case 0x04: qualifiers.append("lowdr"); break;
+    case 0x08: qualifiers.append("highdr"); break;
+    }
+    switch (u8(12)) {
+    case 1: qualifiers.append("port"); break;
+    case 2: qualifiers.append("land"); break;
+    case 3: qualifiers.append("square"); break;
+    }
+    const quint8 uiMode = u8(29);
+    switch (uiMode & 0x0F) {
+    case 2: qualifiers.append("desk"); break;
+    case 3: qualifiers.append("car"); break;
+    case 4: qualifiers.append("television"); break;
+    case 5: qualifiers.append("appliance"); break;
+    case 6: qualifiers.append("watch"); break;
+    case 7: qualifiers.append("vrheadset"); break;
+    }
+    switch (uiMode & 0x30) {
+    case 0x10: qualifiers.append("notnight"); break;
+    case 0x20: qualifiers.append("night"); break;
+    }
+    const quint16 density = u16(14);
+    switch (density) {
+    case 0: break;
+    case 120: qualifiers.append("ldpi"); break;
+    case 160: qualifiers.append("mdpi"); break;
+    case 213: qualifiers.append("tvdpi"); break;
+    case 240: qualifiers.append("hdpi"); break;
+    case 320: qualifiers.append("xhdpi"); break;
+    case 480: qualifiers.append("xxhdpi"); break;
+    case 640: qualifiers.append("xxxhdpi"); break;
+    case 0xFFFE: qualifiers.append("anydpi"); break;
+    case 0xFFFF: qualifiers.append("nodpi"); break;
+    default: qualifiers.append(QString("%1dpi").arg(density)); break;
+    }
+    switch (u8(13)) {
+    case 1: qualifiers.append("notouch"); break;
+    case 3: qualifiers.append("finger"); break;
+    }
+    const quint8 inputFlags = u8(18);
+    switch (inputFlags & 0x03) {
+    case 1: qualifiers.append("keysexposed"); break;
+    case 2: qualifiers.append("keyshidden"); break;
+    case 3: qualifiers.append("keyssoft"); break;
+    }
+    switch (u8(16)) {
+    case 1: qualifiers.append("nokeys"); break;
+    case 2: qualifiers.append("qwerty"); break;
+    case 3: qualifiers.append("12key"); break;
+    }
+    switch (inputFlags & 0x0C) {
+    case 0x04: qualifiers.append("navexposed"); break;
+    case 0x08: qualifiers.append("navhidden"); break;
+    }
+    switch (u8(17)) {
+    case 1: qualifiers.append("nonav"); break;
+    case 2: qualifiers.append("dpad"); break;
+    case 3: qualifiers.append("trackball"); break;
+    case 4: qualifiers.append("wheel"); break;
+    }
+    const quint16 screenWidth = u16(20);
+    const quint16 screenHeight = u16(22);
+    if (screenWidth || screenHeight) {
+        qualifiers.append(QString("%1x%2").arg(screenWidth).arg(screenHeight));
+    }
+    if (const quint16 sdk = u16(24)) {
+        qualifiers.append(QString("v%1").arg(sdk));
+    }
+
+    return qualifiers.join('-');
+}
+
+bool ResourceTable::readTable(const uchar *data, quint64 size)
+{
+    if (size < 12 || readValue<quint16>(data) != TableChunk) {
+        qWarning() << "Resource table: invalid header";
+        return false;
+    }
+    quint64 offset = readValue<quint16>(data + 2);
+    while (offset + 8 <= size) {
+        const uchar *chunk = data + offset;
+        const quint16 type = readValue<quint16>(chunk);
+        const quint32 chunkSize = readValue<quint32>(chunk + 4);
+        if (chunkSize < 8 || chunkSize > size - offset) {
+            qWarning() << "Resource table: invalid chunk";
+            return false;
+        }
+        if (type == StringPoolChunk) {
+            if (!values.read(chunk, chunkSize)) {
+                return false;
+            }
+        } else if (type == PackageChunk) {
+            if (!readPackage(chunk, chunkSize)) {
+                return false;
+            }
+        }
+        offset += chunkSize;
+    }
+    return true;
+}
+
+bool ResourceTable::readPackage(const uchar *package, quint32 size)
+{
+    const quint16 headerSize = readValue<quint16>(package + 2);
+    if (headerSize < 284 || headerSize > size) {
+        return false;
+    }
+
+    Package info;
+    info.id = readValue<quint32>(package + 8);
+    QString name;
+    for (int i = 0; i < 128; ++i) {
+        const quint16 c = readValue<quint16>(package + 12 + 2 * i);
+        if (!c) {
+            break;
+        }
+        name.append(QChar(c));
+    }
+    info.name = name;
+    const quint32 typeStrings = readValue<quint32>(package + 268);
+    const quint32 keyStrings = readValue<quint32>(package + 276);
+    if (quint64(typeStrings) + 8 > size || quint64(keyStrings) + 8 > size) {
+        return false;
+    }
+    // The pools must not extend past the package chunk, whatever their own headers say:
+    const quint32 typeStringsSize = qMin(readValue<quint32>(package + typeStrings + 4), size - typeStrings);
+    const quint32 keyStringsSize = qMin(readValue<quint32>(package + keyStrings + 4), size - keyStrings);
+    if (!info.types.read(package + typeStrings, typeStringsSize) || !info.keys.read(package + keyStrings, keyStringsSize)) {
+        return false;
+    }
+    const int packageIndex = packages.count();
+    packages.append(info);
+
+    QHash<QString, int> configIndexes;
+    for (int i = 0; i < configs.count(); ++i) {
+        configIndexes.insert(configs.at(i), i);
+    }
+
+    quint64 chunkOffset = headerSize;
+    while (chunkOffset + 8 <= size) {
+        const uchar *chunk = package + chunkOffset;
+        const quint16 type = readValue<quint16>(chunk);
+        const quint16 chunkHeaderSize = readValue<quint16>(chunk + 2);
+        const quint32 chunkSize = readValue<quint32>(chunk + 4);
+        if (chunkSize < 8 || chunkHeaderSize > chunkSize || chunkSize > size - chunkOffset) {
+            return false;
+        }
+
+        if (type == TypeChunk && chunkHeaderSize >= 24) {
+            const quint8 typeId = chunk[8];
+            const quint8 flags = chunk[9];
+            const quint32 entryCount = readValue<quint32>(chunk + 12);
+            const quint32 entriesOffset = readValue<quint32>(chunk + 16);
+            const uchar *config = chunk + 20;
+            const quint32 configSize = qMin<quint32>(readValue<quint32>(config), chunkHeaderSize - 20);
+
+            const QString qualifiers = getQualifiers(config, configSize);
+            int configIndex = configIndexes.value(qualifiers, -1);
+            if (configIndex == -1) {
+                configIndex = configs.count();
+                configs.append(qualifiers);
+                configIndexes.insert(qualifiers, configIndex);
+            }
+
+            // Offsets are 16-bit in the compact tables, and 16-bit index and offset pairs in the sparse ones
+            const int offsetSize = (flags & Offset16TypeFlag) && !(flags & SparseTypeFlag) ? 2 : 4;
+            if (chunkHeaderSize + quint64(entryCount) * offsetSize > chunkSize || entriesOffset > chunkSize) {
+                return false;
+            }
+            const uchar *offsets = chunk + chunkHeaderSize;
+            const uchar *entriesStart = chunk + entriesOffset;
+            for (quint32 i = 0; i < entryCount; ++i) {
+                quint32 entryIndex = i;
+                quint32 offset;
+                if (flags & SparseTypeFlag) {
+                    entryIndex = readValue<quint16>(offsets + 4 * i);
+                    offset = readValue<quint16>(offsets + 4 * i + 2) * 4u;
+                } else if (flags & Offset16TypeFlag) {
+                    const quint16 offset16 = readValue<quint16>(offsets + 2 * i);
+                    if (offset16 == NoEntry16) {
+                        continue;
+                    }
+                    offset = offset16 * 4u;
+                } else {
+                    offset = readValue<quint32>(offsets + 4 * i);
+                    if (offset == NoEntry) {
+                        continue;
+                    }
+                }
+
+                const quint64 dataOffset = quint64(entriesOffset) + offset;
+                if (dataOffset + 8 > chunkSize) {
+                    return false;
+                }
+                const uchar *data = entriesStart + offset;
+
+                Entry entry;
+                entry.id = (info.id << 24) | (quint32(typeId) << 16) | entryIndex;
+                entry.package = packageIndex;
+                entry.config = configIndex;
+                entry.parent = 0;
+                const quint16 entryFlags = readValue<quint16>(data + 2);
+                if (entryFlags & CompactEntryFlag) {
+                    entry.key = readValue<quint16>(data);
+                    entry.complex = false;
+                    entry.value = {static_cast<quint8>(entryFlags >> 8), readValue<quint32>(data + 4)};
+                } else {
+                    const quint16 entrySize = readValue<quint16>(data);
+                    entry.key = static_cast<qint32>(readValue<quint32>(data + 4));
+                    entry.complex = entryFlags & ComplexEntryFlag;
+                    if (entry.complex) {
+                        if (dataOffset + 16 > chunkSize) {
+                            return false;
+                        }
+                        entry.value = {BinaryXml::TypeNull, 0};
+                        entry.parent = readValue<quint32>(data + 8);
+                        const quint32 count = readValue<quint32>(data + 12);
+                        if (dataOffset + entrySize + 12 * quint64(count) > chunkSize) {
+                            return false;
+                        }
+                        const uchar *item = data + entrySize;
+                        entry.items.reserve(static_cast<int>(count));
+                        for (quint32 j = 0; j < count; ++j, item += 12) {
+                            entry.items.append({readValue<quint32>(item), {item[7], readValue<quint32>(item + 8)}});
+                        }
+                    } else {
+                        if (dataOffset + entrySize + 8 > chunkSize) {
+                            return false;
+                        }
+                        const uchar *value = data + entrySize;
+                        entry.value = {value[3], readValue<quint32>(value + 4)};
+                    }
+                }
+                entryIndexes.insert(entry.id, entries.count());
+                entries.append(entry);
+            }
+        }
+
+        chunkOffset += chunkSize;
+    }
+
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef RESOURCETABLE_H
+#define RESOURCETABLE_H
+
+#include "base/ziparchive.h"
+#include <QMultiHash>
+
+// Compiled resource table ("resources.arsc") read directly from the APK.
+// The table is memory-mapped whenever it's stored uncompressed; strings are decoded on demand.
+
+class ResourceTable
+{
+public:
+    class StringPool
+    {
+    public:
+        bool read(const uchar *chunk, quint32 size);
+        int count() const;
+        QString at(int index) const;
+
+    private:
+        const uchar *offsets = nullptr;
+        const uchar *strings = nullptr;
+        const uchar *end = nullptr;
+        quint32 stringCount = 0;
+        bool utf8 = false;
+    };
+
+    struct Value
+    {
+        quint8 type;
+        quint32 data;
+    };
+
+    struct MapItem
+    {
+        quint32 name;
+        Value value;
+    };
+
+    struct Entry
+    {
+        quint32 id; // 0xPPTTEEEE
+        int package;
+        int config;
+        qint32 key;
+        bool complex;
+        Value value; // Simple entries only
+        quint32 parent; // Complex entries only
+        QVector<MapItem> items; // Complex entries only
+    };
+
+    explicit ResourceTable(const QString &apkPath);
+
+    bool open();
+
+    const QVector<Entry> &getEntries() const;
+    QVector<const Entry *> findEntries(quint32 id) const;
+    QString getPackageName(const Entry &entry) const;
+    QString getTypeName(const Entry &entry) const;
+    QString getKeyName(const Entry &entry) const;
+    QString getQualifiers(const Entry &entry) const;
+    QString getResourceName(quint32 id) const;
+    QString formatValue(const Value &value) const;
+    QString formatValue(const Entry &entry) const;
+
+    static QString getQualifiers(const uchar *config, quint32 size);
+
+private:
+    struct Package
+    {
+        quint32 id;
+        QString name;
+        StringPool types;
+        StringPool keys;
+    };
+
+    bool readTable(const uchar *data, quint64 size);
+    bool readPackage(const uchar *chunk, quint32 size);
+
+    ZipArchive apk;
+    QByteArray buffer; // Used when the table is compressed
+    StringPool values;
+    QVector<Package> packages;
+    QStringList configs;
+    QVector<Entry> entries;
+    QMultiHash<quint32, int> entryIndexes;
+};
+
+#endif // RESOURCETABLE_H
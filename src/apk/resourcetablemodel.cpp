@@ -0,0 +1,212 @@
+#include "apk/resourcetablemodel.h"
+#include "apk/resourcefile.h"
+#include "apk/resourcetable.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QFutureWatcher>
+
+ResourceTableModel::Node::Node(Node *parent, const QString &caption)
+    : parent(parent)
+    , row(parent ? parent->children.count() : 0)
+    , caption(caption)
+{
+    if (parent) {
+        parent->children.append(this);
+    }
+}
+
+ResourceTableModel::Node::~Node()
+{
+    qDeleteAll(children);
+}
+
+ResourceTableModel::ResourceTableModel(QObject *parent)
+    : QAbstractItemModel(parent)
+    , root(new Node)
+{}
+
+ResourceTableModel::~ResourceTableModel()
+{
+    delete root;
+    qDeleteAll(files);
+}
+
+void ResourceTableModel::initialize(const QString &apkPath)
+{
+    auto watcher = new QFutureWatcher<Contents>(this);
+    connect(watcher, &QFutureWatcher<Contents>::finished, this, [=]() {
+        const auto contents = watcher->result();
+        beginResetModel();
+            delete root;
+            qDeleteAll(files);
+            table = contents.table;
+            root = contents.root;
+            files = contents.files;
+        endResetModel();
+        emit initialized(!table.isNull());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&ResourceTableModel::load, apkPath));
+}
+
+QSharedPointer<const ResourceTable> ResourceTableModel::getTable() const
+{
+    return table;
+}
+
+ResourceTableModel::Contents ResourceTableModel::load(const QString &apkPath)
+{
+    Contents contents;
+    contents.root = new Node;
+
+    auto table = QSharedPointer<ResourceTable>(new ResourceTable(apkPath));
+    if (!table->open()) {
+        return contents;
+    }
+    contents.table = table;
+
+    QHash<QString, Node *> types;
+    QHash<quint32, Node *> resources;
+    QHash<QString, ResourceFile *> files;
+
+    const auto &entries = table->getEntries();
+    for (int i = 0; i < entries.count(); ++i) {
+        const auto &entry = entries.at(i);
+        const QString type = table->getTypeName(entry);
+
+        Node *typeNode = types.value(type);
+        if (!typeNode) {
+            typeNode = new Node(contents.root, type);
+            types.insert(type, typeNode);
+        }
+
+        Node *resourceNode = resources.value(entry.id);
+        if (!resourceNode) {
+            resourceNode = new Node(typeNode, table->getKeyName(entry));
+            resourceNode->id = entry.id;
+            resources.insert(entry.id, resourceNode);
+        }
+
+        // Reuse the qualifier parser of the unpacked resources
+        const QString qualifiers = table->getQualifiers(entry);
+        const QString directory = qualifiers.isEmpty() ? type : QString("%1-%2").arg(type, qualifiers);
+        ResourceFile *file = files.value(directory);
+        if (!file) {
+            file = new ResourceFile(QString("%1/%2").arg(directory, resourceNode->caption));
+            files.insert(directory, file);
+            contents.files.append(file);
+        }
+
+        Node *variantNode = new Node(resourceNode, qualifiers);
+        variantNode->id = entry.id;
+        variantNode->entry = i;
+        variantNode->file = file;
+    }
+
+    return contents;
+}
+
+QVariant ResourceTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    const Node *node = static_cast<Node *>(index.internalPointer());
+    const auto entry = node->entry != -1 ? &table->getEntries().at(node->entry) : nullptr;
+    const auto file = node->file;
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case SortRole:
+        switch (index.column()) {
+        case CaptionColumn:
+            if (entry) {
+                return !file->getReadableQualifiers().isEmpty() ? file->getReadableQualifiers() : tr("Default");
+            }
+            return node->caption;
+        case ValueColumn:
+            if (entry) {
+                return table->formatValue(*entry);
+            }
+            if (node->id && node->children.count() == 1) {
+                return table->formatValue(table->getEntries().at(node->children.first()->entry));
+            }
+            break;
+        case LanguageColumn:
+            return file ? file->getLanguageName() : QVariant();
+        case QualifiersColumn:
+            return entry ? table->getQualifiers(*entry) : QVariant();
+        case IdColumn:
+            if (role == SortRole) {
+                return node->id;
+            }
+            return node->id ? QString("0x%1").arg(node->id, 8, 16, QChar('0')) : QVariant();
+        }
+        break;
+    case Qt::DecorationRole:
+        if (index.column() == LanguageColumn && file && !file->getLocaleCode().isEmpty()) {
+            return file->getLanguageIcon();
+        }
+        break;
+    case Qt::ToolTipRole:
+        if (index.column() == ValueColumn) {
+            return data(index, Qt::DisplayRole);
+        }
+        break;
+    }
+    return QVariant();
+}
+
+QVariant ResourceTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal) {
+        switch (section) {
+        case CaptionColumn:
+            return tr("Resource");
+        case ValueColumn:
+            return tr("Value");
+        case LanguageColumn:
+            return tr("Language");
+        case QualifiersColumn:
+            //: This string refers to the Android qualifiers (https://developer.android.com/guide/topics/resources/providing-resources).
+            return tr("Qualifiers");
+        case IdColumn:
+            return "ID";
+        }
+    }
+    return QVariant();
+}
+
+QModelIndex ResourceTableModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!hasIndex(row, column, parent)) {
+        return QModelIndex();
+    }
+    const Node *parentNode = parent.isValid() ? static_cast<Node *>(parent.internalPointer()) : root;
+    return createIndex(row, column, parentNode->children.at(row));
+}
+
+QModelIndex ResourceTableModel::parent(const QModelIndex &index) const
+{
+    if (index.isValid()) {
+        const Node *parentNode = static_cast<Node *>(index.internalPointer())->parent;
+        if (parentNode != root) {
+            return createIndex(parentNode->row, 0, const_cast<Node *>(parentNode));
+        }
+    }
+    return QModelIndex();
+}
+
+int ResourceTableModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) {
+        return 0;
+    }
+    const Node *parentNode = parent.isValid() ? static_cast<Node *>(parent.internalPointer()) : root;
+    return parentNode->children.count();
+}
+
+int ResourceTableModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return ColumnCount;
+}
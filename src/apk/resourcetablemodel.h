@@ -0,0 +1,75 @@
+#ifndef RESOURCETABLEMODEL_H
+#define RESOURCETABLEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QSharedPointer>
+
+class ResourceFile;
+class ResourceTable;
+
+// Read-only tree of compiled resources (type -> resource -> configuration) read from "resources.arsc".
+
+class ResourceTableModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        CaptionColumn,
+        ValueColumn,
+        LanguageColumn,
+        QualifiersColumn,
+        IdColumn,
+        ColumnCount
+    };
+
+    enum Role {
+        SortRole = Qt::UserRole + 1
+    };
+
+    explicit ResourceTableModel(QObject *parent = nullptr);
+    ~ResourceTableModel() override;
+
+    void initialize(const QString &apkPath);
+    QSharedPointer<const ResourceTable> getTable() const;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &index) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+signals:
+    void initialized(bool success);
+
+private:
+    struct Node
+    {
+        Node(Node *parent = nullptr, const QString &caption = QString());
+        ~Node();
+
+        Node *parent;
+        int row;
+        QString caption;
+        quint32 id = 0;
+        int entry = -1;
+        const ResourceFile *file = nullptr;
+        QVector<Node *> children;
+    };
+
+    struct Contents
+    {
+        QSharedPointer<ResourceTable> table;
+        Node *root;
+        QList<ResourceFile *> files;
+    };
+
+    static Contents load(const QString &apkPath);
+
+    QSharedPointer<ResourceTable> table;
+    Node *root;
+    QList<ResourceFile *> files; // Parsed qualifiers shared by all entries of the same configuration
+};
+
+#endif // RESOURCETABLEMODEL_H
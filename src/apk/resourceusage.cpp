@@ -0,0 +1,195 @@
+#include "apk/resourceusage.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QDirIterator>
+#include <QRegularExpression>
+#include <QXmlStreamReader>
+
+ResourceUsage::ResourceUsage(const QString &contentsPath) : contentsPath(contentsPath) {}
+
+QFuture<QVector<UnusedResource>> ResourceUsage::analyze(const QString &contentsPath)
+{
+    return QtConcurrent::run([contentsPath]() {
+        return ResourceUsage(contentsPath).findUnused();
+    });
+}
+
+QVector<UnusedResource> ResourceUsage::findUnused()
+{
+    collectResourceFiles();
+    collectPublicIds();
+    collectRoots();
+
+    // Follow references transitively (e.g., layout -> drawable -> color):
+
+    while (!queue.isEmpty()) {
+        const auto key = queue.takeLast();
+        for (const auto &path : files.value(key)) {
+            if (path.endsWith(".xml", Qt::CaseInsensitive)) {
+                collectXmlReferences(path);
+            }
+        }
+    }
+
+    QVector<UnusedResource> unused;
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        if (used.contains(it.key())) {
+            continue;
+        }
+        const auto type = it.key().section('/', 0, 0);
+        const auto name = it.key().section('/', 1);
+        for (const auto &path : it.value()) {
+            unused.append({path, type, name, QFileInfo(path).size()});
+        }
+    }
+    std::sort(unused.begin(), unused.end(), [](const UnusedResource &a, const UnusedResource &b) {
+        return a.size > b.size;
+    });
+    return unused;
+}
+
+void ResourceUsage::collectResourceFiles()
+{
+    QDirIterator directories(contentsPath + "/res/", QDir::Dirs | QDir::NoDotAndDotDot);
+    while (directories.hasNext()) {
+        const QFileInfo directory(directories.next());
+        const QString type = directory.fileName().section('-', 0, 0);
+        if (type == "values") {
+            // Values are not file-based resources and are treated as roots
+            continue;
+        }
+        QDirIterator resourceFiles(directory.filePath(), QDir::Files);
+        while (resourceFiles.hasNext()) {
+            const QString path = resourceFiles.next();
+            const QString name = getResourceName(QFileInfo(path).fileName());
+            const QString key = getResourceKey(type, name);
+            auto &variants = files[key];
+            if (variants.isEmpty()) {
+                names[name].append(key);
+            }
+            variants.append(path);
+        }
+    }
+}
+
+void ResourceUsage::collectPublicIds()
+{
+    // Apktool stores the original resource IDs in "public.xml".
+    // They are required to resolve the numeric constants inlined into smali.
+
+    QFile file(contentsPath + "/res/values/public.xml");
+    if (!file.open(QFile::ReadOnly)) {
+        return;
+    }
+    QXmlStreamReader xml(&file);
+    while (!xml.atEnd()) {
+        if (xml.readNext() == QXmlStreamReader::StartElement && xml.name() == QLatin1String("public")) {
+            const auto attributes = xml.attributes();
+            bool ok;
+            const quint32 id = attributes.value("id").toUInt(&ok, 0);
+            if (ok) {
+                const auto type = attributes.value("type").toString();
+                const auto name = attributes.value("name").toString();
+                publicIds.insert(id, getResourceKey(type, name));
+            }
+        }
+    }
+}
+
+void ResourceUsage::collectRoots()
+{
+    collectXmlReferences(contentsPath + "/AndroidManifest.xml");
+
+    QDirIterator directories(contentsPath + "/res/", {"values*"}, QDir::Dirs | QDir::NoDotAndDotDot);
+    while (directories.hasNext()) {
+        QDirIterator values(directories.next(), {"*.xml"}, QDir::Files);
+        while (values.hasNext()) {
+            const QString path = values.next();
+            if (QFileInfo(path).fileName() != "public.xml") {
+                collectXmlReferences(path);
+            }
+        }
+    }
+
+    const auto smaliDirs = QDir(contentsPath).entryList({"smali*"}, QDir::Dirs);
+    for (const auto &smaliDir : smaliDirs) {
+        QDirIterator smali(QString("%1/%2/").arg(contentsPath, smaliDir), {"*.smali"}, QDir::Files, QDirIterator::Subdirectories);
+        while (smali.hasNext()) {
+            collectSmaliReferences(smali.next());
+        }
+    }
+}
+
+void ResourceUsage::collectSmaliReferences(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return;
+    }
+    const QString data = QString::fromUtf8(file.readAll());
+
+    // Inlined resource IDs, e.g. "const v0, 0x7f080001":
+    static const QRegularExpression idRegex("\\b0x(7f[0-9a-fA-F]{6})\\b");
+    auto ids = idRegex.globalMatch(data);
+    while (ids.hasNext()) {
+        const auto key = publicIds.value(ids.next().captured(1).toUInt(nullptr, 16));
+        if (!key.isEmpty()) {
+            markUsed(key);
+        }
+    }
+
+    // Non-inlined field access, e.g. "Lcom/example/R$drawable;->icon:I":
+    static const QRegularExpression fieldRegex("R\\$(\\w+);->(\\w+):I");
+    auto fields = fieldRegex.globalMatch(data);
+    while (fields.hasNext()) {
+        const auto match = fields.next();
+        markUsed(getResourceKey(match.captured(1), match.captured(2)));
+    }
+
+    // String constants which may be used in Resources.getIdentifier() lookups:
+    static const QRegularExpression stringRegex("const-string(?:/jumbo)? [vp]\\d+, \"(\\w+)\"");
+    auto strings = stringRegex.globalMatch(data);
+    while (strings.hasNext()) {
+        const auto keys = names.value(strings.next().captured(1));
+        for (const auto &key : keys) {
+            markUsed(key);
+        }
+    }
+}
+
+void ResourceUsage::collectXmlReferences(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        return;
+    }
+    const QString data = QString::fromUtf8(file.readAll());
+
+    // E.g., "@drawable/icon", "@com.example:layout/main" (framework resources are skipped):
+    static const QRegularExpression referenceRegex("@\\*?(?:([\\w.]+):)?(\\w+)/([\\w.]+)");
+    auto references = referenceRegex.globalMatch(data);
+    while (references.hasNext()) {
+        const auto match = references.next();
+        if (match.captured(1) != "android") {
+            markUsed(getResourceKey(match.captured(2), match.captured(3)));
+        }
+    }
+}
+
+void ResourceUsage::markUsed(const QString &key)
+{
+    if (files.contains(key) && !used.contains(key)) {
+        used.insert(key);
+        queue.append(key);
+    }
+}
+
+QString ResourceUsage::getResourceKey(const QString &type, const QString &name)
+{
+    return QString("%1/%2").arg(type, name);
+}
+
+QString ResourceUsage::getResourceName(const QString &filename)
+{
+    // Strips both regular and compound extensions (e.g., "icon.9.png" -> "icon")
+    return filename.section('.', 0, 0);
+}
@@ -0,0 +1,45 @@
+#ifndef RESOURCEUSAGE_H
+#define RESOURCEUSAGE_H
+
+#include <QFuture>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+struct UnusedResource
+{
+    QString path;
+    QString type;
+    QString name;
+    qint64 size;
+};
+
+class ResourceUsage
+{
+public:
+    ResourceUsage(const QString &contentsPath);
+
+    static QFuture<QVector<UnusedResource>> analyze(const QString &contentsPath);
+    QVector<UnusedResource> findUnused();
+
+private:
+    void collectResourceFiles();
+    void collectPublicIds();
+    void collectRoots();
+    void collectSmaliReferences(const QString &path);
+    void collectXmlReferences(const QString &path);
+    void markUsed(const QString &key);
+
+    static QString getResourceKey(const QString &type, const QString &name);
+    static QString getResourceName(const QString &filename);
+
+    QString contentsPath;
+    QHash<QString, QStringList> files; // Resource key -> file paths (one per qualifier set)
+    QHash<quint32, QString> publicIds; // Resource ID -> resource key
+    QHash<QString, QStringList> names; // Resource name -> resource keys
+    QSet<QString> used;
+    QStringList queue;
+};
+
+#endif // RESOURCEUSAGE_H
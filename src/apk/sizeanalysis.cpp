@@ -0,0 +1,150 @@
+#include "apk/sizeanalysis.h"
+#include "base/ziparchive.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QFileInfo>
+#include <QtEndian>
+
+namespace
+{
+    const int DexHeaderSize = 0x70;
+
+    struct DexEntry
+    {
+        const ZipArchive::Entry *entry;
+        SizeAnalysis::DexInfo info;
+    };
+
+    bool isDex(const QString &name)
+    {
+        return !name.contains('/') && name.startsWith("classes") && name.endsWith(".dex");
+    }
+}
+
+SizeAnalysis::Node &SizeAnalysis::Node::child(const QString &name)
+{
+    int index = childIndexes.value(name, -1);
+    if (index == -1) {
+        index = children.count();
+        Node node;
+        node.name = name;
+        children.append(node);
+        childIndexes.insert(name, index);
+    }
+    return children[index];
+}
+
+QFuture<SizeAnalysis::Node> SizeAnalysis::analyze(const QString &apkPath)
+{
+    return QtConcurrent::run(&SizeAnalysis::analyzeArchive, apkPath);
+}
+
+SizeAnalysis::Node SizeAnalysis::analyzeArchive(const QString &apkPath)
+{
+    Node root;
+    ZipArchive apk(apkPath);
+    if (!apk.open()) {
+        return root;
+    }
+    root.name = QFileInfo(apkPath).fileName();
+
+    const QString code = tr("Code");
+    const QString libraries = tr("Native Libraries");
+    const QString resources = tr("Resources");
+    const QString assets = tr("Assets");
+    const QString other = tr("Other");
+
+    // DEX headers are the only part that needs decompression, read them concurrently:
+
+    QVector<DexEntry> dexEntries;
+    for (const auto &entry : apk.getEntries()) {
+        if (isDex(entry.name)) {
+            dexEntries.append({&entry, DexInfo()});
+        }
+    }
+    QtConcurrent::blockingMap(dexEntries, [&apk](DexEntry &dex) {
+        dex.info = readDexHeader(apk.readHead(*dex.entry, DexHeaderSize));
+    });
+    QHash<QString, DexInfo> dexInfo;
+    for (const auto &dex : dexEntries) {
+        dexInfo.insert(dex.entry->name, dex.info);
+    }
+
+    for (const auto &entry : apk.getEntries()) {
+        if (entry.isDirectory()) {
+            continue;
+        }
+
+        QStringList path = entry.name.split('/', QString::SkipEmptyParts);
+        if (path.isEmpty()) {
+            continue;
+        }
+        const QString top = path.first();
+        if (isDex(entry.name)) {
+            path.prepend(code);
+        } else if (top == "lib" && path.count() > 2) {
+            path[0] = libraries; // Grouped by ABI
+        } else if (top == "res" && path.count() > 2) {
+            // Grouped by type, then by the qualified directory (e.g., "drawable" -> "drawable-xxhdpi")
+            path[0] = path.at(1).section('-', 0, 0);
+            path.prepend(resources);
+        } else if (top == "resources.arsc") {
+            path.prepend(resources);
+        } else if (top == "assets" && path.count() > 1) {
+            path[0] = assets;
+        } else {
+            path.prepend(other);
+        }
+
+        Node *node = &root;
+        for (const QString &name : path) {
+            node->size += entry.uncompressedSize;
+            node->compressedSize += entry.compressedSize;
+            node->files += 1;
+            node = &node->child(name);
+        }
+        node->size += entry.uncompressedSize;
+        node->compressedSize += entry.compressedSize;
+        node->files += 1;
+
+        if (dexInfo.contains(entry.name)) {
+            const DexInfo &info = dexInfo.value(entry.name);
+            if (info.valid) {
+                //: "%1", "%2" and "%3" will be replaced with the number of classes, methods and strings in a DEX file.
+                node->details = tr("Classes: %1, methods: %2, strings: %3").arg(info.classes).arg(info.methods).arg(info.strings);
+            }
+        } else if (top == "resources.arsc" || (top == "lib" && entry.name.endsWith(".so"))) {
+            // These are expected to be stored uncompressed to be memory-mapped at runtime
+            node->details = entry.isCompressed() ? tr("Compressed") : tr("Stored");
+        }
+    }
+
+    // Overall DEX statistics:
+
+    if (!dexEntries.isEmpty()) {
+        DexInfo total;
+        for (const auto &dex : dexEntries) {
+            total.classes += dex.info.classes;
+            total.methods += dex.info.methods;
+            total.strings += dex.info.strings;
+        }
+        root.child(code).details = tr("Classes: %1, methods: %2, strings: %3").arg(total.classes).arg(total.methods).arg(total.strings);
+    }
+
+    return root;
+}
+
+SizeAnalysis::DexInfo SizeAnalysis::readDexHeader(const QByteArray &header)
+{
+    DexInfo info;
+    if (header.size() < DexHeaderSize || !header.startsWith("dex\n")) {
+        return info;
+    }
+    const uchar *data = reinterpret_cast<const uchar *>(header.constData());
+    info.strings = qFromLittleEndian<quint32>(data + 0x38);
+    info.types = qFromLittleEndian<quint32>(data + 0x40);
+    info.fields = qFromLittleEndian<quint32>(data + 0x50);
+    info.methods = qFromLittleEndian<quint32>(data + 0x58);
+    info.classes = qFromLittleEndian<quint32>(data + 0x60);
+    info.valid = true;
+    return info;
+}
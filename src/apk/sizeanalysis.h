@@ -0,0 +1,47 @@
+#ifndef SIZEANALYSIS_H
+#define SIZEANALYSIS_H
+
+#include <QCoreApplication>
+#include <QFuture>
+#include <QHash>
+#include <QVector>
+
+// Breakdown of the APK size (code, native libraries, resources, assets) computed from
+// the ZIP central directory and the DEX headers, without unpacking the APK.
+
+class SizeAnalysis
+{
+    Q_DECLARE_TR_FUNCTIONS(SizeAnalysis)
+
+public:
+    struct Node
+    {
+        Node &child(const QString &name);
+
+        QString name;
+        QString details;
+        quint64 size = 0;
+        quint64 compressedSize = 0;
+        int files = 0;
+        QVector<Node> children;
+
+    private:
+        QHash<QString, int> childIndexes;
+    };
+
+    struct DexInfo
+    {
+        bool valid = false;
+        quint32 strings = 0;
+        quint32 types = 0;
+        quint32 methods = 0;
+        quint32 fields = 0;
+        quint32 classes = 0;
+    };
+
+    static QFuture<Node> analyze(const QString &apkPath);
+    static Node analyzeArchive(const QString &apkPath);
+    static DexInfo readDexHeader(const QByteArray &header);
+};
+
+#endif // SIZEANALYSIS_H
@@ -0,0 +1,368 @@
+#include "apk/smalichecker.h"
+#include "apk/smalitokenizer.h"
+#include <QDebug>
+#include <QFile>
+#include <QSet>
+#include <QTextStream>
+
+namespace
+{
+    struct Reference
+    {
+        int line;
+        QString name;
+    };
+
+    struct Method
+    {
+        int line = -1; // Of the .method directive
+        int parameterRegisters = 0;
+        int registers = -1; // Total, or -1 if not declared
+        int registersLine = -1;
+        bool hasInstructions = false;
+        QSet<QString> labels;
+        QVector<Reference> labelReferences;
+        QVector<Reference> registerReferences;
+    };
+
+    int countParameterRegisters(const QString &line, bool isStatic)
+    {
+        int count = isStatic ? 0 : 1; // "this"
+        const int open = line.indexOf('(');
+        const int close = line.indexOf(')', open);
+        if (open == -1 || close == -1) {
+            return count;
+        }
+        for (int i = open + 1; i < close; ++i) {
+            const QChar c = line.at(i);
+            if (c == '[' || c == 'L') {
+                // Arrays and objects are references, which take a single register
+                while (i < close && line.at(i) == '[') {
+                    ++i;
+                }
+                if (i < close && line.at(i) == 'L') {
+                    i = line.indexOf(';', i);
+                    if (i == -1 || i > close) {
+                        break;
+                    }
+                }
+                ++count;
+            } else {
+                // Long and double take a register pair
+                count += (c == 'J' || c == 'D') ? 2 : 1;
+            }
+        }
+        return count;
+    }
+
+    QStringList splitOperands(const QString &operands)
+    {
+        QStringList result;
+        QString current;
+        bool isQuoted = false;
+        int depth = 0;
+        for (int i = 0; i < operands.size(); ++i) {
+            const QChar c = operands.at(i);
+            if (isQuoted) {
+                current.append(c);
+                if (c == '\\' && i + 1 < operands.size()) {
+                    current.append(operands.at(++i));
+                } else if (c == '"') {
+                    isQuoted = false;
+                }
+                continue;
+            }
+            if (c == '"') {
+                isQuoted = true;
+            } else if (c == '{') {
+                ++depth;
+            } else if (c == '}') {
+                --depth;
+            } else if (c == ',' && depth == 0) {
+                result.append(current.trimmed());
+                current.clear();
+                continue;
+            }
+            current.append(c);
+        }
+        if (!result.isEmpty() || !current.trimmed().isEmpty()) {
+            result.append(current.trimmed());
+        }
+        return result;
+    }
+
+    // Operand kinds: register, register list (R), label, string, integer, type, field and method reference.
+    char getOperandKind(const QString &operand)
+    {
+        if (operand.isEmpty()) {
+            return '?';
+        }
+        const QChar c = operand.at(0);
+        if (c == '{') {
+            return 'R';
+        } else if (SmaliTokenizer::isRegister(QStringRef(&operand))) {
+            return 'r';
+        } else if (c == ':') {
+            return 'l';
+        } else if (c == '"') {
+            return 's';
+        } else if (c.isDigit() || (c == '-' && operand.size() > 1 && operand.at(1).isDigit())) {
+            return 'i';
+        } else if (operand.contains("->")) {
+            return operand.contains('(') ? 'm' : 'f';
+        } else if (c == 'L' || c == '[') {
+            return 't';
+        }
+        return '?';
+    }
+
+    // Returns the expected operand kinds, or "*" if the operands are not checked
+    const char *getOperandShape(const QString &opcode)
+    {
+        if (opcode == "nop" || opcode.startsWith("return-void")) {
+            return "";
+        } else if (opcode.startsWith("move-result") || opcode == "move-exception" || opcode.startsWith("return")
+                   || opcode.startsWith("monitor-") || opcode == "throw") {
+            return "r";
+        } else if (opcode.startsWith("move")) {
+            return "rr";
+        } else if (opcode.startsWith("const-string")) {
+            return "rs";
+        } else if (opcode == "const-class" || opcode == "check-cast" || opcode == "new-instance") {
+            return "rt";
+        } else if (opcode.startsWith("const-method")) {
+            return "*";
+        } else if (opcode.startsWith("const")) {
+            return "ri";
+        } else if (opcode == "instance-of" || opcode == "new-array") {
+            return "rrt";
+        } else if (opcode == "array-length") {
+            return "rr";
+        } else if (opcode.startsWith("filled-new-array")) {
+            return "Rt";
+        } else if (opcode == "fill-array-data" || opcode == "packed-switch" || opcode == "sparse-switch") {
+            return "rl";
+        } else if (opcode.startsWith("goto")) {
+            return "l";
+        } else if (opcode.startsWith("if-")) {
+            return opcode.endsWith('z') ? "rl" : "rrl";
+        } else if (opcode.startsWith("cmp") || opcode.startsWith("aget") || opcode.startsWith("aput")) {
+            return "rrr";
+        } else if (opcode.contains("quick") || opcode.startsWith("execute-inline") || opcode == "throw-verification-error"
+                   || opcode.startsWith("invoke-custom") || opcode.startsWith("invoke-polymorphic")) {
+            return "*";
+        } else if (opcode.startsWith("iget") || opcode.startsWith("iput")) {
+            return "rrf";
+        } else if (opcode.startsWith("sget") || opcode.startsWith("sput")) {
+            return "rf";
+        } else if (opcode.startsWith("invoke-")) {
+            return "Rm";
+        } else if (opcode.endsWith("/2addr")) {
+            return "rr";
+        } else if (opcode.startsWith("rsub-int") || opcode.endsWith("/lit8") || opcode.endsWith("/lit16")) {
+            return "rri";
+        } else if (opcode.startsWith("neg-") || opcode.startsWith("not-") || opcode.contains("-to-")) {
+            return "rr";
+        }
+        return "rrr"; // Binary operations, e.g., "add-int"
+    }
+}
+
+QVector<SmaliChecker::Error> SmaliChecker::check(const QString &text)
+{
+    QVector<Error> errors;
+    QVector<SmaliTokenizer::Token> tokens;
+    QVector<SmaliTokenizer::Fold> folds;
+    SmaliTokenizer::State state;
+    Method method;
+
+    auto getOperandKindName = [](char kind) -> QString {
+        switch (kind) {
+        case 'r': return tr("register");
+        case 'R': return tr("register list");
+        case 'l': return tr("label");
+        case 's': return tr("string");
+        case 'i': return tr("number");
+        case 't': return tr("type");
+        case 'f': return tr("field reference");
+        case 'm': return tr("method reference");
+        }
+        return QString();
+    };
+
+    // Registers and labels are resolved once the whole method is read:
+    auto finishMethod = [&]() {
+        if (method.registers == -1) {
+            if (method.hasInstructions) {
+                errors.append({method.line, tr("Missing .registers or .locals directive.")});
+            }
+        } else if (method.registers < method.parameterRegisters) {
+            //: "%1" is the number of registers declared with the .registers directive.
+            errors.append({method.registersLine, tr("The method takes %n parameter register(s), but only %1 registers are declared.",
+                                                    nullptr, method.parameterRegisters).arg(method.registers)});
+        } else {
+            for (const Reference &reference : qAsConst(method.registerReferences)) {
+                const bool isParameter = reference.name.at(0) == 'p';
+                const int number = reference.name.midRef(1).toInt();
+                const int count = isParameter ? method.parameterRegisters : method.registers;
+                if (number >= count) {
+                    errors.append({reference.line, isParameter
+                        ? tr("Register %1 is out of range: the method has %n parameter register(s).", nullptr, count).arg(reference.name)
+                        : tr("Register %1 is out of range: the method has %n register(s).", nullptr, count).arg(reference.name)});
+                }
+            }
+        }
+        for (const Reference &reference : qAsConst(method.labelReferences)) {
+            if (!method.labels.contains(reference.name)) {
+                errors.append({reference.line, tr("Undefined label \"%1\".").arg(reference.name)});
+            }
+        }
+        method = Method();
+    };
+
+    const QStringList lines = text.split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        const QString &line = lines.at(i);
+        tokens.clear();
+        folds.clear();
+        const SmaliTokenizer::State previousState = state;
+        state = SmaliTokenizer::tokenize(line, state, tokens, folds);
+
+        const bool hasComment = !tokens.isEmpty() && tokens.last().type == SmaliTokenizer::Comment;
+        const QString code = line.left(hasComment ? tokens.last().start : line.size()).trimmed();
+        if (code.isEmpty()) {
+            continue;
+        }
+
+        auto addLabelReferences = [&]() {
+            for (const auto &token : qAsConst(tokens)) {
+                if (token.type == SmaliTokenizer::Label) {
+                    method.labelReferences.append({i, line.mid(token.start + 1, token.length - 1)});
+                }
+            }
+        };
+
+        const bool inMethodBody = previousState.method && previousState.block == SmaliTokenizer::NoRegion;
+        if (inMethodBody) {
+            for (const auto &token : qAsConst(tokens)) {
+                if (token.type == SmaliTokenizer::Register) {
+                    method.registerReferences.append({i, line.mid(token.start, token.length)});
+                }
+            }
+        }
+
+        if (code.startsWith('.')) {
+            const auto &first = tokens.first();
+            const QString directive = line.mid(first.start, first.length).simplified(); // E.g., ".end method"
+            if (directive == ".method") {
+                if (previousState.method) {
+                    errors.append({method.line, tr("The method is not closed with .end method.")});
+                    method = Method();
+                }
+                bool isStatic = false;
+                for (const auto &token : qAsConst(tokens)) {
+                    if (token.type == SmaliTokenizer::Keyword && line.midRef(token.start, token.length) == QLatin1String("static")) {
+                        isStatic = true;
+                    }
+                }
+                method.line = i;
+                method.parameterRegisters = countParameterRegisters(line, isStatic);
+            } else if (directive == ".end method") {
+                if (previousState.method) {
+                    finishMethod();
+                } else {
+                    errors.append({i, tr("Unexpected .end method.")});
+                }
+            } else if (directive == ".registers" || directive == ".locals") {
+                if (!previousState.method) {
+                    errors.append({i, tr("The %1 directive is only allowed inside of a method.").arg(directive)});
+                    continue;
+                }
+                bool ok;
+                const int count = code.mid(first.length).trimmed().toInt(&ok, 0);
+                if (!ok || count < 0) {
+                    errors.append({i, tr("Invalid register count.")});
+                } else {
+                    method.registers = directive == ".locals" ? count + method.parameterRegisters : count;
+                    method.registersLine = i;
+                }
+            } else if ((directive == ".catch" || directive == ".catchall") && previousState.method) {
+                addLabelReferences();
+            }
+            continue;
+        }
+
+        // Switch payloads list their targets, e.g., ":pswitch_0" lines in a .packed-switch block
+        if (previousState.block != SmaliTokenizer::NoRegion) {
+            if (previousState.method && (previousState.block == SmaliTokenizer::PackedSwitchRegion
+                                      || previousState.block == SmaliTokenizer::SparseSwitchRegion)) {
+                addLabelReferences();
+            }
+            continue;
+        }
+
+        if (code.startsWith(':')) {
+            if (previousState.method) {
+                const auto &first = tokens.first();
+                const QString label = line.mid(first.start + 1, first.length - 1);
+                if (method.labels.contains(label)) {
+                    errors.append({i, tr("Duplicate label \"%1\".").arg(label)});
+                }
+                method.labels.insert(label);
+            }
+            continue;
+        }
+
+        int opcodeEnd = 0;
+        while (opcodeEnd < code.size() && !code.at(opcodeEnd).isSpace()) {
+            ++opcodeEnd;
+        }
+        const QString opcode = code.left(opcodeEnd);
+        if (!previousState.method) {
+            errors.append({i, tr("Instruction outside of a method.")});
+            continue;
+        }
+        if (!SmaliTokenizer::isOpcode(QStringRef(&opcode))) {
+            errors.append({i, tr("Unknown instruction \"%1\".").arg(opcode)});
+            continue;
+        }
+        method.hasInstructions = true;
+        addLabelReferences();
+
+        const QString shape = getOperandShape(opcode);
+        if (shape == "*") {
+            continue;
+        }
+        const QStringList operands = splitOperands(code.mid(opcodeEnd));
+        if (operands.size() != shape.size()) {
+            errors.append({i, tr("The \"%1\" instruction takes %n operand(s).", nullptr, shape.size()).arg(opcode)});
+            continue;
+        }
+        for (int operand = 0; operand < operands.size(); ++operand) {
+            const char kind = shape.at(operand).toLatin1();
+            if (getOperandKind(operands.at(operand)) != kind) {
+                //: "%1" is the operand position, "%2" is the instruction, "%3" is the expected operand kind (e.g., "register").
+                errors.append({i, tr("Operand %1 of the \"%2\" instruction must be a %3.")
+                                   .arg(operand + 1).arg(opcode, getOperandKindName(kind))});
+                break;
+            }
+        }
+    }
+
+    if (state.method) {
+        errors.append({method.line, tr("The method is not closed with .end method.")});
+    }
+    return errors;
+}
+
+QVector<SmaliChecker::Error> SmaliChecker::checkFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        qWarning() << "Error: Could not read smali file" << path;
+        return {};
+    }
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    return check(stream.readAll());
+}
@@ -0,0 +1,26 @@
+#ifndef SMALICHECKER_H
+#define SMALICHECKER_H
+
+#include <QCoreApplication>
+#include <QVector>
+
+// Syntax and structure checks of smali code: unknown instructions, operand shapes, label resolution,
+// register numbers against the .registers/.locals counts, and unbalanced .method blocks.
+// Meant to catch the common mistakes in milliseconds, before apktool is run; it is not a full assembler.
+
+class SmaliChecker
+{
+    Q_DECLARE_TR_FUNCTIONS(SmaliChecker)
+
+public:
+    struct Error
+    {
+        int line; // Zero-based
+        QString message;
+    };
+
+    static QVector<Error> check(const QString &text);
+    static QVector<Error> checkFile(const QString &path);
+};
+
+#endif // SMALICHECKER_H
@@ -0,0 +1,362 @@
+#include "apk/smalitokenizer.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+    // Sorted, so that the words can be looked up with a binary search, without allocating strings:
+
+    const char *const Opcodes[] = {
+        "add-double", "add-double/2addr", "add-float", "add-float/2addr", "add-int", "add-int/2addr",
+        "add-int/lit16", "add-int/lit8", "add-long", "add-long/2addr", "aget", "aget-boolean", "aget-byte",
+        "aget-char", "aget-object", "aget-short", "aget-wide", "and-int", "and-int/2addr", "and-int/lit16",
+        "and-int/lit8", "and-long", "and-long/2addr", "aput", "aput-boolean", "aput-byte", "aput-char",
+        "aput-object", "aput-short", "aput-wide", "array-length", "check-cast", "cmp-long", "cmpg-double",
+        "cmpg-float", "cmpl-double", "cmpl-float", "const", "const-class", "const-method-handle",
+        "const-method-type", "const-string", "const-string/jumbo", "const-wide", "const-wide/16", "const-wide/32",
+        "const-wide/high16", "const/16", "const/4", "const/high16", "div-double", "div-double/2addr", "div-float",
+        "div-float/2addr", "div-int", "div-int/2addr", "div-int/lit16", "div-int/lit8", "div-long",
+        "div-long/2addr", "double-to-float", "double-to-int", "double-to-long", "execute-inline",
+        "execute-inline/range", "fill-array-data", "filled-new-array", "filled-new-array/range", "float-to-double",
+        "float-to-int", "float-to-long", "goto", "goto/16", "goto/32", "if-eq", "if-eqz", "if-ge", "if-gez",
+        "if-gt", "if-gtz", "if-le", "if-lez", "if-lt", "if-ltz", "if-ne", "if-nez", "iget", "iget-boolean",
+        "iget-byte", "iget-char", "iget-object", "iget-object-volatile", "iget-quick", "iget-short",
+        "iget-volatile", "iget-wide", "iget-wide-volatile", "instance-of", "int-to-byte", "int-to-char",
+        "int-to-double", "int-to-float", "int-to-long", "int-to-short", "invoke-custom", "invoke-custom/range",
+        "invoke-direct", "invoke-direct/range", "invoke-interface", "invoke-interface/range",
+        "invoke-object-init/range", "invoke-polymorphic", "invoke-polymorphic/range", "invoke-static",
+        "invoke-static/range", "invoke-super", "invoke-super/range", "invoke-virtual", "invoke-virtual/range",
+        "iput", "iput-boolean", "iput-byte", "iput-char", "iput-object", "iput-short", "iput-volatile", "iput-wide",
+        "iput-wide-volatile", "long-to-double", "long-to-float", "long-to-int", "monitor-enter", "monitor-exit",
+        "move", "move-exception", "move-object", "move-object/16", "move-object/from16", "move-result",
+        "move-result-object", "move-result-wide", "move-wide", "move-wide/16", "move-wide/from16", "move/16",
+        "move/from16", "mul-double", "mul-double/2addr", "mul-float", "mul-float/2addr", "mul-int", "mul-int/2addr",
+        "mul-int/lit16", "mul-int/lit8", "mul-long", "mul-long/2addr", "neg-double", "neg-float", "neg-int",
+        "neg-long", "new-array", "new-instance", "nop", "not-int", "not-long", "or-int", "or-int/2addr",
+        "or-int/lit16", "or-int/lit8", "or-long", "or-long/2addr", "packed-switch", "rem-double",
+        "rem-double/2addr", "rem-float", "rem-float/2addr", "rem-int", "rem-int/2addr", "rem-int/lit16",
+        "rem-int/lit8", "rem-long", "rem-long/2addr", "return", "return-object", "return-void",
+        "return-void-barrier", "return-wide", "rsub-int", "rsub-int/lit8", "sget", "sget-boolean", "sget-byte",
+        "sget-char", "sget-object", "sget-object-volatile", "sget-short", "sget-volatile", "sget-wide",
+        "sget-wide-volatile", "shl-int", "shl-int/2addr", "shl-int/lit8", "shl-long", "shl-long/2addr", "shr-int",
+        "shr-int/2addr", "shr-int/lit8", "shr-long", "shr-long/2addr", "sparse-switch", "sput", "sput-boolean",
+        "sput-byte", "sput-char", "sput-object", "sput-short", "sput-volatile", "sput-wide", "sput-wide-volatile",
+        "sub-double", "sub-double/2addr", "sub-float", "sub-float/2addr", "sub-int", "sub-int/2addr", "sub-long",
+        "sub-long/2addr", "throw", "throw-verification-error", "ushr-int", "ushr-int/2addr", "ushr-int/lit8",
+        "ushr-long", "ushr-long/2addr", "xor-int", "xor-int/2addr", "xor-int/lit16", "xor-int/lit8", "xor-long",
+        "xor-long/2addr"
+    };
+
+    const char *const Keywords[] = {
+        "abstract", "annotation", "bridge", "build", "constructor", "declared-synchronized", "enum", "final",
+        "interface", "native", "private", "protected", "public", "runtime", "static", "strictfp", "synchronized",
+        "synthetic", "system", "transient", "varargs", "volatile"
+    };
+
+    struct WordLess
+    {
+        bool operator()(const char *a, const QStringRef &b) const { return b.compare(QLatin1String(a)) > 0; }
+        bool operator()(const QStringRef &a, const char *b) const { return a.compare(QLatin1String(b)) < 0; }
+    };
+
+    template <size_t N>
+    bool contains(const char *const (&table)[N], const QStringRef &word)
+    {
+        return std::binary_search(std::begin(table), std::end(table), word, WordLess());
+    }
+
+    bool isWordChar(QChar c)
+    {
+        return c.isLetterOrNumber() || c == '_' || c == '$' || c == '-' || c == '/';
+    }
+
+    bool isLabelChar(QChar c)
+    {
+        return c.isLetterOrNumber() || c == '_' || c == '$';
+    }
+
+    SmaliTokenizer::Region getRegion(const QStringRef &directive)
+    {
+        if (directive == QLatin1String("method")) {
+            return SmaliTokenizer::MethodRegion;
+        } else if (directive == QLatin1String("annotation")) {
+            return SmaliTokenizer::AnnotationRegion;
+        } else if (directive == QLatin1String("array-data")) {
+            return SmaliTokenizer::ArrayDataRegion;
+        } else if (directive == QLatin1String("packed-switch")) {
+            return SmaliTokenizer::PackedSwitchRegion;
+        } else if (directive == QLatin1String("sparse-switch")) {
+            return SmaliTokenizer::SparseSwitchRegion;
+        }
+        return SmaliTokenizer::NoRegion;
+    }
+}
+
+bool SmaliTokenizer::State::operator==(const State &other) const
+{
+    return method == other.method && block == other.block;
+}
+
+bool SmaliTokenizer::State::operator!=(const State &other) const
+{
+    return !(*this == other);
+}
+
+SmaliTokenizer::State SmaliTokenizer::tokenize(const QString &line, State state, QVector<Token> &tokens, QVector<Fold> &folds)
+{
+    const int length = line.size();
+    int position = 0;
+    bool isFirst = true;
+    while (position < length) {
+        const QChar c = line.at(position);
+        if (c.isSpace()) {
+            ++position;
+            continue;
+        }
+        const int start = position;
+        const bool isFirstToken = isFirst;
+        isFirst = false;
+        const QChar next = position + 1 < length ? line.at(position + 1) : QChar();
+
+        if (c == '#') {
+            tokens.append({Comment, start, length - start});
+            break;
+        }
+
+        if (c == '"') {
+            int segment = start;
+            ++position;
+            while (position < length && line.at(position) != '"') {
+                if (line.at(position) == '\\' && position + 1 < length) {
+                    if (position > segment) {
+                        tokens.append({String, segment, position - segment});
+                    }
+                    const int escapeLength = line.at(position + 1) == 'u' ? qMin(6, length - position) : 2;
+                    tokens.append({StringEscape, position, escapeLength});
+                    position += escapeLength;
+                    segment = position;
+                } else {
+                    ++position;
+                }
+            }
+            position = qMin(position + 1, length);
+            if (position > segment) {
+                tokens.append({String, segment, position - segment});
+            }
+            continue;
+        }
+
+        if (c == '\'') {
+            ++position;
+            while (position < length && line.at(position) != '\'') {
+                position += line.at(position) == '\\' ? 2 : 1;
+            }
+            position = qMin(position + 1, length);
+            tokens.append({Char, start, position - start});
+            continue;
+        }
+
+        if (c == '.' && next == '.') {
+            // Register range, e.g., "{v0 .. v5}"
+            position += 2;
+            tokens.append({Operator, start, 2});
+            continue;
+        }
+
+        if (c == '.' && isFirstToken) {
+            ++position;
+            while (position < length && isWordChar(line.at(position))) {
+                ++position;
+            }
+            QStringRef name = line.midRef(start + 1, position - start - 1);
+            const bool isEnd = name == QLatin1String("end");
+            if (isEnd) {
+                // E.g., ".end method"
+                while (position < length && line.at(position).isSpace()) {
+                    ++position;
+                }
+                const int nameStart = position;
+                while (position < length && isWordChar(line.at(position))) {
+                    ++position;
+                }
+                name = line.midRef(nameStart, position - nameStart);
+            }
+            tokens.append({Directive, start, position - start});
+            const Region region = getRegion(name);
+            if (region == MethodRegion) {
+                state.method = !isEnd;
+                state.block = NoRegion;
+                folds.append({region, !isEnd});
+            } else if (region != NoRegion) {
+                state.block = isEnd ? NoRegion : region;
+                folds.append({region, !isEnd});
+            }
+            continue;
+        }
+
+        if (c == ':') {
+            if (start == 0 || !isLabelChar(line.at(start - 1))) {
+                // Label, e.g., ":cond_0"
+                ++position;
+                while (position < length && isLabelChar(line.at(position))) {
+                    ++position;
+                }
+                tokens.append({Label, start, position - start});
+            } else {
+                // Field type, e.g., "name:Ljava/lang/String;"
+                position = readDescriptor(line, position + 1, tokens);
+            }
+            continue;
+        }
+
+        if (c == '-' && next == '>') {
+            position += 2;
+            tokens.append({Operator, start, 2});
+            continue;
+        }
+
+        if (c == '(') {
+            // Method prototype, e.g., "(ILjava/lang/String;)V"
+            ++position;
+            while (position < length && line.at(position) != ')') {
+                const int end = readDescriptor(line, position, tokens);
+                if (end == position) {
+                    break;
+                }
+                position = end;
+            }
+            if (position < length && line.at(position) == ')') {
+                position = readDescriptor(line, position + 1, tokens);
+            }
+            continue;
+        }
+
+        if (c.isDigit() || (c == '-' && next.isDigit())) {
+            ++position;
+            const bool isHex = line.midRef(start, 3).startsWith(QLatin1String("0x"))
+                            || line.midRef(start, 3).startsWith(QLatin1String("-0x"));
+            bool isFloat = false;
+            while (position < length) {
+                const QChar d = line.at(position);
+                if (d == '.' || (!isHex && (d == 'e' || d == 'E'))) {
+                    isFloat = true;
+                } else if ((d == '-' || d == '+') && isFloat && !isHex) {
+                    // Exponent sign
+                } else if (!d.isLetterOrNumber()) {
+                    break;
+                }
+                ++position;
+            }
+            const QChar suffix = line.at(position - 1);
+            if (!isHex && (suffix == 'f' || suffix == 'F' || suffix == 'd' || suffix == 'D')) {
+                isFloat = true;
+            }
+            tokens.append({isHex ? Hex : (isFloat ? Float : Decimal), start, position - start});
+            continue;
+        }
+
+        if (c == 'L' || c == '[') {
+            const int end = readDescriptor(line, position, tokens);
+            if (end != position) {
+                position = end;
+                continue;
+            }
+        }
+
+        if (c == '<' && next.isLetter()) {
+            // Constructor, e.g., "<init>"
+            const int end = line.indexOf('>', position);
+            position = end != -1 ? end + 1 : length;
+            tokens.append({Method, start, position - start});
+            continue;
+        }
+
+        if (isWordChar(c)) {
+            while (position < length && isWordChar(line.at(position))) {
+                ++position;
+            }
+            const QStringRef word = line.midRef(start, position - start);
+            const QChar following = position < length ? line.at(position) : QChar();
+            if (isFirstToken && state.method && state.block == NoRegion && isOpcode(word)) {
+                tokens.append({Opcode, start, position - start});
+            } else if (following == '(') {
+                tokens.append({Method, start, position - start});
+            } else if (following == ':') {
+                tokens.append({Field, start, position - start});
+            } else if (isRegister(word)) {
+                tokens.append({Register, start, position - start});
+            } else if (word == QLatin1String("true") || word == QLatin1String("false")) {
+                tokens.append({Boolean, start, position - start});
+            } else if (isKeyword(word)) {
+                tokens.append({Keyword, start, position - start});
+            }
+            continue;
+        }
+
+        ++position;
+    }
+    return state;
+}
+
+bool SmaliTokenizer::isOpcode(const QStringRef &word)
+{
+    return contains(Opcodes, word);
+}
+
+bool SmaliTokenizer::isKeyword(const QStringRef &word)
+{
+    return contains(Keywords, word);
+}
+
+bool SmaliTokenizer::isRegister(const QStringRef &word)
+{
+    if (word.size() < 2 || (word.at(0) != 'v' && word.at(0) != 'p')) {
+        return false;
+    }
+    for (int i = 1; i < word.size(); ++i) {
+        if (!word.at(i).isDigit()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int SmaliTokenizer::readDescriptor(const QString &line, int position, QVector<Token> &tokens)
+{
+    const int length = line.size();
+    const int start = position;
+    while (position < length && line.at(position) == '[') {
+        ++position;
+    }
+    if (position >= length) {
+        return start;
+    }
+    const QChar c = line.at(position);
+    if (c == 'L') {
+        // Class, e.g., "Ljava/lang/Object;"
+        const int end = line.indexOf(';', position);
+        if (end == -1) {
+            return start;
+        }
+        for (int i = position + 1; i < end; ++i) {
+            const QChar ch = line.at(i);
+            if (!isWordChar(ch) && ch != '<' && ch != '>') {
+                return start;
+            }
+        }
+        const QStringRef name = line.midRef(position + 1, end - position - 1);
+        const bool isBuiltin = name.startsWith(QLatin1String("java/"))
+                            || name.startsWith(QLatin1String("javax/"))
+                            || name.startsWith(QLatin1String("dalvik/"))
+                            || name.startsWith(QLatin1String("android/"));
+        tokens.append({isBuiltin ? BuiltinType : Type, start, end + 1 - start});
+        return end + 1;
+    }
+    if (c.unicode() < 128 && c.unicode() != 0 && std::strchr("ZBSCIJFDV", c.toLatin1())) {
+        // Primitive, e.g., "I" or "[Z"
+        tokens.append({Type, start, position + 1 - start});
+        return position + 1;
+    }
+    return start;
+}
@@ -0,0 +1,75 @@
+#ifndef SMALITOKENIZER_H
+#define SMALITOKENIZER_H
+
+#include <QStringRef>
+#include <QVector>
+
+// Single-pass smali tokenizer, used to highlight and fold smali files without the generic syntax engine.
+// Lines are tokenized one at a time: the state at the end of a line is passed on to the next one.
+
+class SmaliTokenizer
+{
+public:
+    enum TokenType : quint8 {
+        Comment,
+        Directive,
+        Keyword,
+        Opcode,
+        Register,
+        Label,
+        Type,
+        BuiltinType,
+        Method,
+        Field,
+        Decimal,
+        Hex,
+        Float,
+        Boolean,
+        Char,
+        String,
+        StringEscape,
+        Operator,
+        TokenTypeCount
+    };
+
+    enum Region : quint8 {
+        NoRegion,
+        MethodRegion,
+        AnnotationRegion,
+        ArrayDataRegion,
+        PackedSwitchRegion,
+        SparseSwitchRegion
+    };
+
+    struct Token
+    {
+        TokenType type;
+        int start;
+        int length;
+    };
+
+    struct Fold
+    {
+        Region region;
+        bool begin;
+    };
+
+    struct State
+    {
+        bool method = false; // Inside of the .method block
+        Region block = NoRegion; // Innermost annotation, array or switch block
+        bool operator==(const State &other) const;
+        bool operator!=(const State &other) const;
+    };
+
+    static State tokenize(const QString &line, State state, QVector<Token> &tokens, QVector<Fold> &folds);
+
+    static bool isOpcode(const QStringRef &word);
+    static bool isKeyword(const QStringRef &word);
+    static bool isRegister(const QStringRef &word);
+
+private:
+    static int readDescriptor(const QString &line, int position, QVector<Token> &tokens);
+};
+
+#endif // SMALITOKENIZER_H
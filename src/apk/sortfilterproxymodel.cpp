@@ -19,3 +19,27 @@ QString SortFilterProxyModel::getResourcePath(const QModelIndex &index) const
 {
     return sourceModel()->getResourcePath(mapToSource(index));
 }
+
+void SortFilterProxyModel::setAcceptedNodes(const QSet<const void *> &nodes)
+{
+    acceptedNodes = nodes;
+    filtered = true;
+    invalidateFilter();
+}
+
+void SortFilterProxyModel::clearAcceptedNodes()
+{
+    if (filtered) {
+        acceptedNodes.clear();
+        filtered = false;
+        invalidateFilter();
+    }
+}
+
+bool SortFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    if (!filtered) {
+        return true;
+    }
+    return acceptedNodes.contains(sourceModel()->index(sourceRow, 0, sourceParent).internalPointer());
+}
@@ -2,6 +2,7 @@
 #define SORTFILTERPROXYMODEL_H
 
 #include "apk/resourceitemsmodel.h"
+#include <QSet>
 #include <QSortFilterProxyModel>
 
 class SortFilterProxyModel : public QSortFilterProxyModel, public IResourceItemsModel
@@ -16,6 +17,17 @@ public:
     bool replaceResource(const QModelIndex &index, const QString &path = QString(), QWidget *parent = nullptr) override;
     bool removeResource(const QModelIndex &index) override;
     QString getResourcePath(const QModelIndex &index) const override;
+
+    // Only display the given source nodes (identified by their internal pointers)
+    void setAcceptedNodes(const QSet<const void *> &nodes);
+    void clearAcceptedNodes();
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    QSet<const void *> acceptedNodes;
+    bool filtered = false;
 };
 
 #endif // SORTFILTERPROXYMODEL_H
@@ -4,6 +4,7 @@
 #include "base/updater.h"
 #include "base/utils.h"
 #include "windows/androidexplorer.h"
+#include "windows/apkcomparer.h"
 #include "windows/devicemanager.h"
 #include "windows/dialogs.h"
 #include "windows/keymanager.h"
@@ -85,6 +86,12 @@ void ActionProvider::openAndroidExplorer(QWidget *parent) const
     explorer->show();
 }
 
+void ActionProvider::openApkComparer(QWidget *parent) const
+{
+    ApkComparer comparer(QString(), QString(), parent);
+    comparer.exec();
+}
+
 void ActionProvider::takeScreenshot(QWidget *parent) const
 {
     const auto device = Dialogs::getScreenshotDevice(parent);
@@ -124,6 +131,17 @@ QAction *ActionProvider::getOpenApk(QWidget *parent) const
     return action;
 }
 
+QAction *ActionProvider::getPatchApk(QWidget *parent) const
+{
+    auto action = new QAction(QIcon::fromTheme("document-edit"), {}, parent);
+
+    auto translate = [=]() { action->setText(tr("Open APK for Quick &Patching...")); };
+    connect(this, &ActionProvider::languageChanged, action, translate);
+    translate();
+
+    return action;
+}
+
 QAction *ActionProvider::getOptimizeApk(QWidget *parent) const
 {
     auto action = new QAction(QIcon::fromTheme("apk-optimize"), {}, parent);
@@ -422,6 +440,21 @@ QAction *ActionProvider::getOpenAndroidExplorer(QWidget *parent) const
     return action;
 }
 
+QAction *ActionProvider::getOpenApkComparer(QWidget *parent) const
+{
+    auto action = new QAction(QIcon::fromTheme("document-swap"), {}, parent);
+
+    auto translate = [=]() { action->setText(tr("Co&mpare APKs...")); };
+    connect(this, &ActionProvider::languageChanged, action, translate);
+    translate();
+
+    connect(action, &QAction::triggered, parent, [=]() {
+        openApkComparer(parent);
+    });
+
+    return action;
+}
+
 QAction *ActionProvider::getTakeScreenshot(QWidget *parent) const
 {
     return getTakeScreenshot({}, parent);
@@ -26,10 +26,12 @@ public:
     void openDeviceManager(QWidget *parent = nullptr) const;
     void openKeyManager(QWidget *parent = nullptr) const;
     void openAndroidExplorer(QWidget *parent = nullptr) const;
+    void openApkComparer(QWidget *parent = nullptr) const;
     void takeScreenshot(QWidget *parent) const;
     void takeScreenshot(const QString &serial, QWidget *parent) const;
 
     QAction *getOpenApk(QWidget *parent) const;
+    QAction *getPatchApk(QWidget *parent) const;
     QAction *getOptimizeApk(QWidget *parent) const;
     QAction *getSignApk(QWidget *parent) const;
     QAction *getInstallApk(QWidget *parent) const;
@@ -57,6 +59,7 @@ public:
     QAction *getOpenDeviceManager(QWidget *parent) const;
     QAction *getOpenKeyManager(QWidget *parent) const;
     QAction *getOpenAndroidExplorer(QWidget *parent) const;
+    QAction *getOpenApkComparer(QWidget *parent) const;
     QAction *getTakeScreenshot(QWidget *parent) const;
     QAction *getTakeScreenshot(const QString &serial, QWidget *parent) const;
 
@@ -0,0 +1,51 @@
+#include "base/androidfilesystemcache.h"
+
+AndroidFileSystemCache &AndroidFileSystemCache::get(const QString &serial)
+{
+    static QHash<QString, AndroidFileSystemCache> caches;
+    return caches[serial];
+}
+
+bool AndroidFileSystemCache::contains(const QString &path) const
+{
+    return entries.contains(path);
+}
+
+bool AndroidFileSystemCache::isFresh(const QString &path) const
+{
+    auto it = entries.constFind(path);
+    return it != entries.constEnd() && it->timer.isValid() && !it->timer.hasExpired(TimeToLive);
+}
+
+QList<AndroidFileSystemItem> AndroidFileSystemCache::getItems(const QString &path) const
+{
+    return entries.value(path).items;
+}
+
+void AndroidFileSystemCache::insert(const QString &path, const QList<AndroidFileSystemItem> &items)
+{
+    if (entries.count() >= MaxEntries && !entries.contains(path)) {
+        // Evict the least recently updated listing
+        auto oldest = entries.begin();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (!it->timer.isValid() || (oldest->timer.isValid() && it->timer.elapsed() > oldest->timer.elapsed())) {
+                oldest = it;
+            }
+        }
+        entries.erase(oldest);
+    }
+    Entry &entry = entries[path];
+    entry.items = items;
+    entry.timer.start();
+}
+
+void AndroidFileSystemCache::invalidate(const QString &path)
+{
+    // Listings are kept to be shown until refreshed, but are no longer considered fresh
+    const QString prefix = path.endsWith('/') ? path : path + '/';
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it.key() == path || it.key().startsWith(prefix)) {
+            it->timer.invalidate();
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef ANDROIDFILESYSTEMCACHE_H
+#define ANDROIDFILESYSTEMCACHE_H
+
+#include "base/androidfilesystemitem.h"
+#include <QElapsedTimer>
+#include <QHash>
+
+// Directory listings of a single device, shared by all Android explorers opened for it.
+// Stale listings are still returned so that they can be shown while being refreshed.
+
+class AndroidFileSystemCache
+{
+public:
+    static AndroidFileSystemCache &get(const QString &serial);
+
+    bool contains(const QString &path) const;
+    bool isFresh(const QString &path) const;
+    QList<AndroidFileSystemItem> getItems(const QString &path) const;
+
+    void insert(const QString &path, const QList<AndroidFileSystemItem> &items);
+    void invalidate(const QString &path); // Also invalidates the nested directories
+
+private:
+    struct Entry
+    {
+        QList<AndroidFileSystemItem> items;
+        QElapsedTimer timer;
+    };
+
+    static const qint64 TimeToLive = 30000;
+    static const int MaxEntries = 256;
+
+    QHash<QString, Entry> entries;
+};
+
+#endif // ANDROIDFILESYSTEMCACHE_H
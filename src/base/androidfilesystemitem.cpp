@@ -1,10 +1,12 @@
 #include "base/androidfilesystemitem.h"
 #include <QFileIconProvider>
 
-AndroidFileSystemItem::AndroidFileSystemItem(const QString &path, Type type)
+AndroidFileSystemItem::AndroidFileSystemItem(const QString &path, Type type, quint64 size, const QDateTime &modified)
     : path(path)
     , name(QFileInfo(path).fileName())
     , type(type)
+    , size(size)
+    , modified(modified)
 {
 }
 
@@ -34,3 +36,13 @@ AndroidFileSystemItem::Type AndroidFileSystemItem::getType() const
 {
     return type;
 }
+
+quint64 AndroidFileSystemItem::getSize() const
+{
+    return size;
+}
+
+const QDateTime &AndroidFileSystemItem::getModified() const
+{
+    return modified;
+}
@@ -1,6 +1,7 @@
 #ifndef ANDROIDFILESYSTEMITEM_H
 #define ANDROIDFILESYSTEMITEM_H
 
+#include <QDateTime>
 #include <QIcon>
 
 class QFileIconProvider;
@@ -12,17 +13,21 @@ public:
         AndroidFSFile,
         AndroidFSDirectory
     };
-    AndroidFileSystemItem(const QString &path, Type type);
+    AndroidFileSystemItem(const QString &path, Type type, quint64 size = 0, const QDateTime &modified = QDateTime());
     QString getPath() const;
     QString getName() const;
     QIcon getIcon(const QFileIconProvider &iconProvider) const;
     Type getType() const;
+    quint64 getSize() const;
+    const QDateTime &getModified() const;
 
 private:
     QString path;
     QString name;
     QIcon icon;
     Type type;
+    quint64 size;
+    QDateTime modified;
 };
 
 #endif // ANDROIDFILESYSTEMITEM_H
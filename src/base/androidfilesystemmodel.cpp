@@ -1,8 +1,13 @@
 #include "base/androidfilesystemmodel.h"
+#include "base/androidfilesystemcache.h"
+#include "base/application.h"
+#include "base/settings.h"
 #include "base/utils.h"
 #include "tools/adb.h"
 #include <QDir>
+#include <QLocale>
 #include <QRegularExpression>
+#include <algorithm>
 
 #ifdef QT_DEBUG
     #include <QDebug>
@@ -12,8 +17,7 @@ AndroidFileSystemModel::AndroidFileSystemModel(const QString &serial, QObject *p
     : QAbstractTableModel(parent)
     , serial(serial)
 {
-    emit pathChanged("/");
-    ls();
+    open("/");
 }
 
 bool AndroidFileSystemModel::setData(const QModelIndex &index, const QVariant &value, int role)
@@ -33,24 +37,58 @@ bool AndroidFileSystemModel::setData(const QModelIndex &index, const QVariant &v
 QVariant AndroidFileSystemModel::data(const QModelIndex &index, int role) const
 {
     if (index.isValid()) {
+        const AndroidFileSystemItem &item = fileSystemItems.at(index.row());
         switch (role) {
         case Qt::DisplayRole:
         case Qt::EditRole:
             switch (index.column()) {
             case NameColumn:
-                return getItemName(index);
+                return item.getName();
+            case SizeColumn:
+                if (item.getType() == AndroidFileSystemItem::AndroidFSFile) {
+                    return QLocale().formattedDataSize(item.getSize());
+                }
+                break;
+            case ModifiedColumn:
+                return QLocale().toString(item.getModified(), QLocale::ShortFormat);
             case PathColumn:
-                return getItemPath(index);
+                return item.getPath();
             }
+            break;
         case Qt::DecorationRole:
-            return getItemIcon(index);
+            if (index.column() == NameColumn) {
+                return item.getIcon(iconProvider);
+            }
+            break;
+        case Qt::TextAlignmentRole:
+            if (index.column() == SizeColumn) {
+                return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+            }
+            break;
         case FileTypeRole:
-            return getItemType(index);
+            return item.getType();
         }
     }
     return {};
 }
 
+QVariant AndroidFileSystemModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal) {
+        switch (section) {
+        case NameColumn:
+            return tr("Name");
+        case SizeColumn:
+            return tr("Size");
+        case ModifiedColumn:
+            return tr("Date Modified");
+        case PathColumn:
+            return tr("Path");
+        }
+    }
+    return QVariant();
+}
+
 QModelIndex AndroidFileSystemModel::index(int row, int column, const QModelIndex &) const
 {
     if (row >= 0 && row < rowCount()) {
@@ -75,6 +113,27 @@ Qt::ItemFlags AndroidFileSystemModel::flags(const QModelIndex &index) const
     return QAbstractItemModel::flags(index) | Qt::ItemIsEditable;
 }
 
+void AndroidFileSystemModel::sort(int column, Qt::SortOrder order)
+{
+    // The listing already contains everything needed, so no device round trips are made here
+    sortColumn = column;
+    sortOrder = order;
+    emit layoutAboutToBeChanged();
+    const QList<AndroidFileSystemItem> oldItems = fileSystemItems;
+    sortItems();
+    QHash<QString, int> newRows;
+    for (int row = 0; row < fileSystemItems.count(); ++row) {
+        newRows.insert(fileSystemItems.at(row).getPath(), row);
+    }
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QModelIndexList newIndexes;
+    for (const QModelIndex &index : oldIndexes) {
+        newIndexes.append(createIndex(newRows.value(oldItems.at(index.row()).getPath()), index.column()));
+    }
+    changePersistentIndexList(oldIndexes, newIndexes);
+    emit layoutChanged();
+}
+
 QString AndroidFileSystemModel::getItemName(const QModelIndex &index) const
 {
     return fileSystemItems.at(index.row()).getName();
@@ -100,9 +159,23 @@ const QString &AndroidFileSystemModel::getCurrentPath() const
     return currentPath;
 }
 
+bool AndroidFileSystemModel::isLoading() const
+{
+    return loading;
+}
+
+bool AndroidFileSystemModel::canGoBack() const
+{
+    return historyIndex > 0;
+}
+
+bool AndroidFileSystemModel::canGoForward() const
+{
+    return historyIndex + 1 < history.count();
+}
+
 void AndroidFileSystemModel::cd(const QString &path)
 {
-    beginResetModel();
     QString directory;
     if (path.startsWith('/')) {
         directory = path;
@@ -111,20 +184,27 @@ void AndroidFileSystemModel::cd(const QString &path)
     } else {
         directory = QString("%1/%2").arg(currentPath, path);
     }
-    directory = QDir::cleanPath(Utils::normalizePath(directory));
-    auto shell = new Adb::Cd(path, serial, this);
-    connect(shell, &Adb::Cd::finished, this, [=](bool success) {
-        if (success) {
-            currentPath = directory;
-            emit pathChanged(directory);
-            ls();
-        } else {
-            endResetModel();
-            emit error(tr("Could not open the directory."));
-        }
-        shell->deleteLater();
-    });
-    shell->run();
+    open(QDir::cleanPath(Utils::normalizePath(directory)));
+}
+
+void AndroidFileSystemModel::back()
+{
+    if (canGoBack()) {
+        open(history.at(historyIndex - 1), historyIndex - 1);
+    }
+}
+
+void AndroidFileSystemModel::forward()
+{
+    if (canGoForward()) {
+        open(history.at(historyIndex + 1), historyIndex + 1);
+    }
+}
+
+void AndroidFileSystemModel::refresh()
+{
+    invalidate({currentPath});
+    ls(currentPath);
 }
 
 void AndroidFileSystemModel::copy(const QString &src, const QString &dst)
@@ -132,9 +212,7 @@ void AndroidFileSystemModel::copy(const QString &src, const QString &dst)
     auto adb = new Adb::Cp(src, dst + '/', serial, this);
     connect(adb, &Adb::Cp::finished, this, [=](bool success) {
         if (success) {
-            if (dst == currentPath) {
-                ls();
-            }
+            invalidate({dst});
         } else {
             emit error(tr("Could not copy the file or directory."));
         }
@@ -148,9 +226,7 @@ void AndroidFileSystemModel::move(const QString &src, const QString &dst)
     auto adb = new Adb::Mv(src, dst + '/', serial, this);
     connect(adb, &Adb::Mv::finished, this, [=](bool success) {
         if (success) {
-            if (dst == currentPath) {
-                ls();
-            }
+            invalidate({QFileInfo(src).path(), src, dst});
         } else {
             emit error(tr("Could not move the file or directory."));
         }
@@ -164,7 +240,7 @@ void AndroidFileSystemModel::rename(const QString &src, const QString &dst)
     auto adb = new Adb::Mv(src, dst, serial, this);
     connect(adb, &Adb::Mv::finished, this, [=](bool success) {
         if (success) {
-            ls();
+            invalidate({QFileInfo(src).path(), src, QFileInfo(dst).path()});
         } else {
             emit error(tr("Could not rename the file or directory."));
         }
@@ -178,7 +254,7 @@ void AndroidFileSystemModel::remove(const QString &path)
     auto adb = new Adb::Rm(path, serial, this);
     connect(adb, &Adb::Rm::finished, this, [=](bool success) {
         if (success) {
-            ls();
+            invalidate({QFileInfo(path).path(), path});
         } else {
             emit error(tr("Could not delete the file or directory."));
         }
@@ -187,44 +263,231 @@ void AndroidFileSystemModel::remove(const QString &path)
     adb->run();
 }
 
-void AndroidFileSystemModel::download(const QString &src, const QString &dst)
+AdbTransfer *AndroidFileSystemModel::download(const QString &src, const QString &dst)
 {
     auto adb = new Adb::Pull(src, dst, serial, this);
+    adb->setStreamCount(app->settings->getAdbTransferStreams());
     connect(adb, &Adb::Pull::finished, this, [=](bool success) {
         if (!success) {
             emit error(tr("Could not download the file or directory."));
         }
-        adb->deleteLater();
     });
     adb->run();
+    return adb;
 }
 
-void AndroidFileSystemModel::upload(const QString &src, const QString &dst)
+AdbTransfer *AndroidFileSystemModel::upload(const QString &src, const QString &dst)
 {
     auto adb = new Adb::Push(src, dst, serial, this);
+    adb->setStreamCount(app->settings->getAdbTransferStreams());
     connect(adb, &Adb::Push::finished, this, [=](bool success) {
-        if (success) {
-            if (dst == currentPath) {
-                ls();
-            }
-        } else {
+        // Some of the files may have been uploaded even if the transfer failed
+        invalidate({dst});
+        if (!success) {
             emit error(tr("Could not upload the file."));
         }
-        adb->deleteLater();
     });
     adb->run();
+    return adb;
+}
+
+void AndroidFileSystemModel::open(const QString &directory, int historyIndex)
+{
+    prefetchQueue.clear();
+    if (AndroidFileSystemCache::get(serial).contains(directory)) {
+        // Cached listings are shown right away, and refreshed in the background if outdated
+        pendingPath.clear();
+        setCurrentPath(directory, historyIndex);
+        setItems(AndroidFileSystemCache::get(serial).getItems(directory));
+        if (AndroidFileSystemCache::get(serial).isFresh(directory)) {
+            prefetch();
+        } else {
+            ls(directory);
+        }
+    } else {
+        // The current listing stays visible until the new one arrives
+        pendingPath = directory;
+        pendingHistoryIndex = historyIndex;
+        ls(directory);
+    }
+    updateLoading();
+}
+
+void AndroidFileSystemModel::setCurrentPath(const QString &directory, int historyIndex)
+{
+    if (historyIndex < 0) {
+        if (this->historyIndex < 0 || history.at(this->historyIndex) != directory) {
+            history.erase(history.begin() + this->historyIndex + 1, history.end());
+            history.append(directory);
+        }
+        this->historyIndex = history.count() - 1;
+    } else {
+        this->historyIndex = historyIndex;
+    }
+    currentPath = directory;
+    emit pathChanged(directory);
+    emit historyChanged();
 }
 
-void AndroidFileSystemModel::ls()
+void AndroidFileSystemModel::setItems(const QList<AndroidFileSystemItem> &items)
 {
     beginResetModel();
-    auto shell = new Adb::Ls(currentPath, serial, this);
+    fileSystemItems = items;
+    sortItems();
+    endResetModel();
+}
+
+void AndroidFileSystemModel::updateItems(const QList<AndroidFileSystemItem> &items)
+{
+    // Applies the difference between the listings, so that the selection and scroll position are kept
+    QHash<QString, int> newRows;
+    for (int row = 0; row < items.count(); ++row) {
+        newRows.insert(items.at(row).getPath(), row);
+    }
+    for (int row = fileSystemItems.count() - 1; row >= 0; --row) {
+        if (!newRows.contains(fileSystemItems.at(row).getPath())) {
+            int first = row;
+            while (first > 0 && !newRows.contains(fileSystemItems.at(first - 1).getPath())) {
+                --first;
+            }
+            beginRemoveRows(QModelIndex(), first, row);
+                fileSystemItems.erase(fileSystemItems.begin() + first, fileSystemItems.begin() + row + 1);
+            endRemoveRows();
+            row = first;
+        }
+    }
+    QSet<QString> existingPaths;
+    bool changed = false;
+    for (int row = 0; row < fileSystemItems.count(); ++row) {
+        const AndroidFileSystemItem &oldItem = fileSystemItems.at(row);
+        const AndroidFileSystemItem &newItem = items.at(newRows.value(oldItem.getPath()));
+        existingPaths.insert(oldItem.getPath());
+        if (oldItem.getType() != newItem.getType()
+                || oldItem.getSize() != newItem.getSize()
+                || oldItem.getModified() != newItem.getModified()) {
+            fileSystemItems[row] = newItem;
+            changed = true;
+            emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+        }
+    }
+    QList<AndroidFileSystemItem> addedItems;
+    for (const AndroidFileSystemItem &item : items) {
+        if (!existingPaths.contains(item.getPath())) {
+            addedItems.append(item);
+        }
+    }
+    if (!addedItems.isEmpty()) {
+        const int first = fileSystemItems.count();
+        beginInsertRows(QModelIndex(), first, first + addedItems.count() - 1);
+            fileSystemItems.append(addedItems);
+        endInsertRows();
+    }
+    if (!addedItems.isEmpty() || changed) {
+        sort(sortColumn, sortOrder);
+    }
+}
+
+void AndroidFileSystemModel::ls(const QString &directory)
+{
+    if (listing.contains(directory)) {
+        return; // Already being listed, e.g., by prefetching
+    }
+    listing.insert(directory);
+    auto shell = new Adb::Ls(directory, serial, this);
     connect(shell, &Adb::Ls::finished, this, [=](bool success) {
-        Q_UNUSED(success)
-        fileSystemItems.clear();
-        fileSystemItems.append(shell->getFileSystemItems());
-        endResetModel();
+        listing.remove(directory);
+        if (success) {
+            AndroidFileSystemCache::get(serial).insert(directory, shell->getFileSystemItems());
+            if (directory == pendingPath) {
+                pendingPath.clear();
+                setCurrentPath(directory, pendingHistoryIndex);
+                setItems(shell->getFileSystemItems());
+                prefetch();
+            } else if (directory == currentPath && pendingPath.isEmpty()) {
+                updateItems(shell->getFileSystemItems());
+                prefetch();
+            }
+        } else if (directory == pendingPath || (directory == currentPath && pendingPath.isEmpty())) {
+            pendingPath.clear();
+            emit error(tr("Could not open the directory."));
+        }
+        updateLoading();
+        prefetchNext();
         shell->deleteLater();
     });
+    updateLoading();
     shell->run();
 }
+
+void AndroidFileSystemModel::invalidate(const QStringList &paths)
+{
+    AndroidFileSystemCache &cache = AndroidFileSystemCache::get(serial);
+    for (const QString &path : paths) {
+        cache.invalidate(path);
+    }
+    if (!cache.isFresh(currentPath)) {
+        ls(currentPath);
+    }
+}
+
+void AndroidFileSystemModel::prefetch()
+{
+    // Subdirectories of the current directory are listed one by one while idle
+    const int MaxPrefetchCount = 16;
+    prefetchQueue.clear();
+    for (const AndroidFileSystemItem &item : fileSystemItems) {
+        if (item.getType() == AndroidFileSystemItem::AndroidFSDirectory
+                && !AndroidFileSystemCache::get(serial).isFresh(item.getPath())) {
+            prefetchQueue.append(item.getPath());
+            if (prefetchQueue.count() == MaxPrefetchCount) {
+                break;
+            }
+        }
+    }
+    prefetchNext();
+}
+
+void AndroidFileSystemModel::prefetchNext()
+{
+    while (listing.isEmpty() && !prefetchQueue.isEmpty()) {
+        const QString directory = prefetchQueue.takeFirst();
+        if (!AndroidFileSystemCache::get(serial).isFresh(directory)) {
+            ls(directory);
+        }
+    }
+}
+
+void AndroidFileSystemModel::updateLoading()
+{
+    // Refreshing the listing already shown doesn't count as loading
+    const bool loading = !pendingPath.isEmpty();
+    if (this->loading != loading) {
+        this->loading = loading;
+        emit loadingChanged(loading);
+    }
+}
+
+void AndroidFileSystemModel::sortItems()
+{
+    const int column = sortColumn;
+    auto lessThan = [=](const AndroidFileSystemItem &a, const AndroidFileSystemItem &b) {
+        switch (column) {
+        case SizeColumn:
+            return a.getSize() < b.getSize();
+        case ModifiedColumn:
+            return a.getModified() < b.getModified();
+        default:
+            return a.getName().compare(b.getName(), Qt::CaseInsensitive) < 0;
+        }
+    };
+    const Qt::SortOrder order = sortOrder;
+    std::stable_sort(fileSystemItems.begin(), fileSystemItems.end(), [=](const AndroidFileSystemItem &a, const AndroidFileSystemItem &b) {
+        // Directories always go first
+        const bool isDirectoryA = a.getType() == AndroidFileSystemItem::AndroidFSDirectory;
+        const bool isDirectoryB = b.getType() == AndroidFileSystemItem::AndroidFSDirectory;
+        if (isDirectoryA != isDirectoryB) {
+            return isDirectoryA;
+        }
+        return order == Qt::AscendingOrder ? lessThan(a, b) : lessThan(b, a);
+    });
+}
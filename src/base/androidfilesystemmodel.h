@@ -4,6 +4,10 @@
 #include "base/androidfilesystemitem.h"
 #include <QAbstractTableModel>
 #include <QFileIconProvider>
+#include <QSet>
+#include <QStringList>
+
+class AdbTransfer;
 
 class AndroidFileSystemModel : public QAbstractTableModel
 {
@@ -12,6 +16,8 @@ class AndroidFileSystemModel : public QAbstractTableModel
 public:
     enum Column {
         NameColumn,
+        SizeColumn,
+        ModifiedColumn,
         PathColumn,
         ColumnCount
     };
@@ -24,10 +30,12 @@ public:
 
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
     QModelIndex index(int row, int column = 0, const QModelIndex &parent = QModelIndex()) const override;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
     Qt::ItemFlags flags(const QModelIndex &index) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
 
     QString getItemName(const QModelIndex &index) const;
     QString getItemPath(const QModelIndex &index) const;
@@ -35,24 +43,51 @@ public:
     AndroidFileSystemItem::Type getItemType(const QModelIndex &index) const;
 
     const QString &getCurrentPath() const;
+    bool isLoading() const;
+    bool canGoBack() const;
+    bool canGoForward() const;
+
     void cd(const QString &path);
+    void back();
+    void forward();
+    void refresh();
     void copy(const QString &src, const QString &dst);
     void move(const QString &src, const QString &dst);
     void rename(const QString &src, const QString &dst);
     void remove(const QString &path);
-    void download(const QString &src, const QString &dst);
-    void upload(const QString &src, const QString &dst);
+    AdbTransfer *download(const QString &src, const QString &dst);
+    AdbTransfer *upload(const QString &src, const QString &dst);
 
 signals:
     void pathChanged(const QString &path);
+    void historyChanged();
+    void loadingChanged(bool loading);
     void error(const QString &error);
 
 private:
-    void ls();
+    void open(const QString &directory, int historyIndex = -1);
+    void setCurrentPath(const QString &directory, int historyIndex);
+    void setItems(const QList<AndroidFileSystemItem> &items);
+    void updateItems(const QList<AndroidFileSystemItem> &items);
+    void ls(const QString &directory);
+    void invalidate(const QStringList &paths);
+    void prefetch();
+    void prefetchNext();
+    void updateLoading();
+    void sortItems();
 
     QList<AndroidFileSystemItem> fileSystemItems;
+    int sortColumn = NameColumn;
+    Qt::SortOrder sortOrder = Qt::AscendingOrder;
     QString serial;
     QString currentPath;
+    QString pendingPath; // Directory being opened, until its listing arrives
+    QStringList history;
+    int historyIndex = -1;
+    int pendingHistoryIndex = -1;
+    QSet<QString> listing;
+    QStringList prefetchQueue;
+    bool loading = false;
     QFileIconProvider iconProvider;
 };
 
@@ -8,6 +8,7 @@
 #include "windows/androidexplorer.h"
 #include "windows/dialogs.h"
 #include "windows/mainwindow.h"
+#include <KSyntaxHighlighting/Repository>
 #include <QDir>
 #include <QFileOpenEvent>
 #include <QPixmapCache>
@@ -44,6 +45,7 @@ Application::Application(int &argc, char **argv) : SingleApplication(argc, argv,
 
 Application::~Application()
 {
+    delete highlightingRepository;
     delete settings;
 }
 
@@ -105,6 +107,15 @@ void Application::setTheme(const QString &theme)
     ThemeRepository().getTheme(theme)->initialize();
 }
 
+KSyntaxHighlighting::Repository *Application::getHighlightingRepository()
+{
+    // Syntax definitions and themes are only loaded once the first code editor is opened
+    if (!highlightingRepository) {
+        highlightingRepository = new KSyntaxHighlighting::Repository;
+    }
+    return highlightingRepository;
+}
+
 bool Application::event(QEvent *event)
 {
     // File open request on macOS
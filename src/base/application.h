@@ -5,11 +5,13 @@
 #include "base/actionprovider.h"
 #include "base/language.h"
 #include <SingleApplication>
-#include <KSyntaxHighlighting/Repository>
 #include <QTranslator>
 
 class MainWindow;
 class Settings;
+namespace KSyntaxHighlighting {
+    class Repository;
+}
 
 class Application : public SingleApplication
 {
@@ -26,10 +28,10 @@ public:
     MainWindow *createNewInstance();
     void setLanguage(const QString &locale);
     void setTheme(const QString &theme);
+    KSyntaxHighlighting::Repository *getHighlightingRepository();
 
     Settings *settings;
     ActionProvider actions;
-    KSyntaxHighlighting::Repository highlightingRepository;
 
 protected:
     bool event(QEvent *event) override;
@@ -44,6 +46,7 @@ private:
     PackageListModel packages;
     QTranslator translator;
     QTranslator translatorQt;
+    KSyntaxHighlighting::Repository *highlightingRepository = nullptr;
 };
 
 #define app (static_cast<Application *>(qApp))
@@ -39,3 +39,36 @@ void Commands::dequeue()
         emit finished(true);
     }
 }
+
+ParallelCommands::~ParallelCommands()
+{
+    for (auto command : qAsConst(commands)) {
+        command->deleteLater();
+    }
+}
+
+void ParallelCommands::run()
+{
+    emit started();
+    if (commands.isEmpty()) {
+        emit finished(true);
+        return;
+    }
+    const QList<Command *> pending = commands;
+    commands.clear();
+    running = pending.count();
+    for (auto command : pending) {
+        command->run();
+    }
+}
+
+void ParallelCommands::add(Command *command)
+{
+    commands.append(command);
+    connect(command, &Command::finished, this, [=](bool success) {
+        this->success = this->success && success;
+        if (--running == 0) {
+            emit finished(this->success);
+        }
+    });
+}
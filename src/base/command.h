@@ -30,4 +30,18 @@ private:
     QQueue<Command *> commands;
 };
 
+class ParallelCommands : public Command
+{
+public:
+    ParallelCommands(QObject *parent = nullptr) : Command(parent) {}
+    ~ParallelCommands() override;
+    void run() override;
+    void add(Command *command);
+
+private:
+    QList<Command *> commands;
+    int running = 0;
+    bool success = true;
+};
+
 #endif // COMMAND_H
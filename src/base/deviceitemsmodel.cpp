@@ -1,7 +1,22 @@
 #include "base/deviceitemsmodel.h"
 #include "base/application.h"
 #include "base/settings.h"
-#include "tools/adb.h"
+#include "tools/adbdevicetracker.h"
+#include <QSet>
+
+DeviceItemsModel::DeviceItemsModel(QObject *parent) : QAbstractTableModel(parent)
+{
+    // The list is kept up to date by the device tracker, so it is available without waiting
+    auto tracker = AdbDeviceTracker::instance();
+    connect(tracker, &AdbDeviceTracker::devicesChanged, this, [this]() {
+        update();
+        emit fetched(true);
+    });
+    connect(tracker, &AdbDeviceTracker::failed, this, [this]() {
+        emit fetched(false);
+    });
+    update();
+}
 
 Device DeviceItemsModel::get(const QModelIndex &index) const
 {
@@ -11,27 +26,15 @@ Device DeviceItemsModel::get(const QModelIndex &index) const
     return {};
 }
 
+bool DeviceItemsModel::isLoading() const
+{
+    return !AdbDeviceTracker::instance()->isReady();
+}
+
 void DeviceItemsModel::refresh()
 {
     emit fetching();
-    auto adb = new Adb::Devices(this);
-    connect(adb, &Adb::Devices::finished, this, [=](bool success) {
-        beginResetModel();
-        devices.clear();
-        if (success) {
-            devices.append(adb->devices());
-            for (auto &device : devices) {
-                const QString serial = device.getSerial();
-                const QString alias = app->settings->getDeviceAlias(serial);
-                if (!alias.isEmpty()) {
-                    device.setAlias(alias);
-                }
-            }
-        }
-        endResetModel();
-        emit fetched(success);
-    });
-    adb->run();
+    AdbDeviceTracker::instance()->resubscribe();
 }
 
 void DeviceItemsModel::save() const
@@ -117,3 +120,46 @@ int DeviceItemsModel::columnCount(const QModelIndex &parent) const
     Q_UNUSED(parent)
     return ColumnCount;
 }
+
+void DeviceItemsModel::update()
+{
+    // Devices are updated in place, so that the selection and unsaved aliases are kept
+    const QList<Device> trackedDevices = AdbDeviceTracker::instance()->getDevices();
+    QHash<QString, Device> trackedSerials;
+    for (const Device &device : trackedDevices) {
+        trackedSerials.insert(device.getSerial(), device);
+    }
+    for (int row = devices.count() - 1; row >= 0; --row) {
+        if (!trackedSerials.contains(devices.at(row).getSerial())) {
+            beginRemoveRows(QModelIndex(), row, row);
+                devices.removeAt(row);
+            endRemoveRows();
+        }
+    }
+    QSet<QString> existingSerials;
+    for (int row = 0; row < devices.count(); ++row) {
+        Device &device = devices[row];
+        const Device &tracked = trackedSerials.value(device.getSerial());
+        existingSerials.insert(device.getSerial());
+        if (device.getProductString() != tracked.getProductString()
+                || device.getModelString() != tracked.getModelString()
+                || device.getDeviceString() != tracked.getDeviceString()) {
+            device.setProductString(tracked.getProductString());
+            device.setModelString(tracked.getModelString());
+            device.setDeviceString(tracked.getDeviceString());
+            emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+        }
+    }
+    for (Device device : trackedDevices) {
+        if (existingSerials.contains(device.getSerial())) {
+            continue;
+        }
+        const QString alias = app->settings->getDeviceAlias(device.getSerial());
+        if (!alias.isEmpty()) {
+            device.setAlias(alias);
+        }
+        beginInsertRows(QModelIndex(), devices.count(), devices.count());
+            devices.append(device);
+        endInsertRows();
+    }
+}
@@ -18,8 +18,11 @@ public:
         ColumnCount
     };
 
+    explicit DeviceItemsModel(QObject *parent = nullptr);
+
     Device get(const QModelIndex &index) const;
-    void refresh();
+    bool isLoading() const;
+    void refresh(); // The list is updated automatically, this only reconnects to the ADB server
     void save() const;
 
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
@@ -34,6 +37,8 @@ signals:
     void fetched(bool success);
 
 private:
+    void update();
+
     QList<Device> devices;
 };
 
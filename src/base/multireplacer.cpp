@@ -0,0 +1,202 @@
+#include "base/multireplacer.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QDirIterator>
+#include <QFutureInterface>
+#include <QSaveFile>
+#include <QThread>
+#include <QDebug>
+
+MultiReplacer::MultiReplacer(const QVector<QPair<QByteArray, QByteArray>> &replacements)
+    : replacements(replacements)
+{
+    // Build the trie:
+
+    transitions.fill(-1, 256);
+    outputs.append(-1);
+    for (int pattern = 0; pattern < replacements.count(); ++pattern) {
+        const QByteArray &needle = replacements.at(pattern).first;
+        if (needle.isEmpty()) {
+            continue;
+        }
+        int state = 0;
+        for (const char byte : needle) {
+            const int transition = state * 256 + static_cast<uchar>(byte);
+            if (transitions.at(transition) == -1) {
+                transitions[transition] = outputs.count();
+                transitions.resize(transitions.size() + 256);
+                std::fill(transitions.end() - 256, transitions.end(), -1);
+                outputs.append(-1);
+            }
+            state = transitions.at(transition);
+        }
+        if (outputs.at(state) == -1) {
+            outputs[state] = pattern;
+        }
+    }
+
+    // Compute failure links and turn the trie into a deterministic automaton:
+
+    QVector<int> failures(outputs.count(), 0);
+    QVector<int> queue;
+    for (int byte = 0; byte < 256; ++byte) {
+        int &next = transitions[byte];
+        if (next == -1) {
+            next = 0;
+        } else {
+            queue.append(next);
+        }
+    }
+    for (int i = 0; i < queue.count(); ++i) {
+        const int state = queue.at(i);
+        for (int byte = 0; byte < 256; ++byte) {
+            const int fallback = transitions.at(failures.at(state) * 256 + byte);
+            int &next = transitions[state * 256 + byte];
+            if (next == -1) {
+                next = fallback;
+            } else {
+                failures[next] = fallback;
+                if (outputs.at(next) == -1) {
+                    // A pattern ending at the state itself is always longer than the inherited one
+                    outputs[next] = outputs.at(fallback);
+                }
+                queue.append(next);
+            }
+        }
+    }
+}
+
+QByteArray MultiReplacer::replace(const QByteArray &data) const
+{
+    const auto bytes = reinterpret_cast<const uchar *>(data.constData());
+    Match match;
+    if (!findNext(bytes, data.size(), 0, match)) {
+        return data;
+    }
+    return replace(bytes, data.size(), match);
+}
+
+bool MultiReplacer::replaceFile(const QString &path, bool dryRun) const
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        qWarning() << "Could not open" << path;
+        return false;
+    }
+    const qint64 size = file.size();
+    if (!size) {
+        return false;
+    }
+
+    QByteArray buffer;
+    const uchar *data = file.map(0, size);
+    if (!data) {
+        buffer = file.readAll();
+        data = reinterpret_cast<const uchar *>(buffer.constData());
+    }
+
+    // Most of the files contain no matches and are never rewritten
+    Match match;
+    if (!findNext(data, size, 0, match)) {
+        return false;
+    }
+    if (dryRun) {
+        return true;
+    }
+
+    const QByteArray output = replace(data, size, match);
+    file.close();
+
+    QSaveFile target(path);
+    if (!target.open(QFile::WriteOnly) || target.write(output) != output.size() || !target.commit()) {
+        qWarning() << "Could not write" << path;
+        return false;
+    }
+    return true;
+}
+
+QFuture<QString> MultiReplacer::replaceInFiles(const QStringList &paths, bool dryRun) const
+{
+    return replaceInFiles({{*this, paths}}, dryRun);
+}
+
+QFuture<QString> MultiReplacer::replaceInFiles(const QVector<QPair<MultiReplacer, QStringList>> &jobs, bool dryRun)
+{
+    QFutureInterface<QString> interface;
+    interface.reportStarted();
+    auto future = interface.future();
+
+    QtConcurrent::run([=]() mutable {
+
+        // Paths may point to both files and directories:
+
+        QVector<QPair<const MultiReplacer *, QString>> files;
+        for (const auto &job : qAsConst(jobs)) {
+            for (const QString &path : job.second) {
+                if (QFileInfo(path).isDir()) {
+                    QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories);
+                    while (it.hasNext()) {
+                        files.append({&job.first, it.next()});
+                    }
+                } else {
+                    files.append({&job.first, path});
+                }
+            }
+        }
+        interface.setProgressRange(0, files.count());
+
+        // Process the files in parallel; results are the files which contain at least one match:
+
+        QAtomicInt next(0);
+        QAtomicInt processed(0);
+        QVector<QFuture<void>> workers;
+        const int threadCount = qMax(1, QThread::idealThreadCount());
+        for (int i = 0; i < threadCount; ++i) {
+            workers.append(QtConcurrent::run([&]() {
+                int index;
+                while ((index = next.fetchAndAddRelaxed(1)) < files.count() && !interface.isCanceled()) {
+                    const QString &file = files.at(index).second;
+                    if (files.at(index).first->replaceFile(file, dryRun)) {
+                        interface.reportResult(file);
+                    }
+                    interface.setProgressValue(processed.fetchAndAddRelaxed(1) + 1);
+                }
+            }));
+        }
+        for (auto &worker : workers) {
+            worker.waitForFinished();
+        }
+        interface.reportFinished();
+    });
+
+    return future;
+}
+
+bool MultiReplacer::findNext(const uchar *data, qint64 size, qint64 from, Match &match) const
+{
+    int state = 0;
+    for (qint64 i = from; i < size; ++i) {
+        state = transitions.at(state * 256 + data[i]);
+        const int pattern = outputs.at(state);
+        if (pattern != -1) {
+            match.pattern = pattern;
+            match.position = i - replacements.at(pattern).first.size() + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+QByteArray MultiReplacer::replace(const uchar *data, qint64 size, Match match) const
+{
+    QByteArray output;
+    output.reserve(size);
+    qint64 position = 0;
+    do {
+        const auto &replacement = replacements.at(match.pattern);
+        output.append(reinterpret_cast<const char *>(data + position), match.position - position);
+        output.append(replacement.second);
+        position = match.position + replacement.first.size();
+    } while (findNext(data, size, position, match));
+    output.append(reinterpret_cast<const char *>(data + position), size - position);
+    return output;
+}
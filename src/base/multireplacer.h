@@ -0,0 +1,36 @@
+#ifndef MULTIREPLACER_H
+#define MULTIREPLACER_H
+
+#include <QFuture>
+#include <QPair>
+#include <QVector>
+
+// Byte-level multi-pattern search and replace based on the Aho-Corasick automaton.
+// Among the matches ending at the same position the longest one wins; matches never overlap.
+
+class MultiReplacer
+{
+public:
+    MultiReplacer(const QVector<QPair<QByteArray, QByteArray>> &replacements);
+
+    QByteArray replace(const QByteArray &data) const;
+    bool replaceFile(const QString &path, bool dryRun = false) const;
+    QFuture<QString> replaceInFiles(const QStringList &paths, bool dryRun = false) const;
+    // Runs several replacers at once, each one on its own set of paths
+    static QFuture<QString> replaceInFiles(const QVector<QPair<MultiReplacer, QStringList>> &jobs, bool dryRun = false);
+
+private:
+    struct Match {
+        qint64 position;
+        int pattern;
+    };
+
+    bool findNext(const uchar *data, qint64 size, qint64 from, Match &match) const;
+    QByteArray replace(const uchar *data, qint64 size, Match match) const;
+
+    QVector<QPair<QByteArray, QByteArray>> replacements;
+    QVector<int> transitions; // State * 256 + byte -> next state
+    QVector<int> outputs; // State -> index of the longest pattern ending at this state, or -1
+};
+
+#endif // MULTIREPLACER_H
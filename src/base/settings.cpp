@@ -91,6 +91,11 @@ QString Settings::getAdbPath() const
     return settings->value("ADB/Path").toString();
 }
 
+int Settings::getAdbTransferStreams() const
+{
+    return settings->value("ADB/TransferStreams", 4).toInt();
+}
+
 bool Settings::getCustomKeystore() const
 {
     return !settings->value("Signer/DemoKey", true).toBool();
@@ -143,6 +148,11 @@ bool Settings::getKeepBrokenResources() const
     return settings->value("Apktool/KeepBroken", false).toBool();
 }
 
+bool Settings::getCheckSmali() const
+{
+    return settings->value("Apktool/CheckSmali", true).toBool();
+}
+
 QString Settings::getDeviceAlias(const QString &serial) const
 {
     return settings->value(QString("Devices/%1").arg(serial)).toString();
@@ -358,6 +368,11 @@ void Settings::setAdbPath(const QString &path)
     settings->setValue("ADB/Path", path);
 }
 
+void Settings::setAdbTransferStreams(int count)
+{
+    settings->setValue("ADB/TransferStreams", count);
+}
+
 void Settings::setCustomKeystore(bool custom)
 {
     settings->setValue("Signer/DemoKey", !custom);
@@ -410,6 +425,11 @@ void Settings::setKeepBrokenResources(bool keepBroken)
     settings->setValue("Apktool/KeepBroken", keepBroken);
 }
 
+void Settings::setCheckSmali(bool check)
+{
+    settings->setValue("Apktool/CheckSmali", check);
+}
+
 void Settings::setDeviceAlias(const QString &serial, const QString &alias)
 {
     settings->setValue(QString("Devices/%1").arg(serial), alias);
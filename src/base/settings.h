@@ -26,6 +26,7 @@ public:
     QString getApksignerPath() const;
     QString getZipalignPath() const;
     QString getAdbPath() const;
+    int getAdbTransferStreams() const;
     bool getCustomKeystore() const;
     QString getKeystorePath() const;
     QString getKeystorePassword() const;
@@ -36,6 +37,7 @@ public:
     bool getMakeDebuggable() const;
     bool getDecompileSources() const;
     bool getKeepBrokenResources() const;
+    bool getCheckSmali() const;
     QString getDeviceAlias(const QString &serial) const;
     QString getLastDirectory() const;
     bool getSingleInstance() const;
@@ -77,6 +79,7 @@ public:
     void setApksignerPath(const QString &path);
     void setZipalignPath(const QString &path);
     void setAdbPath(const QString &path);
+    void setAdbTransferStreams(int count);
     void setCustomKeystore(bool custom);
     void setKeystorePath(const QString &path);
     void setKeystorePassword(const QString &password);
@@ -87,6 +90,7 @@ public:
     void setMakeDebuggable(bool debuggable);
     void setDecompileSources(bool smali);
     void setKeepBrokenResources(bool keepBroken);
+    void setCheckSmali(bool check);
     void setDeviceAlias(const QString &serial, const QString &alias);
     void setLastDirectory(const QString &directory);
     void setSingleInstance(bool value);
@@ -0,0 +1,348 @@
+#include "base/ziparchive.h"
+#include <QtEndian>
+#include <QDebug>
+#include <limits>
+#include <zlib.h>
+
+namespace
+{
+    const quint32 LocalHeaderSignature = 0x04034b50;
+    const quint32 CentralHeaderSignature = 0x02014b50;
+    const quint32 EndOfCentralDirectorySignature = 0x06054b50;
+    const quint32 Zip64EndOfCentralDirectorySignature = 0x06064b50;
+    const quint32 Zip64EndOfCentralDirectoryLocatorSignature = 0x07064b50;
+    const quint16 Zip64ExtraFieldTag = 0x0001;
+    const int LocalHeaderSize = 30;
+    const int CentralHeaderSize = 46;
+    const int EndOfCentralDirectorySize = 22;
+    const int Zip64EndOfCentralDirectoryLocatorSize = 20;
+    const int Zip64EndOfCentralDirectorySize = 56;
+    const int MaxDeflateRatio = 1032; // Deflate can't compress any better than that
+    const int InflateChunkSize = 64 * 1024;
+
+    template<typename T> T readValue(const uchar *data)
+    {
+        return qFromLittleEndian<T>(data);
+    }
+}
+
+ZipArchive::ZipArchive(const QString &path) : file(path) {}
+
+ZipArchive::~ZipArchive()
+{
+    close();
+}
+
+bool ZipArchive::open()
+{
+    if (isOpen()) {
+        return true;
+    }
+    if (!file.open(QFile::ReadOnly)) {
+        qWarning() << "Could not open" << file.fileName();
+        return false;
+    }
+    size = file.size();
+    data = file.map(0, size);
+    if (!data || !parseCentralDirectory()) {
+        qWarning() << "Could not read ZIP archive" << file.fileName();
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ZipArchive::close()
+{
+    entries.clear();
+    entryIndexes.clear();
+    data = nullptr;
+    size = 0;
+    file.close();
+}
+
+bool ZipArchive::isOpen() const
+{
+    return data;
+}
+
+QString ZipArchive::getPath() const
+{
+    return file.fileName();
+}
+
+qint64 ZipArchive::getSize() const
+{
+    return size;
+}
+
+const QVector<ZipArchive::Entry> &ZipArchive::getEntries() const
+{
+    return entries;
+}
+
+const ZipArchive::Entry *ZipArchive::getEntry(const QString &name) const
+{
+    const int index = entryIndexes.value(name, -1);
+    return index != -1 ? &entries.at(index) : nullptr;
+}
+
+qint64 ZipArchive::getDataOffset(const Entry &entry) const
+{
+    // The local header may contain different name and extra field lengths than the central one.
+    // Each term is checked against the archive size before adding, so that ZIP64 values can't overflow.
+    const quint64 offset = entry.localHeaderOffset;
+    if (quint64(size) < LocalHeaderSize || offset > quint64(size) - LocalHeaderSize
+            || readValue<quint32>(data + offset) != LocalHeaderSignature) {
+        return -1;
+    }
+    const quint16 nameLength = readValue<quint16>(data + offset + 26);
+    const quint16 extraLength = readValue<quint16>(data + offset + 28);
+    const quint64 dataOffset = offset + LocalHeaderSize + nameLength + extraLength;
+    if (dataOffset > quint64(size) || entry.compressedSize > quint64(size) - dataOffset) {
+        return -1;
+    }
+    return dataOffset;
+}
+
+const uchar *ZipArchive::getRawData(const Entry &entry) const
+{
+    const qint64 offset = getDataOffset(entry);
+    return offset != -1 ? data + offset : nullptr;
+}
+
+QByteArray ZipArchive::read(const QString &name) const
+{
+    const Entry *entry = getEntry(name);
+    return entry ? read(*entry) : QByteArray();
+}
+
+QByteArray ZipArchive::read(const Entry &entry) const
+{
+    const uchar *raw = getRawData(entry);
+    if (!raw) {
+        return {};
+    }
+    switch (entry.method) {
+    case Stored:
+        if (entry.compressedSize > quint64(std::numeric_limits<int>::max())) {
+            return {};
+        }
+        return QByteArray(reinterpret_cast<const char *>(raw), static_cast<int>(entry.compressedSize));
+    case Deflated:
+        return inflate(raw, entry.compressedSize, entry.uncompressedSize);
+    default:
+        qWarning() << "Unsupported compression method" << entry.method << "for" << entry.name;
+        return {};
+    }
+}
+
+QByteArray ZipArchive::readHead(const Entry &entry, int length) const
+{
+    const uchar *raw = getRawData(entry);
+    if (!raw) {
+        return {};
+    }
+    length = static_cast<int>(qMin<quint64>(length, entry.uncompressedSize));
+    switch (entry.method) {
+    case Stored:
+        return QByteArray(reinterpret_cast<const char *>(raw), static_cast<int>(qMin<quint64>(length, entry.compressedSize)));
+    case Deflated: {
+        QByteArray output(length, Qt::Uninitialized);
+        z_stream stream = {};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            return {};
+        }
+        stream.next_in = const_cast<Bytef *>(raw);
+        stream.avail_in = static_cast<uInt>(qMin<quint64>(entry.compressedSize, std::numeric_limits<uInt>::max()));
+        stream.next_out = reinterpret_cast<Bytef *>(output.data());
+        stream.avail_out = static_cast<uInt>(length);
+        const int result = ::inflate(&stream, Z_SYNC_FLUSH);
+        inflateEnd(&stream);
+        if ((result != Z_OK && result != Z_STREAM_END) || stream.total_out != uLong(length)) {
+            return {};
+        }
+        return output;
+    }
+    default:
+        return {};
+    }
+}
+
+QByteArray ZipArchive::inflate(const uchar *data, quint64 size, quint64 expectedSize)
+{
+    if (expectedSize >= quint64(std::numeric_limits<int>::max()) || expectedSize / MaxDeflateRatio > size) {
+        return {};
+    }
+
+    z_stream stream = {};
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) { // Raw deflate without zlib header
+        return {};
+    }
+
+    // The output buffer grows with the inflated data rather than trusting the declared size up front.
+    // One byte more than declared is allowed, so that an oversized stream is detected.
+    QByteArray output;
+    const quint64 outputLimit = expectedSize + 1;
+    quint64 remaining = size;
+    int result = Z_OK;
+    while (result == Z_OK) {
+        if (stream.avail_in == 0 && remaining > 0) {
+            const uInt chunk = static_cast<uInt>(qMin<quint64>(remaining, std::numeric_limits<uInt>::max()));
+            stream.next_in = const_cast<Bytef *>(data + (size - remaining));
+            stream.avail_in = chunk;
+            remaining -= chunk;
+        }
+        if (stream.avail_out == 0) {
+            const quint64 produced = stream.total_out;
+            if (produced >= outputLimit) {
+                break;
+            }
+            const quint64 capacity = qMin(outputLimit, qMax<quint64>(produced * 2, InflateChunkSize));
+            output.resize(static_cast<int>(capacity));
+            stream.next_out = reinterpret_cast<Bytef *>(output.data() + produced);
+            stream.avail_out = static_cast<uInt>(capacity - produced);
+        }
+        result = ::inflate(&stream, Z_NO_FLUSH);
+    }
+    const quint64 total = stream.total_out;
+    inflateEnd(&stream);
+
+    if (result != Z_STREAM_END || total != expectedSize) {
+        return {};
+    }
+    output.resize(static_cast<int>(expectedSize));
+    return output;
+}
+
+QByteArray ZipArchive::deflate(const QByteArray &data)
+{
+    z_stream stream = {};
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return {};
+    }
+    QByteArray output(static_cast<int>(deflateBound(&stream, static_cast<uLong>(data.size()))), Qt::Uninitialized);
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(output.data());
+    stream.avail_out = static_cast<uInt>(output.size());
+    const int result = ::deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+
+    if (result != Z_STREAM_END) {
+        return {};
+    }
+    output.resize(static_cast<int>(stream.total_out));
+    return output;
+}
+
+quint32 ZipArchive::checksum(const QByteArray &data)
+{
+    return static_cast<quint32>(crc32(0, reinterpret_cast<const Bytef *>(data.constData()), static_cast<uInt>(data.size())));
+}
+
+bool ZipArchive::parseCentralDirectory()
+{
+    if (size < EndOfCentralDirectorySize) {
+        return false;
+    }
+
+    // Find the end of central directory record (it's followed by a comment of up to 64 KiB):
+
+    qint64 eocd = -1;
+    const qint64 searchLimit = qMax<qint64>(0, size - EndOfCentralDirectorySize - 0xFFFF);
+    for (qint64 offset = size - EndOfCentralDirectorySize; offset >= searchLimit; --offset) {
+        if (readValue<quint32>(data + offset) == EndOfCentralDirectorySignature) {
+            eocd = offset;
+            break;
+        }
+    }
+    if (eocd == -1) {
+        return false;
+    }
+
+    quint64 entryCount = readValue<quint16>(data + eocd + 10);
+    quint64 directorySize = readValue<quint32>(data + eocd + 12);
+    quint64 directoryOffset = readValue<quint32>(data + eocd + 16);
+
+    // ZIP64:
+
+    const qint64 locator = eocd - Zip64EndOfCentralDirectoryLocatorSize;
+    if (locator >= 0 && readValue<quint32>(data + locator) == Zip64EndOfCentralDirectoryLocatorSignature) {
+        const quint64 zip64Eocd = readValue<quint64>(data + locator + 8);
+        if (size >= Zip64EndOfCentralDirectorySize && zip64Eocd <= quint64(size) - Zip64EndOfCentralDirectorySize
+                && readValue<quint32>(data + zip64Eocd) == Zip64EndOfCentralDirectorySignature) {
+            entryCount = readValue<quint64>(data + zip64Eocd + 32);
+            directorySize = readValue<quint64>(data + zip64Eocd + 40);
+            directoryOffset = readValue<quint64>(data + zip64Eocd + 48);
+        }
+    }
+
+    if (directoryOffset > quint64(size) || directorySize > quint64(size) - directoryOffset) {
+        return false;
+    }
+
+    // Parse central directory headers:
+
+    // The entry count comes from the archive, so it is capped by the number of headers that fit into the directory
+    entries.reserve(static_cast<int>(qMin<quint64>(entryCount, directorySize / CentralHeaderSize)));
+    entryIndexes.reserve(entries.capacity());
+    const uchar *header = data + directoryOffset;
+    const uchar *directoryEnd = header + directorySize;
+    for (quint64 i = 0; i < entryCount; ++i) {
+        if (header + CentralHeaderSize > directoryEnd || readValue<quint32>(header) != CentralHeaderSignature) {
+            return false;
+        }
+        const quint16 nameLength = readValue<quint16>(header + 28);
+        const quint16 extraLength = readValue<quint16>(header + 30);
+        const quint16 commentLength = readValue<quint16>(header + 32);
+        const uchar *name = header + CentralHeaderSize;
+        const uchar *extra = name + nameLength;
+        if (extra + extraLength + commentLength > directoryEnd) {
+            return false;
+        }
+
+        Entry entry;
+        entry.flags = readValue<quint16>(header + 8);
+        entry.method = readValue<quint16>(header + 10);
+        entry.modifiedTime = readValue<quint16>(header + 12);
+        entry.modifiedDate = readValue<quint16>(header + 14);
+        entry.crc = readValue<quint32>(header + 16);
+        entry.compressedSize = readValue<quint32>(header + 20);
+        entry.uncompressedSize = readValue<quint32>(header + 24);
+        entry.localHeaderOffset = readValue<quint32>(header + 42);
+        entry.name = QString::fromUtf8(reinterpret_cast<const char *>(name), nameLength);
+
+        // ZIP64 extended information only contains the fields which overflowed in the main header:
+        const uchar *field = extra;
+        while (field + 4 <= extra + extraLength) {
+            const quint16 tag = readValue<quint16>(field);
+            const quint16 fieldSize = readValue<quint16>(field + 2);
+            const uchar *value = field + 4;
+            const uchar *valueEnd = value + fieldSize;
+            if (valueEnd > extra + extraLength) {
+                break;
+            }
+            if (tag == Zip64ExtraFieldTag) {
+                if (entry.uncompressedSize == 0xFFFFFFFF && value + 8 <= valueEnd) {
+                    entry.uncompressedSize = readValue<quint64>(value);
+                    value += 8;
+                }
+                if (entry.compressedSize == 0xFFFFFFFF && value + 8 <= valueEnd) {
+                    entry.compressedSize = readValue<quint64>(value);
+                    value += 8;
+                }
+                if (entry.localHeaderOffset == 0xFFFFFFFF && value + 8 <= valueEnd) {
+                    entry.localHeaderOffset = readValue<quint64>(value);
+                }
+            }
+            field = valueEnd;
+        }
+
+        entryIndexes.insert(entry.name, entries.count());
+        entries.append(entry);
+        header = extra + extraLength + commentLength;
+    }
+
+    return true;
+}
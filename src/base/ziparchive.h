@@ -0,0 +1,67 @@
+#ifndef ZIPARCHIVE_H
+#define ZIPARCHIVE_H
+
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+// Read-only ZIP archive backed by a memory-mapped file.
+// Only the central directory is parsed on open; entries are decompressed on demand.
+
+class ZipArchive
+{
+public:
+    struct Entry
+    {
+        QString name;
+        quint16 flags;
+        quint16 method;
+        quint16 modifiedTime;
+        quint16 modifiedDate;
+        quint32 crc;
+        quint64 compressedSize;
+        quint64 uncompressedSize;
+        quint64 localHeaderOffset;
+
+        bool isDirectory() const { return name.endsWith('/'); }
+        bool isCompressed() const { return method != Stored; }
+    };
+
+    enum Method {
+        Stored = 0,
+        Deflated = 8
+    };
+
+    explicit ZipArchive(const QString &path);
+    ~ZipArchive();
+
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    QString getPath() const;
+    qint64 getSize() const;
+    const QVector<Entry> &getEntries() const;
+    const Entry *getEntry(const QString &name) const;
+    qint64 getDataOffset(const Entry &entry) const;
+    const uchar *getRawData(const Entry &entry) const;
+
+    QByteArray read(const QString &name) const;
+    QByteArray read(const Entry &entry) const;
+    QByteArray readHead(const Entry &entry, int length) const; // Decompresses only the first bytes
+
+    static QByteArray inflate(const uchar *data, quint64 size, quint64 expectedSize);
+    static QByteArray deflate(const QByteArray &data);
+    static quint32 checksum(const QByteArray &data); // CRC-32
+
+private:
+    bool parseCentralDirectory();
+
+    QFile file;
+    const uchar *data = nullptr;
+    qint64 size = 0;
+    QVector<Entry> entries;
+    QHash<QString, int> entryIndexes;
+};
+
+#endif // ZIPARCHIVE_H
@@ -0,0 +1,264 @@
+#include "base/zippatcher.h"
+#include "base/ziparchive.h"
+#include <QDateTime>
+#include <QSaveFile>
+#include <QStringList>
+#include <QVector>
+#include <QtEndian>
+#include <QDebug>
+
+namespace
+{
+    const quint32 LocalHeaderSignature = 0x04034b50;
+    const quint32 CentralHeaderSignature = 0x02014b50;
+    const quint32 EndOfCentralDirectorySignature = 0x06054b50;
+    const quint16 AlignmentExtraFieldTag = 0xd935; // Same as used by apksigner and zipalign
+    const quint16 DataDescriptorFlag = 1 << 3;
+    const quint16 Utf8Flag = 1 << 11;
+    const quint16 Version = 20;
+    const int LocalHeaderSize = 30;
+    const int DefaultAlignment = 4;
+    const int NativeLibraryAlignment = 4096;
+
+    template<typename T> void appendValue(QByteArray &buffer, T value)
+    {
+        const T littleEndian = qToLittleEndian(value);
+        buffer.append(reinterpret_cast<const char *>(&littleEndian), sizeof(T));
+    }
+
+    struct Record
+    {
+        QByteArray name;
+        quint16 flags;
+        quint16 method;
+        quint16 modifiedTime;
+        quint16 modifiedDate;
+        quint32 crc;
+        quint64 compressedSize;
+        quint64 uncompressedSize;
+        quint64 localHeaderOffset;
+    };
+}
+
+ZipPatcher::ZipPatcher(const QString &sourcePath) : sourcePath(sourcePath) {}
+
+void ZipPatcher::replace(const QString &name, const QByteArray &data)
+{
+    removals.remove(name);
+    replacements.insert(name, data);
+}
+
+void ZipPatcher::remove(const QString &name)
+{
+    replacements.remove(name);
+    removals.insert(name);
+}
+
+bool ZipPatcher::isEmpty() const
+{
+    return replacements.isEmpty() && removals.isEmpty();
+}
+
+bool ZipPatcher::write(const QString &targetPath) const
+{
+    ZipArchive source(sourcePath);
+    if (!source.open()) {
+        return false;
+    }
+    QSaveFile target(targetPath);
+    if (!target.open(QSaveFile::WriteOnly)) {
+        qWarning() << "Could not open" << targetPath;
+        return false;
+    }
+
+    QVector<Record> records;
+    quint64 offset = 0;
+
+    auto writeEntry = [&](Record record, const char *data) -> bool {
+        // Uncompressed data is padded with an extra field to allow memory-mapping at runtime:
+        QByteArray extra;
+        if (record.method == ZipArchive::Stored) {
+            const int alignment = record.name.endsWith(".so") ? NativeLibraryAlignment : DefaultAlignment;
+            const quint64 dataOffset = offset + LocalHeaderSize + record.name.size() + 6;
+            const int padding = static_cast<int>((alignment - dataOffset % alignment) % alignment);
+            appendValue<quint16>(extra, AlignmentExtraFieldTag);
+            appendValue<quint16>(extra, static_cast<quint16>(2 + padding));
+            appendValue<quint16>(extra, static_cast<quint16>(alignment));
+            extra.append(padding, '\0');
+        }
+
+        // Sizes are always known in advance, so no data descriptor is needed:
+        record.flags = (record.flags & ~DataDescriptorFlag) | Utf8Flag;
+        record.localHeaderOffset = offset;
+        if (record.compressedSize > 0xFFFFFFFF || record.uncompressedSize > 0xFFFFFFFF || offset > 0xFFFFFFFF) {
+            qWarning() << "ZIP64 is not supported by the ZIP patcher:" << record.name;
+            return false;
+        }
+
+        QByteArray header;
+        appendValue<quint32>(header, LocalHeaderSignature);
+        appendValue<quint16>(header, Version);
+        appendValue<quint16>(header, record.flags);
+        appendValue<quint16>(header, record.method);
+        appendValue<quint16>(header, record.modifiedTime);
+        appendValue<quint16>(header, record.modifiedDate);
+        appendValue<quint32>(header, record.crc);
+        appendValue<quint32>(header, static_cast<quint32>(record.compressedSize));
+        appendValue<quint32>(header, static_cast<quint32>(record.uncompressedSize));
+        appendValue<quint16>(header, static_cast<quint16>(record.name.size()));
+        appendValue<quint16>(header, static_cast<quint16>(extra.size()));
+        header.append(record.name);
+        header.append(extra);
+
+        if (target.write(header) != header.size()
+                || target.write(data, static_cast<qint64>(record.compressedSize)) != qint64(record.compressedSize)) {
+            return false;
+        }
+        offset += header.size() + record.compressedSize;
+        records.append(record);
+        return true;
+    };
+
+    auto writeReplacement = [&](const QString &name, const QByteArray &data, const ZipArchive::Entry *original) -> bool {
+        Record record;
+        record.name = name.toUtf8();
+        record.flags = 0;
+        record.crc = ZipArchive::checksum(data);
+        record.uncompressedSize = static_cast<quint64>(data.size());
+        if (original) {
+            // Entries stored uncompressed may be required to stay that way (e.g., "resources.arsc")
+            record.method = original->method == ZipArchive::Stored ? ZipArchive::Stored : ZipArchive::Deflated;
+        } else {
+            record.method = isCompressible(name) ? ZipArchive::Deflated : ZipArchive::Stored;
+        }
+        const QDateTime now = QDateTime::currentDateTime();
+        record.modifiedTime = static_cast<quint16>((now.time().hour() << 11) | (now.time().minute() << 5) | (now.time().second() / 2));
+        record.modifiedDate = static_cast<quint16>(((now.date().year() - 1980) << 9) | (now.date().month() << 5) | now.date().day());
+
+        if (record.method == ZipArchive::Deflated) {
+            const QByteArray compressed = ZipArchive::deflate(data);
+            if (compressed.isNull() && !data.isEmpty()) {
+                return false;
+            }
+            record.compressedSize = static_cast<quint64>(compressed.size());
+            return writeEntry(record, compressed.constData());
+        }
+        record.compressedSize = record.uncompressedSize;
+        return writeEntry(record, data.constData());
+    };
+
+    // Existing entries keep their order:
+
+    for (const auto &entry : source.getEntries()) {
+        if (removals.contains(entry.name) || isSignatureEntry(entry.name)) {
+            continue;
+        }
+        bool success;
+        const auto replacement = replacements.constFind(entry.name);
+        if (replacement != replacements.constEnd()) {
+            success = writeReplacement(entry.name, replacement.value(), &entry);
+        } else {
+            const uchar *raw = source.getRawData(entry);
+            if (!raw) {
+                qWarning() << "Could not read" << entry.name;
+                return false;
+            }
+            Record record;
+            record.name = entry.name.toUtf8();
+            record.flags = entry.flags;
+            record.method = entry.method;
+            record.modifiedTime = entry.modifiedTime;
+            record.modifiedDate = entry.modifiedDate;
+            record.crc = entry.crc;
+            record.compressedSize = entry.compressedSize;
+            record.uncompressedSize = entry.uncompressedSize;
+            success = writeEntry(record, reinterpret_cast<const char *>(raw));
+        }
+        if (!success) {
+            qWarning() << "Could not write" << entry.name;
+            return false;
+        }
+    }
+
+    // New entries:
+
+    for (auto it = replacements.constBegin(); it != replacements.constEnd(); ++it) {
+        if (!source.getEntry(it.key()) && !writeReplacement(it.key(), it.value(), nullptr)) {
+            qWarning() << "Could not write" << it.key();
+            return false;
+        }
+    }
+
+    // Central directory:
+
+    QByteArray directory;
+    for (const Record &record : records) {
+        appendValue<quint32>(directory, CentralHeaderSignature);
+        appendValue<quint16>(directory, Version);
+        appendValue<quint16>(directory, Version);
+        appendValue<quint16>(directory, record.flags);
+        appendValue<quint16>(directory, record.method);
+        appendValue<quint16>(directory, record.modifiedTime);
+        appendValue<quint16>(directory, record.modifiedDate);
+        appendValue<quint32>(directory, record.crc);
+        appendValue<quint32>(directory, static_cast<quint32>(record.compressedSize));
+        appendValue<quint32>(directory, static_cast<quint32>(record.uncompressedSize));
+        appendValue<quint16>(directory, static_cast<quint16>(record.name.size()));
+        appendValue<quint16>(directory, 0); // Extra field length
+        appendValue<quint16>(directory, 0); // Comment length
+        appendValue<quint16>(directory, 0); // Disk number
+        appendValue<quint16>(directory, 0); // Internal attributes
+        appendValue<quint32>(directory, 0); // External attributes
+        appendValue<quint32>(directory, static_cast<quint32>(record.localHeaderOffset));
+        directory.append(record.name);
+    }
+    if (records.count() > 0xFFFF || offset > 0xFFFFFFFF) {
+        qWarning() << "ZIP64 is not supported by the ZIP patcher";
+        return false;
+    }
+    const quint32 directorySize = static_cast<quint32>(directory.size());
+    appendValue<quint32>(directory, EndOfCentralDirectorySignature);
+    appendValue<quint16>(directory, 0); // Disk number
+    appendValue<quint16>(directory, 0); // Central directory disk number
+    appendValue<quint16>(directory, static_cast<quint16>(records.count()));
+    appendValue<quint16>(directory, static_cast<quint16>(records.count()));
+    appendValue<quint32>(directory, directorySize);
+    appendValue<quint32>(directory, static_cast<quint32>(offset));
+    appendValue<quint16>(directory, 0); // Comment length
+
+    if (target.write(directory) != directory.size()) {
+        return false;
+    }
+    // The source must be unmapped before it can be replaced (when patching in place)
+    source.close();
+    return target.commit();
+}
+
+bool ZipPatcher::isSignatureEntry(const QString &name)
+{
+    if (!name.startsWith("META-INF/") || name.indexOf('/', 9) != -1) {
+        return false;
+    }
+    return name == "META-INF/MANIFEST.MF"
+        || name.endsWith(".SF")
+        || name.endsWith(".RSA")
+        || name.endsWith(".DSA")
+        || name.endsWith(".EC");
+}
+
+bool ZipPatcher::isCompressible(const QString &name)
+{
+    // Same list as in aapt, these formats are already compressed
+    static const QStringList compressed = {
+        ".jpg", ".jpeg", ".png", ".gif", ".webp",
+        ".wav", ".mp2", ".mp3", ".ogg", ".aac", ".mpg", ".mpeg", ".mid", ".midi", ".smf", ".jet",
+        ".rtttl", ".imy", ".xmf", ".mp4", ".m4a", ".m4v", ".3gp", ".3gpp", ".3g2", ".3gpp2",
+        ".amr", ".awb", ".wma", ".wmv", ".webm", ".mkv", ".so", ".arsc"
+    };
+    for (const QString &extension : compressed) {
+        if (name.endsWith(extension, Qt::CaseInsensitive)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef ZIPPATCHER_H
+#define ZIPPATCHER_H
+
+#include <QMap>
+#include <QSet>
+#include <QString>
+
+// Writes a copy of a ZIP archive with some of its entries replaced, added or removed.
+// Unchanged entries are copied byte-for-byte without recompression. Uncompressed entries are
+// aligned as zipalign would do (4 bytes, 4 KiB for native libraries), and the previous JAR
+// signature is dropped so the result is ready to be signed. The source archive may be patched in place.
+
+class ZipPatcher
+{
+public:
+    explicit ZipPatcher(const QString &sourcePath);
+
+    void replace(const QString &name, const QByteArray &data);
+    void remove(const QString &name);
+    bool isEmpty() const;
+
+    bool write(const QString &targetPath) const;
+
+private:
+    static bool isSignatureEntry(const QString &name);
+    static bool isCompressible(const QString &name);
+
+    QString sourcePath;
+    QMap<QString, QByteArray> replacements;
+    QSet<QString> removals;
+};
+
+#endif // ZIPPATCHER_H
@@ -3,11 +3,22 @@
 #include "widgets/codesearchbar.h"
 #include "base/application.h"
 #include <KSyntaxHighlighting/Definition>
+#include <KSyntaxHighlighting/Repository>
 #include <QAction>
 #include <QBoxLayout>
+#include <QProgressBar>
 #include <QRegularExpression>
 #include <QScrollBar>
 #include <QTextCodec>
+#include <QtConcurrent/QtConcurrent>
+
+namespace
+{
+    // Files above this size are opened in the large file mode
+    const qint64 LargeFileSize = 2 * 1024 * 1024;
+    const int ChunkSize = 256 * 1024;
+    const int SmaliCheckDelay = 300;
+}
 
 CodeSheet::CodeSheet(const ResourceModelIndex &index, QWidget *parent) : BaseFileSheet(index, parent)
 {
@@ -21,17 +32,42 @@ CodeSheet::CodeSheet(const ResourceModelIndex &index, QWidget *parent) : BaseFil
     setSheetIcon(index.icon());
 
     editor = new CodeEditor(this);
-    editor->setDefinition(app->highlightingRepository.definitionForFileName(filename));
+    editor->setDefinition(app->getHighlightingRepository()->definitionForFileName(filename));
 
     searchBar = new CodeSearchBar(editor);
     connect(editor, &CodeEditor::searchFinished, searchBar, &CodeSearchBar::setResults);
 
+    progressBar = new QProgressBar(this);
+    progressBar->setTextVisible(false);
+    progressBar->hide();
+
+    chunkTimer.setInterval(0);
+    connect(&chunkTimer, &QTimer::timeout, this, &CodeSheet::loadNextChunk);
+
     auto layout = new QVBoxLayout(this);
     layout->addWidget(editor);
+    layout->addWidget(progressBar);
     layout->addWidget(searchBar);
     layout->setMargin(0);
     layout->setSpacing(0);
 
+    if (filename.endsWith(".smali", Qt::CaseInsensitive)) {
+        checkTimer.setSingleShot(true);
+        checkTimer.setInterval(SmaliCheckDelay);
+        connect(&checkTimer, &QTimer::timeout, this, &CodeSheet::checkSmali);
+        connect(editor, &QPlainTextEdit::textChanged, &checkTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+        connect(&checkWatcher, &QFutureWatcher<QVector<SmaliChecker::Error>>::finished, this, [this]() {
+            if (checkTimer.isActive()) {
+                return; // Outdated, the text has been changed since
+            }
+            QHash<int, QString> errors;
+            for (const SmaliChecker::Error &error : checkWatcher.result()) {
+                errors.insert(error.line, error.message);
+            }
+            editor->setLineErrors(errors);
+        });
+    }
+
     load();
     connect(editor, &QPlainTextEdit::modificationChanged, this, &CodeSheet::setModified);
 
@@ -68,16 +104,38 @@ bool CodeSheet::load()
     if (file.open(QFile::ReadOnly)) {
         QTextStream stream(&file);
         stream.setCodec("UTF-8"); // Fallback if no codec is detected on further read
-        auto cursor = editor->textCursor();
-        const int selectionStart = cursor.selectionStart();
-        const int selectionEnd = cursor.selectionEnd();
-        const int scrollPosition = editor->verticalScrollBar()->value();
+        if (!chunkTimer.isActive()) {
+            auto cursor = editor->textCursor();
+            restoredSelectionStart = cursor.selectionStart();
+            restoredSelectionEnd = cursor.selectionEnd();
+            restoredScrollPosition = editor->verticalScrollBar()->value();
+        }
+        chunkTimer.stop();
+        const bool isLargeFile = file.size() > LargeFileSize;
+        editor->setLargeFileMode(isLargeFile);
+        if (isLargeFile) {
+            pendingText = stream.readAll();
+            pendingPosition = 0;
+            codec = stream.codec(); // Qt automatically deletes the codec on exit
+            editor->setReadOnly(true);
+            editor->document()->setUndoRedoEnabled(false);
+            editor->clear();
+            progressBar->setRange(0, pendingText.size());
+            progressBar->setValue(0);
+            progressBar->show();
+            chunkTimer.start();
+            return true;
+        }
+        progressBar->hide();
+        editor->document()->setUndoRedoEnabled(true);
+        editor->setReadOnly(false);
         editor->setPlainText(stream.readAll());
         codec = stream.codec(); // Qt automatically deletes the codec on exit
-        cursor.setPosition(selectionStart);
-        cursor.setPosition(selectionEnd, QTextCursor::KeepAnchor);
+        auto cursor = editor->textCursor();
+        cursor.setPosition(restoredSelectionStart);
+        cursor.setPosition(restoredSelectionEnd, QTextCursor::KeepAnchor);
         editor->setTextCursor(cursor);
-        editor->verticalScrollBar()->setValue(scrollPosition);
+        editor->verticalScrollBar()->setValue(restoredScrollPosition);
         setModified(false);
         return true;
     }
@@ -87,6 +145,10 @@ bool CodeSheet::load()
 
 bool CodeSheet::save(const QString &as)
 {
+    if (chunkTimer.isActive()) {
+        qWarning() << "Error: Could not save code resource file while it is being loaded";
+        return false;
+    }
     QFile file(as.isEmpty() ? index.path() : as);
     if (file.open(QFile::WriteOnly)) {
         file.resize(0);
@@ -112,6 +174,41 @@ void CodeSheet::keyPressEvent(QKeyEvent *event)
     BaseFileSheet::keyPressEvent(event);
 }
 
+void CodeSheet::loadNextChunk()
+{
+    // Chunks end at line breaks, so that every chunk completes the last block
+    int chunkEnd = pendingText.indexOf('\n', pendingPosition + ChunkSize);
+    chunkEnd = (chunkEnd != -1) ? chunkEnd + 1 : pendingText.size();
+    QTextCursor cursor(editor->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(pendingText.mid(pendingPosition, chunkEnd - pendingPosition));
+    pendingPosition = chunkEnd;
+    progressBar->setValue(pendingPosition);
+
+    if (pendingPosition >= pendingText.size()) {
+        chunkTimer.stop();
+        pendingText.clear();
+        progressBar->hide();
+        editor->document()->setUndoRedoEnabled(true);
+        editor->document()->setModified(false);
+        editor->setReadOnly(false);
+        cursor.setPosition(qMin(restoredSelectionStart, editor->document()->characterCount() - 1));
+        cursor.setPosition(qMin(restoredSelectionEnd, editor->document()->characterCount() - 1), QTextCursor::KeepAnchor);
+        editor->setTextCursor(cursor);
+        editor->verticalScrollBar()->setValue(restoredScrollPosition);
+        setModified(false);
+    }
+}
+
+void CodeSheet::checkSmali()
+{
+    if (chunkTimer.isActive() || checkWatcher.isRunning()) {
+        checkTimer.start();
+        return;
+    }
+    checkWatcher.setFuture(QtConcurrent::run(&SmaliChecker::check, editor->toPlainText()));
+}
+
 void CodeSheet::findSelectedText()
 {
     auto cursor = editor->textCursor();
@@ -2,9 +2,13 @@
 #define CODESHEET_H
 
 #include "sheets/basefilesheet.h"
+#include "apk/smalichecker.h"
+#include <QFutureWatcher>
+#include <QTimer>
 
 class CodeEditor;
 class CodeSearchBar;
+class QProgressBar;
 
 class CodeSheet : public BaseFileSheet
 {
@@ -18,12 +22,27 @@ protected:
     void keyPressEvent(QKeyEvent *event) override;
 
 private:
+    void loadNextChunk();
+    void checkSmali();
     void findSelectedText();
     void replaceSelectedText();
 
     QTextCodec *codec;
     CodeEditor *editor;
     CodeSearchBar *searchBar;
+    QProgressBar *progressBar;
+
+    // Large files are inserted in chunks to keep the interface responsive
+    QTimer chunkTimer;
+    QString pendingText;
+    int pendingPosition = 0;
+    int restoredSelectionStart = 0;
+    int restoredSelectionEnd = 0;
+    int restoredScrollPosition = 0;
+
+    // Smali files are checked in the background once the user stops typing
+    QTimer checkTimer;
+    QFutureWatcher<QVector<SmaliChecker::Error>> checkWatcher;
 };
 
 #endif // CODESHEET_H
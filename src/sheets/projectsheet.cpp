@@ -1,8 +1,10 @@
 #include "sheets/projectsheet.h"
 #include "windows/dialogs.h"
+#include "windows/manifestpatcher.h"
 #include "apk/package.h"
 #include "base/utils.h"
 #include <QEvent>
+#include <QLabel>
 #include <QPushButton>
 
 ProjectSheet::ProjectSheet(Package *package, QWidget *parent) : BaseActionSheet(parent)
@@ -10,6 +12,12 @@ ProjectSheet::ProjectSheet(Package *package, QWidget *parent) : BaseActionSheet(
     setSheetIcon(QIcon::fromTheme("tool-projectmanager"));
     this->package = package;
 
+    summary = new QLabel(this);
+    summary->setAlignment(Qt::AlignCenter);
+    summary->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    summary->setStyleSheet("margin-bottom: 12px;");
+    addWidget(summary);
+
     btnEditTitle = addButton();
     connect(btnEditTitle, &QPushButton::clicked, this, [this]() {
         emit titleEditorRequested();
@@ -21,6 +29,12 @@ ProjectSheet::ProjectSheet(Package *package, QWidget *parent) : BaseActionSheet(
         package->setApplicationIcon(iconSource, this);
     });
 
+    btnPatchManifest = addButton();
+    connect(btnPatchManifest, &QPushButton::clicked, package, [package, this]() {
+        ManifestPatcher dialog(package, this);
+        dialog.exec();
+    });
+
     btnExplore = addButton();
     connect(btnExplore, &QPushButton::clicked, package, [package]() {
         Utils::explore(package->getContentsPath());
@@ -53,20 +67,52 @@ void ProjectSheet::changeEvent(QEvent *event)
 void ProjectSheet::onPackageUpdated()
 {
     setHeading(package->getTitle());
+    updateSummary();
     btnEditTitle->setEnabled(package->getState().canEdit());
-    btnEditIcon->setEnabled(package->getState().canEdit());
+    btnEditIcon->setEnabled(package->getState().isIdle() && (package->getState().canEdit() || package->getState().isPatchable()));
+    btnPatchManifest->setVisible(package->getState().isPatchable());
+    btnPatchManifest->setEnabled(package->getState().isIdle());
     btnExplore->setEnabled(package->getState().canExplore());
     btnSave->setEnabled(package->getState().canSave());
     btnInstall->setEnabled(package->getState().canInstall());
 }
 
+void ProjectSheet::updateSummary()
+{
+    // Prefer the unpacked manifest as it reflects the user changes
+    const auto &binaryManifest = package->getBinaryManifest();
+    const auto manifest = package->manifest;
+    if (!manifest && !binaryManifest.isValid()) {
+        summary->hide();
+        return;
+    }
+    const QString packageName = manifest ? manifest->getPackageName() : binaryManifest.getPackageName();
+    const QString versionName = manifest ? manifest->getVersionName() : binaryManifest.getVersionName();
+    const int versionCode = manifest ? manifest->getVersionCode() : binaryManifest.getVersionCode();
+    const int minSdk = manifest ? manifest->getMinSdk() : binaryManifest.getMinSdk();
+    const int targetSdk = manifest ? manifest->getTargetSdk() : binaryManifest.getTargetSdk();
+    const int permissions = manifest ? manifest->getPermissionList().count() : binaryManifest.getPermissions().count();
+
+    QStringList lines;
+    lines.append(packageName);
+    //: "%1" will be replaced with a version name, "%2" will be replaced with a version code (e.g., "Version 1.2.3 (45)").
+    lines.append(tr("Version %1 (%2)").arg(versionName).arg(versionCode));
+    //: "%1" and "%2" will be replaced with Android API levels (e.g., "Minimum SDK: 21, Target SDK: 30").
+    lines.append(tr("Minimum SDK: %1, Target SDK: %2").arg(minSdk).arg(targetSdk));
+    lines.append(tr("Permissions: %1").arg(permissions));
+    summary->setText(lines.join('\n'));
+    summary->show();
+}
+
 void ProjectSheet::retranslate()
 {
+    updateSummary();
     //: This string refers to a single project (as in "Manager of a project").
     setSheetTitle(tr("Project Manager"));
     tr("Edit APK"); // TODO For future use
     btnEditTitle->setText(tr("Application Title"));
     btnEditIcon->setText(tr("Application Icon"));
+    btnPatchManifest->setText(tr("Manifest Attributes"));
     btnExplore->setText(tr("Open Contents"));
     btnSave->setText(tr("Save APK"));
     btnInstall->setText(tr("Install APK"));
@@ -4,6 +4,7 @@
 #include "sheets/baseactionsheet.h"
 
 class Package;
+class QLabel;
 
 class ProjectSheet : public BaseActionSheet
 {
@@ -22,12 +23,15 @@ protected:
 
 private:
     void onPackageUpdated();
+    void updateSummary();
     void retranslate();
 
     Package *package;
 
+    QLabel *summary;
     QPushButton *btnEditIcon;
     QPushButton *btnEditTitle;
+    QPushButton *btnPatchManifest;
     QPushButton *btnExplore;
     QPushButton *btnSave;
     QPushButton *btnInstall;
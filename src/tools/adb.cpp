@@ -1,30 +1,162 @@
 #include "tools/adb.h"
+#include "tools/adbconnection.h"
+#include "tools/adbsync.h"
 #include "base/application.h"
-#include "base/process.h"
 #include "base/settings.h"
 #include "base/utils.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QFileInfo>
+#include <QFutureWatcher>
 #include <QDebug>
 #include <QFile>
 #include <QRegularExpression>
 
-void Adb::Cd::run()
+namespace
 {
-    emit started();
+    struct Result
+    {
+        bool success = false;
+        QString output;
+    };
+
+    struct ListResult
+    {
+        bool success = false;
+        QList<AndroidFileSystemItem> items;
+    };
+
+    template<typename Function, typename Callback>
+    void runInBackground(Command *command, Function function, Callback callback)
+    {
+        // The adb server is only started by the client if it isn't running yet
+        AdbConnection::setAdbPath(Adb::getPath());
+        typedef decltype(function()) Output;
+        auto watcher = new QFutureWatcher<Output>(command);
+        QObject::connect(watcher, &QFutureWatcher<Output>::finished, command, [=]() {
+            callback(watcher->result());
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(function));
+    }
 
-    QStringList arguments;
-    if (!serial.isEmpty()) {
-        arguments << "-s" << serial;
+    template<typename Callback>
+    void runShell(Command *command, const QString &serial, const QString &shellCommand, Callback callback)
+    {
+        runInBackground(command, [=]() {
+            Result result;
+            result.success = AdbConnection::shell(serial, shellCommand, &result.output);
+            return result;
+        }, callback);
     }
-    arguments << "shell" << "cd" << path;
 
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, [=](bool success, const QString &output) {
-        resultOutput = output;
-        emit finished(success);
-        process->deleteLater();
-    });
-    process->run(getPath(), arguments);
+    QString joinPath(const QString &directory, const QString &name)
+    {
+        return directory.endsWith('/') ? directory + name : QString("%1/%2").arg(directory, name);
+    }
+
+    bool execute(const QString &serial, const QString &command, const QString &input, QString &output)
+    {
+        // Runs the command without a shell protocol, optionally streaming the file to its standard input
+        AdbConnection connection;
+        if (!connection.connectToDevice(serial, QString("exec:%1").arg(command))) {
+            output = connection.getError();
+            return false;
+        }
+        if (!input.isEmpty()) {
+            QFile file(input);
+            if (!file.open(QFile::ReadOnly)) {
+                output = file.errorString();
+                return false;
+            }
+            while (!file.atEnd()) {
+                if (!connection.write(file.read(64 * 1024))) {
+                    output = connection.getError();
+                    return false;
+                }
+            }
+        }
+        output = QString::fromUtf8(connection.readToEnd()).trimmed();
+        return output.contains("Success");
+    }
+
+    Result install(const QString &serial, const QStringList &apks)
+    {
+        Result result;
+
+        // Devices with the "cmd" feature (Android 7.0+) read the APK directly from the stream,
+        // older devices require it to be copied to a temporary location first, as with "adb install"
+        const bool streamed = AdbConnection::getFeatures(serial).contains("cmd");
+        const QString pm = streamed ? "cmd package" : "pm";
+        QStringList temporaryFiles;
+        auto cleanup = [&]() {
+            for (const QString &path : temporaryFiles) {
+                AdbConnection::shell(serial, QString("rm -f %1").arg(Adb::escapePath(path)));
+            }
+        };
+        if (!streamed) {
+            AdbSync sync(serial);
+            for (const QString &apk : apks) {
+                const QString target = QString("/data/local/tmp/%1").arg(QFileInfo(apk).fileName());
+                if (!sync.send(apk, target)) {
+                    result.output = sync.getError();
+                    cleanup();
+                    return result;
+                }
+                temporaryFiles.append(target);
+            }
+        }
+
+        if (apks.count() == 1) {
+            const QString apk = apks.first();
+            if (streamed) {
+                const QString command = QString("%1 install -r -S %2").arg(pm).arg(QFileInfo(apk).size());
+                result.success = execute(serial, command, apk, result.output);
+            } else {
+                const QString command = QString("%1 install -r %2").arg(pm, Adb::escapePath(temporaryFiles.first()));
+                result.success = execute(serial, command, QString(), result.output);
+            }
+            cleanup();
+            return result;
+        }
 
+        // Split APKs are written into an install session, which is then committed as a whole
+        qint64 totalSize = 0;
+        for (const QString &apk : apks) {
+            totalSize += QFileInfo(apk).size();
+        }
+        if (!execute(serial, QString("%1 install-create -r -S %2").arg(pm).arg(totalSize), QString(), result.output)) {
+            cleanup();
+            return result;
+        }
+        const QString session = QRegularExpression("\\[(\\d+)\\]").match(result.output).captured(1);
+        if (session.isEmpty()) {
+            cleanup();
+            return result;
+        }
+        for (int i = 0; i < apks.count(); ++i) {
+            const qint64 size = QFileInfo(apks.at(i)).size();
+            const QString source = streamed ? QString("-") : Adb::escapePath(temporaryFiles.at(i));
+            const QString command = QString("%1 install-write -S %2 %3 %4.apk %5").arg(pm).arg(size).arg(session).arg(i).arg(source);
+            if (!execute(serial, command, streamed ? apks.at(i) : QString(), result.output)) {
+                QString abandonOutput;
+                execute(serial, QString("%1 install-abandon %2").arg(pm, session), QString(), abandonOutput);
+                cleanup();
+                return result;
+            }
+        }
+        result.success = execute(serial, QString("%1 install-commit %2").arg(pm, session), QString(), result.output);
+        cleanup();
+        return result;
+    }
+}
+
+void Adb::Cd::run()
+{
+    emit started();
+    runShell(this, serial, QString("cd %1").arg(path), [=](const Result &result) {
+        resultOutput = result.output;
+        emit finished(result.success);
+    });
 }
 
 const QString &Adb::Cd::output() const
@@ -35,20 +167,10 @@ const QString &Adb::Cd::output() const
 void Adb::Mkdir::run()
 {
     emit started();
-
-    QStringList arguments;
-    if (!serial.isEmpty()) {
-        arguments << "-s" << serial;
-    }
-    arguments << "shell" << "mkdir" << path;
-
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, [=](bool success, const QString &output) {
-        resultOutput = output;
-        emit finished(success);
-        process->deleteLater();
+    runShell(this, serial, QString("mkdir %1").arg(path), [=](const Result &result) {
+        resultOutput = result.output;
+        emit finished(result.success);
     });
-    process->run(getPath(), arguments);
 }
 
 const QString &Adb::Mkdir::output() const
@@ -59,20 +181,10 @@ const QString &Adb::Mkdir::output() const
 void Adb::Cp::run()
 {
     emit started();
-
-    QStringList arguments;
-    if (!serial.isEmpty()) {
-        arguments << "-s" << serial;
-    }
-    arguments << "shell" << "cp" << "-R" << "-n" << src << dst;
-
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, [=](bool success, const QString &output) {
-        resultOutput = output;
-        emit finished(success);
-        process->deleteLater();
+    runShell(this, serial, QString("cp -R -n %1 %2").arg(src, dst), [=](const Result &result) {
+        resultOutput = result.output;
+        emit finished(result.success);
     });
-    process->run(getPath(), arguments);
 }
 
 const QString &Adb::Cp::output() const
@@ -83,69 +195,52 @@ const QString &Adb::Cp::output() const
 void Adb::Mv::run()
 {
     emit started();
-
-    QStringList arguments;
-    if (!serial.isEmpty()) {
-        arguments << "-s" << serial;
-    }
-    arguments << "shell" << "mv" << "-n" << src << dst;
-
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, &Command::finished);
-    connect(process, &Process::finished, process, &QObject::deleteLater);
-    process->run(getPath(), arguments);
+    runShell(this, serial, QString("mv -n %1 %2").arg(src, dst), [=](const Result &result) {
+        emit finished(result.success);
+    });
 }
 
 void Adb::Rm::run()
 {
     emit started();
-
-    QStringList arguments;
-    if (!serial.isEmpty()) {
-        arguments << "-s" << serial;
-    }
-    arguments << "shell" << "rm" << "-rf" << path;
-
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, &Command::finished);
-    connect(process, &Process::finished, process, &QObject::deleteLater);
-    process->run(getPath(), arguments);
+    runShell(this, serial, QString("rm -rf %1").arg(path), [=](const Result &result) {
+        emit finished(result.success);
+    });
 }
 
 void Adb::Ls::run()
 {
     emit started();
-
-    QStringList arguments;
-    if (!serial.isEmpty()) {
-        arguments << "-s" << serial;
-    }
-    arguments << "shell" << "stat" << "-L" << "-c" << "'%F,%n'" << QString("%1/*").arg(path);
-
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, [=](bool success, const QString &output) {
-        fileSystemItems.clear();
-        const auto entries = output.split('\n');
-        for (const QString &entry : entries) {
-            if (!entry.isEmpty() && !entry.endsWith(": Permission denied")) {
-                const QRegularExpression regex("^(.+?),(.+)$");
-                const QString fsItemPath = regex.match(entry).captured(2);
-                const QString fsItemType = regex.match(entry).captured(1);
-                if (fsItemType == "regular file") {
-                    fileSystemItems.append(AndroidFileSystemItem(fsItemPath, AndroidFileSystemItem::AndroidFSFile));
-                } else if (fsItemType == "directory") {
-                    fileSystemItems.append(AndroidFileSystemItem(fsItemPath, AndroidFileSystemItem::AndroidFSDirectory));
-                } else {
-#ifdef QT_DEBUG
-                    qWarning() << "Warning: Unhandled AndroidFileSystemItem type" << fsItemType;
-#endif
-                }
+    const QString path = this->path;
+    const QString serial = this->serial;
+    runInBackground(this, [=]() {
+        // A single sync request returns the names along with the type, size and date of each entry
+        ListResult result;
+        AdbSync sync(serial);
+        QVector<AdbSync::Entry> entries;
+        if (!sync.list(path, entries)) {
+            qWarning() << "Could not list directory:" << sync.getError();
+            return result;
+        }
+        for (const AdbSync::Entry &entry : entries) {
+            const QString entryPath = joinPath(path, entry.name);
+            AdbSync::Stat stat = entry.stat;
+            if (stat.isSymLink() && !sync.stat(entryPath, stat, true)) {
+                return result;
+            }
+            const QDateTime modified = QDateTime::fromMSecsSinceEpoch(stat.modified * 1000);
+            if (stat.isFile()) {
+                result.items.append(AndroidFileSystemItem(entryPath, AndroidFileSystemItem::AndroidFSFile, stat.size, modified));
+            } else if (stat.isDirectory()) {
+                result.items.append(AndroidFileSystemItem(entryPath, AndroidFileSystemItem::AndroidFSDirectory, 0, modified));
             }
         }
-        emit finished(success);
-        process->deleteLater();
+        result.success = true;
+        return result;
+    }, [=](const ListResult &result) {
+        fileSystemItems = result.items;
+        emit finished(result.success);
     });
-    process->run(getPath(), arguments);
 }
 
 const QList<AndroidFileSystemItem> &Adb::Ls::getFileSystemItems() const
@@ -156,20 +251,14 @@ const QList<AndroidFileSystemItem> &Adb::Ls::getFileSystemItems() const
 void Adb::Install::run()
 {
     emit started();
-
-    QStringList arguments;
-    if (!serial.isEmpty()) {
-        arguments << "-s" << serial;
-    }
-    arguments << "install" << "-r" << apk;
-
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, [=](bool success, const QString &output) {
-        resultOutput = output;
-        emit finished(success);
-        process->deleteLater();
+    const QStringList apks = this->apks;
+    const QString serial = this->serial;
+    runInBackground(this, [=]() {
+        return install(serial, apks);
+    }, [=](const Result &result) {
+        resultOutput = result.output;
+        emit finished(result.success);
     });
-    process->run(getPath(), arguments);
 }
 
 const QString &Adb::Install::output() const
@@ -177,87 +266,46 @@ const QString &Adb::Install::output() const
     return resultOutput;
 }
 
-void Adb::Push::run()
-{
-    emit started();
-
-    QStringList arguments;
-    if (!serial.isEmpty()) {
-        arguments << "-s" << serial;
-    }
-    arguments << "push" << src << dst;
-
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, &Command::finished);
-    connect(process, &Process::finished, process, &QObject::deleteLater);
-    process->run(getPath(), arguments);
-}
-
-void Adb::Pull::run()
-{
-    emit started();
-
-    QStringList arguments;
-    if (!serial.isEmpty()) {
-        arguments << "-s" << serial;
-    }
-    arguments << "pull" << src << dst;
-
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, &Command::finished);
-    connect(process, &Process::finished, process, &QObject::deleteLater);
-    process->run(getPath(), arguments);
-}
-
 void Adb::Screenshot::run()
 {
-    QStringList arguments;
-    if (!serial.isEmpty()) {
-        arguments << "-s" << serial;
-    }
-    arguments << "exec-out" << "screencap" << "-p";
-
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, [=](bool success) {
-        if (!success) {
+    const QString dst = this->dst;
+    const QString serial = this->serial;
+    runInBackground(this, [=]() {
+        Result result;
+        AdbConnection connection;
+        if (connection.connectToDevice(serial, "exec:screencap -p")) {
+            const QByteArray image = connection.readToEnd();
+            QFile file(dst);
+            result.success = !image.isEmpty() && file.open(QFile::WriteOnly) && file.write(image) == image.size();
+        }
+        return result;
+    }, [=](const Result &result) {
+        if (!result.success) {
             QFile::remove(dst);
         }
-        emit finished(success);
-        process->deleteLater();
+        emit finished(result.success);
     });
-    process->setStandardOutputFile(dst);
-    process->run(getPath(), arguments);
 }
 
 void Adb::Devices::run()
 {
     emit started();
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, [=](bool success, const QString &output) {
-        resultDevices.clear();
-        if (success) {
-            QStringList lines = output.split('\n');
-            lines.removeFirst();
-            for (const QString &line : qAsConst(lines)) {
-                const QString serial = QRegularExpression("^(\\S+)\\s+device(\\s|$)").match(line).captured(1);
-                if (!serial.isEmpty()) {
-                    const QString modelString = QRegularExpression("\\s+model:(\\S+)(\\s|$)").match(line).captured(1);
-                    const QString deviceString = QRegularExpression("\\s+device:(\\S+)(\\s|$)").match(line).captured(1);
-                    const QString productString = QRegularExpression("\\s+product:(\\S+)(\\s|$)").match(line).captured(1);
-                    Device device(serial);
-                    device.setModelString(modelString);
-                    device.setDeviceString(deviceString);
-                    device.setProductString(productString);
-                    resultDevices.append(device);
-                }
-            }
+    runInBackground(this, []() {
+        Result result;
+        QString error;
+        const QByteArray reply = AdbConnection::query("host:devices-l", &error);
+        result.success = error.isEmpty();
+        result.output = result.success ? QString::fromUtf8(reply) : error;
+        return result;
+    }, [=](const Result &result) {
+        if (result.success) {
+            resultDevices = parseDevices(result.output);
         } else {
-            resultError = output;
+            resultDevices.clear();
+            resultError = result.output;
         }
-        emit finished(success);
-        process->deleteLater();
+        emit finished(result.success);
     });
-    process->run(getPath(), {"devices", "-l"});
 }
 
 const QList<Device> &Adb::Devices::devices() const
@@ -273,16 +321,20 @@ const QString &Adb::Devices::error() const
 void Adb::Version::run()
 {
     emit started();
-    auto process = new Process(this);
-    connect(process, &Process::finished, this, [=](bool success, const QString &output) {
-        if (success) {
-            QRegularExpression regex("Android Debug Bridge version (.+)");
-            resultVersion = regex.match(output).captured(1).trimmed();
+    runInBackground(this, []() {
+        // The server reports its protocol revision (e.g., "0029" for version 1.0.41)
+        Result result;
+        bool ok;
+        const int revision = AdbConnection::query("host:version").toInt(&ok, 16);
+        if (ok) {
+            result.success = true;
+            result.output = QString("1.0.%1").arg(revision);
         }
-        emit finished(success);
-        process->deleteLater();
+        return result;
+    }, [=](const Result &result) {
+        resultVersion = result.output;
+        emit finished(result.success);
     });
-    process->run(getPath(), {"version"});
 }
 
 const QString &Adb::Version::version() const
@@ -306,3 +358,33 @@ QString Adb::escapePath(QString path)
     path = QString("\"%1\"").arg(path);
     return path;
 }
+
+QList<Device> Adb::parseDevices(const QString &reply)
+{
+    // Each line is "<serial> <state> [<key>:<value>...]", with no header line unlike the adb client output.
+    // Only devices in the "device" state are ready to be used.
+    QList<Device> devices;
+    const QStringList lines = reply.split('\n', QString::SkipEmptyParts);
+    for (const QString &line : lines) {
+        const QStringList fields = line.simplified().split(' ');
+        if (fields.count() < 2 || fields.at(1) != "device") {
+            continue;
+        }
+        Device device(fields.at(0));
+        for (int i = 2; i < fields.count(); ++i) {
+            const QString &field = fields.at(i);
+            const int separator = field.indexOf(':');
+            const QStringRef key = field.leftRef(separator);
+            const QString value = field.mid(separator + 1);
+            if (key == "model") {
+                device.setModelString(value);
+            } else if (key == "device") {
+                device.setDeviceString(value);
+            } else if (key == "product") {
+                device.setProductString(value);
+            }
+        }
+        devices.append(device);
+    }
+    return devices;
+}
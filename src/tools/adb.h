@@ -4,10 +4,12 @@
 #include "base/androidfilesystemitem.h"
 #include "base/command.h"
 #include "base/device.h"
+#include "tools/adbtransfer.h"
 
 namespace Adb
 {
     QString escapePath(QString path);
+    QList<Device> parseDevices(const QString &reply); // Parses the "host:devices-l" reply
 
     // Cd
 
@@ -111,7 +113,7 @@ namespace Adb
     public:
         Ls(const QString &path, const QString &serial = QString(), QObject *parent = nullptr)
             : Command(parent)
-            , path(escapePath(path))
+            , path(path)
             , serial(serial) {}
 
         void run() override;
@@ -129,55 +131,39 @@ namespace Adb
     {
     public:
         Install(const QString &apk, const QString &serial = QString(), QObject *parent = nullptr)
+            : Install(QStringList{apk}, serial, parent) {}
+
+        // Multiple APKs are installed in a single session as a base APK with its splits
+        Install(const QStringList &apks, const QString &serial = QString(), QObject *parent = nullptr)
             : Command(parent)
-            , apk(apk)
+            , apks(apks)
             , serial(serial) {}
 
         void run() override;
         const QString &output() const;
 
     private:
-        const QString apk;
+        const QStringList apks;
         const QString serial;
         QString resultOutput;
     };
 
     // Push
 
-    class Push : public Command
+    class Push : public AdbTransfer
     {
     public:
         Push(const QString &src, const QString &dst, const QString &serial = QString(), QObject *parent = nullptr)
-            : Command(parent)
-            , src(src)
-            , dst(dst)
-            , serial(serial) {}
-
-        void run() override;
-
-    private:
-        const QString src;
-        const QString dst;
-        const QString serial;
+            : AdbTransfer(AdbTransfer::Upload, src, dst, serial, parent) {}
     };
 
     // Pull
 
-    class Pull : public Command
+    class Pull : public AdbTransfer
     {
     public:
         Pull(const QString &src, const QString &dst, const QString &serial = QString(), QObject *parent = nullptr)
-            : Command(parent)
-            , src(src)
-            , dst(dst)
-            , serial(serial) {}
-
-        void run() override;
-
-    private:
-        const QString src;
-        const QString dst;
-        const QString serial;
+            : AdbTransfer(AdbTransfer::Download, src, dst, serial, parent) {}
     };
 
     // Screenshot
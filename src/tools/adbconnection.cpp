@@ -0,0 +1,302 @@
+#include "tools/adbconnection.h"
+#include <QHash>
+#include <QHostAddress>
+#include <QMutex>
+#include <QProcess>
+#include <QTcpSocket>
+#include <QtEndian>
+
+namespace
+{
+    const quint16 DefaultServerPort = 5037;
+    const int ConnectTimeout = 3000;
+    const int ReplyTimeout = 30000;
+    const int ReadTimeout = 300000; // Device services may stay silent for a while, e.g., "pm install"
+    const int StartServerTimeout = 30000;
+
+    enum ShellPacket : char {
+        StdoutPacket = 1,
+        StderrPacket = 2,
+        ExitPacket = 3
+    };
+
+    QMutex adbPathMutex;
+    QString adbPath;
+
+    quint16 getServerPort()
+    {
+        // Same variable as used by the adb client itself
+        bool ok;
+        const int port = qEnvironmentVariableIntValue("ANDROID_ADB_SERVER_PORT", &ok);
+        return (ok && port > 0 && port <= 0xFFFF) ? static_cast<quint16>(port) : DefaultServerPort;
+    }
+
+    bool startServer()
+    {
+        static QMutex mutex;
+        QMutexLocker locker(&mutex);
+        adbPathMutex.lock();
+        const QString path = adbPath;
+        adbPathMutex.unlock();
+        if (path.isEmpty()) {
+            return false;
+        }
+        QProcess process;
+        process.start(path, {"start-server"});
+        return process.waitForFinished(StartServerTimeout)
+            && process.exitStatus() == QProcess::NormalExit
+            && process.exitCode() == 0;
+    }
+}
+
+AdbConnection::AdbConnection() = default;
+
+AdbConnection::~AdbConnection() = default;
+
+bool AdbConnection::connectToHost(const QString &service)
+{
+    if (!open() || !request(service)) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+bool AdbConnection::connectToDevice(const QString &serial, const QString &service)
+{
+    // Switches the connection to the device transport, then opens the service on the device:
+    const QString transport = !serial.isEmpty() ? QString("host:transport:%1").arg(serial) : QString("host:transport-any");
+    if (!open() || !request(transport) || !request(service)) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+bool AdbConnection::isConnected()
+{
+    if (!socket) {
+        return false;
+    }
+    socket->waitForReadyRead(0); // Updates the state if the server has closed the connection
+    return socket->state() == QAbstractSocket::ConnectedState;
+}
+
+bool AdbConnection::waitForReadyRead(int timeout)
+{
+    return socket && (socket->bytesAvailable() > 0 || socket->waitForReadyRead(timeout));
+}
+
+void AdbConnection::disconnect()
+{
+    if (socket) {
+        socket->abort();
+        socket.reset();
+    }
+}
+
+bool AdbConnection::read(char *data, qint64 size)
+{
+    if (!waitForData(size, ReadTimeout)) {
+        return false;
+    }
+    return socket->read(data, size) == size;
+}
+
+QByteArray AdbConnection::read(qint64 size)
+{
+    if (!waitForData(size, ReadTimeout)) {
+        return QByteArray();
+    }
+    return socket->read(size);
+}
+
+QByteArray AdbConnection::readLengthPrefixed()
+{
+    if (!waitForData(4, ReplyTimeout)) {
+        return QByteArray();
+    }
+    bool ok;
+    const int length = socket->read(4).toInt(&ok, 16);
+    if (!ok) {
+        error = tr("Unexpected reply from the ADB server.");
+        return QByteArray();
+    }
+    return read(length);
+}
+
+QByteArray AdbConnection::readToEnd()
+{
+    QByteArray data;
+    while (socket) {
+        data.append(socket->readAll());
+        if (socket->state() != QAbstractSocket::ConnectedState) {
+            data.append(socket->readAll());
+            break;
+        }
+        if (!socket->waitForReadyRead(ReadTimeout)) {
+            data.append(socket->readAll());
+            if (socket->error() == QAbstractSocket::SocketTimeoutError) {
+                error = tr("The ADB server did not respond in time.");
+            }
+            break;
+        }
+    }
+    return data;
+}
+
+bool AdbConnection::write(const QByteArray &data)
+{
+    if (!socket || socket->write(data) != data.size()) {
+        error = socket ? socket->errorString() : tr("Not connected to the ADB server.");
+        return false;
+    }
+    while (socket->bytesToWrite() > 0) {
+        if (!socket->waitForBytesWritten(ReplyTimeout)) {
+            error = socket->errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+const QString &AdbConnection::getError() const
+{
+    return error;
+}
+
+QByteArray AdbConnection::query(const QString &service, QString *error)
+{
+    AdbConnection connection;
+    QByteArray reply;
+    if (connection.connectToHost(service)) {
+        reply = connection.readLengthPrefixed();
+    }
+    if (error) {
+        *error = connection.getError();
+    }
+    return reply;
+}
+
+bool AdbConnection::shell(const QString &serial, const QString &command, QString *output)
+{
+    AdbConnection connection;
+    QByteArray data;
+    bool success = false;
+
+    if (connection.connectToDevice(serial, QString("shell,v2,raw:%1").arg(command))) {
+        // Shell protocol v2 reports the exit code after the [id, length, data] packets of the output:
+        char header[5];
+        while (connection.read(header, sizeof(header))) {
+            const quint32 length = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(header + 1));
+            const QByteArray packet = connection.read(length);
+            if (quint32(packet.size()) != length) {
+                break;
+            }
+            if (header[0] == StdoutPacket || header[0] == StderrPacket) {
+                data.append(packet);
+            } else if (header[0] == ExitPacket) {
+                success = !packet.isEmpty() && packet.at(0) == 0;
+                break;
+            }
+        }
+    } else if (connection.connectToDevice(serial, QString("shell:%1").arg(command))) {
+        // Older devices don't report the exit code, same as with the adb client
+        data = connection.readToEnd();
+        success = connection.getError().isEmpty();
+    } else {
+        data = connection.getError().toUtf8();
+    }
+
+    if (output) {
+        *output = QString::fromUtf8(data).replace("\r\n", "\n").trimmed();
+    }
+    return success;
+}
+
+QStringList AdbConnection::getFeatures(const QString &serial)
+{
+    // Device features don't change while it's connected, so they are only queried once
+    static QMutex mutex;
+    static QHash<QString, QStringList> cache;
+    if (serial.isEmpty()) {
+        return {};
+    }
+    QMutexLocker locker(&mutex);
+    auto it = cache.constFind(serial);
+    if (it == cache.constEnd()) {
+        QString error;
+        const QString reply = QString::fromUtf8(query(QString("host-serial:%1:features").arg(serial), &error));
+        if (!error.isEmpty()) {
+            return {};
+        }
+        it = cache.insert(serial, reply.split(',', QString::SkipEmptyParts));
+    }
+    return it.value();
+}
+
+void AdbConnection::setAdbPath(const QString &path)
+{
+    QMutexLocker locker(&adbPathMutex);
+    adbPath = path;
+}
+
+bool AdbConnection::open()
+{
+    disconnect();
+    error.clear();
+    socket.reset(new QTcpSocket);
+    socket->connectToHost(QHostAddress::LocalHost, getServerPort());
+    if (socket->waitForConnected(ConnectTimeout)) {
+        return true;
+    }
+    if (socket->error() == QAbstractSocket::ConnectionRefusedError && startServer()) {
+        socket->abort();
+        socket->connectToHost(QHostAddress::LocalHost, getServerPort());
+        if (socket->waitForConnected(ConnectTimeout)) {
+            return true;
+        }
+    }
+    //: "%1" will be replaced with an error description.
+    error = tr("Could not connect to the ADB server: %1").arg(socket->errorString());
+    socket.reset();
+    return false;
+}
+
+bool AdbConnection::request(const QString &service)
+{
+    const QByteArray payload = service.toUtf8();
+    if (!write(QByteArray::number(payload.size(), 16).rightJustified(4, '0') + payload)) {
+        return false;
+    }
+    if (!waitForData(4, ReplyTimeout)) {
+        return false;
+    }
+    const QByteArray status = socket->read(4);
+    if (status == "OKAY") {
+        return true;
+    }
+    if (status == "FAIL") {
+        error = QString::fromUtf8(readLengthPrefixed());
+    } else {
+        error = tr("Unexpected reply from the ADB server.");
+    }
+    return false;
+}
+
+bool AdbConnection::waitForData(qint64 size, int timeout)
+{
+    if (!socket) {
+        error = tr("Not connected to the ADB server.");
+        return false;
+    }
+    while (socket->bytesAvailable() < size) {
+        if (!socket->waitForReadyRead(timeout)) {
+            error = socket->error() == QAbstractSocket::SocketTimeoutError
+                ? tr("The ADB server did not respond in time.")
+                : socket->errorString();
+            return false;
+        }
+    }
+    return true;
+}
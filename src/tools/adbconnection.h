@@ -0,0 +1,49 @@
+#ifndef ADBCONNECTION_H
+#define ADBCONNECTION_H
+
+#include <QCoreApplication>
+#include <QScopedPointer>
+#include <QStringList>
+
+class QTcpSocket;
+
+// Connection to the local adb server using its smart socket protocol, used in place of spawning the adb client.
+// All calls are blocking, so connections are meant to be created and used within worker threads.
+
+class AdbConnection
+{
+    Q_DECLARE_TR_FUNCTIONS(AdbConnection)
+
+public:
+    AdbConnection();
+    ~AdbConnection();
+
+    bool connectToHost(const QString &service); // Host service (e.g., "host:version")
+    bool connectToDevice(const QString &serial, const QString &service); // Device service (e.g., "shell:ls", "sync:")
+    bool isConnected();
+    bool waitForReadyRead(int timeout); // Returns false on timeout, e.g., while waiting for device tracking updates
+    void disconnect();
+
+    bool read(char *data, qint64 size);
+    QByteArray read(qint64 size);
+    QByteArray readLengthPrefixed(); // Host service replies are prefixed with a hexadecimal length
+    QByteArray readToEnd();
+    bool write(const QByteArray &data);
+
+    const QString &getError() const;
+
+    static QByteArray query(const QString &service, QString *error = nullptr);
+    static bool shell(const QString &serial, const QString &command, QString *output = nullptr);
+    static QStringList getFeatures(const QString &serial); // E.g., "shell_v2", "cmd", "ls_v2"
+    static void setAdbPath(const QString &path); // Used to start the server when it isn't running
+
+private:
+    bool open();
+    bool request(const QString &service);
+    bool waitForData(qint64 size, int timeout);
+
+    QScopedPointer<QTcpSocket> socket;
+    QString error;
+};
+
+#endif // ADBCONNECTION_H
@@ -0,0 +1,139 @@
+#include "tools/adbdevicetracker.h"
+#include "tools/adb.h"
+#include "tools/adbconnection.h"
+#include <QCoreApplication>
+#include <QDebug>
+
+namespace
+{
+    const int PollInterval = 250;
+    const int ReconnectInterval = 2000;
+
+    bool isSameDevice(const Device &a, const Device &b)
+    {
+        return a.getSerial() == b.getSerial()
+            && a.getProductString() == b.getProductString()
+            && a.getModelString() == b.getModelString()
+            && a.getDeviceString() == b.getDeviceString();
+    }
+}
+
+AdbDeviceTracker::AdbDeviceTracker(QObject *parent) : QThread(parent)
+{
+}
+
+AdbDeviceTracker *AdbDeviceTracker::instance()
+{
+    static AdbDeviceTracker *tracker = nullptr;
+    if (!tracker) {
+        // The adb server is only started by the client if it isn't running yet
+        AdbConnection::setAdbPath(Adb::getPath());
+        tracker = new AdbDeviceTracker(qApp);
+        connect(qApp, &QCoreApplication::aboutToQuit, tracker, &AdbDeviceTracker::stop);
+        tracker->start();
+    }
+    return tracker;
+}
+
+QList<Device> AdbDeviceTracker::getDevices() const
+{
+    QMutexLocker locker(&mutex);
+    return devices;
+}
+
+bool AdbDeviceTracker::hasDevice(const QString &serial) const
+{
+    QMutexLocker locker(&mutex);
+    for (const Device &device : devices) {
+        if (device.getSerial() == serial) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AdbDeviceTracker::isReady() const
+{
+    QMutexLocker locker(&mutex);
+    return ready;
+}
+
+void AdbDeviceTracker::resubscribe()
+{
+    // The list is signaled again even if it hasn't changed
+    QMutexLocker locker(&mutex);
+    resubscribeRequested = true;
+    ready = false;
+}
+
+void AdbDeviceTracker::stop()
+{
+    requestInterruption();
+    wait();
+}
+
+void AdbDeviceTracker::run()
+{
+    bool reportedFailure = false;
+    while (!isInterruptionRequested()) {
+        mutex.lock();
+        if (resubscribeRequested) {
+            resubscribeRequested = false;
+            reportedFailure = false;
+        }
+        mutex.unlock();
+        AdbConnection connection;
+        if (!connection.connectToHost("host:track-devices-l")) {
+            // Reported once per outage, while reconnection attempts continue in the background
+            if (!reportedFailure) {
+                qWarning() << "Could not track devices:" << connection.getError();
+                reportedFailure = true;
+                setDevices({});
+                emit failed(connection.getError());
+            }
+            for (int elapsed = 0; elapsed < ReconnectInterval && !isInterruptionRequested() && !isResubscribeRequested(); elapsed += PollInterval) {
+                msleep(PollInterval);
+            }
+            continue;
+        }
+        reportedFailure = false;
+
+        // The server sends the full device list right away, then again on every change
+        while (!isInterruptionRequested() && !isResubscribeRequested()) {
+            if (!connection.waitForReadyRead(PollInterval)) {
+                if (!connection.isConnected()) {
+                    break;
+                }
+                continue;
+            }
+            const QByteArray reply = connection.readLengthPrefixed();
+            if (reply.isEmpty() && !connection.isConnected()) {
+                break;
+            }
+            setDevices(Adb::parseDevices(QString::fromUtf8(reply)));
+        }
+    }
+}
+
+bool AdbDeviceTracker::isResubscribeRequested() const
+{
+    QMutexLocker locker(&mutex);
+    return resubscribeRequested;
+}
+
+void AdbDeviceTracker::setDevices(const QList<Device> &devices)
+{
+    {
+        QMutexLocker locker(&mutex);
+        bool changed = !ready || this->devices.count() != devices.count();
+        for (int i = 0; !changed && i < devices.count(); ++i) {
+            changed = !isSameDevice(this->devices.at(i), devices.at(i));
+        }
+        ready = true;
+        if (!changed) {
+            return;
+        }
+        this->devices = devices;
+    }
+    emit devicesChanged();
+}
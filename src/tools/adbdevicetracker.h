@@ -0,0 +1,42 @@
+#ifndef ADBDEVICETRACKER_H
+#define ADBDEVICETRACKER_H
+
+#include "base/device.h"
+#include <QMutex>
+#include <QThread>
+
+// Keeps the list of connected devices up to date through a "host:track-devices-l" subscription,
+// which the adb server updates as soon as a device is attached, detached or changes its state.
+
+class AdbDeviceTracker : public QThread
+{
+    Q_OBJECT
+
+public:
+    static AdbDeviceTracker *instance();
+
+    QList<Device> getDevices() const;
+    bool hasDevice(const QString &serial) const;
+    bool isReady() const; // Whether the device list has been received at least once
+    void resubscribe(); // Reconnects right away, e.g., after the ADB server has been restarted
+    void stop();
+
+signals:
+    void devicesChanged();
+    void failed(const QString &error);
+
+protected:
+    void run() override;
+
+private:
+    explicit AdbDeviceTracker(QObject *parent = nullptr);
+    void setDevices(const QList<Device> &devices);
+    bool isResubscribeRequested() const;
+
+    mutable QMutex mutex;
+    QList<Device> devices;
+    bool ready = false;
+    bool resubscribeRequested = false;
+};
+
+#endif // ADBDEVICETRACKER_H
@@ -0,0 +1,315 @@
+#include "tools/adbsync.h"
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QThreadStorage>
+#include <QtEndian>
+#include <cstring>
+
+namespace
+{
+    const quint32 MaxDataSize = 64 * 1024;
+    const quint32 TypeMask = 0170000;
+    const quint32 DirectoryType = 0040000;
+    const quint32 FileType = 0100000;
+    const quint32 SymLinkType = 0120000;
+    const int StatSize = 16; // [id, mode, size, time]
+    const int EntrySize = 20; // [id, mode, size, time, name length]
+    const int ExtendedStatSize = 72; // [id, error, dev, ino, mode, nlink, uid, gid, size, atime, mtime, ctime]
+    const int ExtendedEntrySize = 76; // Same as above, followed by the name length
+
+    // Idle sessions of the current thread, by device serial
+    QThreadStorage<QHash<QString, QSharedPointer<AdbConnection>>> idleSessions;
+
+    bool supportsExtendedProtocol(const QString &serial)
+    {
+        const QStringList features = AdbConnection::getFeatures(serial);
+        return features.contains("ls_v2") && features.contains("stat_v2");
+    }
+
+    template<typename T> T readValue(const char *data)
+    {
+        return qFromLittleEndian<T>(reinterpret_cast<const uchar *>(data));
+    }
+
+    template<typename T> void appendValue(QByteArray &buffer, T value)
+    {
+        const T littleEndian = qToLittleEndian(value);
+        buffer.append(reinterpret_cast<const char *>(&littleEndian), sizeof(T));
+    }
+}
+
+bool AdbSync::Stat::isDirectory() const
+{
+    return (mode & TypeMask) == DirectoryType;
+}
+
+bool AdbSync::Stat::isFile() const
+{
+    return (mode & TypeMask) == FileType;
+}
+
+bool AdbSync::Stat::isSymLink() const
+{
+    return (mode & TypeMask) == SymLinkType;
+}
+
+AdbSync::AdbSync(const QString &serial) : serial(serial), extended(supportsExtendedProtocol(serial))
+{
+    connection = idleSessions.localData().take(serial);
+    if (!connection || !connection->isConnected()) {
+        connection.reset(new AdbConnection);
+        if (!connection->connectToDevice(serial, "sync:")) {
+            error = connection->getError();
+            connection.reset();
+        }
+    }
+}
+
+AdbSync::~AdbSync()
+{
+    // Broken sessions have already been dropped in fail()
+    if (connection) {
+        idleSessions.localData().insert(serial, connection);
+    }
+}
+
+bool AdbSync::isValid() const
+{
+    return !connection.isNull();
+}
+
+const QString &AdbSync::getError() const
+{
+    return error;
+}
+
+bool AdbSync::stat(const QString &path, Stat &result, bool followLinks)
+{
+    result = Stat();
+    if (extended) {
+        // STA2 follows symbolic links, LST2 doesn't
+        if (!sendRequest(followLinks ? "STA2" : "LST2", path.toUtf8())) {
+            return false;
+        }
+        return readStat(connection->read(ExtendedStatSize), result);
+    }
+
+    if (!sendRequest("STAT", path.toUtf8()) || !readStat(connection->read(StatSize), result)) {
+        return false;
+    }
+    if (followLinks && result.isSymLink()) {
+        // The legacy protocol can't follow links, but only directories can be listed along with "."
+        QVector<Entry> entries;
+        bool isDirectory = false;
+        if (!sendRequest("LIST", path.toUtf8()) || !readEntries(entries, isDirectory)) {
+            return false;
+        }
+        result.mode = (isDirectory ? DirectoryType : FileType) | (result.mode & ~TypeMask);
+    }
+    return true;
+}
+
+bool AdbSync::list(const QString &path, QVector<Entry> &result)
+{
+    bool hasSelf;
+    if (!sendRequest(extended ? "LIS2" : "LIST", path.toUtf8())) {
+        return false;
+    }
+    return readEntries(result, hasSelf);
+}
+
+bool AdbSync::send(const QString &localPath, const QString &remotePath, const std::function<bool(qint64)> &progress)
+{
+    QFile file(localPath);
+    if (!file.open(QFile::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    const bool executable = file.permissions() & QFile::ExeOwner;
+    const quint32 mode = FileType | (executable ? 0755 : 0644);
+    if (!sendRequest("SEND", QString("%1,%2").arg(remotePath).arg(mode).toUtf8())) {
+        return false;
+    }
+
+    while (!file.atEnd()) {
+        const QByteArray data = file.read(MaxDataSize);
+        if (data.isEmpty() && file.error() != QFile::NoError) {
+            // The transfer can't be cancelled, so the session is abandoned
+            fail(file.errorString());
+            return false;
+        }
+        if (!sendRequest("DATA", data)) {
+            return false;
+        }
+        if (progress && !progress(data.size())) {
+            // The session can't be interrupted in the middle of a file, so it is abandoned
+            fail(tr("The transfer has been canceled."));
+            return false;
+        }
+    }
+
+    QByteArray done("DONE");
+    appendValue<quint32>(done, static_cast<quint32>(QFileInfo(file).lastModified().toMSecsSinceEpoch() / 1000));
+    char id[4];
+    quint32 length;
+    if (!connection->write(done) || !readReply(id, length)) {
+        fail(connection->getError());
+        return false;
+    }
+    if (qstrncmp(id, "OKAY", 4) != 0) {
+        fail(qstrncmp(id, "FAIL", 4) == 0 ? QString::fromUtf8(connection->read(length)) : tr("Unexpected reply from the device."));
+        return false;
+    }
+    return true;
+}
+
+bool AdbSync::receive(const QString &remotePath, const QString &localPath, const std::function<bool(qint64)> &progress)
+{
+    QSaveFile file(localPath);
+    if (!file.open(QFile::WriteOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    if (!sendRequest("RECV", remotePath.toUtf8())) {
+        return false;
+    }
+
+    forever {
+        char id[4];
+        quint32 length;
+        if (!readReply(id, length)) {
+            fail(connection->getError());
+            return false;
+        }
+        if (qstrncmp(id, "DONE", 4) == 0) {
+            return file.commit();
+        }
+        if (qstrncmp(id, "DATA", 4) != 0 || length > MaxDataSize) {
+            fail(qstrncmp(id, "FAIL", 4) == 0 ? QString::fromUtf8(connection->read(length)) : tr("Unexpected reply from the device."));
+            return false;
+        }
+        const QByteArray data = connection->read(length);
+        if (quint32(data.size()) != length) {
+            fail(connection->getError());
+            return false;
+        }
+        if (file.write(data) != data.size()) {
+            // The remaining data can't be skipped, so the session is dropped
+            fail(file.errorString());
+            return false;
+        }
+        if (progress && !progress(data.size())) {
+            // The session can't be interrupted in the middle of a file, so it is abandoned
+            fail(tr("The transfer has been canceled."));
+            return false;
+        }
+    }
+}
+
+bool AdbSync::readStat(const QByteArray &reply, Stat &result)
+{
+    if (extended) {
+        if (reply.size() != ExtendedStatSize || !(reply.startsWith("STA2") || reply.startsWith("LST2"))) {
+            fail(tr("Unexpected reply from the device."));
+            return false;
+        }
+        if (readValue<quint32>(reply.constData() + 4) == 0) {
+            // Otherwise, the file doesn't exist or can't be accessed
+            result.mode = readValue<quint32>(reply.constData() + 24);
+            result.size = readValue<quint64>(reply.constData() + 40);
+            result.modified = readValue<qint64>(reply.constData() + 56);
+        }
+        return true;
+    }
+    if (reply.size() != StatSize || !reply.startsWith("STAT")) {
+        fail(tr("Unexpected reply from the device."));
+        return false;
+    }
+    result.mode = readValue<quint32>(reply.constData() + 4);
+    result.size = readValue<quint32>(reply.constData() + 8);
+    result.modified = readValue<quint32>(reply.constData() + 12);
+    return true;
+}
+
+bool AdbSync::readEntries(QVector<Entry> &result, bool &hasSelf)
+{
+    result.clear();
+    hasSelf = false;
+    const int headerSize = extended ? ExtendedEntrySize : EntrySize;
+    forever {
+        // Each entry is a stat structure followed by the name, the list ends with "DONE":
+        const QByteArray header = connection->read(headerSize);
+        if (header.size() != headerSize) {
+            fail(connection->getError());
+            return false;
+        }
+        if (header.startsWith("DONE")) {
+            return true;
+        }
+        if (!header.startsWith(extended ? "DNT2" : "DENT")) {
+            fail(tr("Unexpected reply from the device."));
+            return false;
+        }
+        const quint32 nameLength = readValue<quint32>(header.constData() + headerSize - 4);
+        const QByteArray name = connection->read(nameLength);
+        if (quint32(name.size()) != nameLength) {
+            fail(connection->getError());
+            return false;
+        }
+        if (name == "." || name == "..") {
+            hasSelf = true;
+            continue;
+        }
+        Entry entry;
+        entry.name = QString::fromUtf8(name);
+        if (extended) {
+            if (readValue<quint32>(header.constData() + 4) != 0) {
+                continue; // Could not be accessed
+            }
+            entry.stat.mode = readValue<quint32>(header.constData() + 24);
+            entry.stat.size = readValue<quint64>(header.constData() + 40);
+            entry.stat.modified = readValue<qint64>(header.constData() + 56);
+        } else {
+            entry.stat.mode = readValue<quint32>(header.constData() + 4);
+            entry.stat.size = readValue<quint32>(header.constData() + 8);
+            entry.stat.modified = readValue<quint32>(header.constData() + 12);
+        }
+        result.append(entry);
+    }
+}
+
+bool AdbSync::sendRequest(const char *id, const QByteArray &data)
+{
+    if (!connection) {
+        return false;
+    }
+    QByteArray request(id, 4);
+    appendValue<quint32>(request, static_cast<quint32>(data.size()));
+    request.append(data);
+    if (!connection->write(request)) {
+        fail(connection->getError());
+        return false;
+    }
+    return true;
+}
+
+bool AdbSync::readReply(char *id, quint32 &length)
+{
+    char header[8];
+    if (!connection->read(header, sizeof(header))) {
+        return false;
+    }
+    std::memcpy(id, header, 4);
+    length = readValue<quint32>(header + 4);
+    return true;
+}
+
+void AdbSync::fail(const QString &message)
+{
+    // The device closes the session on failure, and protocol errors leave it in an unknown state
+    error = message;
+    connection.reset();
+}
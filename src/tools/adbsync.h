@@ -0,0 +1,61 @@
+#ifndef ADBSYNC_H
+#define ADBSYNC_H
+
+#include "tools/adbconnection.h"
+#include <QSharedPointer>
+#include <QVector>
+#include <functional>
+
+// File listing and transfer session using the adb sync protocol ("sync:" service).
+// Sessions are kept open after use and reused by the same thread for the same device.
+// The extended protocol (LIS2/STA2) is used when the device supports it, e.g., for 64-bit file sizes.
+
+class AdbSync
+{
+    Q_DECLARE_TR_FUNCTIONS(AdbSync)
+
+public:
+    struct Stat
+    {
+        quint32 mode = 0;
+        quint64 size = 0;
+        qint64 modified = 0; // Seconds since epoch
+
+        bool exists() const { return mode != 0; }
+        bool isDirectory() const;
+        bool isFile() const;
+        bool isSymLink() const;
+    };
+
+    struct Entry
+    {
+        QString name;
+        Stat stat;
+    };
+
+    explicit AdbSync(const QString &serial = QString());
+    ~AdbSync();
+
+    bool isValid() const;
+    const QString &getError() const;
+
+    bool stat(const QString &path, Stat &result, bool followLinks = false);
+    bool list(const QString &path, QVector<Entry> &result);
+    // The progress callback is called with the size of each transferred chunk, and cancels the transfer by returning false
+    bool send(const QString &localPath, const QString &remotePath, const std::function<bool(qint64)> &progress = nullptr);
+    bool receive(const QString &remotePath, const QString &localPath, const std::function<bool(qint64)> &progress = nullptr);
+
+private:
+    bool readStat(const QByteArray &reply, Stat &result);
+    bool readEntries(QVector<Entry> &result, bool &hasSelf);
+    bool sendRequest(const char *id, const QByteArray &data);
+    bool readReply(char *id, quint32 &length);
+    void fail(const QString &message);
+
+    QString serial;
+    bool extended = false;
+    QSharedPointer<AdbConnection> connection;
+    QString error;
+};
+
+#endif // ADBSYNC_H
@@ -0,0 +1,319 @@
+#include "tools/adbtransfer.h"
+#include "tools/adb.h"
+#include "tools/adbconnection.h"
+#include "tools/adbsync.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFutureWatcher>
+#include <QDebug>
+
+namespace
+{
+    const int ProgressInterval = 250;
+
+    QString joinPath(const QString &directory, const QString &name)
+    {
+        return directory.endsWith('/') ? directory + name : QString("%1/%2").arg(directory, name);
+    }
+
+    bool isSameFile(const QFileInfo &local, quint64 size, qint64 modified)
+    {
+        return local.exists()
+            && static_cast<quint64>(local.size()) == size
+            && local.lastModified().toMSecsSinceEpoch() / 1000 == modified;
+    }
+}
+
+AdbTransfer::AdbTransfer(Direction direction, const QString &src, const QString &dst, const QString &serial, QObject *parent)
+    : Command(parent)
+    , direction(direction)
+    , src(src)
+    , dst(dst)
+    , serial(serial)
+{
+    progressTimer.setInterval(ProgressInterval);
+    connect(&progressTimer, &QTimer::timeout, this, &AdbTransfer::reportProgress);
+}
+
+AdbTransfer::~AdbTransfer()
+{
+    // Pending workers stop after their current chunk instead of finishing the whole transfer
+    canceled.store(1);
+    threadPool.waitForDone();
+}
+
+void AdbTransfer::run()
+{
+    emit started();
+    // The adb server is only started by the client if it isn't running yet
+    AdbConnection::setAdbPath(Adb::getPath());
+    auto watcher = new QFutureWatcher<Plan>(this);
+    connect(watcher, &QFutureWatcher<Plan>::finished, this, [=]() {
+        const Plan plan = watcher->result();
+        watcher->deleteLater();
+        if (!plan.success) {
+            error = plan.error;
+            qWarning() << "Could not prepare the transfer of" << src << error;
+            emit finished(false);
+            return;
+        }
+        jobs = plan.jobs;
+        totalBytes = plan.totalBytes;
+        skippedCount = plan.skippedCount;
+        transferJobs();
+    });
+    const Direction direction = this->direction;
+    const QString src = this->src;
+    const QString dst = this->dst;
+    const QString serial = this->serial;
+    watcher->setFuture(QtConcurrent::run(&threadPool, [=]() {
+        return direction == Upload ? planUpload(serial, src, dst, canceled) : planDownload(serial, src, dst, canceled);
+    }));
+}
+
+void AdbTransfer::setStreamCount(int count)
+{
+    streamCount = qMax(1, count);
+}
+
+qint64 AdbTransfer::getTotalBytes() const
+{
+    return totalBytes;
+}
+
+qint64 AdbTransfer::getTransferredBytes() const
+{
+    return transferredBytes.load();
+}
+
+int AdbTransfer::getFileCount() const
+{
+    return jobs.count();
+}
+
+int AdbTransfer::getSkippedCount() const
+{
+    return skippedCount;
+}
+
+const QString &AdbTransfer::getError() const
+{
+    return error;
+}
+
+AdbTransfer::Plan AdbTransfer::planUpload(const QString &serial, const QString &src, const QString &dst, const QAtomicInt &canceled)
+{
+    Plan plan;
+    QScopedPointer<AdbSync> sync(new AdbSync(serial));
+    AdbSync::Stat stat;
+    if (!sync->stat(dst, stat, true)) {
+        plan.error = sync->getError();
+        return plan;
+    }
+    const QFileInfo source(src);
+    const QString target = stat.isDirectory() ? joinPath(dst, source.fileName()) : dst;
+
+    // Remote directories are listed once to compare all of their files at once
+    QHash<QString, QHash<QString, AdbSync::Stat>> remoteDirectories;
+    auto addJob = [&](const QFileInfo &file, const QString &remotePath) {
+        const QString remoteDirectory = QFileInfo(remotePath).path();
+        if (!remoteDirectories.contains(remoteDirectory)) {
+            QHash<QString, AdbSync::Stat> &remoteFiles = remoteDirectories[remoteDirectory];
+            QVector<AdbSync::Entry> entries;
+            if (sync->list(remoteDirectory, entries)) {
+                for (const AdbSync::Entry &entry : entries) {
+                    remoteFiles.insert(entry.name, entry.stat);
+                }
+            } else {
+                // The file is transferred anyway, but the broken session can't be used anymore
+                sync.reset(new AdbSync(serial));
+            }
+        }
+        const AdbSync::Stat remote = remoteDirectories.value(remoteDirectory).value(file.fileName());
+        if (remote.isFile() && isSameFile(file, remote.size, remote.modified)) {
+            ++plan.skippedCount;
+            return;
+        }
+        Job job;
+        job.src = file.filePath();
+        job.dst = remotePath;
+        plan.jobs.append(job);
+        plan.totalBytes += file.size();
+    };
+
+    if (source.isDir()) {
+        // Parent directories are created by the device as the files are sent
+        const QDir directory(src);
+        QDirIterator it(src, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            if (canceled.load()) {
+                plan.error = tr("The transfer has been canceled.");
+                return plan;
+            }
+            it.next();
+            addJob(it.fileInfo(), joinPath(target, directory.relativeFilePath(it.filePath())));
+        }
+    } else if (source.exists()) {
+        addJob(source, target);
+    } else {
+        plan.error = tr("File not found.");
+        return plan;
+    }
+    plan.success = true;
+    return plan;
+}
+
+AdbTransfer::Plan AdbTransfer::planDownload(const QString &serial, const QString &src, const QString &dst, const QAtomicInt &canceled)
+{
+    Plan plan;
+    AdbSync sync(serial);
+    AdbSync::Stat stat;
+    if (!sync.stat(src, stat, true)) {
+        plan.error = sync.getError();
+        return plan;
+    }
+    if (!stat.exists()) {
+        plan.error = tr("File not found.");
+        return plan;
+    }
+    const QString target = QFileInfo(dst).isDir() ? joinPath(dst, QFileInfo(src).fileName()) : dst;
+
+    auto addJob = [&](const QString &remotePath, const QString &localPath, const AdbSync::Stat &stat) {
+        if (isSameFile(QFileInfo(localPath), stat.size, stat.modified)) {
+            ++plan.skippedCount;
+            return;
+        }
+        Job job;
+        job.src = remotePath;
+        job.dst = localPath;
+        job.modified = stat.modified;
+        plan.jobs.append(job);
+        plan.totalBytes += stat.size;
+    };
+
+    if (!stat.isDirectory()) {
+        addJob(src, target, stat);
+        plan.success = true;
+        return plan;
+    }
+
+    // Directories are walked breadth-first, with a single listing request per directory
+    QList<QPair<QString, QString>> directories{{src, target}};
+    while (!directories.isEmpty()) {
+        if (canceled.load()) {
+            plan.error = tr("The transfer has been canceled.");
+            return plan;
+        }
+        const auto directory = directories.takeFirst();
+        if (!QDir().mkpath(directory.second)) {
+            plan.error = tr("Could not create the directory: %1").arg(QDir::toNativeSeparators(directory.second));
+            return plan;
+        }
+        QVector<AdbSync::Entry> entries;
+        if (!sync.list(directory.first, entries)) {
+            plan.error = sync.getError();
+            return plan;
+        }
+        for (const AdbSync::Entry &entry : entries) {
+            const QString remotePath = joinPath(directory.first, entry.name);
+            const QString localPath = joinPath(directory.second, entry.name);
+            AdbSync::Stat entryStat = entry.stat;
+            if (entryStat.isSymLink() && !sync.stat(remotePath, entryStat, true)) {
+                plan.error = sync.getError();
+                return plan;
+            }
+            if (entryStat.isDirectory()) {
+                directories.append({remotePath, localPath});
+            } else if (entryStat.isFile()) {
+                addJob(remotePath, localPath, entryStat);
+            }
+        }
+    }
+    plan.success = true;
+    return plan;
+}
+
+void AdbTransfer::transferJobs()
+{
+    if (jobs.isEmpty()) {
+        emit progress(0, 0, 0);
+        emit finished(true);
+        return;
+    }
+
+    speedTimer.start();
+    progressTimer.start();
+    reportProgress();
+
+    // Each stream takes the next pending job until none are left
+    runningStreams = qMin(streamCount, jobs.count());
+    threadPool.setMaxThreadCount(runningStreams);
+    for (int i = 0; i < runningStreams; ++i) {
+        auto watcher = new QFutureWatcher<void>(this);
+        connect(watcher, &QFutureWatcher<void>::finished, this, [=]() {
+            watcher->deleteLater();
+            if (--runningStreams > 0) {
+                return;
+            }
+            progressTimer.stop();
+            reportProgress();
+            if (!errors.isEmpty()) {
+                error = errors.join('\n');
+                qWarning() << "Could not transfer" << errors.count() << "file(s):" << error;
+            }
+            emit finished(errors.isEmpty());
+        });
+        watcher->setFuture(QtConcurrent::run(&threadPool, [this]() {
+            QScopedPointer<AdbSync> sync(new AdbSync(serial));
+            auto onProgress = [this](qint64 bytes) {
+                transferredBytes.fetchAndAddRelaxed(bytes);
+                return !canceled.load();
+            };
+            forever {
+                if (canceled.load()) {
+                    break;
+                }
+                const int index = nextJob.fetchAndAddRelaxed(1);
+                if (index >= jobs.count()) {
+                    break;
+                }
+                const Job &job = jobs.at(index);
+                bool success;
+                if (direction == Upload) {
+                    success = sync->send(job.src, job.dst, onProgress);
+                } else {
+                    success = sync->receive(job.src, job.dst, onProgress);
+                    if (success) {
+                        // Makes the file match the device copy on the next transfer
+                        QFile file(job.dst);
+                        if (file.open(QFile::ReadWrite)) {
+                            file.setFileTime(QDateTime::fromMSecsSinceEpoch(job.modified * 1000), QFileDevice::FileModificationTime);
+                        }
+                    }
+                }
+                if (!success) {
+                    QMutexLocker locker(&errorsMutex);
+                    errors.append(QString("%1: %2").arg(job.src, sync->getError()));
+                    if (!sync->isValid()) {
+                        sync.reset(new AdbSync(serial));
+                    }
+                }
+            }
+        }));
+    }
+}
+
+void AdbTransfer::reportProgress()
+{
+    // Throughput is smoothed to avoid jumps between reports
+    const qint64 transferred = transferredBytes.load();
+    const qint64 elapsed = speedTimer.restart();
+    if (elapsed > 0) {
+        const qint64 currentSpeed = (transferred - lastTransferredBytes) * 1000 / elapsed;
+        bytesPerSecond = bytesPerSecond ? (bytesPerSecond * 3 + currentSpeed) / 4 : currentSpeed;
+    }
+    lastTransferredBytes = transferred;
+    emit progress(transferred, totalBytes, bytesPerSecond);
+}
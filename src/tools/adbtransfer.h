@@ -0,0 +1,88 @@
+#ifndef ADBTRANSFER_H
+#define ADBTRANSFER_H
+
+#include "base/command.h"
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+// Copies a file or a directory tree between the computer and a device, one job per file,
+// using several concurrent sync sessions. Files which already exist at the destination with
+// the same size and date are skipped, so an interrupted transfer is resumed by running it again.
+
+class AdbTransfer : public Command
+{
+    Q_OBJECT
+
+public:
+    enum Direction {
+        Upload,
+        Download
+    };
+
+    AdbTransfer(Direction direction, const QString &src, const QString &dst, const QString &serial = QString(), QObject *parent = nullptr);
+    ~AdbTransfer() override;
+
+    void run() override;
+    void setStreamCount(int count);
+
+    qint64 getTotalBytes() const;
+    qint64 getTransferredBytes() const;
+    int getFileCount() const;
+    int getSkippedCount() const;
+    const QString &getError() const;
+
+signals:
+    void progress(qint64 transferred, qint64 total, qint64 bytesPerSecond);
+
+private:
+    struct Job
+    {
+        QString src;
+        QString dst;
+        qint64 modified = 0; // Seconds since epoch
+    };
+
+    struct Plan
+    {
+        bool success = false;
+        QString error;
+        QVector<Job> jobs;
+        qint64 totalBytes = 0;
+        int skippedCount = 0;
+    };
+
+    static Plan planUpload(const QString &serial, const QString &src, const QString &dst, const QAtomicInt &canceled);
+    static Plan planDownload(const QString &serial, const QString &src, const QString &dst, const QAtomicInt &canceled);
+
+    void transferJobs();
+    void reportProgress();
+
+    const Direction direction;
+    const QString src;
+    const QString dst;
+    const QString serial;
+    int streamCount = 4;
+
+    QVector<Job> jobs;
+    qint64 totalBytes = 0;
+    int skippedCount = 0;
+    QAtomicInt nextJob;
+    QAtomicInt canceled; // Checked by the workers between files and chunks
+    QAtomicInteger<qint64> transferredBytes;
+    int runningStreams = 0;
+    QStringList errors;
+    QMutex errorsMutex;
+    QString error;
+
+    QThreadPool threadPool;
+    QTimer progressTimer;
+    QElapsedTimer speedTimer;
+    qint64 lastTransferredBytes = 0;
+    qint64 bytesPerSecond = 0;
+};
+
+#endif // ADBTRANSFER_H
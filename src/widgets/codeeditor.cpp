@@ -1,19 +1,31 @@
 #include "widgets/codeeditor.h"
+#include "widgets/codehighlighter.h"
 #include "widgets/codesidebar.h"
 #include "base/application.h"
 #include "base/utils.h"
 #include <KSyntaxHighlighting/Definition>
-#include <KSyntaxHighlighting/SyntaxHighlighter>
+#include <KSyntaxHighlighting/Repository>
 #include <QRegularExpression>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrent>
+
+namespace
+{
+    // Number of blocks highlighted above and below the visible area ahead of the background highlighting
+    const int HighlightMargin = 100;
+}
 
 CodeEditor::CodeEditor(QWidget *parent)
     : QPlainTextEdit(parent)
     , sidebar(new CodeSideBar(this))
-    , highlighter(new KSyntaxHighlighting::SyntaxHighlighter(document()))
+    , highlighter(new CodeHighlighter(document()))
+    , viewportTimer(new QTimer(this))
+    , searchGeneration(new QAtomicInt(0))
+    , searchTimer(new QTimer(this))
 {
     setLineWrapMode(CodeEditor::NoWrap);
 
-    const auto defaultTheme = app->highlightingRepository.defaultTheme(Utils::isDarkTheme()
+    const auto defaultTheme = app->getHighlightingRepository()->defaultTheme(Utils::isDarkTheme()
         ? KSyntaxHighlighting::Repository::DarkTheme
         : KSyntaxHighlighting::Repository::LightTheme);
     setTheme(defaultTheme);
@@ -31,8 +43,74 @@ CodeEditor::CodeEditor(QWidget *parent)
     setFont(font);
     sidebar->setFont(font);
 
+    // The visible area is updated once it is scrolled or repainted, outside of the paint cycle
+    viewportTimer->setSingleShot(true);
+    viewportTimer->setInterval(0);
+    connect(viewportTimer, &QTimer::timeout, this, &CodeEditor::updateViewport);
+    connect(this, &CodeEditor::updateRequest, this, [this]() {
+        if (!viewportTimer->isActive()) {
+            viewportTimer->start();
+        }
+    });
+
+    // Search results are refreshed in the background once the user stops typing
+    searchTimer->setSingleShot(true);
+    connect(searchTimer, &QTimer::timeout, this, &CodeEditor::highlightSearchResults);
+    connect(&searchWatcher, &QFutureWatcher<SearchResult>::finished, this, [this]() {
+        const SearchResult result = searchWatcher.result();
+        if (result.generation != searchGeneration->load()) {
+            return; // Outdated or cancelled
+        }
+        searchMatches = result.matches;
+        highlightedSearchRange = {-1, -1};
+        highlightVisibleSearchResults();
+        if (searchNavigationPending) {
+            searchNavigationPending = false;
+            nextSearchQuery(false);
+        } else {
+            emit searchFinished(searchMatches.size(), getCurrentSearchResult());
+        }
+    });
+
     connect(this, &CodeEditor::cursorPositionChanged, this, &CodeEditor::highlightCurrentLine);
-    connect(this, &CodeEditor::textChanged, this, &CodeEditor::highlightSearchResults);
+    connect(document(), &QTextDocument::contentsChange, this, &CodeEditor::shiftSearchResults);
+    connect(this, &CodeEditor::textChanged, this, [this]() {
+        if (!searchQuery.isEmpty()) {
+            searchTimer->start(largeFileMode ? 1000 : 200);
+        }
+    });
+}
+
+CodeEditor::~CodeEditor()
+{
+    searchGeneration->ref(); // Cancel the running search
+}
+
+void CodeEditor::setLargeFileMode(bool enabled)
+{
+    if (largeFileMode == enabled) {
+        return;
+    }
+    largeFileMode = enabled;
+    highlighter->setLazy(enabled);
+    highlighter->rehighlight();
+    if (enabled) {
+        // Unfold everything, as folding requires the whole document to be highlighted
+        for (auto block = document()->begin(); block.isValid(); block = block.next()) {
+            if (!block.isVisible()) {
+                block.setVisible(true);
+                block.setLineCount(block.layout()->lineCount());
+            }
+        }
+        document()->markContentsDirty(0, document()->characterCount());
+    }
+    highlightVisibleBlocks();
+    viewport()->update();
+}
+
+bool CodeEditor::isLargeFileMode() const
+{
+    return largeFileMode;
 }
 
 int CodeEditor::getTabWidth() const
@@ -76,7 +154,7 @@ QTextBlock CodeEditor::blockAtPosition(int y) const
 
 bool CodeEditor::isFoldable(const QTextBlock &block) const
 {
-    return highlighter->startsFoldingRegion(block);
+    return !largeFileMode && highlighter->startsFoldingRegion(block);
 }
 
 bool CodeEditor::isFolded(const QTextBlock &block) const
@@ -118,17 +196,8 @@ void CodeEditor::replaceOne(const QString &with)
     if (searchQuery.isEmpty()) {
         return;
     }
-    const QString selectedText = textCursor().selectedText();
-    if (!selectedText.isEmpty()) {
-        if (!searchByRegex) {
-            if (selectedText == searchQuery) {
-                textCursor().insertText(with);
-            }
-        } else {
-            if (QRegularExpression(searchQuery).match(selectedText).captured() == selectedText) {
-                textCursor().insertText(with);
-            }
-        }
+    if (getCurrentSearchResult()) {
+        textCursor().insertText(with);
     }
     nextSearchQuery();
 }
@@ -138,28 +207,42 @@ void CodeEditor::replaceAll(const QString &with)
     if (searchQuery.isEmpty()) {
         return;
     }
-    auto replaceCursor = find();
-    if (replaceCursor.isNull()) {
+    searchTimer->stop();
+    searchGeneration->ref(); // Cancel the running search
+    const QString text = toPlainText();
+    const auto matches = findMatches(text, searchQuery, searchCaseSensitive, searchByRegex, []() { return false; });
+    if (matches.isEmpty()) {
         return;
     }
-    replaceCursor.beginEditBlock();
-    forever {
-        replaceCursor.insertText(with);
-        const auto nextCursor = find(replaceCursor);
-        if (nextCursor.isNull()) {
-            break;
-        }
-        replaceCursor.setPosition(nextCursor.selectionStart());
-        replaceCursor.setPosition(nextCursor.selectionEnd(), QTextCursor::KeepAnchor);
+
+    // Build the replaced text between the first and the last match in a single pass:
+    const int from = matches.first().start;
+    const int to = matches.last().start + matches.last().length;
+    QString replaced;
+    replaced.reserve(to - from);
+    int position = from;
+    for (const SearchMatch &match : matches) {
+        replaced.append(text.midRef(position, match.start - position));
+        replaced.append(with);
+        position = match.start + match.length;
     }
-    replaceCursor.endEditBlock();
+
+    // Search results are not tracked during the edit, as they are all replaced
+    searchMatches.clear();
+    auto cursor = textCursor();
+    cursor.beginEditBlock();
+    cursor.setPosition(from);
+    cursor.setPosition(to, QTextCursor::KeepAnchor);
+    cursor.insertText(replaced);
+    cursor.endEditBlock();
+    highlightSearchResults();
 }
 
 void CodeEditor::setSearchQuery(const QString &query)
 {
     searchQuery = query;
+    searchNavigationPending = true;
     highlightSearchResults();
-    nextSearchQuery(false);
 }
 
 void CodeEditor::setSearchCaseSensitive(bool enabled)
@@ -176,45 +259,36 @@ void CodeEditor::setSearchByRegex(bool enabled)
 
 void CodeEditor::nextSearchQuery(bool skipCurrent)
 {
-    const int totalResults = searchResultCursors.count();
-    if (!totalResults) {
+    if (searchNavigationPending) {
+        return; // Will be done once the search is finished
+    }
+    if (searchMatches.isEmpty()) {
         emit searchFinished(0, 0);
         return;
     }
-
-    QTextCursor resultCursor;
-    if (skipCurrent) {
-        resultCursor = find(textCursor());
-    } else {
-        resultCursor = find(textCursor().selectionStart());
-    }
-    if (resultCursor.isNull()) {
-        // Reached the end of the document, start from the beginning
-        resultCursor = find(0);
-    }
-    setTextCursor(resultCursor);
-
-    const int currentResult = searchResultCursors.indexOf(resultCursor) + 1;
-    emit searchFinished(totalResults, currentResult);
+    const int from = skipCurrent ? textCursor().selectionEnd() : textCursor().selectionStart();
+    const auto it = std::lower_bound(searchMatches.cbegin(), searchMatches.cend(), from, [](const SearchMatch &match, int position) {
+        return match.start < position;
+    });
+    // If the end of the document is reached, start from the beginning
+    selectSearchResult(it != searchMatches.cend() ? it - searchMatches.cbegin() : 0);
 }
 
 void CodeEditor::prevSearchQuery()
 {
-    const int totalResults = searchResultCursors.count();
-    if (!totalResults) {
+    if (searchNavigationPending) {
+        return; // Will be done once the search is finished
+    }
+    if (searchMatches.isEmpty()) {
         emit searchFinished(0, 0);
         return;
     }
-
-    auto resultCursor = find(textCursor(), true);
-    if (resultCursor.isNull()) {
-        // Reached the beginning of the document, start from the end
-        resultCursor = find(document()->characterCount(), true);
-    }
-    setTextCursor(resultCursor);
-
-    const int currentResult = searchResultCursors.indexOf(resultCursor) + 1;
-    emit searchFinished(totalResults, currentResult);
+    const int from = textCursor().selectionStart();
+    const auto it = std::lower_bound(searchMatches.cbegin(), searchMatches.cend(), from, [](const SearchMatch &match, int position) {
+        return match.start < position;
+    });
+    // If the beginning of the document is reached, start from the end
+    selectSearchResult((it != searchMatches.cbegin() ? it - searchMatches.cbegin() : searchMatches.size()) - 1);
 }
 
 void CodeEditor::setTheme(const KSyntaxHighlighting::Theme &theme)
@@ -224,13 +298,13 @@ void CodeEditor::setTheme(const KSyntaxHighlighting::Theme &theme)
     newPalette.setColor(QPalette::Highlight, theme.editorColor(KSyntaxHighlighting::Theme::TextSelection));
     setPalette(newPalette);
     highlighter->setTheme(theme);
-    highlighter->rehighlight();
+    highlightVisibleBlocks();
 }
 
 void CodeEditor::setDefinition(const KSyntaxHighlighting::Definition &definition)
 {
     highlighter->setDefinition(definition);
-    highlighter->rehighlight();
+    highlightVisibleBlocks();
     setTabStopDistance(getTabWidth() * QFontMetrics(font()).horizontalAdvance(' '));
 }
 
@@ -244,6 +318,17 @@ void CodeEditor::setExtraSelectionGroup(ExtraSelectionGroup group, const QList<Q
     setExtraSelections(allSelections);
 }
 
+void CodeEditor::setLineErrors(const QHash<int, QString> &errors)
+{
+    lineErrors = errors;
+    sidebar->update();
+}
+
+QString CodeEditor::getLineError(int line) const
+{
+    return lineErrors.value(line);
+}
+
 void CodeEditor::resizeEvent(QResizeEvent *event)
 {
     QPlainTextEdit::resizeEvent(event);
@@ -295,26 +380,6 @@ void CodeEditor::keyPressEvent(QKeyEvent *event)
     QPlainTextEdit::keyPressEvent(event);
 }
 
-QTextCursor CodeEditor::find(int from, bool backward)
-{
-    QTextDocument::FindFlags options;
-    options.setFlag(QTextDocument::FindCaseSensitively, searchCaseSensitive);
-    options.setFlag(QTextDocument::FindBackward, backward);
-    if (searchByRegex && !searchQuery.isEmpty()) {
-        return document()->find(QRegularExpression(searchQuery), from, options);
-    }
-    return document()->find(searchQuery, from, options);
-}
-
-QTextCursor CodeEditor::find(const QTextCursor &cursor, bool backward)
-{
-    int from = 0;
-    if (!cursor.isNull()) {
-        from = backward ? cursor.selectionStart() : cursor.selectionEnd();
-    }
-    return find(from, backward);
-}
-
 void CodeEditor::highlightCurrentLine()
 {
     QTextEdit::ExtraSelection selection;
@@ -328,19 +393,178 @@ void CodeEditor::highlightCurrentLine()
 
 void CodeEditor::highlightSearchResults()
 {
-    searchResultCursors.clear();
+    searchTimer->stop();
+    const int generation = searchGeneration->fetchAndAddOrdered(1) + 1;
+    if (searchQuery.isEmpty()) {
+        searchMatches.clear();
+        searchNavigationPending = false;
+        highlightedSearchRange = {-1, -1};
+        highlightVisibleSearchResults();
+        emit searchFinished(0, 0);
+        return;
+    }
+
+    // The search runs on a snapshot of the text, which has the same positions as the document
+    const QString text = toPlainText();
+    const QString query = searchQuery;
+    const bool caseSensitive = searchCaseSensitive;
+    const bool byRegex = searchByRegex;
+    const QSharedPointer<QAtomicInt> currentGeneration = searchGeneration;
+    searchWatcher.setFuture(QtConcurrent::run([=]() -> SearchResult {
+        SearchResult result;
+        result.generation = generation;
+        result.matches = findMatches(text, query, caseSensitive, byRegex, [=]() {
+            return currentGeneration->load() != generation;
+        });
+        return result;
+    }));
+}
+
+void CodeEditor::highlightVisibleSearchResults()
+{
+    // Only the visible results are turned into extra selections
+    const auto visibleBlocks = getVisibleBlocks();
+    const QPair<int, int> range = visibleBlocks.first.isValid()
+        ? qMakePair(visibleBlocks.first.position(), visibleBlocks.second.position() + visibleBlocks.second.length())
+        : qMakePair(0, 0);
+    if (range == highlightedSearchRange) {
+        return;
+    }
+    highlightedSearchRange = range;
+
     QList<QTextEdit::ExtraSelection> resultHighlights;
-    auto resultCursor = find();
-    while (!resultCursor.isNull() && resultCursor.hasSelection()) {
-        searchResultCursors << resultCursor;
+    auto it = std::lower_bound(searchMatches.cbegin(), searchMatches.cend(), range.first, [](const SearchMatch &match, int position) {
+        return match.start + match.length <= position;
+    });
+    for (; it != searchMatches.cend() && it->start < range.second; ++it) {
         QTextEdit::ExtraSelection resultHighlight;
         resultHighlight.format.setForeground(QColor(getTextColor(KSyntaxHighlighting::Theme::Normal)));
         resultHighlight.format.setBackground(QColor(getEditorColor(KSyntaxHighlighting::Theme::SearchHighlight)));
-        resultHighlight.cursor = resultCursor;
+        resultHighlight.cursor = QTextCursor(document());
+        resultHighlight.cursor.setPosition(it->start);
+        resultHighlight.cursor.setPosition(it->start + it->length, QTextCursor::KeepAnchor);
         resultHighlights << resultHighlight;
-        resultCursor = find(resultCursor);
     }
     setExtraSelectionGroup(ExtraSelectionGroup::SearchResultSelection, resultHighlights);
-    const int totalResults = searchResultCursors.count();
-    emit searchFinished(totalResults);
+}
+
+void CodeEditor::shiftSearchResults(int position, int removed, int added)
+{
+    if (searchMatches.isEmpty()) {
+        return;
+    }
+    // Results overlapping the changed text are dropped until the search is repeated
+    auto first = std::lower_bound(searchMatches.begin(), searchMatches.end(), position, [](const SearchMatch &match, int position) {
+        return match.start + match.length <= position;
+    });
+    auto output = first;
+    const int delta = added - removed;
+    for (auto it = first; it != searchMatches.end(); ++it) {
+        if (it->start >= position + removed) {
+            *output = {it->start + delta, it->length};
+            ++output;
+        }
+    }
+    searchMatches.erase(output, searchMatches.end());
+    highlightedSearchRange = {-1, -1};
+}
+
+void CodeEditor::selectSearchResult(int index)
+{
+    const SearchMatch &match = searchMatches.at(index);
+    auto cursor = textCursor();
+    cursor.setPosition(match.start);
+    cursor.setPosition(match.start + match.length, QTextCursor::KeepAnchor);
+    setTextCursor(cursor);
+    emit searchFinished(searchMatches.size(), index + 1);
+}
+
+int CodeEditor::getCurrentSearchResult() const
+{
+    const auto cursor = textCursor();
+    const auto it = std::lower_bound(searchMatches.cbegin(), searchMatches.cend(), cursor.selectionStart(), [](const SearchMatch &match, int position) {
+        return match.start < position;
+    });
+    if (it != searchMatches.cend() && it->start == cursor.selectionStart() && it->start + it->length == cursor.selectionEnd()) {
+        return it - searchMatches.cbegin() + 1;
+    }
+    return 0;
+}
+
+QVector<CodeEditor::SearchMatch> CodeEditor::findMatches(const QString &text, const QString &query, bool caseSensitive, bool byRegex,
+                                                         const std::function<bool()> &isCancelled)
+{
+    QVector<SearchMatch> matches;
+    int iteration = 0;
+    if (byRegex) {
+        // Anchors match at line boundaries, like with QTextDocument::find()
+        QRegularExpression::PatternOptions options = QRegularExpression::MultilineOption;
+        if (!caseSensitive) {
+            options |= QRegularExpression::CaseInsensitiveOption;
+        }
+        const QRegularExpression regex(query, options);
+        if (!regex.isValid()) {
+            return matches;
+        }
+        auto iterator = regex.globalMatch(text);
+        while (iterator.hasNext()) {
+            if (++iteration % 1024 == 0 && isCancelled()) {
+                return {};
+            }
+            const auto match = iterator.next();
+            if (match.capturedLength() > 0) {
+                matches.append({match.capturedStart(), match.capturedLength()});
+            }
+        }
+    } else {
+        const auto sensitivity = caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+        int position = text.indexOf(query, 0, sensitivity);
+        while (position != -1) {
+            if (++iteration % 1024 == 0 && isCancelled()) {
+                return {};
+            }
+            matches.append({position, query.size()});
+            position = text.indexOf(query, position + query.size(), sensitivity);
+        }
+    }
+    return matches;
+}
+
+void CodeEditor::highlightVisibleBlocks()
+{
+    auto visibleBlocks = getVisibleBlocks();
+    auto first = visibleBlocks.first;
+    auto last = visibleBlocks.second;
+    if (!first.isValid()) {
+        return;
+    }
+    for (int i = 0; i < HighlightMargin && first.previous().isValid(); ++i) {
+        first = first.previous();
+    }
+    for (int i = 0; i < HighlightMargin && last.next().isValid(); ++i) {
+        last = last.next();
+    }
+    highlighter->highlightBlocks(first, last);
+}
+
+QPair<QTextBlock, QTextBlock> CodeEditor::getVisibleBlocks() const
+{
+    const auto first = firstVisibleBlock();
+    if (!first.isValid()) {
+        return {};
+    }
+    auto last = first;
+    const int viewportHeight = viewport()->height();
+    int top = static_cast<int>(blockBoundingGeometry(first).translated(contentOffset()).top());
+    while (last.next().isValid() && top <= viewportHeight) {
+        top += static_cast<int>(blockBoundingRect(last).height());
+        last = last.next();
+    }
+    return {first, last};
+}
+
+void CodeEditor::updateViewport()
+{
+    highlightVisibleBlocks();
+    highlightVisibleSearchResults();
 }
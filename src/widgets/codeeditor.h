@@ -2,11 +2,15 @@
 #define CODEEDITOR_H
 
 #include <KSyntaxHighlighting/Theme>
+#include <QFutureWatcher>
 #include <QPlainTextEdit>
+#include <QSharedPointer>
+#include <functional>
 
+class CodeHighlighter;
 class CodeSideBar;
+class QTimer;
 namespace KSyntaxHighlighting {
-    class SyntaxHighlighter;
     class Definition;
 }
 
@@ -22,6 +26,11 @@ public:
     };
 
     CodeEditor(QWidget *parent = nullptr);
+    ~CodeEditor() override;
+
+    // Large files are only highlighted around the visible area, without folding
+    void setLargeFileMode(bool enabled);
+    bool isLargeFileMode() const;
 
     int getTabWidth() const;
     QRgb getEditorColor(KSyntaxHighlighting::Theme::EditorColorRole) const;
@@ -45,6 +54,10 @@ public:
     void setDefinition(const KSyntaxHighlighting::Definition &definition);
     void setExtraSelectionGroup(ExtraSelectionGroup group, const QList<QTextEdit::ExtraSelection> &selection);
 
+    // Errors are displayed in the sidebar, keyed by the zero-based line number
+    void setLineErrors(const QHash<int, QString> &errors);
+    QString getLineError(int line) const;
+
 signals:
     void searchFinished(int totalResults, int currentResult = 0);
 
@@ -53,19 +66,47 @@ protected:
     void keyPressEvent(QKeyEvent *event) override;
 
 private:
-    QTextCursor find(int from = 0, bool backward = false);
-    QTextCursor find(const QTextCursor &cursor, bool backward = false);
+    struct SearchMatch
+    {
+        int start;
+        int length;
+    };
 
+    struct SearchResult
+    {
+        QVector<SearchMatch> matches;
+        int generation = 0;
+    };
+
+    static QVector<SearchMatch> findMatches(const QString &text, const QString &query, bool caseSensitive, bool byRegex,
+                                            const std::function<bool()> &isCancelled);
+
+    QPair<QTextBlock, QTextBlock> getVisibleBlocks() const;
+    void updateViewport();
     void highlightCurrentLine();
     void highlightSearchResults();
+    void highlightVisibleSearchResults();
+    void highlightVisibleBlocks();
+    void shiftSearchResults(int position, int removed, int added);
+    void selectSearchResult(int index);
+    int getCurrentSearchResult() const;
 
     CodeSideBar *sidebar;
-    KSyntaxHighlighting::SyntaxHighlighter *highlighter;
+    CodeHighlighter *highlighter;
+    bool largeFileMode = false;
+    QTimer *viewportTimer;
     QMap<ExtraSelectionGroup, QList<QTextEdit::ExtraSelection>> extraSelections;
+    QHash<int, QString> lineErrors;
+
     QString searchQuery;
     bool searchCaseSensitive = false;
     bool searchByRegex = false;
-    QList<QTextCursor> searchResultCursors;
+    QVector<SearchMatch> searchMatches; // Sorted by position
+    QPair<int, int> highlightedSearchRange;
+    bool searchNavigationPending = false;
+    QSharedPointer<QAtomicInt> searchGeneration;
+    QFutureWatcher<SearchResult> searchWatcher;
+    QTimer *searchTimer;
 };
 
 #endif // CODEEDITOR_H
@@ -0,0 +1,377 @@
+#include "widgets/codehighlighter.h"
+#include <KSyntaxHighlighting/Definition>
+#include <KSyntaxHighlighting/Format>
+#include <KSyntaxHighlighting/Theme>
+#include <QElapsedTimer>
+#include <QTextDocument>
+#include <QTimer>
+
+using namespace KSyntaxHighlighting;
+
+namespace
+{
+    // Maximum duration of a single background highlighting slice, in milliseconds
+    const int PassSliceDuration = 10;
+}
+
+bool CodeHighlighter::LineState::operator==(const LineState &other) const
+{
+    return state == other.state && smaliState == other.smaliState;
+}
+
+CodeHighlighter::CodeHighlighter(QTextDocument *document)
+    : QObject(document)
+    , document(document)
+    , passTimer(new QTimer(this))
+{
+    passTimer->setSingleShot(true);
+    passTimer->setInterval(0);
+    connect(passTimer, &QTimer::timeout, this, &CodeHighlighter::continuePass);
+    connect(document, &QTextDocument::contentsChange, this, &CodeHighlighter::contentsChanged);
+    updateSmaliFormats();
+}
+
+void CodeHighlighter::setDefinition(const Definition &definition)
+{
+    if (definition != this->definition()) {
+        AbstractHighlighter::setDefinition(definition);
+        smali = definition.name() == "Smali";
+        rehighlight();
+    }
+}
+
+void CodeHighlighter::setTheme(const Theme &theme)
+{
+    AbstractHighlighter::setTheme(theme);
+    updateSmaliFormats();
+    rehighlight();
+}
+
+void CodeHighlighter::setLazy(bool lazy)
+{
+    this->lazy = lazy;
+    if (lazy) {
+        passBlock = -1;
+        passTimer->stop();
+    }
+}
+
+bool CodeHighlighter::isLazy() const
+{
+    return lazy;
+}
+
+void CodeHighlighter::rehighlight()
+{
+    // Previously highlighted blocks become outdated
+    ++generation;
+    passBlock = -1;
+    if (!lazy) {
+        schedulePass(0, false);
+    }
+}
+
+void CodeHighlighter::highlightBlocks(const QTextBlock &first, const QTextBlock &last)
+{
+    // The preceding blocks might not have been highlighted yet, in which case the initial state is assumed
+    LineState state = getStartState(first);
+    for (auto block = first; block.isValid(); block = block.next()) {
+        if (isHighlighted(block, state)) {
+            state = getBlockData(block)->endState;
+        } else {
+            state = highlightBlock(block, state);
+        }
+        if (block == last) {
+            break;
+        }
+    }
+}
+
+bool CodeHighlighter::startsFoldingRegion(const QTextBlock &block) const
+{
+    return getFoldingRegion(block).begin;
+}
+
+QTextBlock CodeHighlighter::findFoldingRegionEnd(const QTextBlock &startBlock) const
+{
+    const auto region = getFoldingRegion(startBlock);
+    int depth = 1;
+    for (auto block = startBlock.next(); block.isValid(); block = block.next()) {
+        const BlockData *data = getBlockData(block);
+        if (!data) {
+            continue;
+        }
+        for (const FoldingMarker &marker : data->foldingMarkers) {
+            if (marker.id != region.id) {
+                continue;
+            }
+            depth += marker.begin ? 1 : -1;
+            if (depth == 0) {
+                return block;
+            }
+        }
+    }
+    return QTextBlock();
+}
+
+void CodeHighlighter::applyFormat(int offset, int length, const Format &format)
+{
+    if (length == 0) {
+        return;
+    }
+    QTextLayout::FormatRange range;
+    range.start = offset;
+    range.length = length;
+    // Always set the foreground color to avoid palette issues
+    range.format.setForeground(format.textColor(theme()));
+    if (format.hasBackgroundColor(theme())) {
+        range.format.setBackground(format.backgroundColor(theme()));
+    }
+    if (format.isBold(theme())) {
+        range.format.setFontWeight(QFont::Bold);
+    }
+    if (format.isItalic(theme())) {
+        range.format.setFontItalic(true);
+    }
+    if (format.isUnderline(theme())) {
+        range.format.setFontUnderline(true);
+    }
+    if (format.isStrikeThrough(theme())) {
+        range.format.setFontStrikeOut(true);
+    }
+    formats.append(range);
+}
+
+void CodeHighlighter::applyFolding(int offset, int length, FoldingRegion region)
+{
+    Q_UNUSED(offset)
+    Q_UNUSED(length)
+
+    if (region.type() != FoldingRegion::None) {
+        addFoldingMarker({region.id(), region.type() == FoldingRegion::Begin});
+    }
+}
+
+void CodeHighlighter::contentsChanged(int position, int removed, int added)
+{
+    Q_UNUSED(removed)
+
+    // Inserted blocks have no data yet, so only the first and the last changed blocks have to be invalidated:
+    const auto first = document->findBlock(position);
+    const auto last = document->findBlock(position + added);
+    for (const auto &block : {first, last}) {
+        BlockData *data = getBlockData(block);
+        if (data) {
+            data->generation = -1;
+        }
+    }
+    if (lazy) {
+        return; // Changed blocks are highlighted once requested
+    }
+
+    // Highlight the changed blocks, then the following ones until the state is the same as before.
+    // The first slice is done right away, so that the edited text is not displayed unformatted.
+    schedulePass(first.blockNumber(), true);
+    continuePass();
+}
+
+void CodeHighlighter::schedulePass(int fromBlock, bool untilConverged)
+{
+    if (passBlock == -1) {
+        passBlock = fromBlock;
+        passUntilConverged = untilConverged;
+    } else {
+        // A running full pass is not narrowed down to the changed blocks
+        passBlock = qMin(passBlock, fromBlock);
+        passUntilConverged = passUntilConverged && untilConverged;
+    }
+    passTimer->start();
+}
+
+void CodeHighlighter::continuePass()
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+    auto block = document->findBlockByNumber(passBlock);
+    LineState state = getStartState(block);
+    while (block.isValid()) {
+        if (isHighlighted(block, state)) {
+            if (passUntilConverged) {
+                break;
+            }
+            state = getBlockData(block)->endState;
+        } else {
+            state = highlightBlock(block, state);
+        }
+        block = block.next();
+        if (elapsed.hasExpired(PassSliceDuration)) {
+            break;
+        }
+    }
+    if (block.isValid() && !(passUntilConverged && isHighlighted(block, state))) {
+        passBlock = block.blockNumber();
+        passTimer->start();
+    } else {
+        passBlock = -1;
+        passTimer->stop();
+    }
+}
+
+CodeHighlighter::LineState CodeHighlighter::highlightBlock(QTextBlock block, const LineState &state)
+{
+    formats.clear();
+    foldingMarkers.clear();
+    LineState endState;
+    if (smali) {
+        endState.smaliState = highlightSmaliLine(block.text(), state.smaliState);
+    } else {
+        endState.state = highlightLine(block.text(), state.state);
+    }
+    block.layout()->setFormats(formats);
+    document->markContentsDirty(block.position(), block.length());
+
+    BlockData *data = getBlockData(block);
+    if (!data) {
+        data = new BlockData;
+        block.setUserData(data);
+    }
+    data->startState = state;
+    data->endState = endState;
+    data->foldingMarkers = foldingMarkers;
+    data->generation = generation;
+    return endState;
+}
+
+SmaliTokenizer::State CodeHighlighter::highlightSmaliLine(const QString &text, const SmaliTokenizer::State &state)
+{
+    smaliTokens.clear();
+    smaliFolds.clear();
+    const SmaliTokenizer::State endState = SmaliTokenizer::tokenize(text, state, smaliTokens, smaliFolds);
+    for (const SmaliTokenizer::Token &token : smaliTokens) {
+        QTextLayout::FormatRange range;
+        range.start = token.start;
+        range.length = token.length;
+        range.format = smaliFormats.at(token.type);
+        formats.append(range);
+    }
+    for (const SmaliTokenizer::Fold &fold : smaliFolds) {
+        addFoldingMarker({fold.region, fold.begin});
+    }
+    return endState;
+}
+
+void CodeHighlighter::addFoldingMarker(const FoldingMarker &marker)
+{
+    if (!marker.begin) {
+        // Regions opened and closed in the same block are dropped
+        for (int i = foldingMarkers.size() - 1; i >= 0; --i) {
+            if (foldingMarkers.at(i).id == marker.id && foldingMarkers.at(i).begin) {
+                foldingMarkers.remove(i);
+                return;
+            }
+        }
+    }
+    foldingMarkers.append(marker);
+}
+
+void CodeHighlighter::updateSmaliFormats()
+{
+    // Token formats are prepared once per theme, as there are only a few token types
+    smaliFormats.resize(SmaliTokenizer::TokenTypeCount);
+    for (int type = 0; type < SmaliTokenizer::TokenTypeCount; ++type) {
+        const auto style = getTextStyle(static_cast<SmaliTokenizer::TokenType>(type));
+        QTextCharFormat format;
+        format.setForeground(QColor(theme().textColor(style)));
+        if (theme().backgroundColor(style)) {
+            format.setBackground(QColor(theme().backgroundColor(style)));
+        }
+        if (theme().isBold(style)) {
+            format.setFontWeight(QFont::Bold);
+        }
+        if (theme().isItalic(style)) {
+            format.setFontItalic(true);
+        }
+        if (theme().isUnderline(style)) {
+            format.setFontUnderline(true);
+        }
+        if (theme().isStrikeThrough(style)) {
+            format.setFontStrikeOut(true);
+        }
+        smaliFormats[type] = format;
+    }
+}
+
+CodeHighlighter::LineState CodeHighlighter::getStartState(const QTextBlock &block) const
+{
+    const BlockData *data = getBlockData(block.previous());
+    if (data && data->generation == generation) {
+        return data->endState;
+    }
+    return LineState();
+}
+
+CodeHighlighter::BlockData *CodeHighlighter::getBlockData(const QTextBlock &block) const
+{
+    return block.isValid() ? dynamic_cast<BlockData *>(block.userData()) : nullptr;
+}
+
+bool CodeHighlighter::isHighlighted(const QTextBlock &block, const LineState &state) const
+{
+    const BlockData *data = getBlockData(block);
+    return data && data->generation == generation && data->startState == state;
+}
+
+CodeHighlighter::FoldingMarker CodeHighlighter::getFoldingRegion(const QTextBlock &block)
+{
+    const auto data = block.isValid() ? dynamic_cast<const BlockData *>(block.userData()) : nullptr;
+    if (data) {
+        for (int i = data->foldingMarkers.size() - 1; i >= 0; --i) {
+            if (data->foldingMarkers.at(i).begin) {
+                return data->foldingMarkers.at(i);
+            }
+        }
+    }
+    return {0, false};
+}
+
+Theme::TextStyle CodeHighlighter::getTextStyle(SmaliTokenizer::TokenType type)
+{
+    switch (type) {
+    case SmaliTokenizer::Comment:
+        return Theme::Comment;
+    case SmaliTokenizer::Directive:
+        return Theme::Attribute;
+    case SmaliTokenizer::Keyword:
+    case SmaliTokenizer::Opcode:
+        return Theme::Keyword;
+    case SmaliTokenizer::Register:
+    case SmaliTokenizer::Field:
+        return Theme::Variable;
+    case SmaliTokenizer::Label:
+        return Theme::Others;
+    case SmaliTokenizer::Type:
+        return Theme::DataType;
+    case SmaliTokenizer::BuiltinType:
+        return Theme::BuiltIn;
+    case SmaliTokenizer::Method:
+        return Theme::Function;
+    case SmaliTokenizer::Decimal:
+        return Theme::DecVal;
+    case SmaliTokenizer::Hex:
+    case SmaliTokenizer::Boolean:
+        return Theme::BaseN;
+    case SmaliTokenizer::Float:
+        return Theme::Float;
+    case SmaliTokenizer::Char:
+        return Theme::Char;
+    case SmaliTokenizer::String:
+        return Theme::String;
+    case SmaliTokenizer::StringEscape:
+        return Theme::SpecialChar;
+    case SmaliTokenizer::Operator:
+        return Theme::Operator;
+    case SmaliTokenizer::TokenTypeCount:
+        break;
+    }
+    return Theme::Normal;
+}
@@ -0,0 +1,93 @@
+#ifndef CODEHIGHLIGHTER_H
+#define CODEHIGHLIGHTER_H
+
+#include "apk/smalitokenizer.h"
+#include <KSyntaxHighlighting/AbstractHighlighter>
+#include <KSyntaxHighlighting/FoldingRegion>
+#include <KSyntaxHighlighting/State>
+#include <KSyntaxHighlighting/Theme>
+#include <QTextBlock>
+#include <QTextLayout>
+
+class QTimer;
+
+// Syntax highlighter which applies the formats directly to the block layouts instead of relying on
+// QSyntaxHighlighter, so that the blocks can be highlighted in any order. Each block remembers the
+// state it was highlighted with, which allows to skip up-to-date blocks and to resume from any block.
+// The document is highlighted in short time slices, so that the requested (e.g., visible) blocks can be
+// highlighted first. In the lazy mode, only the blocks explicitly requested with highlightBlocks() are highlighted.
+// Smali files are tokenized natively with SmaliTokenizer instead of the generic syntax engine.
+
+class CodeHighlighter : public QObject, public KSyntaxHighlighting::AbstractHighlighter
+{
+    Q_OBJECT
+
+public:
+    explicit CodeHighlighter(QTextDocument *document);
+
+    void setDefinition(const KSyntaxHighlighting::Definition &definition) override;
+    void setTheme(const KSyntaxHighlighting::Theme &theme) override;
+    void setLazy(bool lazy);
+    bool isLazy() const;
+
+    void rehighlight();
+    void highlightBlocks(const QTextBlock &first, const QTextBlock &last);
+
+    bool startsFoldingRegion(const QTextBlock &block) const;
+    QTextBlock findFoldingRegionEnd(const QTextBlock &startBlock) const;
+
+protected:
+    void applyFormat(int offset, int length, const KSyntaxHighlighting::Format &format) override;
+    void applyFolding(int offset, int length, KSyntaxHighlighting::FoldingRegion region) override;
+
+private:
+    struct LineState
+    {
+        KSyntaxHighlighting::State state; // Of the generic syntax engine
+        SmaliTokenizer::State smaliState;
+        bool operator==(const LineState &other) const;
+    };
+
+    struct FoldingMarker
+    {
+        quint16 id;
+        bool begin;
+    };
+
+    class BlockData : public QTextBlockUserData
+    {
+    public:
+        LineState startState;
+        LineState endState;
+        QVector<FoldingMarker> foldingMarkers;
+        int generation = -1;
+    };
+
+    void contentsChanged(int position, int removed, int added);
+    void schedulePass(int fromBlock, bool untilConverged);
+    void continuePass();
+    LineState highlightBlock(QTextBlock block, const LineState &state);
+    SmaliTokenizer::State highlightSmaliLine(const QString &text, const SmaliTokenizer::State &state);
+    void addFoldingMarker(const FoldingMarker &marker);
+    void updateSmaliFormats();
+    LineState getStartState(const QTextBlock &block) const;
+    BlockData *getBlockData(const QTextBlock &block) const;
+    bool isHighlighted(const QTextBlock &block, const LineState &state) const;
+    static FoldingMarker getFoldingRegion(const QTextBlock &block);
+    static KSyntaxHighlighting::Theme::TextStyle getTextStyle(SmaliTokenizer::TokenType type);
+
+    QTextDocument *document;
+    bool lazy = false;
+    bool smali = false;
+    int generation = 0;
+    QTimer *passTimer;
+    int passBlock = -1; // Number of the next block to be highlighted in the background, or -1 if done
+    bool passUntilConverged = false; // Whether to stop at the first up-to-date block
+    QVector<QTextLayout::FormatRange> formats; // Of the block being highlighted
+    QVector<FoldingMarker> foldingMarkers; // Of the block being highlighted
+    QVector<QTextCharFormat> smaliFormats; // For each token type
+    QVector<SmaliTokenizer::Token> smaliTokens; // Of the block being highlighted
+    QVector<SmaliTokenizer::Fold> smaliFolds; // Of the block being highlighted
+};
+
+#endif // CODEHIGHLIGHTER_H
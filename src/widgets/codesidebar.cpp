@@ -1,8 +1,9 @@
 #include "widgets/codesidebar.h"
 #include "widgets/codeeditor.h"
-#include <KSyntaxHighlighting/SyntaxHighlighter>
+#include <QHelpEvent>
 #include <QPainter>
 #include <QPainterPath>
+#include <QToolTip>
 
 CodeSideBar::CodeSideBar(CodeEditor *parent)
     : QWidget(parent)
@@ -36,6 +37,23 @@ QSize CodeSideBar::sizeHint() const
     return QSize(sidebarWidth, editor->viewport()->height());
 }
 
+bool CodeSideBar::event(QEvent *event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        auto helpEvent = static_cast<QHelpEvent *>(event);
+        const auto block = editor->blockAtPosition(helpEvent->y());
+        const QString error = block.isValid() ? editor->getLineError(block.blockNumber()) : QString();
+        if (!error.isEmpty()) {
+            QToolTip::showText(helpEvent->globalPos(), error, this);
+        } else {
+            QToolTip::hideText();
+            event->ignore();
+        }
+        return true;
+    }
+    return QWidget::event(event);
+}
+
 void CodeSideBar::changeEvent(QEvent *event)
 {
     if (event->type() == QEvent::LayoutDirectionChange) {
@@ -74,6 +92,11 @@ void CodeSideBar::paintEvent(QPaintEvent *event)
 
     while (block.isValid() && top <= event->rect().bottom()) {
 
+        // Error marker
+        if (block.isVisible() && bottom >= event->rect().top() && !editor->getLineError(block.blockNumber()).isEmpty()) {
+            painter.fillRect(0, top, width(), bottom - top, QColor(editor->getEditorColor(KSyntaxHighlighting::Theme::MarkError)));
+        }
+
         // Line number
         if (block.isVisible() && bottom >= event->rect().top()) {
             const int blockNumber = block.blockNumber() + 1;
@@ -86,7 +109,7 @@ void CodeSideBar::paintEvent(QPaintEvent *event)
         }
 
         // Folding marker
-        if (block.isVisible() && editor->highlighter->startsFoldingRegion(block)) {
+        if (block.isVisible() && editor->isFoldable(block)) {
             QPainterPath foldingMarker;
             if (!editor->isFolded(block)) {
                 foldingMarker.moveTo(5, 7);
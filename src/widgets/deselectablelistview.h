@@ -1,18 +0,0 @@
-#ifndef DESELECTABLELISTVIEW_H
-#define DESELECTABLELISTVIEW_H
-
-#include <QListView>
-
-class DeselectableListView : public QListView
-{
-    Q_OBJECT
-
-public:
-    DeselectableListView(QWidget *parent) : QListView(parent) {}
-
-private:
-    void mousePressEvent(QMouseEvent *event) override;
-    void focusInEvent(QFocusEvent *event) override;
-};
-
-#endif // DESELECTABLELISTVIEW_H
@@ -1,9 +1,9 @@
-#include "widgets/deselectablelistview.h"
+#include "widgets/deselectabletreeview.h"
 #include <QMouseEvent>
 
-void DeselectableListView::mousePressEvent(QMouseEvent *event)
+void DeselectableTreeView::mousePressEvent(QMouseEvent *event)
 {
-    QListView::mousePressEvent(event);
+    QTreeView::mousePressEvent(event);
     QModelIndex index = indexAt(event->pos());
     if (!index.isValid()) {
         clearSelection();
@@ -11,10 +11,10 @@ void DeselectableListView::mousePressEvent(QMouseEvent *event)
     }
 }
 
-void DeselectableListView::focusInEvent(QFocusEvent *event)
+void DeselectableTreeView::focusInEvent(QFocusEvent *event)
 {
     const bool deselect = !currentIndex().isValid();
-    QListView::focusInEvent(event);
+    QTreeView::focusInEvent(event);
     if (deselect) {
         selectionModel()->setCurrentIndex({}, QItemSelectionModel::Select);
         setAttribute(Qt::WA_InputMethodEnabled, false);
@@ -0,0 +1,18 @@
+#ifndef DESELECTABLETREEVIEW_H
+#define DESELECTABLETREEVIEW_H
+
+#include <QTreeView>
+
+class DeselectableTreeView : public QTreeView
+{
+    Q_OBJECT
+
+public:
+    DeselectableTreeView(QWidget *parent) : QTreeView(parent) {}
+
+private:
+    void mousePressEvent(QMouseEvent *event) override;
+    void focusInEvent(QFocusEvent *event) override;
+};
+
+#endif // DESELECTABLETREEVIEW_H
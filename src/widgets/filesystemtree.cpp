@@ -10,7 +10,7 @@ FileSystemTree::FileSystemTree(QWidget *parent) : QTreeView(parent)
 
 FileSystemModel *FileSystemTree::model() const
 {
-    return static_cast<FileSystemModel *>(QTreeView::model());
+    return qobject_cast<FileSystemModel *>(QTreeView::model());
 }
 
 void FileSystemTree::setModel(QAbstractItemModel *newModel)
@@ -22,10 +22,11 @@ void FileSystemTree::setModel(QAbstractItemModel *newModel)
     QTreeView::setModel(newModel);
     if (newModel) {
         auto newFileSystemModel = qobject_cast<FileSystemModel *>(newModel);
-        Q_ASSERT(newFileSystemModel);
-        setRootIndex(newFileSystemModel->rootIndex());
-        connect(newFileSystemModel, &QFileSystemModel::rootPathChanged, this, [=](const QString &path) {
-            setRootIndex(newFileSystemModel->index(path));
-        });
+        if (newFileSystemModel) {
+            setRootIndex(newFileSystemModel->rootIndex());
+            connect(newFileSystemModel, &QFileSystemModel::rootPathChanged, this, [=](const QString &path) {
+                setRootIndex(newFileSystemModel->index(path));
+            });
+        }
     }
 }
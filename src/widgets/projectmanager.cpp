@@ -97,6 +97,24 @@ ProjectManager::ProjectManager(PackageListModel &packages, QWidget *parent)
         currentProject->openSignatureViewer();
     });
 
+    actionViewResourceTable = new QAction(this);
+    actionViewResourceTable->setIcon(QIcon::fromTheme("edit-find"));
+    connect(actionViewResourceTable, &QAction::triggered, this, [this]() {
+        currentProject->openResourceTableViewer();
+    });
+
+    actionAnalyzeSize = new QAction(this);
+    actionAnalyzeSize->setIcon(QIcon::fromTheme("zoom-in"));
+    connect(actionAnalyzeSize, &QAction::triggered, this, [this]() {
+        currentProject->openSizeAnalyzer();
+    });
+
+    actionRemoveUnusedResources = new QAction(this);
+    actionRemoveUnusedResources->setIcon(QIcon::fromTheme("edit-delete"));
+    connect(actionRemoveUnusedResources, &QAction::triggered, this, [this]() {
+        currentProject->openResourceCleaner();
+    });
+
     menuTab = new QMenu(this);
     menuTab->setEnabled(false);
 
@@ -218,6 +236,21 @@ QAction *ProjectManager::getActionViewSignatures() const
     return actionViewSignatures;
 }
 
+QAction *ProjectManager::getActionViewResourceTable() const
+{
+    return actionViewResourceTable;
+}
+
+QAction *ProjectManager::getActionAnalyzeSize() const
+{
+    return actionAnalyzeSize;
+}
+
+QAction *ProjectManager::getActionRemoveUnusedResources() const
+{
+    return actionRemoveUnusedResources;
+}
+
 QAction *ProjectManager::getActionOpenProjectPage() const
 {
     return actionOpenProjectPage;
@@ -266,7 +299,10 @@ void ProjectManager::updateActionsForProject(Project *project)
     actionEditTitles->setEnabled(state ? state->canEdit() : false);
     actionEditPermissions->setEnabled(state ? state->canEdit() : false);
     actionClonePackage->setEnabled(state ? state->canEdit() : false);
+    actionRemoveUnusedResources->setEnabled(state ? state->canEdit() : false);
     actionViewSignatures->setEnabled(package);
+    actionViewResourceTable->setEnabled(package);
+    actionAnalyzeSize->setEnabled(package);
     actionOpenProjectPage->setEnabled(package);
     updateActionsForTab(project ? project->getCurrentTab() : nullptr);
     emit currentPackageStateChanged(package);
@@ -303,6 +339,12 @@ void ProjectManager::retranslate()
     actionClonePackage->setText(tr("&Clone APK"));
     //: The "&" is a shortcut key prefix, not an "and" conjunction. Details: https://github.com/kefir500/apk-editor-studio/wiki/Translation-Guide#shortcuts
     actionViewSignatures->setText(tr("View &Signatures"));
+    //: The "&" is a shortcut key prefix, not an "and" conjunction. Details: https://github.com/kefir500/apk-editor-studio/wiki/Translation-Guide#shortcuts
+    actionViewResourceTable->setText(tr("View &Resource Table"));
+    //: The "&" is a shortcut key prefix, not an "and" conjunction. Details: https://github.com/kefir500/apk-editor-studio/wiki/Translation-Guide#shortcuts
+    actionAnalyzeSize->setText(tr("Analyze APK Si&ze"));
+    //: The "&" is a shortcut key prefix, not an "and" conjunction. Details: https://github.com/kefir500/apk-editor-studio/wiki/Translation-Guide#shortcuts
+    actionRemoveUnusedResources->setText(tr("Remove &Unused Resources..."));
     actionSaveFile->setText(tr("&Save"));
     //: The "&" is a shortcut key prefix, not an "and" conjunction. Details: https://github.com/kefir500/apk-editor-studio/wiki/Translation-Guide#shortcuts
     actionSaveFileAs->setText(tr("Save &As..."));
@@ -34,6 +34,9 @@ public:
     QAction *getActionEditPermissions() const;
     QAction *getActionClonePackage() const;
     QAction *getActionViewSignatures() const;
+    QAction *getActionViewResourceTable() const;
+    QAction *getActionAnalyzeSize() const;
+    QAction *getActionRemoveUnusedResources() const;
     QAction *getActionOpenProjectPage() const;
     QMenu *getTabMenu() const;
 
@@ -68,6 +71,9 @@ private:
     QAction *actionEditPermissions;
     QAction *actionClonePackage;
     QAction *actionViewSignatures;
+    QAction *actionViewResourceTable;
+    QAction *actionAnalyzeSize;
+    QAction *actionRemoveUnusedResources;
     QAction *actionOpenProjectPage;
     QMenu *menuTab;
 };
@@ -1,12 +1,14 @@
 #include "widgets/resourcetree.h"
 #include "widgets/decorationsizedelegate.h"
+#include "widgets/loadingwidget.h"
 #include <QHeaderView>
+#include <QtConcurrent/QtConcurrent>
 
 #ifdef QT_DEBUG
     #include <QDebug>
 #endif
 
-ResourceTree::ResourceTree(QWidget *parent) : QTreeView(parent)
+ResourceTree::ResourceTree(QWidget *parent) : QTreeView(parent), generation(new QAtomicInt(0))
 {
     setSortingEnabled(true);
     header()->setSortIndicator(0, Qt::AscendingOrder);
@@ -16,8 +18,45 @@ ResourceTree::ResourceTree(QWidget *parent) : QTreeView(parent)
 
     sortProxy = new SortFilterProxyModel(this);
     sortProxy->setSortRole(ResourceItemsModel::SortRole);
-    sortProxy->setRecursiveFilteringEnabled(true);
     QTreeView::setModel(sortProxy);
+
+    // Queries are only sent once the user stops typing
+    searchTimer.setSingleShot(true);
+    searchTimer.setInterval(200);
+    connect(&searchTimer, &QTimer::timeout, this, &ResourceTree::search);
+
+    connect(&searchWatcher, &QFutureWatcher<SearchResult>::finished, this, [this]() {
+        const SearchResult result = searchWatcher.result();
+        if (result.generation != generation->load()) {
+            return; // Outdated or cancelled
+        }
+        sortProxy->setAcceptedNodes(result.nodes);
+    });
+
+    // The index requires all the resources to be read, which may take a while for the large APKs
+    loading = new LoadingWidget(this);
+    loading->hide();
+    connect(&indexWatcher, &QFutureWatcher<QSharedPointer<const ResourceIndex>>::finished, this, [this]() {
+        if (!indexing) {
+            return; // Cancelled
+        }
+        if (snapshotGeneration != indexGeneration) {
+            // The resources have changed while the index was being built
+            indexing = false;
+            buildIndex();
+            return;
+        }
+        index = indexWatcher.result();
+        indexing = false;
+        loading->hide();
+        emit indexReady();
+        search();
+    });
+}
+
+ResourceTree::~ResourceTree()
+{
+    generation->ref(); // Cancel the running search
 }
 
 ResourceItemsModel *ResourceTree::model() const
@@ -30,10 +69,117 @@ void ResourceTree::setModel(QAbstractItemModel *model)
     if (model) {
         Q_ASSERT(qobject_cast<ResourceItemsModel *>(model));
     }
+    if (this->model()) {
+        disconnect(this->model(), nullptr, this, nullptr);
+    }
     sortProxy->setSourceModel(model);
+    resetting = false;
+    indexing = false;
+    loading->hide();
+    if (model) {
+        // The model can be reset from a worker thread, so these connections are queued
+        connect(model, &QAbstractItemModel::modelAboutToBeReset, this, [this]() {
+            resetting = true;
+        });
+        connect(model, &QAbstractItemModel::modelReset, this, [this]() {
+            resetting = false;
+            invalidateIndex();
+        });
+        connect(model, &QAbstractItemModel::rowsInserted, this, &ResourceTree::invalidateIndex);
+        connect(model, &QAbstractItemModel::rowsRemoved, this, &ResourceTree::invalidateIndex);
+        connect(this->model(), &ResourceItemsModel::fetchedAll, this, [this]() {
+            if (!indexing) {
+                return;
+            }
+            if (resetting) {
+                // Will be repeated once the model is populated
+                indexing = false;
+                loading->hide();
+                return;
+            }
+            // The model can only be accessed from the GUI thread, so the index is built from its snapshot
+            const auto entries = ResourceIndex::snapshot(this->model());
+            snapshotGeneration = indexGeneration;
+            indexWatcher.setFuture(QtConcurrent::run([entries]() {
+                return QSharedPointer<const ResourceIndex>(new ResourceIndex(entries));
+            }));
+        });
+    }
+    invalidateIndex();
 }
 
 void ResourceTree::setFilter(const QString &filter)
 {
-    sortProxy->setFilterWildcard(filter);
+    query.text = filter;
+    searchTimer.start();
+}
+
+void ResourceTree::setFacet(ResourceIndex::Facet facet, const QString &value)
+{
+    query.facets[facet] = value;
+    searchTimer.start();
+}
+
+QString ResourceTree::getFacet(ResourceIndex::Facet facet) const
+{
+    return query.facets[facet];
+}
+
+QStringList ResourceTree::getFacetValues(ResourceIndex::Facet facet)
+{
+    buildIndex();
+    return index ? index->getFacetValues(facet) : QStringList();
+}
+
+bool ResourceTree::isIndexReady() const
+{
+    return !index.isNull();
+}
+
+void ResourceTree::buildIndex()
+{
+    if (index || indexing || !model() || resetting) {
+        return;
+    }
+    indexing = true;
+    loading->show();
+    model()->fetchAll();
+}
+
+void ResourceTree::invalidateIndex()
+{
+    index.reset();
+    ++indexGeneration;
+    generation->ref();
+    searchTimer.start();
+}
+
+void ResourceTree::search()
+{
+    if (resetting) {
+        return; // Will be repeated once the model is populated
+    }
+    if (query.isEmpty()) {
+        generation->ref();
+        sortProxy->clearAcceptedNodes();
+        return;
+    }
+
+    if (!index) {
+        buildIndex(); // The search is repeated once the index is ready
+        return;
+    }
+    const int searchGeneration = generation->fetchAndAddOrdered(1) + 1;
+    const QSharedPointer<const ResourceIndex> currentIndex = index;
+    const ResourceIndex::Query currentQuery = query;
+    const QSharedPointer<QAtomicInt> currentGeneration = generation;
+
+    searchWatcher.setFuture(QtConcurrent::run([=]() -> SearchResult {
+        SearchResult result;
+        result.generation = searchGeneration;
+        result.nodes = currentIndex->search(currentQuery, [=]() {
+            return currentGeneration->load() != searchGeneration;
+        });
+        return result;
+    }));
 }
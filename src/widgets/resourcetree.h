@@ -1,23 +1,58 @@
 #ifndef RESOURCETREE_H
 #define RESOURCETREE_H
 
+#include "apk/resourceindex.h"
 #include "apk/resourceitemsmodel.h"
 #include "apk/sortfilterproxymodel.h"
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QTimer>
 #include <QTreeView>
 
+class LoadingWidget;
+
 class ResourceTree : public QTreeView
 {
     Q_OBJECT
 
 public:
     explicit ResourceTree(QWidget *parent = nullptr);
+    ~ResourceTree() override;
 
     ResourceItemsModel *model() const;
     void setModel(QAbstractItemModel *model) override;
     void setFilter(const QString &filter);
+    void setFacet(ResourceIndex::Facet facet, const QString &value);
+    QString getFacet(ResourceIndex::Facet facet) const;
+    QStringList getFacetValues(ResourceIndex::Facet facet); // Empty until the index is built, see isIndexReady()
+    bool isIndexReady() const;
+    void buildIndex();
+
+signals:
+    void indexReady();
 
 private:
+    struct SearchResult
+    {
+        QSet<const void *> nodes;
+        int generation = 0;
+    };
+
+    void invalidateIndex();
+    void search();
+
     SortFilterProxyModel *sortProxy;
+    QSharedPointer<const ResourceIndex> index;
+    ResourceIndex::Query query;
+    QSharedPointer<QAtomicInt> generation;
+    QFutureWatcher<SearchResult> searchWatcher;
+    QFutureWatcher<QSharedPointer<const ResourceIndex>> indexWatcher;
+    QTimer searchTimer;
+    LoadingWidget *loading;
+    int indexGeneration = 0; // Incremented whenever the resources change
+    int snapshotGeneration = 0;
+    bool indexing = false;
+    bool resetting = false;
 };
 
 #endif // RESOURCETREE_H
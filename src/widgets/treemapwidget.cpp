@@ -0,0 +1,202 @@
+#include "widgets/treemapwidget.h"
+#include "base/utils.h"
+#include <QHelpEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QToolTip>
+#include <algorithm>
+#include <limits>
+
+TreemapWidget::TreemapWidget(QWidget *parent) : QWidget(parent)
+{
+    setMouseTracking(true);
+    setMinimumSize(Utils::scale(120, 120));
+}
+
+void TreemapWidget::setTiles(const QVector<Tile> &tiles)
+{
+    this->tiles = tiles;
+    updateLayout();
+    update();
+}
+
+int TreemapWidget::tileAt(const QPoint &point) const
+{
+    for (int i = 0; i < rects.count(); ++i) {
+        if (rects.at(i).contains(point)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QSize TreemapWidget::sizeHint() const
+{
+    return Utils::scale(320, 240);
+}
+
+bool TreemapWidget::event(QEvent *event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        auto helpEvent = static_cast<QHelpEvent *>(event);
+        const int index = tileAt(helpEvent->pos());
+        if (index != -1) {
+            const Tile &tile = tiles.at(index);
+            QToolTip::showText(helpEvent->globalPos(), QString("%1\n%2").arg(tile.label, tile.description), this);
+        } else {
+            QToolTip::hideText();
+            event->ignore();
+        }
+        return true;
+    }
+    return QWidget::event(event);
+}
+
+void TreemapWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().color(QPalette::Base));
+
+    const int padding = Utils::scale(4);
+    for (int i = 0; i < rects.count(); ++i) {
+        const QRectF &tileRect = rects.at(i);
+        if (tileRect.isEmpty()) {
+            continue;
+        }
+        const QColor color = QColor::fromHsv((i * 47) % 360, 70, 225);
+        painter.fillRect(tileRect, color);
+        painter.setPen(palette().color(QPalette::Base));
+        painter.drawRect(tileRect);
+
+        // Draw the caption only when it fits:
+        const QRectF textRect = tileRect.adjusted(padding, padding, -padding, -padding);
+        const QFontMetrics metrics = painter.fontMetrics();
+        if (textRect.height() < metrics.height() || textRect.width() < metrics.averageCharWidth() * 3) {
+            continue;
+        }
+        const Tile &tile = tiles.at(i);
+        QString text = metrics.elidedText(tile.label, Qt::ElideMiddle, static_cast<int>(textRect.width()));
+        if (textRect.height() >= metrics.height() * 2) {
+            text.append('\n' + metrics.elidedText(tile.description, Qt::ElideRight, static_cast<int>(textRect.width())));
+        }
+        painter.setPen(Qt::black);
+        painter.drawText(textRect, Qt::AlignLeft | Qt::AlignTop, text);
+    }
+}
+
+void TreemapWidget::resizeEvent(QResizeEvent *event)
+{
+    updateLayout();
+    QWidget::resizeEvent(event);
+}
+
+void TreemapWidget::mousePressEvent(QMouseEvent *event)
+{
+    const int index = tileAt(event->pos());
+    if (index != -1) {
+        emit tileClicked(index);
+    }
+    QWidget::mousePressEvent(event);
+}
+
+void TreemapWidget::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    const int index = tileAt(event->pos());
+    if (index != -1) {
+        emit tileActivated(index);
+    }
+    QWidget::mouseDoubleClickEvent(event);
+}
+
+void TreemapWidget::updateLayout()
+{
+    // Read more: Bruls, Huizing, van Wijk, "Squarified Treemaps"
+    rects = QVector<QRectF>(tiles.count());
+    areas = QVector<qreal>(tiles.count(), 0);
+
+    qreal total = 0;
+    QVector<int> order;
+    for (int i = 0; i < tiles.count(); ++i) {
+        if (tiles.at(i).value > 0) {
+            total += tiles.at(i).value;
+            order.append(i);
+        }
+    }
+    if (total <= 0 || width() <= 0 || height() <= 0) {
+        return;
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return tiles.at(a).value > tiles.at(b).value;
+    });
+
+    QRectF bounds(rect());
+    const qreal scale = bounds.width() * bounds.height() / total;
+    for (int index : order) {
+        areas[index] = tiles.at(index).value * scale;
+    }
+
+    QVector<int> row;
+    qreal rowArea = 0;
+    qreal rowMin = 0;
+    qreal rowMax = 0;
+    for (int index : order) {
+        const qreal area = areas.at(index);
+        const qreal side = qMin(bounds.width(), bounds.height());
+        if (!row.isEmpty()) {
+            const qreal current = worstRatio(rowArea, rowMin, rowMax, side);
+            const qreal next = worstRatio(rowArea + area, qMin(rowMin, area), qMax(rowMax, area), side);
+            if (next > current) {
+                layoutRow(row, rowArea, bounds);
+                row.clear();
+                rowArea = 0;
+            }
+        }
+        if (row.isEmpty()) {
+            rowMin = rowMax = area;
+        }
+        row.append(index);
+        rowArea += area;
+        rowMin = qMin(rowMin, area);
+        rowMax = qMax(rowMax, area);
+    }
+    if (!row.isEmpty()) {
+        layoutRow(row, rowArea, bounds);
+    }
+}
+
+void TreemapWidget::layoutRow(const QVector<int> &row, qreal rowArea, QRectF &bounds)
+{
+    if (bounds.width() >= bounds.height()) {
+        // Vertical strip along the left edge
+        const qreal stripWidth = bounds.height() > 0 ? rowArea / bounds.height() : 0;
+        qreal y = bounds.top();
+        for (int index : row) {
+            const qreal height = stripWidth > 0 ? areas.at(index) / stripWidth : 0;
+            rects[index] = QRectF(bounds.left(), y, stripWidth, height);
+            y += height;
+        }
+        bounds.setLeft(bounds.left() + stripWidth);
+    } else {
+        // Horizontal strip along the top edge
+        const qreal stripHeight = bounds.width() > 0 ? rowArea / bounds.width() : 0;
+        qreal x = bounds.left();
+        for (int index : row) {
+            const qreal width = stripHeight > 0 ? areas.at(index) / stripHeight : 0;
+            rects[index] = QRectF(x, bounds.top(), width, stripHeight);
+            x += width;
+        }
+        bounds.setTop(bounds.top() + stripHeight);
+    }
+}
+
+qreal TreemapWidget::worstRatio(qreal rowArea, qreal minArea, qreal maxArea, qreal side)
+{
+    if (rowArea <= 0 || minArea <= 0 || side <= 0) {
+        return std::numeric_limits<qreal>::max();
+    }
+    const qreal side2 = side * side;
+    const qreal area2 = rowArea * rowArea;
+    return qMax(side2 * maxArea / area2, area2 / (side2 * minArea));
+}
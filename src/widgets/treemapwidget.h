@@ -0,0 +1,48 @@
+#ifndef TREEMAPWIDGET_H
+#define TREEMAPWIDGET_H
+
+#include <QWidget>
+
+// Squarified treemap of a flat list of weighted tiles.
+
+class TreemapWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    struct Tile
+    {
+        QString label;
+        QString description;
+        qreal value;
+    };
+
+    explicit TreemapWidget(QWidget *parent = nullptr);
+
+    void setTiles(const QVector<Tile> &tiles);
+    int tileAt(const QPoint &point) const;
+
+    QSize sizeHint() const override;
+
+signals:
+    void tileClicked(int index);
+    void tileActivated(int index);
+
+protected:
+    bool event(QEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    void updateLayout();
+    void layoutRow(const QVector<int> &row, qreal rowArea, QRectF &bounds);
+    static qreal worstRatio(qreal rowArea, qreal minArea, qreal maxArea, qreal side);
+
+    QVector<Tile> tiles;
+    QVector<QRectF> rects;
+    QVector<qreal> areas;
+};
+
+#endif // TREEMAPWIDGET_H
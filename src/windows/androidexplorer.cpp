@@ -1,10 +1,12 @@
 #include "windows/androidexplorer.h"
 #include "windows/dialogs.h"
-#include "widgets/deselectablelistview.h"
+#include "widgets/deselectabletreeview.h"
 #include "widgets/loadingwidget.h"
 #include "widgets/logview.h"
 #include "widgets/toolbar.h"
 #include "tools/adb.h"
+#include "tools/adbdevicetracker.h"
+#include "tools/adbtransfer.h"
 #include "apk/logmodel.h"
 #include "base/androidfilesystemmodel.h"
 #include "base/application.h"
@@ -12,12 +14,14 @@
 #include "base/utils.h"
 #include <QBoxLayout>
 #include <QDockWidget>
+#include <QHeaderView>
 #include <QLineEdit>
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QShortcut>
 #include <QToolButton>
+#include <algorithm>
 
 #ifdef QT_DEBUG
     #include <QDebug>
@@ -104,6 +108,10 @@ AndroidExplorer::AndroidExplorer(const QString &serial, QWidget *parent)
         remove(fileList->currentIndex());
     });
 
+    actionRefresh = new QAction(QIcon::fromTheme("view-refresh"), {}, this);
+    actionRefresh->setShortcut(QKeySequence::Refresh);
+    connect(actionRefresh, &QAction::triggered, fileSystemModel, &AndroidFileSystemModel::refresh);
+
     auto actionInstall = app->actions.getInstallApk(this);
     connect(actionInstall, &QAction::triggered, this, &AndroidExplorer::install);
 
@@ -112,6 +120,7 @@ AndroidExplorer::AndroidExplorer(const QString &serial, QWidget *parent)
     menuFile = new QMenu(this);
     menuFile->addAction(actionDownload);
     menuFile->addAction(actionUpload);
+    menuFile->addAction(actionRefresh);
     menuFile->addSeparator();
     menuFile->addAction(actionInstall);
     menuBar()->addMenu(menuFile);
@@ -139,6 +148,7 @@ AndroidExplorer::AndroidExplorer(const QString &serial, QWidget *parent)
     toolbar->setObjectName("Toolbar");
     toolbar->addActionToPool("download", actionDownload);
     toolbar->addActionToPool("upload", actionUpload);
+    toolbar->addActionToPool("refresh", actionRefresh);
     toolbar->addActionToPool("copy", actionCopy);
     toolbar->addActionToPool("cut", actionCut);
     toolbar->addActionToPool("paste", actionPaste);
@@ -159,16 +169,28 @@ AndroidExplorer::AndroidExplorer(const QString &serial, QWidget *parent)
     fileSelectionActions->addAction(actionRename);
     fileSelectionActions->addAction(actionDelete);
 
+    const bool isLeftToRight = layoutDirection() == Qt::LeftToRight;
+
+    pathBackButton = new QToolButton(this);
+    pathBackButton->setIcon(QIcon::fromTheme(isLeftToRight ? "go-previous" : "go-next"));
+    pathBackButton->setShortcut(QKeySequence::Back);
+    connect(pathBackButton, &QToolButton::clicked, fileSystemModel, &AndroidFileSystemModel::back);
+
+    pathForwardButton = new QToolButton(this);
+    pathForwardButton->setIcon(QIcon::fromTheme(isLeftToRight ? "go-next" : "go-previous"));
+    pathForwardButton->setShortcut(QKeySequence::Forward);
+    connect(pathForwardButton, &QToolButton::clicked, fileSystemModel, &AndroidFileSystemModel::forward);
+
     pathUpButton = new QToolButton(this);
     pathUpButton->setIcon(QIcon::fromTheme("go-up"));
     connect(pathUpButton, &QToolButton::clicked, this, &AndroidExplorer::goUp);
 
     auto pathUpShortcut = new QShortcut(this);
-    pathUpShortcut->setKey(QKeySequence::Back);
+    pathUpShortcut->setKey(QKeySequence("Alt+Up"));
     connect(pathUpShortcut, &QShortcut::activated, this, &AndroidExplorer::goUp);
 
     pathGoButton = new QToolButton(this);
-    pathGoButton->setIcon(QIcon::fromTheme(layoutDirection() == Qt::LeftToRight ? "go-next" : "go-previous"));
+    pathGoButton->setIcon(QIcon::fromTheme(isLeftToRight ? "go-next" : "go-previous"));
     connect(pathGoButton, &QToolButton::clicked, this, [this]() {
         go(pathInput->text());
     });
@@ -178,15 +200,24 @@ AndroidExplorer::AndroidExplorer(const QString &serial, QWidget *parent)
 
     auto pathBar = new QHBoxLayout;
     pathBar->setSpacing(2);
+    pathBar->addWidget(pathBackButton);
+    pathBar->addWidget(pathForwardButton);
     pathBar->addWidget(pathUpButton);
     pathBar->addWidget(pathInput);
     pathBar->addWidget(pathGoButton);
 
-    fileList = new DeselectableListView(this);
+    fileList = new DeselectableTreeView(this);
     fileList->setModel(fileSystemModel);
+    fileList->setRootIsDecorated(false);
+    fileList->setSortingEnabled(true);
+    fileList->sortByColumn(AndroidFileSystemModel::NameColumn, Qt::AscendingOrder);
+    fileList->setColumnHidden(AndroidFileSystemModel::PathColumn, true);
+    fileList->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    fileList->header()->setSectionResizeMode(AndroidFileSystemModel::NameColumn, QHeaderView::Stretch);
+    fileList->header()->setStretchLastSection(false);
     fileList->setContextMenuPolicy(Qt::CustomContextMenu);
-    fileList->setEditTriggers(QListView::SelectedClicked | QListView::EditKeyPressed);
-    connect(fileList, &QListView::activated, this, [this](const QModelIndex &index) {
+    fileList->setEditTriggers(QTreeView::SelectedClicked | QTreeView::EditKeyPressed);
+    connect(fileList, &QTreeView::activated, this, [this](const QModelIndex &index) {
         const auto type = fileSystemModel->getItemType(index);
         const auto path = fileSystemModel->getItemPath(index);
         switch (type) {
@@ -198,7 +229,7 @@ AndroidExplorer::AndroidExplorer(const QString &serial, QWidget *parent)
             break;
         }
     });
-    connect(fileList, &QListView::customContextMenuRequested, this, [this](const QPoint &point) {
+    connect(fileList, &QTreeView::customContextMenuRequested, this, [this](const QPoint &point) {
         QMenu context(this);
         context.addSeparator();
         context.addAction(actionDownload);
@@ -217,17 +248,24 @@ AndroidExplorer::AndroidExplorer(const QString &serial, QWidget *parent)
     });
 
     auto loading = new LoadingWidget(fileList);
+    loading->setVisible(fileSystemModel->isLoading());
+
+    auto updateHistoryButtons = [this]() {
+        pathBackButton->setEnabled(fileSystemModel->canGoBack());
+        pathForwardButton->setEnabled(fileSystemModel->canGoForward());
+    };
+    updateHistoryButtons();
 
     connect(fileSystemModel, &AndroidFileSystemModel::pathChanged, this, [=](const QString &path) {
         pathInput->setText(path);
         fileSelectionActions->setEnabled(false);
     });
+    connect(fileSystemModel, &AndroidFileSystemModel::historyChanged, this, updateHistoryButtons);
+    connect(fileSystemModel, &AndroidFileSystemModel::loadingChanged, loading, &LoadingWidget::setVisible);
     connect(fileSystemModel, &AndroidFileSystemModel::modelAboutToBeReset, this, [=]() {
-        loading->show();
         fileSelectionActions->setEnabled(false);
     });
     connect(fileSystemModel, &AndroidFileSystemModel::modelReset, this, [=]() {
-        loading->hide();
         fileList->scrollToTop();
     });
     connect(fileSystemModel, &AndroidFileSystemModel::error, this, [this](const QString &error) {
@@ -245,6 +283,22 @@ AndroidExplorer::AndroidExplorer(const QString &serial, QWidget *parent)
     layout->addLayout(pathBar);
     layout->addWidget(fileList);
 
+    // The explorer is disabled while its device is detached, and refreshed once it is back
+    auto tracker = AdbDeviceTracker::instance();
+    connect(tracker, &AdbDeviceTracker::devicesChanged, this, [=]() {
+        const bool connected = tracker->hasDevice(this->serial);
+        if (connected == centralWidget()->isEnabled()) {
+            return;
+        }
+        centralWidget()->setEnabled(connected);
+        if (connected) {
+            logModel->add(tr("Device connected."), LogEntry::Success);
+            fileSystemModel->refresh();
+        } else {
+            logModel->add(tr("Device disconnected."), LogEntry::Error);
+        }
+    });
+
     restoreGeometry(app->settings->getAndroidExplorerGeometry());
     restoreState(app->settings->getAndroidExplorerState());
 
@@ -282,7 +336,7 @@ void AndroidExplorer::download(const QString &path)
         return;
     }
 
-    fileSystemModel->download(path, dst);
+    showProgress(fileSystemModel->download(path, dst), path, false);
 }
 
 void AndroidExplorer::upload(const QString &path)
@@ -292,7 +346,53 @@ void AndroidExplorer::upload(const QString &path)
         return;
     }
 
-    fileSystemModel->upload(src, path);
+    showProgress(fileSystemModel->upload(src, path), src, true);
+}
+
+void AndroidExplorer::showProgress(AdbTransfer *transfer, const QString &path, bool upload)
+{
+    auto getStatus = [=](qint64 transferred, qint64 total, qint64 bytesPerSecond) {
+        const QString status = QString("%1 / %2 (%3)").arg(
+            locale().formattedDataSize(transferred),
+            locale().formattedDataSize(total),
+            //: Transfer speed, "%1" will be replaced with a data size (e.g., "2.5 MiB").
+            tr("%1/s").arg(locale().formattedDataSize(bytesPerSecond)));
+        return upload
+            //: "%1" will be replaced with a path to the file or directory, "%2" with the transfer progress.
+            ? tr("Uploading %1: %2").arg(path, status)
+            //: "%1" will be replaced with a path to the file or directory, "%2" with the transfer progress.
+            : tr("Downloading %1: %2").arg(path, status);
+    };
+    const QPersistentModelIndex entryIndex(logModel->add(upload
+        //: "%1" will be replaced with a path to the file or directory.
+        ? tr("Uploading %1...").arg(path)
+        //: "%1" will be replaced with a path to the file or directory.
+        : tr("Downloading %1...").arg(path)));
+    connect(transfer, &AdbTransfer::progress, this, [=](qint64 transferred, qint64 total, qint64 bytesPerSecond) {
+        if (entryIndex.isValid()) {
+            logModel->update(entryIndex, getStatus(transferred, total, bytesPerSecond));
+        }
+    });
+    connect(transfer, &AdbTransfer::finished, this, [=](bool success) {
+        if (!entryIndex.isValid()) {
+            return;
+        }
+        //: Files which were not transferred because the same files already exist at the destination.
+        const QString skipped = transfer->getSkippedCount() ? tr("%n file(s) already up to date.", nullptr, transfer->getSkippedCount()) : QString();
+        if (success) {
+            logModel->update(entryIndex, upload
+                //: "%1" will be replaced with a path to the file or directory.
+                ? tr("Successfully uploaded %1").arg(path)
+                //: "%1" will be replaced with a path to the file or directory.
+                : tr("Successfully downloaded %1").arg(path), skipped, LogEntry::Success);
+        } else {
+            logModel->update(entryIndex, upload
+                //: "%1" will be replaced with a path to the file or directory.
+                ? tr("Could not upload %1").arg(path)
+                //: "%1" will be replaced with a path to the file or directory.
+                : tr("Could not download %1").arg(path), transfer->getError(), LogEntry::Error);
+        }
+    });
 }
 
 void AndroidExplorer::copy(const QString &src, const QString &dst)
@@ -329,8 +429,23 @@ void AndroidExplorer::remove(const QModelIndex &index)
 void AndroidExplorer::install()
 {
     const QStringList paths = Dialogs::getOpenApkFilenames(this);
-    for (const QString &path : paths) {
-        auto install = new Adb::Install(path, serial);
+
+    // A base APK selected along with other APKs is installed with them as its splits
+    QList<QStringList> installs;
+    const bool isSplit = paths.count() > 1 && std::any_of(paths.cbegin(), paths.cend(), [](const QString &path) {
+        return QFileInfo(path).fileName() == "base.apk";
+    });
+    if (isSplit) {
+        installs.append(paths);
+    } else {
+        for (const QString &path : paths) {
+            installs.append(QStringList{path});
+        }
+    }
+
+    for (const QStringList &apks : installs) {
+        const QString path = apks.count() == 1 ? apks.first() : QFileInfo(apks.first()).path();
+        auto install = new Adb::Install(apks, serial);
         //: "%1" will be replaced with a path to the APK.
         const QPersistentModelIndex entryIndex(logModel->add(tr("Installing %1...").arg(path)));
         connect(install, &Command::finished, this, [=](bool success) {
@@ -370,6 +485,14 @@ void AndroidExplorer::retranslate()
     actionPaste->setText(tr("Paste"));
     actionRename->setText(tr("Rename"));
     actionDelete->setText(tr("Delete"));
+    //: Reload the contents of a directory in a file manager.
+    actionRefresh->setText(tr("Refresh"));
+    //: Navigate to the previously visited directory in a file manager.
+    pathBackButton->setText(tr("Back"));
+    pathBackButton->setToolTip(tr("Back"));
+    //: Navigate to the next visited directory in a file manager.
+    pathForwardButton->setText(tr("Forward"));
+    pathForwardButton->setToolTip(tr("Forward"));
     //: Navigate up one directory in a file manager hierarchy.
     pathUpButton->setText(tr("Up"));
     pathUpButton->setToolTip(tr("Up"));
@@ -4,8 +4,9 @@
 #include "base/clipboard.h"
 #include <QMainWindow>
 
+class AdbTransfer;
 class AndroidFileSystemModel;
-class DeselectableListView;
+class DeselectableTreeView;
 class LogModel;
 class QLineEdit;
 class QToolButton;
@@ -27,6 +28,7 @@ private:
     void goUp();
     void download(const QString &path);
     void upload(const QString &path);
+    void showProgress(AdbTransfer *transfer, const QString &path, bool upload);
     void copy(const QString &src, const QString &dst);
     void move(const QString &src, const QString &dst);
     void remove(const QModelIndex &index);
@@ -48,11 +50,14 @@ private:
     QAction *actionPaste;
     QAction *actionRename;
     QAction *actionDelete;
+    QAction *actionRefresh;
 
     QLineEdit *pathInput;
+    QToolButton *pathBackButton;
+    QToolButton *pathForwardButton;
     QToolButton *pathUpButton;
     QToolButton *pathGoButton;
-    DeselectableListView *fileList;
+    DeselectableTreeView *fileList;
 
     QMenu *menuFile;
     QMenu *menuEdit;
@@ -0,0 +1,212 @@
+#include "windows/apkcomparer.h"
+#include "widgets/filebox.h"
+#include "widgets/loadingwidget.h"
+#include "base/utils.h"
+#include <QBoxLayout>
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QElapsedTimer>
+#include <QFormLayout>
+#include <QFutureWatcher>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QSharedPointer>
+#include <QSplitter>
+#include <QTreeWidget>
+#include <QDebug>
+
+namespace
+{
+    class DiffItem : public QTreeWidgetItem
+    {
+    public:
+        using QTreeWidgetItem::QTreeWidgetItem;
+
+        bool operator<(const QTreeWidgetItem &other) const override
+        {
+            // Numeric columns store their raw values in the user role
+            const int column = treeWidget()->sortColumn();
+            const QVariant value = data(column, Qt::UserRole);
+            if (value.isValid()) {
+                return value.toLongLong() < other.data(column, Qt::UserRole).toLongLong();
+            }
+            return QTreeWidgetItem::operator<(other);
+        }
+    };
+}
+
+ApkComparer::ApkComparer(const QString &oldApk, const QString &newApk, QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle(tr("Compare APKs"));
+    setWindowIcon(QIcon::fromTheme("document-swap"));
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+    resize(Utils::scale(900, 600));
+
+    oldApkBox = new FileBox(false, this);
+    oldApkBox->setCurrentPath(oldApk);
+    newApkBox = new FileBox(false, this);
+    newApkBox->setCurrentPath(newApk);
+    btnCompare = new QPushButton(tr("Compare"), this);
+    connect(btnCompare, &QPushButton::clicked, this, &ApkComparer::compare);
+
+    auto form = new QFormLayout;
+    //: This string refers to the APK which is compared against the other one.
+    form->addRow(tr("Original APK:"), oldApkBox);
+    //: This string refers to the APK which is compared against the original one.
+    form->addRow(tr("Modified APK:"), newApkBox);
+
+    auto formLayout = new QHBoxLayout;
+    formLayout->addLayout(form, 1);
+    formLayout->addWidget(btnCompare, 0, Qt::AlignBottom);
+
+    summary = new QLabel(this);
+    summary->setWordWrap(true);
+
+    checkboxUnchanged = new QCheckBox(tr("Show unchanged files"), this);
+    connect(checkboxUnchanged, &QCheckBox::toggled, this, &ApkComparer::updateFilter);
+
+    list = new QTreeWidget(this);
+    list->setRootIsDecorated(false);
+    list->setUniformRowHeights(true);
+    list->setSortingEnabled(true);
+    list->setHeaderLabels({tr("Name"), tr("Status"), tr("Original Size"), tr("Modified Size"), tr("Difference")});
+    list->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    list->sortByColumn(NameColumn, Qt::AscendingOrder);
+
+    details = new QPlainTextEdit(this);
+    details->setReadOnly(true);
+    details->setLineWrapMode(QPlainTextEdit::NoWrap);
+    connect(list, &QTreeWidget::currentItemChanged, this, [this](QTreeWidgetItem *item) {
+        details->setPlainText(item ? item->data(NameColumn, Qt::UserRole).toStringList().join('\n') : QString());
+    });
+
+    auto splitter = new QSplitter(Qt::Vertical, this);
+    splitter->addWidget(list);
+    splitter->addWidget(details);
+    splitter->setStretchFactor(0, 3);
+    splitter->setStretchFactor(1, 1);
+
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addLayout(formLayout);
+    layout->addWidget(summary);
+    layout->addWidget(checkboxUnchanged);
+    layout->addWidget(splitter);
+    layout->addWidget(buttons);
+
+    loading = new LoadingWidget(this);
+    loading->hide();
+
+    if (!oldApk.isEmpty() && !newApk.isEmpty()) {
+        compare();
+    }
+}
+
+void ApkComparer::compare()
+{
+    const QString oldApk = oldApkBox->getCurrentPath();
+    const QString newApk = newApkBox->getCurrentPath();
+    if (oldApk.isEmpty() || newApk.isEmpty()) {
+        return;
+    }
+
+    loading->show();
+    auto timer = QSharedPointer<QElapsedTimer>::create();
+    timer->start();
+    auto watcher = new QFutureWatcher<ApkDiff::Result>(this);
+    connect(watcher, &QFutureWatcher<ApkDiff::Result>::finished, this, [=]() {
+        qDebug() << qPrintable(QString("Compared APKs in %1 ms\n").arg(timer->elapsed()));
+        loading->hide();
+        setResult(watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(ApkDiff::compare(oldApk, newApk));
+}
+
+void ApkComparer::setResult(const ApkDiff::Result &result)
+{
+    list->clear();
+    details->clear();
+    if (!result.success) {
+        summary->clear();
+        QMessageBox::warning(this, {}, tr("Could not read the APK."));
+        return;
+    }
+
+    int added = 0;
+    int removed = 0;
+    int modified = 0;
+    list->setSortingEnabled(false);
+    for (const auto &entry : result.entries) {
+        switch (entry.status) {
+        case ApkDiff::Status::Added:
+            ++added;
+            break;
+        case ApkDiff::Status::Removed:
+            ++removed;
+            break;
+        case ApkDiff::Status::Modified:
+            ++modified;
+            break;
+        case ApkDiff::Status::Unchanged:
+            break;
+        }
+        const qint64 difference = qint64(entry.newCompressedSize) - qint64(entry.oldCompressedSize);
+        auto item = new DiffItem(list);
+        item->setText(NameColumn, entry.name);
+        item->setData(NameColumn, Qt::UserRole, entry.details);
+        item->setText(StatusColumn, getStatusTitle(entry.status));
+        item->setData(StatusColumn, Qt::UserRole + 1, static_cast<int>(entry.status));
+        item->setData(OldSizeColumn, Qt::UserRole, entry.oldCompressedSize);
+        item->setData(NewSizeColumn, Qt::UserRole, entry.newCompressedSize);
+        if (entry.status != ApkDiff::Status::Added) {
+            item->setText(OldSizeColumn, locale().formattedDataSize(entry.oldCompressedSize));
+        }
+        if (entry.status != ApkDiff::Status::Removed) {
+            item->setText(NewSizeColumn, locale().formattedDataSize(entry.newCompressedSize));
+        }
+        const QString sign = difference > 0 ? "+" : (difference < 0 ? "-" : QString());
+        item->setText(DifferenceColumn, sign + locale().formattedDataSize(qAbs(difference)));
+        item->setData(DifferenceColumn, Qt::UserRole, difference);
+        for (int column : {OldSizeColumn, NewSizeColumn, DifferenceColumn}) {
+            item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+        }
+    }
+    list->setSortingEnabled(true);
+
+    //: "%1", "%2" and "%3" will be replaced with the number of added, removed and modified files.
+    summary->setText(tr("Files added: %1, removed: %2, modified: %3.").arg(added).arg(removed).arg(modified));
+    updateFilter();
+}
+
+void ApkComparer::updateFilter()
+{
+    const bool showUnchanged = checkboxUnchanged->isChecked();
+    for (int i = 0; i < list->topLevelItemCount(); ++i) {
+        const auto item = list->topLevelItem(i);
+        const auto status = static_cast<ApkDiff::Status>(item->data(StatusColumn, Qt::UserRole + 1).toInt());
+        item->setHidden(!showUnchanged && status == ApkDiff::Status::Unchanged);
+    }
+}
+
+QString ApkComparer::getStatusTitle(ApkDiff::Status status)
+{
+    switch (status) {
+    case ApkDiff::Status::Added:
+        //: This string refers to a file present only in the modified APK.
+        return tr("Added");
+    case ApkDiff::Status::Removed:
+        //: This string refers to a file present only in the original APK.
+        return tr("Removed");
+    case ApkDiff::Status::Modified:
+        return tr("Modified");
+    case ApkDiff::Status::Unchanged:
+        return tr("Unchanged");
+    }
+    return QString();
+}
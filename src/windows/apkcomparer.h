@@ -0,0 +1,47 @@
+#ifndef APKCOMPARER_H
+#define APKCOMPARER_H
+
+#include "apk/apkdiff.h"
+#include <QDialog>
+
+class FileBox;
+class LoadingWidget;
+class QCheckBox;
+class QLabel;
+class QPlainTextEdit;
+class QPushButton;
+class QTreeWidget;
+
+class ApkComparer : public QDialog
+{
+    Q_OBJECT
+
+public:
+    ApkComparer(const QString &oldApk = QString(), const QString &newApk = QString(), QWidget *parent = nullptr);
+
+private:
+    enum Column {
+        NameColumn,
+        StatusColumn,
+        OldSizeColumn,
+        NewSizeColumn,
+        DifferenceColumn
+    };
+
+    void compare();
+    void setResult(const ApkDiff::Result &result);
+    void updateFilter();
+
+    static QString getStatusTitle(ApkDiff::Status status);
+
+    FileBox *oldApkBox;
+    FileBox *newApkBox;
+    QPushButton *btnCompare;
+    QLabel *summary;
+    QCheckBox *checkboxUnchanged;
+    QTreeWidget *list;
+    QPlainTextEdit *details;
+    LoadingWidget *loading;
+};
+
+#endif // APKCOMPARER_H
@@ -25,6 +25,7 @@ DeviceManager::DeviceManager(QWidget *parent) : QDialog(parent)
     deviceList->setModel(&deviceModel);
     deviceList->setCurrentIndex(QModelIndex());
     auto loading = new LoadingWidget(deviceList);
+    loading->setVisible(deviceModel.isLoading());
 
     QPushButton *btnRefresh = new QPushButton(tr("Refresh"), this);
     btnRefresh->setIcon(QIcon::fromTheme("view-refresh"));
@@ -69,14 +70,8 @@ DeviceManager::DeviceManager(QWidget *parent) : QDialog(parent)
         QModelIndex index = deviceModel.index(deviceList->currentIndex().row(), DeviceItemsModel::AliasColumn);
         deviceModel.setData(index, alias);
     });
-    connect(&deviceModel, &DeviceItemsModel::fetching, this, [=]() {
-        loading->show();
-        setEnabled(false);
-    });
-    connect(&deviceModel, &DeviceItemsModel::fetched, this, [=]() {
-        loading->hide();
-        setEnabled(true);
-    });
+    connect(&deviceModel, &DeviceItemsModel::fetching, loading, &LoadingWidget::show);
+    connect(&deviceModel, &DeviceItemsModel::fetched, loading, &LoadingWidget::hide);
     connect(btnRefresh, &QPushButton::clicked, &deviceModel, &DeviceItemsModel::refresh);
     connect(btnApply, &QPushButton::clicked, &deviceModel, &DeviceItemsModel::save);
     connect(dialogButtons, &QDialogButtonBox::accepted, this, &DeviceManager::accept);
@@ -89,25 +84,12 @@ DeviceManager::DeviceManager(QWidget *parent) : QDialog(parent)
     });
 
     setCurrentDevice({});
-    deviceModel.refresh();
 }
 
 Device DeviceManager::selectDevice(const QString &title, const QString &action, const QIcon &icon, QWidget *parent)
 {
     DeviceManager dialog(parent);
-    dialog.setWindowTitle(title.isEmpty() ? tr("Select Device") : title);
-    if (!icon.isNull()) {
-        dialog.setWindowIcon(icon);
-    }
-
-    auto btnSelect = dialog.dialogButtons->button(QDialogButtonBox::Ok);
-    btnSelect->setEnabled(false);
-    if (!action.isEmpty()) {
-        btnSelect->setText(action);
-    }
-    if (!icon.isNull()) {
-        btnSelect->setIcon(icon);
-    }
+    auto btnSelect = dialog.initSelectButton(title.isEmpty() ? tr("Select Device") : title, action, icon);
 
     connect(&dialog, &DeviceManager::currentChanged, btnSelect, [btnSelect](const Device &device) {
         btnSelect->setEnabled(!device.isNull());
@@ -120,6 +102,47 @@ Device DeviceManager::selectDevice(const QString &title, const QString &action,
     return {};
 }
 
+QList<Device> DeviceManager::selectDevices(const QString &title, const QString &action, const QIcon &icon, QWidget *parent)
+{
+    DeviceManager dialog(parent);
+    //: This string refers to multiple devices.
+    auto btnSelect = dialog.initSelectButton(title.isEmpty() ? tr("Select Devices") : title, action, icon);
+    dialog.deviceList->setSelectionMode(QAbstractItemView::ExtendedSelection);
+
+    auto selectionModel = dialog.deviceList->selectionModel();
+    connect(selectionModel, &QItemSelectionModel::selectionChanged, btnSelect, [btnSelect, selectionModel]() {
+        btnSelect->setEnabled(selectionModel->hasSelection());
+    });
+
+    QList<Device> devices;
+    if (dialog.exec() == QDialog::Accepted) {
+        // The list view only selects the first column, so the rows are never fully selected
+        const QModelIndexList indexes = selectionModel->selectedIndexes();
+        for (const QModelIndex &index : indexes) {
+            devices.append(dialog.deviceModel.get(index));
+        }
+    }
+    return devices;
+}
+
+QPushButton *DeviceManager::initSelectButton(const QString &title, const QString &action, const QIcon &icon)
+{
+    setWindowTitle(title);
+    if (!icon.isNull()) {
+        setWindowIcon(icon);
+    }
+
+    auto btnSelect = dialogButtons->button(QDialogButtonBox::Ok);
+    btnSelect->setEnabled(false);
+    if (!action.isEmpty()) {
+        btnSelect->setText(action);
+    }
+    if (!icon.isNull()) {
+        btnSelect->setIcon(icon);
+    }
+    return btnSelect;
+}
+
 bool DeviceManager::setCurrentDevice(const Device &device)
 {
     emit currentChanged(device);
@@ -9,6 +9,7 @@ class QDialogButtonBox;
 class QLabel;
 class QLineEdit;
 class QListView;
+class QPushButton;
 
 class DeviceManager : public QDialog
 {
@@ -21,11 +22,16 @@ public:
                                const QString &action = QString(),
                                const QIcon &icon = QIcon(),
                                QWidget *parent = nullptr);
+    static QList<Device> selectDevices(const QString &title = QString(),
+                                       const QString &action = QString(),
+                                       const QIcon &icon = QIcon(),
+                                       QWidget *parent = nullptr);
 
 signals:
     void currentChanged(const Device &device);
 
 private:
+    QPushButton *initSelectButton(const QString &title, const QString &action, const QIcon &icon);
     bool setCurrentDevice(const Device &device);
 
     QListView *deviceList;
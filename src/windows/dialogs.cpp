@@ -112,12 +112,12 @@ QString Dialogs::getOpenDirectory(const QString &defaultPath, QWidget *parent)
     return QFileDialog::getExistingDirectory(parent, QString(), path);
 }
 
-Device Dialogs::getInstallDevice(QWidget *parent)
+QList<Device> Dialogs::getInstallDevices(QWidget *parent)
 {
     const QString title(qApp->translate("Dialogs", "Install APK"));
     const QString action(qApp->translate("Dialogs", "Install"));
     const QIcon icon(QIcon::fromTheme("apk-install"));
-    return DeviceManager::selectDevice(title, action, icon, parent);
+    return DeviceManager::selectDevices(title, action, icon, parent);
 }
 
 Device Dialogs::getExplorerDevice(QWidget *parent)
@@ -29,7 +29,7 @@ namespace Dialogs
 
     QString getOpenDirectory(const QString &defaultPath, QWidget *parent = nullptr);
 
-    Device getInstallDevice(QWidget *parent = nullptr);
+    QList<Device> getInstallDevices(QWidget *parent = nullptr);
     Device getExplorerDevice(QWidget *parent = nullptr);
     Device getScreenshotDevice(QWidget *parent = nullptr);
 
@@ -20,16 +20,19 @@
 #include "base/updater.h"
 #include "apk/package.h"
 #include "apk/project.h"
+#include <QActionGroup>
 #include <QBoxLayout>
 #include <QDebug>
 #include <QDockWidget>
 #include <QDropEvent>
+#include <QFileInfo>
 #include <QHeaderView>
 #include <QLineEdit>
 #include <QMenuBar>
 #include <QMimeData>
 #include <QMimeDatabase>
 #include <QTimer>
+#include <QToolButton>
 
 int MainWindow::instances = 0;
 
@@ -44,6 +47,7 @@ MainWindow::MainWindow(PackageListModel &packages, QWidget *parent)
 
     projectManager = new ProjectManager(packages, this);
     connect(projectManager, &ProjectManager::currentPackageStateChanged, this, &MainWindow::updateWindowForPackage);
+    connect(projectManager, &ProjectManager::currentPackageStateChanged, this, &MainWindow::updateContentsForPackage);
     connect(projectManager, &ProjectManager::projectCreated, this, [this](Project *project) {
         setCurrentPackage(project->getPackage());
     });
@@ -84,6 +88,7 @@ void MainWindow::openApk(const QString &path)
 {
     if (auto package = addPackage(path)) {
         auto command = package->createCommandChain();
+        command->add(package->createReadCommand(), false);
         command->add(package->createUnpackCommand(), true);
         command->run();
     }
@@ -97,12 +102,31 @@ void MainWindow::openExternalApk()
     }
 }
 
+void MainWindow::patchExternalApk()
+{
+    const QStringList paths = Dialogs::getOpenApkFilenames(this);
+    for (const QString &path : paths) {
+        if (auto package = addPackage(path)) {
+            // The APK is edited in place of unpacking, so only the archive contents are available
+            auto command = package->createCommandChain();
+            command->add(package->createReadCommand(), true);
+            connect(command, &Command::finished, this, [=](bool success) {
+                if (!success || !package->openForPatching()) {
+                    QMessageBox::warning(this, {}, tr("Could not open the APK for patching."));
+                }
+            });
+            command->run();
+        }
+    }
+}
+
 void MainWindow::optimizeExternalApk()
 {
     const QStringList paths = Dialogs::getOpenApkFilenames(this);
     for (const QString &path : paths) {
         if (auto package = addPackage(path)) {
             auto command = package->createCommandChain();
+            command->add(package->createReadCommand(), false);
             command->add(package->createZipalignCommand(), true);
             command->run();
         }
@@ -119,6 +143,7 @@ void MainWindow::signExternalApk()
     for (const QString &path : paths) {
         if (auto package = addPackage(path)) {
             auto command = package->createCommandChain();
+            command->add(package->createReadCommand(), false);
             command->add(package->createSignCommand(keystore.get()), true);
             command->run();
         }
@@ -127,15 +152,16 @@ void MainWindow::signExternalApk()
 
 void MainWindow::installExternalApk()
 {
-    const auto device = Dialogs::getInstallDevice(this);
-    if (device.isNull()) {
+    const auto devices = Dialogs::getInstallDevices(this);
+    if (devices.isEmpty()) {
         return;
     }
     const QStringList paths = Dialogs::getOpenApkFilenames(this);
     for (const QString &path : paths) {
         if (auto package = addPackage(path)) {
             auto command = package->createCommandChain();
-            command->add(package->createInstallCommand(device.getSerial()), true);
+            command->add(package->createReadCommand(), false);
+            command->add(package->createInstallCommand(devices), true);
             command->run();
         }
     }
@@ -147,36 +173,125 @@ void MainWindow::processArguments(const QStringList &arguments)
     QCommandLineOption optimizeOption(QStringList{"o", "optimize", "z", "zipalign"});
     QCommandLineOption signOption(QStringList{"s", "sign"});
     QCommandLineOption installOption(QStringList{"i", "install"});
+    QCommandLineOption versionCodeOption("version-code", {}, "code");
+    QCommandLineOption versionNameOption("version-name", {}, "name");
+    QCommandLineOption minSdkOption("min-sdk", {}, "level");
+    QCommandLineOption debuggableOption("debuggable", {}, "true|false");
+    QCommandLineOption outputOption("output", {}, "path");
     cli.addOption(optimizeOption);
     cli.addOption(signOption);
     cli.addOption(installOption);
+    cli.addOption(versionCodeOption);
+    cli.addOption(versionNameOption);
+    cli.addOption(minSdkOption);
+    cli.addOption(debuggableOption);
+    cli.addOption(outputOption);
     cli.parse(arguments);
 
+    const bool optimize = cli.isSet(optimizeOption);
+    const bool sign = cli.isSet(signOption);
+    const bool install = cli.isSet(installOption);
+    const bool patchManifest = cli.isSet(versionCodeOption) || cli.isSet(versionNameOption)
+                            || cli.isSet(minSdkOption) || cli.isSet(debuggableOption);
+
+    // Manifest values are validated up front; the unset ones are taken from the APK once it is read
+    bool ok = true;
+    auto toInt = [&](const QCommandLineOption &option, int minimum) {
+        bool isNumber = true;
+        const int value = cli.isSet(option) ? cli.value(option).toInt(&isNumber) : 0;
+        ok = ok && isNumber && (!cli.isSet(option) || value >= minimum);
+        return value;
+    };
+    auto toBool = [&](const QCommandLineOption &option) {
+        const QString value = cli.value(option).toLower();
+        if (value == "true" || value == "1" || value == "yes") {
+            return true;
+        }
+        ok = ok && (!cli.isSet(option) || value == "false" || value == "0" || value == "no");
+        return false;
+    };
+    const bool hasVersionCode = cli.isSet(versionCodeOption);
+    const bool hasVersionName = cli.isSet(versionNameOption);
+    const bool hasMinSdk = cli.isSet(minSdkOption);
+    const bool hasDebuggable = cli.isSet(debuggableOption);
+    const int versionCode = toInt(versionCodeOption, 0);
+    const QString versionName = cli.value(versionNameOption);
+    const int minSdk = toInt(minSdkOption, 1);
+    const bool debuggable = toBool(debuggableOption);
+    const QString output = cli.isSet(outputOption) ? QFileInfo(cli.value(outputOption)).absoluteFilePath() : QString();
+    if (patchManifest && !ok) {
+        QMessageBox::warning(this, {}, tr("Invalid manifest attribute value."));
+        return;
+    }
+
     const auto positionalArguments = cli.positionalArguments();
     for (const QString &path : positionalArguments) {
-        if (auto package = addPackage(path)) {
-            auto command = package->createCommandChain();
-            if (!cli.isSet(optimizeOption) && !cli.isSet(signOption) && !cli.isSet(installOption)) {
-                command->add(package->createUnpackCommand(), true);
-            } else {
-                if (cli.isSet(optimizeOption)) {
-                    command->add(package->createZipalignCommand(), true);
-                }
-                if (cli.isSet(signOption)) {
-                    auto keystore = Keystore::get(this);
-                    if (keystore) {
-                        command->add(package->createSignCommand(keystore.get()), true);
-                    }
-                }
-                if (cli.isSet(installOption)) {
-                    const auto device = Dialogs::getInstallDevice(this);
-                    if (!device.isNull()) {
-                        command->add(package->createInstallCommand(device.getSerial()), true);
-                    }
-                }
+        auto package = addPackage(path);
+        if (!package) {
+            continue;
+        }
+        auto command = package->createCommandChain();
+        if (!optimize && !sign && !install && !patchManifest) {
+            command->add(package->createReadCommand(), false);
+            command->add(package->createUnpackCommand(), true);
+            command->run();
+            continue;
+        }
+
+        // The following commands operate on the patched copy, if any
+        const QString target = patchManifest && !output.isEmpty() ? output : package->getOriginalPath();
+        std::shared_ptr<const Keystore> keystore;
+        if (sign) {
+            keystore = Keystore::get(this);
+        }
+        // Patching strips the signature, so the input APK is never left unsigned
+        if (patchManifest && QFileInfo(target) == QFileInfo(package->getOriginalPath()) && !keystore) {
+            QMessageBox::warning(this, {}, tr(
+                "Patching %1 in place requires signing. Specify the output path or sign the APK.").arg(package->getTitle()));
+            delete command;
+            continue;
+        }
+        QList<Device> devices;
+        if (install) {
+            devices = Dialogs::getInstallDevices(this);
+        }
+        auto addActions = [=](Commands *command) {
+            if (optimize) {
+                command->add(package->createZipalignCommand(target), true);
+            }
+            if (keystore) {
+                command->add(package->createSignCommand(keystore.get(), target), true);
             }
+            if (!devices.isEmpty()) {
+                command->add(package->createInstallCommand(devices, target), true);
+            }
+        };
+
+        if (!patchManifest) {
+            command->add(package->createReadCommand(), false);
+            addActions(command);
             command->run();
+            continue;
         }
+
+        // The manifest is patched without unpacking the APK, once its current values are read
+        command->add(package->createReadCommand(), true);
+        connect(command, &Command::finished, this, [=](bool success) {
+            const auto &manifest = package->getBinaryManifest();
+            if (!success || !package->openForPatching() || !package->patchBinaryManifest(
+                    hasVersionCode ? versionCode : manifest.getVersionCode(),
+                    hasVersionName ? versionName : manifest.getVersionName(),
+                    hasMinSdk ? minSdk : manifest.getMinSdk(),
+                    hasDebuggable ? debuggable : manifest.isDebuggable())) {
+                QMessageBox::warning(this, {}, tr("Could not patch the manifest of %1.").arg(package->getTitle()));
+                return;
+            }
+            auto patchCommand = package->createCommandChain();
+            patchCommand->add(package->createPatchCommand(target), true);
+            addActions(patchCommand);
+            patchCommand->run();
+        });
+        command->run();
     }
 }
 
@@ -209,10 +324,29 @@ void MainWindow::initWidgets()
     resourceFilterInput->setClearButtonEnabled(true);
     connect(resourceFilterInput, &QLineEdit::textChanged,
             resourceTree->getView<ResourceTree *>(), &ResourceTree::setFilter);
+    auto resourceFacetMenu = new QMenu(this);
+    connect(resourceFacetMenu, &QMenu::aboutToShow, this, [=]() {
+        populateResourceFacetMenu(resourceFacetMenu);
+    });
+    connect(resourceTree->getView<ResourceTree *>(), &ResourceTree::indexReady, resourceFacetMenu, [=]() {
+        if (resourceFacetMenu->isVisible()) {
+            populateResourceFacetMenu(resourceFacetMenu);
+        }
+    });
+    resourceFacetButton = new QToolButton(this);
+    resourceFacetButton->setIcon(QIcon::fromTheme("view-filter"));
+    resourceFacetButton->setMenu(resourceFacetMenu);
+    resourceFacetButton->setPopupMode(QToolButton::InstantPopup);
+    resourceFacetButton->setCheckable(true);
+    resourceFacetButton->setAutoRaise(true);
+    auto resourceFilterLayout = new QHBoxLayout;
+    resourceFilterLayout->addWidget(resourceFilterInput);
+    resourceFilterLayout->addWidget(resourceFacetButton);
+    resourceFilterLayout->setSpacing(2);
     auto dockResourceWidget = new QWidget(this);
     auto resourceLayout = new QVBoxLayout(dockResourceWidget);
     resourceLayout->addWidget(resourceTree);
-    resourceLayout->addWidget(resourceFilterInput);
+    resourceLayout->addLayout(resourceFilterLayout);
     resourceLayout->setMargin(0);
     resourceLayout->setSpacing(2);
 
@@ -300,6 +434,8 @@ void MainWindow::initMenus()
 
     auto actionOpenApk = app->actions.getOpenApk(this);
     connect(actionOpenApk, &QAction::triggered, this, &MainWindow::openExternalApk);
+    auto actionPatchApk = app->actions.getPatchApk(this);
+    connect(actionPatchApk, &QAction::triggered, this, &MainWindow::patchExternalApk);
     auto actionSaveApk = projectManager->getActionSavePackage();
     auto actionInstallApk = projectManager->getActionInstallPackage();
     auto actionInstallExternal = app->actions.getInstallApk(this);
@@ -327,12 +463,16 @@ void MainWindow::initMenus()
     auto actionKeyManager = app->actions.getOpenKeyManager(this);
     auto actionDeviceManager = app->actions.getOpenDeviceManager(this);
     auto actionAndroidExplorer = app->actions.getOpenAndroidExplorer(this);
+    auto actionApkComparer = app->actions.getOpenApkComparer(this);
     auto actionScreenshot = app->actions.getTakeScreenshot(this);
     auto actionProjectPage = projectManager->getActionOpenProjectPage();
     auto actionTitleEditor = projectManager->getActionEditTitles();
     auto actionPermissionEditor = projectManager->getActionEditPermissions();
     auto actionClonePackage = projectManager->getActionClonePackage();
     auto actionViewSignatures = projectManager->getActionViewSignatures();
+    auto actionViewResourceTable = projectManager->getActionViewResourceTable();
+    auto actionAnalyzeSize = projectManager->getActionAnalyzeSize();
+    auto actionRemoveUnusedResources = projectManager->getActionRemoveUnusedResources();
 
     // Settings Menu:
 
@@ -362,6 +502,7 @@ void MainWindow::initMenus()
 
     menuFile = menuBar()->addMenu(QString());
     menuFile->addAction(actionOpenApk);
+    menuFile->addAction(actionPatchApk);
     menuFile->addMenu(menuRecent);
     menuFile->addSeparator();
     menuFile->addAction(actionSaveApk);
@@ -380,6 +521,7 @@ void MainWindow::initMenus()
     menuBar()->addMenu(projectManager->getTabMenu());
     menuTools = menuBar()->addMenu(QString());
     menuTools->addAction(actionKeyManager);
+    menuTools->addAction(actionApkComparer);
     menuTools->addSeparator();
     menuTools->addAction(actionDeviceManager);
     menuTools->addAction(actionAndroidExplorer);
@@ -390,8 +532,11 @@ void MainWindow::initMenus()
     menuTools->addAction(actionTitleEditor);
     menuTools->addAction(actionPermissionEditor);
     menuTools->addAction(actionClonePackage);
+    menuTools->addAction(actionRemoveUnusedResources);
     menuTools->addSeparator();
     menuTools->addAction(actionViewSignatures);
+    menuTools->addAction(actionViewResourceTable);
+    menuTools->addAction(actionAnalyzeSize);
     menuSettings = menuBar()->addMenu(QString());
     menuSettings->addAction(actionOptions);
     menuSettings->addSeparator();
@@ -428,10 +573,14 @@ void MainWindow::initMenus()
     toolbar->addActionToPool("permission-editor", actionPermissionEditor);
     toolbar->addActionToPool("rename-package", actionClonePackage);
     toolbar->addActionToPool("view-signatures", actionViewSignatures);
+    toolbar->addActionToPool("view-resource-table", actionViewResourceTable);
+    toolbar->addActionToPool("analyze-size", actionAnalyzeSize);
+    toolbar->addActionToPool("remove-unused-resources", actionRemoveUnusedResources);
     toolbar->addActionToPool("device-manager", actionDeviceManager);
     toolbar->addActionToPool("android-explorer", actionAndroidExplorer);
     toolbar->addActionToPool("screenshot", actionScreenshot);
     toolbar->addActionToPool("key-manager", actionKeyManager);
+    toolbar->addActionToPool("compare-apks", actionApkComparer);
     toolbar->addActionToPool("new-window", actionNewWindow);
     toolbar->addActionToPool("settings", actionOptions);
     toolbar->addActionToPool("donate", actionDonate);
@@ -452,6 +601,8 @@ void MainWindow::retranslate()
     dockManifest->setWindowTitle(tr("Manifest"));
     dockIcons->setWindowTitle(tr("Icons"));
     resourceFilterInput->setPlaceholderText(tr("Filter"));
+    //: Refers to filtering the resources by their type, locale, DPI, or API level.
+    resourceFacetButton->setToolTip(tr("Filter by Qualifiers"));
 
     // Menu Bar:
 
@@ -521,6 +672,20 @@ void MainWindow::updateWindowForPackage(Package *package)
     }
 }
 
+void MainWindow::updateContentsForPackage(Package *package)
+{
+    // List the APK contents straight from the archive until it's unpacked
+    QAbstractItemModel *model = dummyFileSystemModel;
+    if (package) {
+        model = package->getState().isUnpacked()
+            ? static_cast<QAbstractItemModel *>(&package->filesystemModel)
+            : static_cast<QAbstractItemModel *>(&package->archiveModel);
+    }
+    if (filesystemTree->getView<QTreeView *>()->model() != model) {
+        filesystemTree->setModel(model);
+    }
+}
+
 void MainWindow::updateRecentMenu()
 {
     menuRecent->clear();
@@ -536,12 +701,58 @@ void MainWindow::updateRecentMenu()
     menuRecent->addAction(recentList.isEmpty() ? actionRecentNone : actionRecentClear);
 }
 
+void MainWindow::populateResourceFacetMenu(QMenu *menu)
+{
+    auto tree = resourceTree->getView<ResourceTree *>();
+    menu->clear();
+    const QList<QPair<ResourceIndex::Facet, QString>> facets {
+        {ResourceIndex::TypeFacet, tr("Type")},
+        {ResourceIndex::LocaleFacet, tr("Locale")},
+        {ResourceIndex::DpiFacet, "DPI"},
+        {ResourceIndex::ApiFacet, "API"},
+    };
+    for (const auto &facet : facets) {
+        const QString current = tree->getFacet(facet.first);
+        auto submenu = menu->addMenu(facet.second);
+        auto group = new QActionGroup(submenu);
+        //: Refers to a resource filter which matches any value (e.g., any locale or any DPI).
+        auto actionAny = submenu->addAction(tr("Any"));
+        actionAny->setCheckable(true);
+        actionAny->setChecked(current.isEmpty());
+        actionAny->setActionGroup(group);
+        submenu->addSeparator();
+        if (!tree->isIndexReady()) {
+            //: Shown while the resources are being read to list the available qualifier values.
+            submenu->addAction(tr("Building index..."))->setEnabled(false);
+        }
+        QStringList values = tree->getFacetValues(facet.first);
+        if (!current.isEmpty() && !values.contains(current)) {
+            values.prepend(current);
+        }
+        for (const QString &value : values) {
+            auto action = submenu->addAction(value);
+            action->setCheckable(true);
+            action->setChecked(value == current);
+            action->setActionGroup(group);
+            action->setData(value);
+        }
+        connect(group, &QActionGroup::triggered, this, [=](QAction *action) {
+            tree->setFacet(facet.first, action->data().toString());
+            bool filtered = false;
+            for (const auto &other : facets) {
+                filtered |= !tree->getFacet(other.first).isEmpty();
+            }
+            resourceFacetButton->setChecked(filtered);
+        });
+    }
+}
+
 void MainWindow::onPackageSwitched(Package *package)
 {
     projectManager->setCurrentProject(package);
 
     resourceTree->setModel(package ? &package->resourcesModel : dummyResourceModel);
-    filesystemTree->setModel(package ? &package->filesystemModel : dummyFileSystemModel);
+    updateContentsForPackage(package);
     iconList->setModel(package ? &package->iconsProxy : nullptr);
     logView->setModel(package ? &package->logModel : nullptr);
     manifestTable->setModel(package ? &package->manifestModel : nullptr);
@@ -18,6 +18,7 @@ class QDragEnterEvent;
 class QDropEvent;
 class QLineEdit;
 class QRubberBand;
+class QToolButton;
 class ResourceAbstractView;
 class ResourceItemsModel;
 class Toolbar;
@@ -32,6 +33,7 @@ public:
 
     void openApk(const QString &path);
     void openExternalApk();
+    void patchExternalApk();
     void optimizeExternalApk();
     void signExternalApk();
     void installExternalApk();
@@ -56,7 +58,9 @@ private:
     Package *addPackage(const QString &path);
 
     void updateWindowForPackage(Package *package);
+    void updateContentsForPackage(Package *package);
     void updateRecentMenu();
+    void populateResourceFacetMenu(QMenu *menu);
     void onPackageSwitched(Package *package);
 
     Project *getCurrentProject() const;
@@ -77,6 +81,7 @@ private:
     ManifestView *manifestTable;
     ResourceAbstractView *resourceTree;
     QLineEdit *resourceFilterInput;
+    QToolButton *resourceFacetButton;
     ResourceAbstractView *filesystemTree;
     ResourceAbstractView *iconList;
     Toolbar *toolbar;
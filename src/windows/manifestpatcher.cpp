@@ -0,0 +1,62 @@
+#include "windows/manifestpatcher.h"
+#include "apk/package.h"
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QSpinBox>
+#include <limits>
+
+ManifestPatcher::ManifestPatcher(Package *package, QWidget *parent) : QDialog(parent), package(package)
+{
+    //: This string refers to the Android manifest attributes (version code, version name, etc.).
+    setWindowTitle(tr("Manifest Attributes"));
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+
+    const auto &manifest = package->getBinaryManifest();
+
+    editVersionCode = new QSpinBox(this);
+    editVersionCode->setRange(0, std::numeric_limits<int>::max());
+    editVersionCode->setValue(manifest.getVersionCode());
+
+    editVersionName = new QLineEdit(this);
+    editVersionName->setText(manifest.getVersionName());
+
+    editMinSdk = new QSpinBox(this);
+    editMinSdk->setRange(1, 999);
+    editMinSdk->setValue(manifest.getMinSdk());
+    // A missing or codename minimum SDK is clamped by the range, so it is only written once actually edited
+    connect(editMinSdk, QOverload<int>::of(&QSpinBox::valueChanged), this, [this]() {
+        minSdkEdited = true;
+    });
+
+    checkDebuggable = new QCheckBox(tr("Debuggable"), this);
+    checkDebuggable->setChecked(manifest.isDebuggable());
+
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+    connect(buttons, &QDialogButtonBox::accepted, this, &ManifestPatcher::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &ManifestPatcher::reject);
+
+    auto layout = new QFormLayout(this);
+    layout->addRow(tr("Version code:"), editVersionCode);
+    layout->addRow(tr("Version name:"), editVersionName);
+    //: This string refers to the Android API level.
+    layout->addRow(tr("Minimum SDK:"), editMinSdk);
+    layout->addRow(checkDebuggable);
+    layout->addRow(buttons);
+}
+
+void ManifestPatcher::accept()
+{
+    const bool success = package->patchBinaryManifest(
+        editVersionCode->value(),
+        editVersionName->text(),
+        minSdkEdited ? editMinSdk->value() : package->getBinaryManifest().getMinSdk(),
+        checkDebuggable->isChecked());
+    if (!success) {
+        QMessageBox::warning(this, {}, tr("Could not update the manifest."));
+        return;
+    }
+    QDialog::accept();
+}
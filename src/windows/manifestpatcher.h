@@ -0,0 +1,32 @@
+#ifndef MANIFESTPATCHER_H
+#define MANIFESTPATCHER_H
+
+#include <QDialog>
+
+class Package;
+class QCheckBox;
+class QLineEdit;
+class QSpinBox;
+
+// Edits the version, minimum SDK and debuggable flag directly in the compiled manifest of a quick-patched APK.
+
+class ManifestPatcher : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit ManifestPatcher(Package *package, QWidget *parent = nullptr);
+
+    void accept() override;
+
+private:
+    Package *package;
+
+    QSpinBox *editVersionCode;
+    QLineEdit *editVersionName;
+    QSpinBox *editMinSdk;
+    QCheckBox *checkDebuggable;
+    bool minSdkEdited = false;
+};
+
+#endif // MANIFESTPATCHER_H
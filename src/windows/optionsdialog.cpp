@@ -106,6 +106,7 @@ void OptionsDialog::load()
     fileboxFrameworks->setCurrentPath(app->settings->getFrameworksDirectory());
     checkboxAapt2->setChecked(app->settings->getUseAapt2());
     checkboxDebuggable->setChecked(app->settings->getMakeDebuggable());
+    checkboxCheckSmali->setChecked(app->settings->getCheckSmali());
     checkboxSources->setChecked(app->settings->getDecompileSources());
     checkboxBrokenResources->setChecked(app->settings->getKeepBrokenResources());
 
@@ -122,6 +123,7 @@ void OptionsDialog::load()
     // ADB
 
     fileboxAdb->setCurrentPath(app->settings->getAdbPath());
+    spinboxTransferStreams->setValue(app->settings->getAdbTransferStreams());
 }
 
 void OptionsDialog::save()
@@ -161,6 +163,7 @@ void OptionsDialog::save()
     app->settings->setFrameworksDirectory(fileboxFrameworks->getCurrentPath());
     app->settings->setUseAapt2(checkboxAapt2->isChecked());
     app->settings->setMakeDebuggable(checkboxDebuggable->isChecked());
+    app->settings->setCheckSmali(checkboxCheckSmali->isChecked());
     app->settings->setDecompileSources(checkboxSources->isChecked());
     app->settings->setKeepBrokenResources(checkboxBrokenResources->isChecked());
 
@@ -177,6 +180,7 @@ void OptionsDialog::save()
     // ADB
 
     app->settings->setAdbPath(fileboxAdb->getCurrentPath());
+    app->settings->setAdbTransferStreams(spinboxTransferStreams->value());
 }
 
 void OptionsDialog::changeEvent(QEvent *event)
@@ -322,9 +326,12 @@ void OptionsDialog::initialize()
     //: "AAPT2" is the name of the tool, don't translate it.
     checkboxAapt2 = new QCheckBox(tr("Use AAPT2"), this);
     checkboxDebuggable = new QCheckBox(tr("Pack for debugging"), this);
+    //: "Smali" is the name of the tool/format, don't translate it.
+    checkboxCheckSmali = new QCheckBox(tr("Check smali code before packing"), this);
     auto layoutPacking = new QVBoxLayout(groupPacking);
     layoutPacking->addWidget(checkboxAapt2);
     layoutPacking->addWidget(checkboxDebuggable);
+    layoutPacking->addWidget(checkboxCheckSmali);
 
     pageApktool->addLayout(formApktool, 0, 0, 1, 2);
     pageApktool->addWidget(groupUnpacking, 1, 0);
@@ -369,6 +376,9 @@ void OptionsDialog::initialize()
     fileboxAdb = new FileBox(false, this);
     fileboxAdb->setDefaultPath("");
     fileboxAdb->setPlaceholderText(Adb::getDefaultPath());
+    spinboxTransferStreams = new QSpinBox(this);
+    spinboxTransferStreams->setMinimum(1);
+    spinboxTransferStreams->setMaximum(16);
     //: This string refers to multiple devices (as in "Manager of devices").
     auto btnDeviceManager = new QPushButton(tr("Open Device Manager"), this);
     btnDeviceManager->setIcon(QIcon::fromTheme("smartphone"));
@@ -379,6 +389,8 @@ void OptionsDialog::initialize()
     });
     //: "ADB" is the name of the tool, don't translate it.
     pageAdb->addRow(tr("ADB path:"), fileboxAdb);
+    //: This string refers to the number of files copied to or from the device at the same time.
+    pageAdb->addRow(tr("Parallel file transfers:"), spinboxTransferStreams);
     pageAdb->addRow(btnDeviceManager);
     pageAdb->setFieldGrowthPolicy(QFormLayout::ExpandingFieldsGrow);
 
@@ -65,6 +65,7 @@ private:
     FileBox *fileboxFrameworks;
     QCheckBox *checkboxAapt2;
     QCheckBox *checkboxDebuggable;
+    QCheckBox *checkboxCheckSmali;
     QCheckBox *checkboxSources;
     QCheckBox *checkboxBrokenResources;
 
@@ -81,6 +82,7 @@ private:
     // ADB
 
     FileBox *fileboxAdb;
+    QSpinBox *spinboxTransferStreams;
 };
 
 #endif // OPTIONSDIALOG_H
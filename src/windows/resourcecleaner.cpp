@@ -0,0 +1,114 @@
+#include "windows/resourcecleaner.h"
+#include "apk/package.h"
+#include "apk/resourceusage.h"
+#include "widgets/loadingwidget.h"
+#include "base/utils.h"
+#include <QBoxLayout>
+#include <QDir>
+#include <QDialogButtonBox>
+#include <QFutureWatcher>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTreeWidget>
+
+ResourceCleaner::ResourceCleaner(Package *package, QWidget *parent) : QDialog(parent), package(package)
+{
+    //: This string refers to unreferenced resources (drawables, layouts, etc.) which can be safely removed from the APK.
+    setWindowTitle(tr("Unused Resources"));
+    setWindowIcon(QIcon::fromTheme("edit-delete"));
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+    resize(Utils::scale(700, 450));
+
+    auto layout = new QVBoxLayout(this);
+
+    summary = new QLabel(this);
+    summary->setWordWrap(true);
+    layout->addWidget(summary);
+
+    list = new QTreeWidget(this);
+    list->setRootIsDecorated(false);
+    list->setUniformRowHeights(true);
+    list->setHeaderLabels({tr("Resource"), tr("Type"), tr("Size"), tr("Path")});
+    list->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    list->header()->setStretchLastSection(true);
+    layout->addWidget(list);
+
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    btnRemove = buttons->addButton(tr("Remove Selected"), QDialogButtonBox::DestructiveRole);
+    btnRemove->setIcon(QIcon::fromTheme("edit-delete"));
+    btnRemove->setEnabled(false);
+    layout->addWidget(buttons);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(btnRemove, &QPushButton::clicked, this, &ResourceCleaner::removeChecked);
+    connect(list, &QTreeWidget::itemChanged, this, &ResourceCleaner::updateSummary);
+
+    auto loading = new LoadingWidget(this);
+    loading->show();
+
+    auto watcher = new QFutureWatcher<QVector<UnusedResource>>(this);
+    connect(watcher, &QFutureWatcher<QVector<UnusedResource>>::finished, this, [=]() {
+        QSignalBlocker blocker(list);
+        const auto resources = watcher->result();
+        for (const auto &resource : resources) {
+            auto item = new QTreeWidgetItem(list);
+            item->setText(NameColumn, resource.name);
+            item->setText(TypeColumn, resource.type);
+            item->setText(SizeColumn, locale().formattedDataSize(resource.size));
+            item->setData(SizeColumn, Qt::UserRole, resource.size);
+            item->setTextAlignment(SizeColumn, Qt::AlignRight | Qt::AlignVCenter);
+            item->setText(PathColumn, QDir::toNativeSeparators(resource.path));
+            item->setData(PathColumn, Qt::UserRole, resource.path);
+            item->setCheckState(NameColumn, Qt::Checked);
+        }
+        blocker.unblock();
+        updateSummary();
+        loading->hide();
+        watcher->deleteLater();
+    });
+    watcher->setFuture(ResourceUsage::analyze(package->getContentsPath()));
+    updateSummary();
+}
+
+void ResourceCleaner::updateSummary()
+{
+    int count = 0;
+    qint64 size = 0;
+    for (int i = 0; i < list->topLevelItemCount(); ++i) {
+        const auto item = list->topLevelItem(i);
+        if (item->checkState(NameColumn) == Qt::Checked) {
+            size += item->data(SizeColumn, Qt::UserRole).toLongLong();
+            ++count;
+        }
+    }
+    const auto total = list->topLevelItemCount();
+    //: "%n" will be replaced with the number of resources, "%1" will be replaced with the amount of freed space (e.g., "12 files (3.5 MB) will be removed").
+    const QString selected = tr("%n file(s) (%1) will be removed.", nullptr, count).arg(locale().formattedDataSize(size));
+    summary->setText(QString("%1 %2").arg(tr("Unreferenced files found: %1.").arg(total), selected));
+    btnRemove->setEnabled(count);
+}
+
+void ResourceCleaner::removeChecked()
+{
+    QStringList paths;
+    for (int i = 0; i < list->topLevelItemCount(); ++i) {
+        const auto item = list->topLevelItem(i);
+        if (item->checkState(NameColumn) == Qt::Checked) {
+            paths.append(item->data(PathColumn, Qt::UserRole).toString());
+        }
+    }
+
+    const QString question = tr("Are you sure you want to remove %n file(s)?", nullptr, paths.count());
+    if (QMessageBox::question(this, {}, question) != QMessageBox::Yes) {
+        return;
+    }
+
+    const int removed = package->resourcesModel.removeResources(paths);
+    if (removed < paths.count()) {
+        QMessageBox::warning(this, {}, tr("Could not remove %n file(s).", nullptr, paths.count() - removed));
+    }
+    if (removed) {
+        accept();
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef RESOURCECLEANER_H
+#define RESOURCECLEANER_H
+
+#include <QDialog>
+
+class Package;
+class QLabel;
+class QPushButton;
+class QTreeWidget;
+
+class ResourceCleaner : public QDialog
+{
+    Q_OBJECT
+
+public:
+    ResourceCleaner(Package *package, QWidget *parent = nullptr);
+
+private:
+    enum Column {
+        NameColumn,
+        TypeColumn,
+        SizeColumn,
+        PathColumn
+    };
+
+    void updateSummary();
+    void removeChecked();
+
+    Package *package;
+    QLabel *summary;
+    QTreeWidget *list;
+    QPushButton *btnRemove;
+};
+
+#endif // RESOURCECLEANER_H
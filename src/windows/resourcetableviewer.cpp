@@ -0,0 +1,60 @@
+#include "windows/resourcetableviewer.h"
+#include "apk/resourcetablemodel.h"
+#include "widgets/loadingwidget.h"
+#include "base/utils.h"
+#include <QBoxLayout>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QSortFilterProxyModel>
+#include <QTreeView>
+
+ResourceTableViewer::ResourceTableViewer(const QString &apkPath, QWidget *parent) : QDialog(parent)
+{
+    //: This string refers to the compiled "resources.arsc" file of an APK.
+    setWindowTitle(tr("Resource Table"));
+    setWindowIcon(QIcon::fromTheme("edit-find"));
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+    resize(Utils::scale(800, 500));
+
+    auto model = new ResourceTableModel(this);
+
+    auto proxy = new QSortFilterProxyModel(this);
+    proxy->setSourceModel(model);
+    proxy->setSortRole(ResourceTableModel::SortRole);
+    proxy->setFilterKeyColumn(-1);
+    proxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    proxy->setRecursiveFilteringEnabled(true);
+
+    auto filter = new QLineEdit(this);
+    filter->setPlaceholderText(tr("Filter"));
+    filter->setClearButtonEnabled(true);
+    connect(filter, &QLineEdit::textChanged, proxy, &QSortFilterProxyModel::setFilterFixedString);
+
+    auto view = new QTreeView(this);
+    view->setModel(proxy);
+    view->setSortingEnabled(true);
+    view->sortByColumn(ResourceTableModel::CaptionColumn, Qt::AscendingOrder);
+    view->setUniformRowHeights(true);
+    view->header()->resizeSection(ResourceTableModel::CaptionColumn, Utils::scale(220));
+    view->header()->resizeSection(ResourceTableModel::ValueColumn, Utils::scale(260));
+
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Ok, this);
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(filter);
+    layout->addWidget(view);
+    layout->addWidget(buttons);
+
+    auto loading = new LoadingWidget(this);
+    loading->show();
+    connect(model, &ResourceTableModel::initialized, this, [=](bool success) {
+        loading->hide();
+        if (!success) {
+            QMessageBox::warning(this, {}, tr("Could not read the resource table."));
+        }
+    });
+    model->initialize(apkPath);
+}
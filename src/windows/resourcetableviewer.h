@@ -0,0 +1,14 @@
+#ifndef RESOURCETABLEVIEWER_H
+#define RESOURCETABLEVIEWER_H
+
+#include <QDialog>
+
+class ResourceTableViewer : public QDialog
+{
+    Q_OBJECT
+
+public:
+    ResourceTableViewer(const QString &apkPath, QWidget *parent = nullptr);
+};
+
+#endif // RESOURCETABLEVIEWER_H
@@ -0,0 +1,154 @@
+#include "windows/sizeanalyzer.h"
+#include "widgets/loadingwidget.h"
+#include "widgets/treemapwidget.h"
+#include "base/utils.h"
+#include <QBoxLayout>
+#include <QDialogButtonBox>
+#include <QFutureWatcher>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QSplitter>
+#include <QTreeWidget>
+
+namespace
+{
+    class SizeItem : public QTreeWidgetItem
+    {
+    public:
+        using QTreeWidgetItem::QTreeWidgetItem;
+
+        bool operator<(const QTreeWidgetItem &other) const override
+        {
+            // Numeric columns store their raw values in the user role
+            const int column = treeWidget()->sortColumn();
+            const QVariant value = data(column, Qt::UserRole);
+            if (value.isValid()) {
+                return value.toULongLong() < other.data(column, Qt::UserRole).toULongLong();
+            }
+            return QTreeWidgetItem::operator<(other);
+        }
+    };
+}
+
+SizeAnalyzer::SizeAnalyzer(const QString &apkPath, QWidget *parent) : QDialog(parent)
+{
+    //: This string refers to the breakdown of an APK size by its contents.
+    setWindowTitle(tr("APK Size"));
+    setWindowIcon(QIcon::fromTheme("zoom-in"));
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+    resize(Utils::scale(960, 540));
+
+    auto layout = new QVBoxLayout(this);
+
+    summary = new QLabel(this);
+    summary->setWordWrap(true);
+    layout->addWidget(summary);
+
+    tree = new QTreeWidget(this);
+    tree->setUniformRowHeights(true);
+    tree->setSortingEnabled(true);
+    //: "Compressed" refers to the size of a file inside the APK, "Share" refers to its percentage of the APK size.
+    tree->setHeaderLabels({tr("Name"), tr("Compressed"), tr("Size"), tr("Share"), tr("Files"), tr("Details")});
+    tree->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    tree->header()->setStretchLastSection(true);
+    tree->sortByColumn(CompressedSizeColumn, Qt::DescendingOrder);
+
+    treemap = new TreemapWidget(this);
+
+    auto splitter = new QSplitter(this);
+    splitter->addWidget(tree);
+    splitter->addWidget(treemap);
+    splitter->setStretchFactor(0, 3);
+    splitter->setStretchFactor(1, 2);
+    layout->addWidget(splitter);
+
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Ok, this);
+    layout->addWidget(buttons);
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+
+    connect(tree, &QTreeWidget::currentItemChanged, this, [this](QTreeWidgetItem *item) {
+        // Leaves are displayed along with their siblings
+        updateTreemap(item && !item->childCount() ? item->parent() : item);
+    });
+    connect(tree->header(), &QHeaderView::sortIndicatorChanged, this, [this]() {
+        // Tiles are mapped to the children by their row
+        updateTreemap(treemapItem != tree->invisibleRootItem() ? treemapItem : nullptr);
+    });
+    connect(treemap, &TreemapWidget::tileClicked, this, [this](int index) {
+        if (treemapItem) {
+            tree->setCurrentItem(treemapItem->child(index));
+        }
+    });
+    connect(treemap, &TreemapWidget::tileActivated, this, [this](int index) {
+        if (treemapItem) {
+            auto item = treemapItem->child(index);
+            item->setExpanded(true);
+            updateTreemap(item->childCount() ? item : treemapItem);
+        }
+    });
+
+    auto loading = new LoadingWidget(this);
+    loading->show();
+
+    auto watcher = new QFutureWatcher<SizeAnalysis::Node>(this);
+    connect(watcher, &QFutureWatcher<SizeAnalysis::Node>::finished, this, [=]() {
+        const auto root = watcher->result();
+        loading->hide();
+        watcher->deleteLater();
+        if (root.name.isEmpty()) {
+            QMessageBox::warning(this, {}, tr("Could not read the APK."));
+            return;
+        }
+        totalSize = root.compressedSize;
+        summary->setText(tr("Compressed: %1, uncompressed: %2, files: %3.").arg(
+            locale().formattedDataSize(root.compressedSize),
+            locale().formattedDataSize(root.size),
+            QString::number(root.files)));
+        tree->setSortingEnabled(false);
+        for (const auto &node : root.children) {
+            addNode(node, nullptr);
+        }
+        tree->setSortingEnabled(true);
+        updateTreemap(nullptr);
+    });
+    watcher->setFuture(SizeAnalysis::analyze(apkPath));
+}
+
+void SizeAnalyzer::addNode(const SizeAnalysis::Node &node, QTreeWidgetItem *parent)
+{
+    auto item = parent ? new SizeItem(parent) : new SizeItem(tree);
+    const qreal share = totalSize ? 100.0 * node.compressedSize / totalSize : 0;
+    item->setText(NameColumn, node.name);
+    item->setText(CompressedSizeColumn, locale().formattedDataSize(node.compressedSize));
+    item->setData(CompressedSizeColumn, Qt::UserRole, node.compressedSize);
+    item->setText(SizeColumn, locale().formattedDataSize(node.size));
+    item->setData(SizeColumn, Qt::UserRole, node.size);
+    item->setText(ShareColumn, QString("%1%").arg(share, 0, 'f', 1));
+    item->setData(ShareColumn, Qt::UserRole, node.compressedSize);
+    item->setText(FilesColumn, QString::number(node.files));
+    item->setData(FilesColumn, Qt::UserRole, node.files);
+    item->setText(DetailsColumn, node.details);
+    for (int column : {CompressedSizeColumn, SizeColumn, ShareColumn, FilesColumn}) {
+        item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+    }
+    for (const auto &child : node.children) {
+        addNode(child, item);
+    }
+}
+
+void SizeAnalyzer::updateTreemap(QTreeWidgetItem *item)
+{
+    // Displays the children of the given item, or the top-level items
+    treemapItem = item ? item : tree->invisibleRootItem();
+    QVector<TreemapWidget::Tile> tiles;
+    for (int i = 0; i < treemapItem->childCount(); ++i) {
+        const auto child = treemapItem->child(i);
+        TreemapWidget::Tile tile;
+        tile.label = child->text(NameColumn);
+        tile.description = QString("%1 (%2)").arg(child->text(CompressedSizeColumn), child->text(ShareColumn));
+        tile.value = child->data(CompressedSizeColumn, Qt::UserRole).toULongLong();
+        tiles.append(tile);
+    }
+    treemap->setTiles(tiles);
+}
@@ -0,0 +1,39 @@
+#ifndef SIZEANALYZER_H
+#define SIZEANALYZER_H
+
+#include "apk/sizeanalysis.h"
+#include <QDialog>
+
+class QLabel;
+class QTreeWidget;
+class QTreeWidgetItem;
+class TreemapWidget;
+
+class SizeAnalyzer : public QDialog
+{
+    Q_OBJECT
+
+public:
+    SizeAnalyzer(const QString &apkPath, QWidget *parent = nullptr);
+
+private:
+    enum Column {
+        NameColumn,
+        CompressedSizeColumn,
+        SizeColumn,
+        ShareColumn,
+        FilesColumn,
+        DetailsColumn
+    };
+
+    void addNode(const SizeAnalysis::Node &node, QTreeWidgetItem *parent);
+    void updateTreemap(QTreeWidgetItem *item);
+
+    QLabel *summary;
+    QTreeWidget *tree;
+    TreemapWidget *treemap;
+    QTreeWidgetItem *treemapItem = nullptr;
+    quint64 totalSize = 0;
+};
+
+#endif // SIZEANALYZER_H
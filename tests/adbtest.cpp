@@ -0,0 +1,530 @@
+#include "tools/adbconnection.h"
+#include "tools/adbsync.h"
+#include <QMap>
+#include <QMutex>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtEndian>
+#include <QtTest>
+
+// Exercises the smart socket and sync protocol clients against an in-process fake adb server,
+// which is picked up through ANDROID_ADB_SERVER_PORT the same way as by the adb client itself.
+
+namespace
+{
+    const QString Serial = "emulator-5554";
+    const quint32 FileMode = 0100644;
+    const quint32 DirectoryMode = 0040755;
+    const int MaxDataSize = 64 * 1024;
+
+    QByteArray lengthPrefixed(const QByteArray &data)
+    {
+        return QByteArray::number(data.size(), 16).rightJustified(4, '0') + data;
+    }
+
+    void appendValue(QByteArray &buffer, quint32 value)
+    {
+        const quint32 littleEndian = qToLittleEndian(value);
+        buffer.append(reinterpret_cast<const char *>(&littleEndian), sizeof(quint32));
+    }
+
+    QByteArray syncPacket(const char *id, quint32 value, const QByteArray &data = QByteArray())
+    {
+        QByteArray packet(id, 4);
+        appendValue(packet, value);
+        return packet + data;
+    }
+}
+
+class FakeAdbServer : public QTcpServer
+{
+public:
+    explicit FakeAdbServer(QObject *parent = nullptr);
+
+    void setFile(const QString &path, const QByteArray &data);
+    QByteArray getFile(const QString &path) const;
+    bool hasFile(const QString &path) const;
+    bool isDirectory(const QString &path) const;
+    QMap<QString, quint32> list(const QString &path) const; // Name -> mode
+    int getSyncSessionCount() const;
+    void addSyncSession();
+
+private:
+    mutable QMutex mutex;
+    QMap<QString, QByteArray> files;
+    int syncSessions = 0;
+};
+
+class FakeAdbSession : public QObject
+{
+public:
+    FakeAdbSession(FakeAdbServer *server, QTcpSocket *socket);
+
+private:
+    enum State {
+        HostState,
+        SyncState,
+        SendState,
+        ClosedState
+    };
+
+    bool process();
+    void handleService(const QString &service);
+    void handleSyncRequest(const QByteArray &id, const QByteArray &data);
+    void handleSendData(const QByteArray &id, const QByteArray &data);
+    QByteArray runShell(const QString &command, int &exitCode) const;
+    void fail(const QByteArray &message);
+    void close();
+
+    FakeAdbServer *server;
+    QTcpSocket *socket;
+    QByteArray buffer;
+    State state = HostState;
+    bool transport = false;
+    QString sendPath;
+    QByteArray sendData;
+};
+
+FakeAdbServer::FakeAdbServer(QObject *parent) : QTcpServer(parent)
+{
+    connect(this, &QTcpServer::newConnection, this, [this]() {
+        while (QTcpSocket *socket = nextPendingConnection()) {
+            new FakeAdbSession(this, socket);
+        }
+    });
+}
+
+void FakeAdbServer::setFile(const QString &path, const QByteArray &data)
+{
+    QMutexLocker locker(&mutex);
+    files.insert(path, data);
+}
+
+QByteArray FakeAdbServer::getFile(const QString &path) const
+{
+    QMutexLocker locker(&mutex);
+    return files.value(path);
+}
+
+bool FakeAdbServer::hasFile(const QString &path) const
+{
+    QMutexLocker locker(&mutex);
+    return files.contains(path);
+}
+
+bool FakeAdbServer::isDirectory(const QString &path) const
+{
+    return !list(path).isEmpty();
+}
+
+QMap<QString, quint32> FakeAdbServer::list(const QString &path) const
+{
+    QMutexLocker locker(&mutex);
+    const QString prefix = path.endsWith('/') ? path : path + '/';
+    QMap<QString, quint32> entries;
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        if (it.key().startsWith(prefix)) {
+            const QString relativePath = it.key().mid(prefix.size());
+            const QString name = relativePath.section('/', 0, 0);
+            entries.insert(name, relativePath.contains('/') ? DirectoryMode : FileMode);
+        }
+    }
+    return entries;
+}
+
+int FakeAdbServer::getSyncSessionCount() const
+{
+    QMutexLocker locker(&mutex);
+    return syncSessions;
+}
+
+void FakeAdbServer::addSyncSession()
+{
+    QMutexLocker locker(&mutex);
+    ++syncSessions;
+}
+
+FakeAdbSession::FakeAdbSession(FakeAdbServer *server, QTcpSocket *socket)
+    : QObject(socket)
+    , server(server)
+    , socket(socket)
+{
+    connect(socket, &QTcpSocket::readyRead, this, [this]() {
+        buffer.append(this->socket->readAll());
+        while (state != ClosedState && process()) {}
+    });
+    connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+}
+
+bool FakeAdbSession::process()
+{
+    if (state == HostState) {
+        // Host requests are prefixed with a hexadecimal length
+        if (buffer.size() < 4) {
+            return false;
+        }
+        bool ok;
+        const int length = buffer.left(4).toInt(&ok, 16);
+        if (!ok) {
+            close();
+            return false;
+        }
+        if (buffer.size() < 4 + length) {
+            return false;
+        }
+        const QString service = QString::fromUtf8(buffer.mid(4, length));
+        buffer.remove(0, 4 + length);
+        handleService(service);
+        return true;
+    }
+
+    // Sync requests are [id, length, data], except for the final DONE of SEND, which carries the modification time
+    if (buffer.size() < 8) {
+        return false;
+    }
+    const QByteArray id = buffer.left(4);
+    const quint32 length = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(buffer.constData() + 4));
+    if (state == SendState && id == "DONE") {
+        buffer.remove(0, 8);
+        handleSendData(id, QByteArray());
+        return true;
+    }
+    if (quint64(buffer.size()) < 8 + quint64(length)) {
+        return false;
+    }
+    const QByteArray data = buffer.mid(8, static_cast<int>(length));
+    buffer.remove(0, 8 + static_cast<int>(length));
+    if (state == SendState) {
+        handleSendData(id, data);
+    } else {
+        handleSyncRequest(id, data);
+    }
+    return true;
+}
+
+void FakeAdbSession::handleService(const QString &service)
+{
+    if (service == "host:version") {
+        socket->write("OKAY" + lengthPrefixed("0029"));
+        close();
+    } else if (service == QString("host-serial:%1:features").arg(Serial)) {
+        socket->write("OKAY" + lengthPrefixed("shell_v2,cmd"));
+        close();
+    } else if (service == "host:transport-any" || service == QString("host:transport:%1").arg(Serial)) {
+        socket->write("OKAY");
+        transport = true;
+    } else if (service.startsWith("host:transport:")) {
+        fail(QString("device '%1' not found").arg(service.mid(15)).toUtf8());
+    } else if (transport && service.startsWith("shell,v2,raw:")) {
+        int exitCode;
+        const QByteArray output = runShell(service.mid(13), exitCode);
+        QByteArray reply("OKAY");
+        reply.append(char(1));
+        appendValue(reply, static_cast<quint32>(output.size()));
+        reply.append(output);
+        reply.append(char(3));
+        appendValue(reply, 1);
+        reply.append(char(exitCode));
+        socket->write(reply);
+        close();
+    } else if (transport && service.startsWith("shell:")) {
+        int exitCode;
+        socket->write("OKAY" + runShell(service.mid(6), exitCode));
+        close();
+    } else if (transport && service == "sync:") {
+        socket->write("OKAY");
+        server->addSyncSession();
+        state = SyncState;
+    } else {
+        fail("unknown host service");
+    }
+}
+
+void FakeAdbSession::handleSyncRequest(const QByteArray &id, const QByteArray &data)
+{
+    const QString path = QString::fromUtf8(data);
+    if (id == "STAT") {
+        quint32 mode = 0;
+        quint32 size = 0;
+        if (server->hasFile(path)) {
+            mode = FileMode;
+            size = static_cast<quint32>(server->getFile(path).size());
+        } else if (server->isDirectory(path)) {
+            mode = DirectoryMode;
+        }
+        QByteArray reply = syncPacket("STAT", mode);
+        appendValue(reply, size);
+        appendValue(reply, 1500000000);
+        socket->write(reply);
+    } else if (id == "LIST") {
+        QByteArray reply;
+        QMap<QString, quint32> entries = server->list(path);
+        if (!entries.isEmpty()) {
+            entries.insert(".", DirectoryMode);
+            entries.insert("..", DirectoryMode);
+        }
+        for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+            const QByteArray name = it.key().toUtf8();
+            const QString entryPath = path + '/' + it.key();
+            reply.append(syncPacket("DENT", it.value()));
+            appendValue(reply, it.value() == FileMode ? static_cast<quint32>(server->getFile(entryPath).size()) : 0);
+            appendValue(reply, 1500000000);
+            appendValue(reply, static_cast<quint32>(name.size()));
+            reply.append(name);
+        }
+        reply.append(QByteArray("DONE") + QByteArray(16, '\0'));
+        socket->write(reply);
+    } else if (id == "RECV") {
+        if (!server->hasFile(path)) {
+            const QByteArray message = "No such file or directory";
+            socket->write(syncPacket("FAIL", static_cast<quint32>(message.size()), message));
+            return;
+        }
+        const QByteArray contents = server->getFile(path);
+        for (int offset = 0; offset < contents.size(); offset += MaxDataSize) {
+            const QByteArray chunk = contents.mid(offset, MaxDataSize);
+            socket->write(syncPacket("DATA", static_cast<quint32>(chunk.size()), chunk));
+        }
+        socket->write(syncPacket("DONE", 0));
+    } else if (id == "SEND") {
+        // The path is followed by the file mode
+        sendPath = path.left(path.lastIndexOf(','));
+        sendData.clear();
+        state = SendState;
+    } else {
+        // Including QUIT
+        close();
+    }
+}
+
+void FakeAdbSession::handleSendData(const QByteArray &id, const QByteArray &data)
+{
+    if (id == "DATA") {
+        sendData.append(data);
+    } else if (id == "DONE") {
+        server->setFile(sendPath, sendData);
+        socket->write(syncPacket("OKAY", 0));
+        state = SyncState;
+    } else {
+        close();
+    }
+}
+
+QByteArray FakeAdbSession::runShell(const QString &command, int &exitCode) const
+{
+    exitCode = 0;
+    if (command.startsWith("echo ")) {
+        return command.mid(5).toUtf8() + '\n';
+    }
+    if (command == "false") {
+        exitCode = 1;
+        return QByteArray();
+    }
+    exitCode = 127;
+    return QString("/system/bin/sh: %1: not found\n").arg(command).toUtf8();
+}
+
+void FakeAdbSession::fail(const QByteArray &message)
+{
+    socket->write("FAIL" + lengthPrefixed(message));
+    close();
+}
+
+void FakeAdbSession::close()
+{
+    // Pending replies are still written before the connection is closed
+    state = ClosedState;
+    socket->disconnectFromHost();
+}
+
+class AdbTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void query();
+    void transportFailure();
+    void shell();
+    void legacyShell();
+    void stat();
+    void list();
+    void receive();
+    void receiveMissing();
+    void send();
+    void sessionReuse();
+
+private:
+    QThread serverThread;
+    FakeAdbServer *server = nullptr;
+};
+
+void AdbTest::initTestCase()
+{
+    // The client calls are blocking, so the server runs in its own thread
+    server = new FakeAdbServer;
+    server->moveToThread(&serverThread);
+    connect(&serverThread, &QThread::finished, server, &QObject::deleteLater);
+    serverThread.start();
+    quint16 port = 0;
+    QMetaObject::invokeMethod(server, [&]() {
+        if (server->listen(QHostAddress::LocalHost)) {
+            port = server->serverPort();
+        }
+    }, Qt::BlockingQueuedConnection);
+    QVERIFY(port != 0);
+    qputenv("ANDROID_ADB_SERVER_PORT", QByteArray::number(port));
+
+    server->setFile("/sdcard/small.txt", "Hello, world!\n");
+    QByteArray large(3 * MaxDataSize + 123, Qt::Uninitialized);
+    for (int i = 0; i < large.size(); ++i) {
+        large[i] = static_cast<char>(i * 31);
+    }
+    server->setFile("/sdcard/Download/large.bin", large);
+}
+
+void AdbTest::cleanupTestCase()
+{
+    serverThread.quit();
+    serverThread.wait();
+}
+
+void AdbTest::query()
+{
+    QString error;
+    QCOMPARE(AdbConnection::query("host:version", &error), QByteArray("0029"));
+    QVERIFY(error.isEmpty());
+    QCOMPARE(AdbConnection::getFeatures(Serial), QStringList({"shell_v2", "cmd"}));
+}
+
+void AdbTest::transportFailure()
+{
+    AdbConnection connection;
+    QVERIFY(!connection.connectToDevice("unknown", "sync:"));
+    QCOMPARE(connection.getError(), QString("device 'unknown' not found"));
+    QVERIFY(!connection.isConnected());
+}
+
+void AdbTest::shell()
+{
+    QString output;
+    QVERIFY(AdbConnection::shell(Serial, "echo hello", &output));
+    QCOMPARE(output, QString("hello"));
+    QVERIFY(!AdbConnection::shell(Serial, "false", &output));
+    QVERIFY(output.isEmpty());
+}
+
+void AdbTest::legacyShell()
+{
+    AdbConnection connection;
+    QVERIFY(connection.connectToDevice(Serial, "shell:echo hello"));
+    QCOMPARE(connection.readToEnd(), QByteArray("hello\n"));
+    QVERIFY(connection.getError().isEmpty());
+}
+
+void AdbTest::stat()
+{
+    AdbSync sync(Serial);
+    QVERIFY2(sync.isValid(), qPrintable(sync.getError()));
+    AdbSync::Stat result;
+    QVERIFY(sync.stat("/sdcard/small.txt", result));
+    QVERIFY(result.isFile());
+    QCOMPARE(result.size, quint64(14));
+    QCOMPARE(result.modified, qint64(1500000000));
+    QVERIFY(sync.stat("/sdcard/Download", result));
+    QVERIFY(result.isDirectory());
+    QVERIFY(sync.stat("/sdcard/missing", result));
+    QVERIFY(!result.exists());
+}
+
+void AdbTest::list()
+{
+    AdbSync sync(Serial);
+    QVector<AdbSync::Entry> entries;
+    QVERIFY(sync.list("/sdcard", entries));
+    QCOMPARE(entries.count(), 2);
+    QCOMPARE(entries.at(0).name, QString("Download"));
+    QVERIFY(entries.at(0).stat.isDirectory());
+    QCOMPARE(entries.at(1).name, QString("small.txt"));
+    QVERIFY(entries.at(1).stat.isFile());
+    QCOMPARE(entries.at(1).stat.size, quint64(14));
+}
+
+void AdbTest::receive()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QString path = directory.filePath("large.bin");
+    AdbSync sync(Serial);
+    qint64 transferred = 0;
+    QVERIFY2(sync.receive("/sdcard/Download/large.bin", path, [&](qint64 size) {
+        transferred += size;
+        return true;
+    }), qPrintable(sync.getError()));
+    QFile file(path);
+    QVERIFY(file.open(QFile::ReadOnly));
+    QCOMPARE(file.readAll(), server->getFile("/sdcard/Download/large.bin"));
+    QCOMPARE(transferred, qint64(3 * MaxDataSize + 123));
+}
+
+void AdbTest::receiveMissing()
+{
+    QTemporaryDir directory;
+    AdbSync sync(Serial);
+    QVERIFY(!sync.receive("/sdcard/missing", directory.filePath("missing")));
+    QCOMPARE(sync.getError(), QString("No such file or directory"));
+    QVERIFY(!QFile::exists(directory.filePath("missing")));
+}
+
+void AdbTest::send()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QByteArray data(2 * MaxDataSize + 1, 'x');
+    QFile file(directory.filePath("upload.bin"));
+    QVERIFY(file.open(QFile::WriteOnly));
+    QCOMPARE(file.write(data), qint64(data.size()));
+    file.close();
+
+    AdbSync sync(Serial);
+    QVERIFY2(sync.send(file.fileName(), "/sdcard/upload.bin"), qPrintable(sync.getError()));
+    QCOMPARE(server->getFile("/sdcard/upload.bin"), data);
+    AdbSync::Stat result;
+    QVERIFY(sync.stat("/sdcard/upload.bin", result));
+    QCOMPARE(result.size, quint64(data.size()));
+}
+
+void AdbTest::sessionReuse()
+{
+    // A failed request drops the session, so the next one has to connect again
+    {
+        QTemporaryDir directory;
+        AdbSync sync(Serial);
+        QVERIFY(!sync.receive("/sdcard/missing", directory.filePath("missing")));
+    }
+    const int sessionCount = server->getSyncSessionCount();
+    AdbSync::Stat result;
+    {
+        AdbSync sync(Serial);
+        QVERIFY(sync.stat("/sdcard/small.txt", result));
+    }
+    {
+        AdbSync sync(Serial);
+        QVERIFY(sync.stat("/sdcard/small.txt", result));
+        QVector<AdbSync::Entry> entries;
+        QVERIFY(sync.list("/sdcard", entries));
+    }
+    QCOMPARE(server->getSyncSessionCount(), sessionCount + 1);
+
+    // Sessions are not shared between devices
+    AdbSync other("emulator-5556");
+    QVERIFY(!other.isValid());
+}
+
+QTEST_GUILESS_MAIN(AdbTest)
+
+#include "adbtest.moc"
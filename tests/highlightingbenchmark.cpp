@@ -0,0 +1,91 @@
+#include <KSyntaxHighlighting/Definition>
+#include <KSyntaxHighlighting/Repository>
+#include <KSyntaxHighlighting/SyntaxHighlighter>
+#include <KSyntaxHighlighting/Theme>
+#include <QElapsedTimer>
+#include <QTextDocument>
+#include <QtTest>
+
+// Measures what used to be paid at startup (creating the syntax highlighting repository),
+// and what the first code editor pays now that the repository is created on demand.
+// Each cold measurement runs once per process, so the benchmark is meant to be run several times.
+
+namespace
+{
+    QString createLayout(int views)
+    {
+        QString xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+                      "<LinearLayout xmlns:android=\"http://schemas.android.com/apk/res/android\"\n"
+                      "    android:layout_width=\"match_parent\"\n"
+                      "    android:layout_height=\"match_parent\"\n"
+                      "    android:orientation=\"vertical\">\n";
+        for (int i = 0; i < views; ++i) {
+            xml += QString("    <!-- Item %1 -->\n"
+                           "    <TextView\n"
+                           "        android:id=\"@+id/text%1\"\n"
+                           "        android:layout_width=\"wrap_content\"\n"
+                           "        android:layout_height=\"wrap_content\"\n"
+                           "        android:text=\"@string/item_%1\" />\n").arg(i);
+        }
+        xml += "</LinearLayout>\n";
+        return xml;
+    }
+
+    void highlight(KSyntaxHighlighting::Repository &repository, const QString &filename, const QString &text)
+    {
+        QTextDocument document;
+        document.setPlainText(text);
+        auto highlighter = new KSyntaxHighlighting::SyntaxHighlighter(&document);
+        highlighter->setTheme(repository.defaultTheme());
+        highlighter->setDefinition(repository.definitionForFileName(filename));
+        highlighter->rehighlight();
+    }
+}
+
+class HighlightingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void startup();
+    void firstEditorOpen();
+    void nextEditorOpen();
+};
+
+void HighlightingBenchmark::startup()
+{
+    // Cost of the eager repository creation, which is no longer paid before the first window is shown
+    QBENCHMARK_ONCE {
+        KSyntaxHighlighting::Repository repository;
+        QVERIFY(!repository.definitions().isEmpty());
+    }
+}
+
+void HighlightingBenchmark::firstEditorOpen()
+{
+    // Repository creation, definition loading and highlighting of the first opened file
+    const QString layout = createLayout(200);
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        KSyntaxHighlighting::Repository repository;
+        const qint64 repositoryTime = timer.restart();
+        highlight(repository, "activity_main.xml", layout);
+        qDebug("Repository: %lld ms, definition and highlighting: %lld ms", repositoryTime, timer.elapsed());
+    }
+}
+
+void HighlightingBenchmark::nextEditorOpen()
+{
+    // Later editors reuse the repository and the already loaded definition
+    KSyntaxHighlighting::Repository repository;
+    const QString layout = createLayout(200);
+    highlight(repository, "activity_main.xml", layout);
+    QBENCHMARK {
+        highlight(repository, "activity_main.xml", layout);
+    }
+}
+
+QTEST_MAIN(HighlightingBenchmark)
+
+#include "highlightingbenchmark.moc"
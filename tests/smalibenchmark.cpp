@@ -0,0 +1,210 @@
+#include "apk/smalitokenizer.h"
+#include <KSyntaxHighlighting/AbstractHighlighter>
+#include <KSyntaxHighlighting/Definition>
+#include <KSyntaxHighlighting/FoldingRegion>
+#include <KSyntaxHighlighting/Format>
+#include <KSyntaxHighlighting/Repository>
+#include <KSyntaxHighlighting/State>
+#include <KSyntaxHighlighting/Theme>
+#include <QDirIterator>
+#include <QtTest>
+
+// Compares the smali tokenizer against the generic syntax engine running the smali.xml definition.
+// Both collect their tokens and folds, so that neither side gets away with discarding its output.
+// The corpus is generated, unless SMALI_CORPUS points to a directory with decoded *.smali files.
+
+namespace
+{
+    QStringList generateCorpus(int classes)
+    {
+        QStringList lines;
+        for (int i = 0; i < classes; ++i) {
+            const QString type = QString("Lcom/example/app/Class%1;").arg(i);
+            lines << QString(".class public final %1").arg(type)
+                  << ".super Ljava/lang/Object;"
+                  << ".source \"Class.java\""
+                  << ""
+                  << "# instance fields"
+                  << ".field private final items:Ljava/util/List;"
+                  << ".field private count:I"
+                  << ""
+                  << ".annotation system Ldalvik/annotation/Signature;"
+                  << "    value = {"
+                  << "        \"Ljava/lang/Object;\""
+                  << "    }"
+                  << ".end annotation"
+                  << ""
+                  << ".method public constructor <init>()V"
+                  << "    .registers 2"
+                  << ""
+                  << "    invoke-direct {p0}, Ljava/lang/Object;-><init>()V"
+                  << ""
+                  << "    new-instance v0, Ljava/util/ArrayList;"
+                  << ""
+                  << "    invoke-direct {v0}, Ljava/util/ArrayList;-><init>()V"
+                  << ""
+                  << QString("    iput-object v0, p0, %1->items:Ljava/util/List;").arg(type)
+                  << ""
+                  << "    return-void"
+                  << ".end method"
+                  << ""
+                  << ".method public get(I)Ljava/lang/String;"
+                  << "    .registers 4"
+                  << "    .param p1, \"index\"    # I"
+                  << ""
+                  << "    .line 42"
+                  << QString("    iget-object v0, p0, %1->items:Ljava/util/List;").arg(type)
+                  << ""
+                  << "    if-ltz p1, :cond_0"
+                  << ""
+                  << "    invoke-interface {v0}, Ljava/util/List;->size()I"
+                  << ""
+                  << "    move-result v1"
+                  << ""
+                  << "    if-ge p1, v1, :cond_0"
+                  << ""
+                  << "    invoke-interface {v0, p1}, Ljava/util/List;->get(I)Ljava/lang/Object;"
+                  << ""
+                  << "    move-result-object v0"
+                  << ""
+                  << "    check-cast v0, Ljava/lang/String;"
+                  << ""
+                  << "    return-object v0"
+                  << ""
+                  << "    :cond_0"
+                  << "    const-string v0, \"Out of range: \\\"index\\\"\\n\""
+                  << ""
+                  << "    return-object v0"
+                  << ".end method"
+                  << ""
+                  << ".method public static select(I)I"
+                  << "    .registers 3"
+                  << ""
+                  << "    packed-switch p0, :pswitch_data_0"
+                  << ""
+                  << "    const/4 v0, -0x1"
+                  << ""
+                  << "    return v0"
+                  << ""
+                  << "    :pswitch_0"
+                  << "    const-wide/high16 v0, 0x3ff0000000000000L    # 1.0"
+                  << ""
+                  << "    const/16 v0, 0x2a"
+                  << ""
+                  << "    return v0"
+                  << ""
+                  << "    :pswitch_data_0"
+                  << "    .packed-switch 0x0"
+                  << "        :pswitch_0"
+                  << "    .end packed-switch"
+                  << ".end method"
+                  << "";
+        }
+        return lines;
+    }
+
+    QStringList readCorpus(const QString &path)
+    {
+        QStringList lines;
+        QDirIterator it(path, {"*.smali"}, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            QFile file(it.next());
+            if (file.open(QFile::ReadOnly | QFile::Text)) {
+                lines << QString::fromUtf8(file.readAll()).split('\n');
+            }
+        }
+        return lines;
+    }
+
+    class SmaliHighlighter : public KSyntaxHighlighting::AbstractHighlighter
+    {
+    public:
+        void highlight(const QStringList &lines)
+        {
+            tokens.clear();
+            folds = 0;
+            KSyntaxHighlighting::State state;
+            for (const QString &line : lines) {
+                state = highlightLine(line, state);
+            }
+        }
+
+        QVector<SmaliTokenizer::Token> tokens;
+        int folds = 0;
+
+    protected:
+        void applyFormat(int offset, int length, const KSyntaxHighlighting::Format &format) override
+        {
+            if (!format.isDefaultTextStyle(theme())) {
+                tokens.append({SmaliTokenizer::Comment, offset, length});
+            }
+        }
+
+        void applyFolding(int offset, int length, KSyntaxHighlighting::FoldingRegion region) override
+        {
+            Q_UNUSED(offset)
+            Q_UNUSED(length)
+            Q_UNUSED(region)
+            ++folds;
+        }
+    };
+}
+
+class SmaliBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void tokenizer();
+    void syntaxDefinition();
+
+private:
+    QStringList corpus;
+};
+
+void SmaliBenchmark::initTestCase()
+{
+    const QString path = qEnvironmentVariable("SMALI_CORPUS");
+    corpus = path.isEmpty() ? generateCorpus(1000) : readCorpus(path);
+    QVERIFY(!corpus.isEmpty());
+    qDebug("Corpus: %d lines", corpus.size());
+}
+
+void SmaliBenchmark::tokenizer()
+{
+    QVector<SmaliTokenizer::Token> tokens;
+    QVector<SmaliTokenizer::Fold> folds;
+    QBENCHMARK {
+        tokens.clear();
+        folds.clear();
+        SmaliTokenizer::State state;
+        for (const QString &line : corpus) {
+            state = SmaliTokenizer::tokenize(line, state, tokens, folds);
+        }
+    }
+    QVERIFY(!tokens.isEmpty());
+    QVERIFY(!folds.isEmpty());
+}
+
+void SmaliBenchmark::syntaxDefinition()
+{
+    KSyntaxHighlighting::Repository repository;
+    const KSyntaxHighlighting::Definition definition = repository.definitionForName("Smali");
+    QVERIFY(definition.isValid());
+
+    SmaliHighlighter highlighter;
+    highlighter.setTheme(repository.defaultTheme());
+    highlighter.setDefinition(definition);
+    highlighter.highlight(corpus.mid(0, 1)); // Loads the definition outside of the measurement
+
+    QBENCHMARK {
+        highlighter.highlight(corpus);
+    }
+    QVERIFY(!highlighter.tokens.isEmpty());
+    QVERIFY(highlighter.folds > 0);
+}
+
+QTEST_GUILESS_MAIN(SmaliBenchmark)
+
+#include "smalibenchmark.moc"